@@ -0,0 +1,228 @@
+/**
+ * #FujiNet-PC modem data pump loopback benchmark
+ *
+ * Runs ModemPump over a local TCP connection, with a fake computer on the
+ * port side that sends and checks a test pattern as fast as the pump takes
+ * it, and a thread as the remote end. Measures both directions, raw and
+ * with telnet (the pattern includes 0xFF, so IACs get doubled and undone).
+ *
+ * Build in the FujiNet-PC build directory:
+ *   cmake --build . --target modem_pump_bench && ./modem_pump_bench [MB]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "modem-pump.h"
+
+// 115200 baud, 8N1
+#define BENCH_BAUD_BYTES_PER_SEC (115200 / 10)
+
+static uint8_t pattern(size_t i)
+{
+    return (uint8_t)(i * 7 + (i >> 8));
+}
+
+static uint64_t now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * The computer: sends the pattern, checks the pattern it gets back
+ */
+class BenchPort : public ModemPort
+{
+public:
+    size_t to_send = 0;
+    size_t sent = 0;
+    size_t received = 0;
+    bool corrupt = false;
+
+    int port_available() override
+    {
+        size_t n = to_send - sent;
+        return n > 65536 ? 65536 : (int)n;
+    }
+
+    size_t port_read(uint8_t *buf, size_t len) override
+    {
+        for (size_t i = 0; i < len; i++)
+            buf[i] = pattern(sent + i);
+        sent += len;
+        return len;
+    }
+
+    size_t port_write(const uint8_t *buf, size_t len) override
+    {
+        for (size_t i = 0; i < len; i++)
+            if (buf[i] != pattern(received + i))
+                corrupt = true;
+        received += len;
+        return len;
+    }
+};
+
+static const telnet_telopt_t no_telopts[] = {{-1, 0, 0}};
+
+static void telnet_event(telnet_t *telnet, telnet_event_t *ev, void *user_data)
+{
+    if (ev->type == TELNET_EV_DATA)
+        ((BenchPort *)user_data)->port_write((const uint8_t *)ev->data.buffer, ev->data.size);
+}
+
+/**
+ * The remote end: swallows and checks len bytes, undoing telnet IAC doubling
+ */
+static void remote_receive(int fd, size_t len, bool telnet, std::atomic<bool> *ok)
+{
+    uint8_t buf[16384];
+    size_t pos = 0;
+    bool iac = false;
+    bool good = true;
+
+    while (pos < len)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            good = false;
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (telnet && buf[i] == TELNET_IAC && !iac)
+            {
+                iac = true;
+                continue;
+            }
+            iac = false;
+            if (buf[i] != pattern(pos))
+                good = false;
+            pos++;
+        }
+    }
+    *ok = good;
+}
+
+/**
+ * The remote end: sends len bytes of the pattern, doubling IACs for telnet
+ */
+static void remote_send(int fd, size_t len, bool telnet)
+{
+    uint8_t buf[16384];
+    size_t pos = 0;
+
+    while (pos < len)
+    {
+        size_t n = 0;
+        while (n < sizeof(buf) - 1 && pos < len)
+        {
+            buf[n++] = pattern(pos);
+            if (telnet && pattern(pos) == TELNET_IAC)
+                buf[n++] = TELNET_IAC;
+            pos++;
+        }
+        if (send(fd, buf, n, MSG_NOSIGNAL) != (ssize_t)n)
+            break;
+    }
+}
+
+static bool run(int listen_fd, uint16_t port, size_t len, bool telnet, bool upload)
+{
+    fnTcpClient tcp;
+    if (!tcp.connect("127.0.0.1", port))
+    {
+        printf("connect failed\n");
+        return false;
+    }
+    int remote = accept(listen_fd, nullptr, nullptr);
+    if (remote < 0)
+    {
+        printf("accept failed\n");
+        return false;
+    }
+
+    BenchPort computer;
+    ModemPump pump(&computer);
+    telnet_t *tel = telnet ? telnet_init(no_telopts, telnet_event, 0, &computer) : nullptr;
+    std::atomic<bool> remote_ok(true);
+
+    std::thread remote_end;
+    if (upload)
+    {
+        computer.to_send = len;
+        remote_end = std::thread(remote_receive, remote, len, telnet, &remote_ok);
+    }
+    else
+        remote_end = std::thread(remote_send, remote, len, telnet);
+
+    uint64_t start = now_ms();
+    uint64_t passes = 0;
+    while (upload ? (computer.sent < len || pump.pending_to_net() > 0) : computer.received < len)
+    {
+        pump.service(tcp, tel, now_ms());
+        passes++;
+        if (!tcp.connected())
+            break;
+    }
+    remote_end.join();
+    uint64_t ms = now_ms() - start;
+    if (ms == 0)
+        ms = 1;
+
+    bool ok = remote_ok && !computer.corrupt && (upload || computer.received == len);
+    double rate = (double)len * 1000 / ms;
+    printf("%-6s %-8s %6.1f MB in %5llu ms: %8.1f MB/s, %7.0f x 115200 baud, %llu passes %s\n",
+           telnet ? "telnet" : "raw", upload ? "to net" : "to port", len / 1048576.0,
+           (unsigned long long)ms, rate / 1048576, rate / BENCH_BAUD_BYTES_PER_SEC,
+           (unsigned long long)passes, ok ? "ok" : "DATA MISMATCH");
+
+    if (tel != nullptr)
+        telnet_free(tel);
+    tcp.stop();
+    close(remote);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    size_t mb = argc > 1 ? atoi(argv[1]) : 64;
+    if (mb == 0)
+        mb = 64;
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 1) < 0 || getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) < 0)
+    {
+        perror("listen");
+        return 1;
+    }
+    uint16_t port = ntohs(addr.sin_port);
+
+    bool ok = true;
+    for (int telnet = 0; telnet < 2; telnet++)
+    {
+        ok &= run(listen_fd, port, mb << 20, telnet, true);
+        ok &= run(listen_fd, port, mb << 20, telnet, false);
+    }
+
+    close(listen_fd);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/**
+ * #FujiNet-PC reactor test
+ *
+ * Checks that the main loop reactor returns from wait() when a watched
+ * descriptor becomes readable, when wake() is called from another thread
+ * and when a wake_in() time has passed, and that a descriptor that's no
+ * longer watched doesn't wake it.
+ *
+ * Then compares the old main loop, which polled the NetSIO socket for 1 ms
+ * and the web server without waiting, with the reactor loop: CPU used while
+ * idle, and how long data written to either socket waits to be seen.
+ *
+ * Build in the FujiNet-PC build directory:
+ *   cmake --build . --target reactor_test && ./reactor_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "fnReactor.h"
+#include "fnSystem.h"
+
+// How long the idle CPU is measured for
+#define TEST_IDLE_MS 2000
+// Writes per socket to measure the wake latency
+#define TEST_WRITES 200
+
+// fnReactor only takes delay() from fnSystem, so the test brings its own
+SystemManager::SystemManager() {}
+void SystemManager::delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+SystemManager fnSystem;
+
+static int failures = 0;
+
+#define CHECK(cond, msg)                                        \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+        {                                                       \
+            printf("FAIL %s:%d %s\n", __FILE__, __LINE__, msg); \
+            failures++;                                         \
+        }                                                       \
+    } while (0)
+
+static uint64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static uint64_t cpu_us()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+struct Pipe
+{
+    int rd = -1;
+    int wr = -1;
+
+    Pipe()
+    {
+        int fds[2];
+        if (pipe(fds) == 0)
+        {
+            rd = fds[0];
+            wr = fds[1];
+            fcntl(rd, F_SETFL, O_NONBLOCK);
+        }
+    }
+    ~Pipe()
+    {
+        close(rd);
+        close(wr);
+    }
+
+    void put(uint64_t stamp) { (void)!write(wr, &stamp, sizeof(stamp)); }
+
+    // Read what's there, the service a loop pass calls; returns the write times seen
+    int take(uint64_t *stamps, int max)
+    {
+        int n = 0;
+        uint64_t stamp;
+        while (n < max && read(rd, &stamp, sizeof(stamp)) == sizeof(stamp))
+            stamps[n++] = stamp;
+        return n;
+    }
+};
+
+// A watched descriptor wakes the loop, and its service sees the data
+static void test_watch()
+{
+    fnReactor.begin();
+    Pipe p;
+    std::atomic<uint64_t> written{0};
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        written = now_us();
+        p.put(written);
+    });
+
+    uint64_t start = now_us(), seen = 0;
+    while (seen == 0 && now_us() - start < 1000000)
+    {
+        uint64_t stamp;
+        if (p.take(&stamp, 1) == 1)
+            seen = now_us();
+        else
+        {
+            fnReactor.watch(p.rd);
+            fnReactor.wait(REACTOR_MAX_WAIT_MS);
+        }
+    }
+    writer.join();
+
+    CHECK(seen != 0, "Service never saw the write");
+    CHECK(seen - written < 10000, "Loop didn't wake when the descriptor became readable");
+    fnReactor.end();
+}
+
+// wake() from another thread ends a wait at once
+static void test_wake()
+{
+    fnReactor.begin();
+    std::thread waker([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        fnReactor.wake();
+    });
+
+    uint64_t start = now_us();
+    fnReactor.wait(2000);
+    uint64_t waited = now_us() - start;
+    waker.join();
+
+    CHECK(waited >= 40000 && waited < 500000, "wake() didn't end the wait");
+    fnReactor.end();
+}
+
+// wake_in() shortens the wait, for one wait only
+static void test_wake_in()
+{
+    fnReactor.begin();
+    fnReactor.wake_in(20);
+    uint64_t start = now_us();
+    CHECK(fnReactor.wait(2000) == 0, "Nothing was ready, wait() should time out");
+    uint64_t waited = now_us() - start;
+    CHECK(waited >= 15000 && waited < 500000, "wake_in() time not kept");
+
+    start = now_us();
+    fnReactor.wait(50);
+    waited = now_us() - start;
+    CHECK(waited >= 40000, "wake_in() applied to the next wait too");
+    fnReactor.end();
+}
+
+// A descriptor not watched again drops out of the set
+static void test_unwatch()
+{
+    fnReactor.begin();
+    Pipe p;
+    fnReactor.watch(p.rd);
+    fnReactor.wait(0);
+
+    p.put(now_us());
+    uint64_t start = now_us();
+    CHECK(fnReactor.wait(50) == 0, "Descriptor no longer watched woke the loop");
+    CHECK(now_us() - start >= 40000, "wait() returned early");
+    fnReactor.end();
+}
+
+struct LoopResult
+{
+    uint64_t passes = 0;
+    uint64_t cpu_us = 0;
+    uint64_t latency_us[2] = {0, 0}; // average, for the NetSIO and the web socket
+    uint64_t latency_max_us[2] = {0, 0};
+};
+
+/*
+ * Run a main loop over two sockets for up to ms, while a thread makes
+ * writes writes to them, taking turns; idle if writes is 0
+ */
+template <typename Pass>
+static LoopResult run_loop(Pass pass, Pipe *pipes, int writes, int ms)
+{
+    LoopResult r;
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        srand(7);
+        for (int i = 0; i < writes && !stop; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(2000 + rand() % 8000));
+            pipes[i % 2].put(now_us());
+        }
+    });
+
+    uint64_t seen[2] = {0, 0};
+    uint64_t start = now_us(), cpu = cpu_us();
+    while (now_us() - start < (uint64_t)ms * 1000 && (writes == 0 || seen[0] + seen[1] < (uint64_t)writes))
+    {
+        pass();
+        r.passes++;
+        for (int i = 0; i < 2; i++)
+        {
+            uint64_t stamps[16];
+            int n = pipes[i].take(stamps, 16);
+            uint64_t t = now_us();
+            for (int k = 0; k < n; k++)
+            {
+                uint64_t latency = t - stamps[k];
+                r.latency_us[i] += latency;
+                if (latency > r.latency_max_us[i])
+                    r.latency_max_us[i] = latency;
+            }
+            seen[i] += n;
+        }
+    }
+    r.cpu_us = cpu_us() - cpu;
+    stop = true;
+    writer.join();
+
+    for (int i = 0; i < 2; i++)
+        if (seen[i] > 0)
+            r.latency_us[i] /= seen[i];
+    if (writes > 0)
+        CHECK(seen[0] + seen[1] == (uint64_t)writes, "Loop missed writes");
+    return r;
+}
+
+// Old main loop: NetSIO poll(1) waits up to 1 ms on its socket, the web server polls without waiting
+static void old_pass(Pipe *pipes)
+{
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(pipes[0].rd, &readfds);
+    timeval tv = {0, 1000};
+    select(pipes[0].rd + 1, &readfds, nullptr, nullptr, &tv);
+}
+
+// Reactor main loop: both services watch their socket, then the loop sleeps
+static void new_pass(Pipe *pipes)
+{
+    fnReactor.watch(pipes[0].rd);
+    fnReactor.watch(pipes[1].rd);
+    fnReactor.wait(REACTOR_MAX_WAIT_MS);
+}
+
+static void report(const char *name, const LoopResult &idle, const LoopResult &busy)
+{
+    printf("%-8s idle: %6.0f passes/s, %5.2f%% CPU   wake latency NetSIO %5llu us (max %5llu), web %5llu us (max %5llu)\n",
+           name, idle.passes * 1000.0 / TEST_IDLE_MS, idle.cpu_us * 100.0 / (TEST_IDLE_MS * 1000.0),
+           (unsigned long long)busy.latency_us[0], (unsigned long long)busy.latency_max_us[0],
+           (unsigned long long)busy.latency_us[1], (unsigned long long)busy.latency_max_us[1]);
+}
+
+int main(int argc, char **argv)
+{
+    test_watch();
+    test_wake();
+    test_wake_in();
+    test_unwatch();
+
+    Pipe pipes[2];
+    LoopResult old_idle = run_loop([&]() { old_pass(pipes); }, pipes, 0, TEST_IDLE_MS);
+    LoopResult old_busy = run_loop([&]() { old_pass(pipes); }, pipes, TEST_WRITES, 10000);
+
+    fnReactor.begin();
+    LoopResult new_idle = run_loop([&]() { new_pass(pipes); }, pipes, 0, TEST_IDLE_MS);
+    LoopResult new_busy = run_loop([&]() { new_pass(pipes); }, pipes, TEST_WRITES, 10000);
+    fnReactor.end();
+
+    report("old", old_idle, old_busy);
+    report("reactor", new_idle, new_busy);
+
+    // Idle, the reactor only wakes for REACTOR_MAX_WAIT_MS
+    CHECK(new_idle.passes <= TEST_IDLE_MS / REACTOR_MAX_WAIT_MS + 2, "Reactor loop didn't sleep while idle");
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -100,6 +100,11 @@ set(CMAKE_CXX_FLAGS_DEBUG "${CMAKE_CXX_FLAGS_DEBUG} -DVERBOSE_HTTP -D__PC_BUILD_
 set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -D${FUJINET_BUILD_PLATFORM} -DMG_TLS=1 -DMG_ENABLE_LOG=0 -DDEV_RELAY_SLIP")
 # MG_TLS needed by mgHttpClient
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DMG_TLS=1")
+# on Linux mongoose keeps its sockets in an epoll set, the main loop (fnReactor) waits on it
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DMG_ENABLE_EPOLL=1")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DMG_ENABLE_EPOLL=1")
+endif()
 # additional debug when investigating TLS issue
 # set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DMG_ENABLE_LOG=1 -DMBEDTLS_X509_CRT_PARSE_C=1 -DMBEDTLS_DEBUG_C=1")
 # set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DMG_ENABLE_LOG=1 -DMBEDTLS_X509_CRT_PARSE_C=1 -DMBEDTLS_DEBUG_C=1")
@@ -122,7 +127,7 @@ set(INCLUDE_DIRS include
     lib/FileSystem
     lib/tcpip lib/ftp lib/TNFSlib lib/telnet lib/fnjson
     lib/webdav lib/http lib/sam lib/task
-    lib/modem-sniffer lib/printer-emulator
+    lib/modem-sniffer lib/modem-pump lib/printer-emulator
     lib/network-protocol
     lib/fuji lib/bus lib/device lib/media
     lib/encrypt lib/base64
@@ -131,6 +136,7 @@ set(INCLUDE_DIRS include
     components_pc/mongoose
     components_pc/miniaudio
     components_pc/cJSON
+    components/lz4/lib
     components_pc/libsmb2/include
     components_pc/libssh/include ${CMAKE_CURRENT_BINARY_DIR}/components_pc/libssh/include
 )
@@ -161,13 +167,16 @@ set(SOURCES src/main.cpp
     lib/utils/peoples_url_parser.h lib/utils/peoples_url_parser.cpp
     lib/utils/punycode.h lib/utils/punycode.cpp
     lib/utils/U8Char.h lib/utils/U8Char.cpp
+    lib/utils/charset.h lib/utils/charset.cpp
     lib/hardware/fnWiFi.h lib/hardware/fnDummyWiFi.h lib/hardware/fnDummyWiFi.cpp
     lib/hardware/led.h lib/hardware/led.cpp
     lib/hardware/fnUART.h lib/hardware/fnUART.cpp
     lib/hardware/fnUARTUnix.cpp lib/hardware/fnUARTWindows.cpp
     lib/hardware/fnSystem.h lib/hardware/fnSystem.cpp lib/hardware/fnSystemNet.cpp
+    lib/hardware/fnReactor.h lib/hardware/fnReactor.cpp
     lib/FileSystem/fnDirCache.h lib/FileSystem/fnDirCache.cpp
     lib/FileSystem/fnFileCache.h lib/FileSystem/fnFileCache.cpp
+    lib/FileSystem/fnBlockCache.h lib/FileSystem/fnBlockCache.cpp
     lib/FileSystem/fnFS.h lib/FileSystem/fnFS.cpp
     lib/FileSystem/fnFsSPIFFS.h lib/FileSystem/fnFsSPIFFS.cpp
     lib/FileSystem/fnFsSD.h lib/FileSystem/fnFsSD.cpp
@@ -179,6 +188,7 @@ set(SOURCES src/main.cpp
     lib/FileSystem/fnFileLocal.h lib/FileSystem/fnFileLocal.cpp
     lib/FileSystem/fnFileTNFS.h lib/FileSystem/fnFileTNFS.cpp
     lib/FileSystem/fnFileSMB.h lib/FileSystem/fnFileSMB.cpp
+    lib/FileSystem/fnFileHTTP.h lib/FileSystem/fnFileHTTP.cpp
     lib/FileSystem/fnFileMem.h lib/FileSystem/fnFileMem.cpp
     lib/FileSystem/fnio.h lib/FileSystem/fnio.cpp
     lib/tcpip/fnDNS.h lib/tcpip/fnDNS.cpp
@@ -187,15 +197,19 @@ set(SOURCES src/main.cpp
     lib/tcpip/fnTcpServer.h lib/tcpip/fnTcpServer.cpp
     lib/ftp/fnFTP.h lib/ftp/fnFTP.cpp
     lib/TNFSlib/tnfslibMountInfo.h lib/TNFSlib/tnfslibMountInfo.cpp
+    lib/TNFSlib/tnfslibDirListing.h lib/TNFSlib/tnfslibDirListing.cpp
     lib/TNFSlib/tnfslib.h lib/TNFSlib/tnfslib.cpp
     lib/TNFSlib/tnfslib_udp.h lib/TNFSlib/tnfslib_udp_testing.cpp
     lib/telnet/libtelnet.h lib/telnet/libtelnet.c
     lib/fnjson/fnjson.h lib/fnjson/fnjson.cpp
+    lib/fnjson/fnJsonStream.h lib/fnjson/fnJsonStream.cpp
     components_pc/mongoose/mongoose.h components_pc/mongoose/mongoose.c
+    components/lz4/lib/lz4.h components/lz4/lib/lz4.c
     lib/webdav/WebDAV.h lib/webdav/WebDAV.cpp
     lib/webdav/IndexParser.h lib/webdav/IndexParser.cpp
     lib/http/httpService.h lib/http/mgHttpService.cpp
     lib/http/httpServiceParser.h lib/http/httpServiceParser.cpp
+    lib/http/httpTemplate.h
     lib/http/httpServiceConfigurator.h lib/http/httpServiceConfigurator.cpp
     lib/http/httpServiceBrowser.h lib/http/httpServiceBrowser.cpp
     lib/http/mgHttpClient.h lib/http/mgHttpClient.cpp
@@ -224,6 +238,7 @@ set(SOURCES src/main.cpp
     lib/network-protocol/networkStatus.h lib/network-protocol/status_error_codes.h
     lib/network-protocol/Protocol.h lib/network-protocol/Protocol.cpp
     lib/network-protocol/ProtocolParser.h lib/network-protocol/ProtocolParser.cpp
+    lib/network-protocol/Translation.h lib/network-protocol/Translation.cpp
     lib/network-protocol/Test.h lib/network-protocol/Test.cpp
     lib/network-protocol/TCP.h lib/network-protocol/TCP.cpp
     lib/network-protocol/UDP.h lib/network-protocol/UDP.cpp
@@ -238,6 +253,7 @@ set(SOURCES src/main.cpp
     lib/fuji/fujiCmd.h
     lib/fuji/fujiHost.h lib/fuji/fujiHost.cpp
     lib/fuji/fujiDisk.h lib/fuji/fujiDisk.cpp
+    lib/fuji/fujiCopy.h lib/fuji/fujiCopy.cpp
     lib/bus/bus.h
     lib/device/device.h
     lib/device/disk.h
@@ -249,9 +265,11 @@ set(SOURCES src/main.cpp
     lib/device/udpstream.h
     lib/device/siocpm.h
     lib/modem-sniffer/modem-sniffer.h lib/modem-sniffer/modem-sniffer.cpp
+    lib/modem-pump/modem-pump.h lib/modem-pump/modem-pump.cpp
     lib/media/media.h
     lib/encoding/base64.h lib/encoding/base64.cpp
     lib/encoding/hash.h lib/encoding/hash.cpp
+    lib/encoding/checksum.h lib/encoding/checksum.cpp
     lib/qrcode/qrcode.h lib/qrcode/qrcode.c
     lib/qrcode/qrmanager.h lib/qrcode/qrmanager.cpp
     lib/encrypt/crypt.h lib/encrypt/crypt.cpp
@@ -496,6 +514,34 @@ add_custom_target(build_version DEPENDS "${CMAKE_BINARY_DIR}/include/build_versi
 add_dependencies(fujinet build_version)
 target_include_directories(fujinet PRIVATE "${CMAKE_BINARY_DIR}/include")
 
+# Modem data pump loopback benchmark, not built by default
+# "modem_pump_bench" target
+if(NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    add_executable(modem_pump_bench EXCLUDE_FROM_ALL
+        bench/modem_pump_bench.cpp
+        lib/modem-pump/modem-pump.cpp
+        lib/tcpip/fnTcpClient.cpp lib/tcpip/fnDNS.cpp
+        lib/compat/compat_inet.c
+        lib/telnet/libtelnet.c
+    )
+    target_compile_definitions(modem_pump_bench PRIVATE UNIT_TESTS)
+    target_include_directories(modem_pump_bench PRIVATE ${INCLUDE_DIRS})
+    target_link_libraries(modem_pump_bench pthread)
+endif()
+
+# Main loop reactor test and wake latency / idle CPU comparison, not built by default
+# "reactor_test" target
+if(NOT CMAKE_SYSTEM_NAME STREQUAL "Windows")
+    add_executable(reactor_test EXCLUDE_FROM_ALL
+        bench/reactor_test.cpp
+        lib/hardware/fnReactor.cpp
+        lib/compat/compat_inet.c
+    )
+    target_compile_definitions(reactor_test PRIVATE UNIT_TESTS)
+    target_include_directories(reactor_test PRIVATE ${INCLUDE_DIRS})
+    target_link_libraries(reactor_test pthread)
+endif()
+
 # WebUI
 # "build_webui" target
 add_custom_command(
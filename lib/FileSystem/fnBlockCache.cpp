@@ -0,0 +1,563 @@
+#include "fnBlockCache.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+#include <mutex>
+
+#include "../../include/debug.h"
+
+#include "fnConfig.h"
+#include "fnFileCache.h"
+#include "fnFsSD.h"
+
+
+// List of cache entries with their size and last use
+#define BLOCK_CACHE_INDEX       BLOCK_CACHE_DIRECTORY "/INDEX.TXT"
+#define BLOCK_CACHE_IDX_MAGIC   "FNBC"
+#define BLOCK_CACHE_IDX_VERSION 1
+// Number of newly cached blocks after which .idx file is updated (don't lose all on power off)
+#define BLOCK_CACHE_IDX_SYNC    64
+
+// Header of <name>.idx file, followed by uint16_t slot for every file block
+typedef struct bc_idx_header
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t block_size;
+    uint32_t size;
+    uint32_t mtime;
+    uint16_t used;
+    uint16_t reserved;
+} bc_idx_header;
+
+typedef struct bc_entry
+{
+    std::string name;
+    uint32_t bytes;
+    uint32_t last_used;
+    bool open;
+} bc_entry;
+
+static std::vector<bc_entry> _entries;
+static bool _entries_loaded = false;
+static uint32_t _use_seq = 0;
+static bc_stats _stats = {};
+// Guards the above: disks are read from the bus task, prefetch and copy tasks alike
+static std::mutex _entries_mutex;
+
+
+static std::string get_entry_path(const std::string &name, const char *ext)
+{
+    return std::string(BLOCK_CACHE_DIRECTORY) + '/' + name + ext;
+}
+
+static uint64_t get_budget()
+{
+    int kb = Config.get_general_blockcache_size();
+    return kb > 0 ? (uint64_t)kb * 1024 : 0;
+}
+
+static uint64_t get_used()
+{
+    uint64_t used = 0;
+    for (const bc_entry &e : _entries)
+        used += e.bytes;
+    return used;
+}
+
+static bc_entry *find_entry(const std::string &name)
+{
+    for (bc_entry &e : _entries)
+    {
+        if (e.name == name)
+            return &e;
+    }
+    return nullptr;
+}
+
+static void load_entries()
+{
+    if (_entries_loaded)
+        return;
+    _entries_loaded = true;
+
+    FileHandler *fh = fnSDFAT.filehandler_open(BLOCK_CACHE_INDEX, "rb");
+    if (fh == nullptr)
+        return;
+
+    std::string data;
+    char buf[256];
+    size_t count;
+    while ((count = fh->read(buf, 1, sizeof(buf))) > 0)
+        data.append(buf, count);
+    fh->close();
+
+    size_t start = 0;
+    while (start < data.size())
+    {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos)
+            end = data.size();
+
+        char name[64];
+        unsigned int bytes, last_used;
+        if (sscanf(data.substr(start, end - start).c_str(), "%63s %u %u", name, &bytes, &last_used) == 3)
+        {
+            _entries.push_back({name, bytes, last_used, false});
+            if (last_used > _use_seq)
+                _use_seq = last_used;
+        }
+        start = end + 1;
+    }
+    Debug_printf("BlockCache: %u entries, %llu bytes\n", (unsigned)_entries.size(), (unsigned long long)get_used());
+}
+
+static void save_entries()
+{
+    FileHandler *fh = fnSDFAT.filehandler_open(BLOCK_CACHE_INDEX, "wb");
+    if (fh == nullptr)
+    {
+        Debug_println("BlockCache - failed to write index");
+        return;
+    }
+
+    char line[96];
+    for (const bc_entry &e : _entries)
+    {
+        int len = snprintf(line, sizeof(line), "%s %u %u\r\n", e.name.c_str(), (unsigned)e.bytes, (unsigned)e.last_used);
+        fh->write(line, 1, len);
+    }
+    fh->close();
+}
+
+// Remove least recently used entry which is not in use
+static bool evict_entry(const std::string &keep)
+{
+    bc_entry *lru = nullptr;
+    for (bc_entry &e : _entries)
+    {
+        if (e.open || e.name == keep)
+            continue;
+        if (lru == nullptr || e.last_used < lru->last_used)
+            lru = &e;
+    }
+    if (lru == nullptr)
+        return false;
+
+    Debug_printf("BlockCache: evicting %s (%u bytes)\n", lru->name.c_str(), (unsigned)lru->bytes);
+    fnSDFAT.remove(get_entry_path(lru->name, ".dat").c_str());
+    fnSDFAT.remove(get_entry_path(lru->name, ".idx").c_str());
+    _entries.erase(_entries.begin() + (lru - _entries.data()));
+    _stats.evictions++;
+    return true;
+}
+
+
+FileHandler *BlockCache::wrap(FileHandler *fh, const char *host, const char *path, uint32_t size, uint32_t mtime)
+{
+    if (fh == nullptr || size == 0)
+        return fh;
+
+    if (!enabled())
+        return fh;
+
+    // too big for 16-bit slots
+    if ((size - 1) / BLOCK_CACHE_BLOCK_SIZE >= BLOCK_CACHE_NO_SLOT)
+        return fh;
+
+    std::unique_lock<std::mutex> lock(_entries_mutex);
+    load_entries();
+
+    // file size and time are part of the name, modified file = new entry
+    std::string key = std::string(path) + '|' + std::to_string(size) + '|' + std::to_string(mtime);
+    std::string name = FileCache::cache_name(host, key.c_str());
+
+    bc_entry *entry = find_entry(name);
+    if (entry != nullptr && entry->open)
+    {
+        // already opened by other handler
+        return fh;
+    }
+
+    uint8_t *block = (uint8_t *)malloc(BLOCK_CACHE_BLOCK_SIZE);
+    if (block == nullptr)
+    {
+        Debug_println("BlockCache::wrap - failed to allocate block buffer");
+        return fh;
+    }
+
+    fnSDFAT.create_path(BLOCK_CACHE_DIRECTORY);
+
+    FileHandler *dat = nullptr;
+    if (entry != nullptr)
+        dat = fnSDFAT.filehandler_open(get_entry_path(name, ".dat").c_str(), "rb+");
+    if (dat == nullptr)
+        dat = fnSDFAT.filehandler_open(get_entry_path(name, ".dat").c_str(), "wb+");
+    if (dat == nullptr)
+    {
+        Debug_println("BlockCache::wrap - failed to open SD file");
+        free(block);
+        return fh;
+    }
+
+    if (entry == nullptr)
+    {
+        _entries.push_back({name, 0, 0, false});
+        entry = &_entries.back();
+    }
+    entry->open = true;
+    entry->last_used = ++_use_seq;
+    lock.unlock();
+
+    Debug_printf("Using SD block cache: %s\n", name.c_str());
+    return new FileHandlerBlockCache(fh, dat, block, name, size, mtime);
+}
+
+bool BlockCache::enabled()
+{
+    return get_budget() != 0 && fnSDFAT.running();
+}
+
+bc_stats BlockCache::stats()
+{
+    std::lock_guard<std::mutex> lock(_entries_mutex);
+    bc_stats s = _stats;
+    s.entries = _entries.size();
+    s.used = get_used();
+    s.budget = get_budget();
+    return s;
+}
+
+bool BlockCache::_reserve(const std::string &name, uint32_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_entries_mutex);
+    uint64_t budget = get_budget();
+    bool evicted = false;
+
+    while (get_used() + bytes > budget)
+    {
+        if (!evict_entry(name))
+            break;
+        evicted = true;
+    }
+    if (evicted)
+        save_entries();
+
+    bc_entry *entry = find_entry(name);
+    if (entry == nullptr || get_used() + bytes > budget)
+        return false;
+
+    entry->bytes += bytes;
+    return true;
+}
+
+void BlockCache::_release(const std::string &name, uint32_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_entries_mutex);
+    bc_entry *entry = find_entry(name);
+    if (entry == nullptr)
+        return;
+
+    entry->bytes = bytes;
+    entry->open = false;
+    entry->last_used = ++_use_seq;
+    save_entries();
+}
+
+void BlockCache::_discard(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(_entries_mutex);
+    bc_entry *entry = find_entry(name);
+    if (entry != nullptr)
+        entry->bytes = 0;
+}
+
+void BlockCache::_count(bool hit)
+{
+    std::lock_guard<std::mutex> lock(_entries_mutex);
+    if (hit)
+        _stats.hits++;
+    else
+        _stats.misses++;
+}
+
+
+FileHandlerBlockCache::FileHandlerBlockCache(FileHandler *fh, FileHandler *dat, uint8_t *block, const std::string &name, uint32_t size, uint32_t mtime)
+{
+    _fh = fh;
+    _dat = dat;
+    _block = block;
+    _name = name;
+    _size = size;
+    _mtime = mtime;
+    _slots.assign((size + BLOCK_CACHE_BLOCK_SIZE - 1) / BLOCK_CACHE_BLOCK_SIZE, BLOCK_CACHE_NO_SLOT);
+
+    if (!_load_index())
+    {
+        // missing or not matching, start over
+        _slots.assign(_slots.size(), BLOCK_CACHE_NO_SLOT);
+        _used = 0;
+        _dirty = true;
+        BlockCache::_discard(_name);
+    }
+}
+
+FileHandlerBlockCache::~FileHandlerBlockCache()
+{
+    if (_fh != nullptr || _dat != nullptr)
+        close(false);
+}
+
+bool FileHandlerBlockCache::_load_index()
+{
+    FileHandler *fh = fnSDFAT.filehandler_open(get_entry_path(_name, ".idx").c_str(), "rb");
+    if (fh == nullptr)
+        return false;
+
+    bc_idx_header hdr;
+    bool valid = fh->read(&hdr, sizeof(hdr), 1) == 1
+        && memcmp(hdr.magic, BLOCK_CACHE_IDX_MAGIC, sizeof(hdr.magic)) == 0
+        && hdr.version == BLOCK_CACHE_IDX_VERSION
+        && hdr.block_size == BLOCK_CACHE_BLOCK_SIZE
+        && hdr.size == _size
+        && hdr.mtime == _mtime
+        && hdr.used <= _slots.size()
+        && fh->read(_slots.data(), sizeof(uint16_t), _slots.size()) == _slots.size();
+    fh->close();
+
+    // blocks referenced by index must be in .dat file
+    if (valid && FileSystem::filesize(_dat) < (long)hdr.used * BLOCK_CACHE_BLOCK_SIZE)
+        valid = false;
+
+    for (size_t i = 0; valid && i < _slots.size(); i++)
+    {
+        if (_slots[i] != BLOCK_CACHE_NO_SLOT && _slots[i] >= hdr.used)
+            valid = false;
+    }
+
+    if (!valid)
+    {
+        Debug_printf("BlockCache: discarding stale index %s\n", _name.c_str());
+        return false;
+    }
+    _used = hdr.used;
+    return true;
+}
+
+void FileHandlerBlockCache::_save_index()
+{
+    _dat->flush();
+
+    FileHandler *fh = fnSDFAT.filehandler_open(get_entry_path(_name, ".idx").c_str(), "wb");
+    if (fh == nullptr)
+    {
+        Debug_println("FileHandlerBlockCache - failed to write index");
+        return;
+    }
+
+    bc_idx_header hdr;
+    memcpy(hdr.magic, BLOCK_CACHE_IDX_MAGIC, sizeof(hdr.magic));
+    hdr.version = BLOCK_CACHE_IDX_VERSION;
+    hdr.block_size = BLOCK_CACHE_BLOCK_SIZE;
+    hdr.size = _size;
+    hdr.mtime = _mtime;
+    hdr.used = _used;
+    hdr.reserved = 0;
+    fh->write(&hdr, sizeof(hdr), 1);
+    fh->write(_slots.data(), sizeof(uint16_t), _slots.size());
+    fh->close();
+    _dirty = false;
+}
+
+// Make block num current, from SD cache if possible
+bool FileHandlerBlockCache::_get_block(uint32_t num)
+{
+    if (num == _block_num)
+        return true;
+
+    uint32_t offset = num * BLOCK_CACHE_BLOCK_SIZE;
+    uint32_t len = _size - offset < BLOCK_CACHE_BLOCK_SIZE ? _size - offset : BLOCK_CACHE_BLOCK_SIZE;
+    uint16_t slot = _slots[num];
+
+    if (slot != BLOCK_CACHE_NO_SLOT)
+    {
+        if (_dat->seek((long)slot * BLOCK_CACHE_BLOCK_SIZE, SEEK_SET) == 0 && _dat->read(_block, 1, len) == len)
+        {
+            BlockCache::_count(true);
+            _block_num = num;
+            _block_len = len;
+            return true;
+        }
+        Debug_printf("FileHandlerBlockCache - failed to read slot %u\n", slot);
+        _slots[num] = BLOCK_CACHE_NO_SLOT;
+        _dirty = true;
+    }
+    return _fetch_block(num);
+}
+
+// Read block num from remote file and store it into SD cache
+bool FileHandlerBlockCache::_fetch_block(uint32_t num)
+{
+    uint32_t offset = num * BLOCK_CACHE_BLOCK_SIZE;
+    uint32_t len = _size - offset < BLOCK_CACHE_BLOCK_SIZE ? _size - offset : BLOCK_CACHE_BLOCK_SIZE;
+
+    _block_num = UINT32_MAX;
+    BlockCache::_count(false);
+
+    if (_remote_pos != (long)offset)
+    {
+        if (_fh->seek(offset, SEEK_SET) != 0)
+        {
+            _remote_pos = -1;
+            return false;
+        }
+        _remote_pos = offset;
+    }
+
+    size_t count = _fh->read(_block, 1, len);
+    _remote_pos += count;
+    if (count == 0)
+        return false;
+
+    _block_num = num;
+    _block_len = count;
+
+    // do not cache incomplete block
+    if (count != len || !_caching)
+        return true;
+
+    if (!BlockCache::_reserve(_name, BLOCK_CACHE_BLOCK_SIZE))
+    {
+        Debug_println("FileHandlerBlockCache - cache is full");
+        _caching = false;
+        return true;
+    }
+
+    // blocks in .dat are always full size, pad the last one
+    if (len < BLOCK_CACHE_BLOCK_SIZE)
+        memset(_block + len, 0, BLOCK_CACHE_BLOCK_SIZE - len);
+
+    if (_dat->seek((long)_used * BLOCK_CACHE_BLOCK_SIZE, SEEK_SET) != 0
+        || _dat->write(_block, 1, BLOCK_CACHE_BLOCK_SIZE) != BLOCK_CACHE_BLOCK_SIZE)
+    {
+        Debug_println("FileHandlerBlockCache - SD write failed");
+        _caching = false;
+        return true;
+    }
+
+    _slots[num] = _used++;
+    _dirty = true;
+    if (_used % BLOCK_CACHE_IDX_SYNC == 0)
+        _save_index();
+
+    return true;
+}
+
+int FileHandlerBlockCache::close(bool destroy)
+{
+    int result = 0;
+
+    if (_dat != nullptr)
+    {
+        if (_dirty)
+            _save_index();
+        _dat->close();
+        _dat = nullptr;
+        BlockCache::_release(_name, (uint32_t)_used * BLOCK_CACHE_BLOCK_SIZE);
+    }
+    if (_fh != nullptr)
+    {
+        result = _fh->close();
+        _fh = nullptr;
+    }
+    if (_block != nullptr)
+    {
+        free(_block);
+        _block = nullptr;
+    }
+    if (destroy) delete this;
+    return result;
+}
+
+int FileHandlerBlockCache::seek(long int off, int whence)
+{
+    long pos;
+    switch (whence)
+    {
+    case SEEK_SET:
+        pos = off;
+        break;
+    case SEEK_CUR:
+        pos = (long)_pos + off;
+        break;
+    case SEEK_END:
+        pos = (long)_size + off;
+        break;
+    default:
+        pos = -1;
+    }
+    if (pos < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    _pos = pos;
+    errno = 0;
+    return 0;
+}
+
+long int FileHandlerBlockCache::tell()
+{
+    return _pos;
+}
+
+size_t FileHandlerBlockCache::read(void *ptr, size_t size, size_t n)
+{
+    size_t bytes_requested = size * n;
+    if (bytes_requested == 0)
+        return 0;
+
+    size_t total_bytes_read = 0;
+    while (total_bytes_read < bytes_requested && _pos < _size)
+    {
+        uint32_t num = _pos / BLOCK_CACHE_BLOCK_SIZE;
+        if (!_get_block(num))
+            break;
+
+        uint32_t off = _pos - num * BLOCK_CACHE_BLOCK_SIZE;
+        if (off >= _block_len)
+            break;
+
+        size_t count = _block_len - off;
+        if (count > bytes_requested - total_bytes_read)
+            count = bytes_requested - total_bytes_read;
+
+        memcpy((uint8_t *)ptr + total_bytes_read, _block + off, count);
+        total_bytes_read += count;
+        _pos += count;
+    }
+    return bytes_requested == total_bytes_read ? n : total_bytes_read / size;
+}
+
+size_t FileHandlerBlockCache::write(const void *ptr, size_t size, size_t n)
+{
+    // only read-only files are cached
+    errno = EROFS;
+    return 0;
+}
+
+int FileHandlerBlockCache::flush()
+{
+    return 0;
+}
+
+int FileHandlerBlockCache::eof()
+{
+    return _pos >= _size;
+}
+
+#endif //!FNIO_IS_STDIO
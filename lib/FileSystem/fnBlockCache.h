@@ -0,0 +1,116 @@
+#ifndef FN_BLOCKCACHE_H
+#define FN_BLOCKCACHE_H
+
+#include "fnio.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Directory on SD card used for cached blocks of remote files
+#define BLOCK_CACHE_DIRECTORY   "/FujiNet/cache/blocks"
+#define BLOCK_CACHE_BLOCK_SIZE  4096
+// Slot value of a block which is not (yet) in the cache
+#define BLOCK_CACHE_NO_SLOT     0xFFFF
+
+
+typedef struct bc_stats
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t entries;
+    uint64_t used;
+    uint64_t budget;
+} bc_stats;
+
+
+/*
+ * Persistent SD card cache of fixed size blocks read from remote (TNFS/SMB)
+ * files. Each cached file is identified by host, path, size and modification
+ * time, so a changed file on the server gets a new entry and the stale one
+ * ages out. Entries are evicted least recently used first to stay within
+ * the [General] blockcache_size budget.
+ *
+ * Per entry, <name>.dat holds blocks in the order they were fetched and
+ * <name>.idx maps file block numbers to slots in the .dat file.
+ */
+class BlockCache
+{
+public:
+   /**
+    * @brief Wrap read-only remote file handler with a block caching handler
+    * @param fh opened remote file handler, owned by returned handler on success
+    * @param host host identification (name, port, share ...)
+    * @param path file path on host
+    * @param size file size
+    * @param mtime file modification time
+    * @return caching file handler, or fh itself if the file can't be cached
+    */
+    static FileHandler *wrap(FileHandler *fh, const char *host, const char *path, uint32_t size, uint32_t mtime);
+
+   /**
+    * @brief Check whether the cache has a budget and an SD card to use,
+    *        so callers can skip asking the server for the file size and time
+    */
+    static bool enabled();
+
+   /**
+    * @brief Get cache statistics (since boot) and usage
+    */
+    static bc_stats stats();
+
+private:
+    friend class FileHandlerBlockCache;
+
+    static bool _reserve(const std::string &name, uint32_t bytes);
+    static void _release(const std::string &name, uint32_t bytes);
+    static void _discard(const std::string &name);
+    static void _count(bool hit);
+};
+
+
+class FileHandlerBlockCache : public FileHandler
+{
+protected:
+    FileHandler *_fh;       // remote file
+    FileHandler *_dat;      // cached blocks on SD
+    std::string _name;
+    uint32_t _size;
+    uint32_t _mtime;
+    uint32_t _pos = 0;
+    long _remote_pos = 0;
+
+    std::vector<uint16_t> _slots;
+    uint16_t _used = 0;
+    bool _dirty = false;
+    bool _caching = true;
+
+    // last block read, from SD or remote
+    uint8_t *_block = nullptr;
+    uint32_t _block_num = UINT32_MAX;
+    uint32_t _block_len = 0;
+
+    bool _load_index();
+    void _save_index();
+    bool _get_block(uint32_t num);
+    bool _fetch_block(uint32_t num);
+
+public:
+    FileHandlerBlockCache(FileHandler *fh, FileHandler *dat, uint8_t *block, const std::string &name, uint32_t size, uint32_t mtime);
+    virtual ~FileHandlerBlockCache() override;
+
+    virtual int close(bool destroy=true) override;
+    virtual int seek(long int off, int whence) override;
+    virtual long int tell() override;
+    virtual size_t read(void *ptr, size_t size, size_t n) override;
+    virtual size_t write(const void *ptr, size_t size, size_t n) override;
+    virtual int flush() override;
+    virtual int eof() override;
+};
+
+#endif //!FNIO_IS_STDIO
+
+#endif // FN_BLOCKCACHE_H
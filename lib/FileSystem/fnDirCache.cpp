@@ -1,6 +1,7 @@
 
 #include "fnDirCache.h"
 
+#include <cctype>
 #include <cstring>
 #include <algorithm>
 #include "compat_string.h"
@@ -8,45 +9,39 @@
 #include "utils.h"
 
 
-bool _fsdir_sort_name_ascend(const fsdir_entry* left, const fsdir_entry* right)
+// First 8 characters of name, lower case, first in the top byte, so the keys
+// compare like strcasecmp() does up to there
+static uint64_t _fsdir_name_key(const char *name)
 {
-    if (left->isDir == right->isDir)
-        return strcasecmp(left->filename, right->filename) < 0;
-    else
-        return left->isDir;
-}
-
-bool _fsdir_sort_name_descend(const fsdir_entry* left, const fsdir_entry* right)
-{
-    if (left->isDir == right->isDir)
-        return strcasecmp(left->filename, right->filename) > 0;
-    else
-        return left->isDir;
-}
-
-bool _fsdir_sort_time_ascend(const fsdir_entry* left, const fsdir_entry* right)
-{
-    if (left->isDir == right->isDir)
-        return left->modified_time > right->modified_time;
-    else
-        return left->isDir;
+    uint64_t key = 0;
+    bool end = false;
+    for (int i = 0; i < 8; i++)
+    {
+        end = end || name[i] == '\0';
+        key = (key << 8) | (end ? 0 : (uint8_t)tolower((uint8_t)name[i]));
+    }
+    return key;
 }
 
-bool _fsdir_sort_time_descend(const fsdir_entry* left, const fsdir_entry* right)
+bool DirCache::sort_compare::operator()(const sort_key &left, const sort_key &right) const
 {
-    if (left->isDir == right->isDir)
-        return left->modified_time < right->modified_time;
-    else
-        return left->isDir;
+    if (left.isDir != right.isDir)
+        return left.isDir;
+    if (left.key != right.key)
+        return reverse ? left.key > right.key : left.key < right.key;
+    // Names only differ after the key if they're longer than it
+    if (!by_name || (left.key & 0xff) == 0)
+        return false;
+    int cmp = strcasecmp(entries[left.index].filename, entries[right.index].filename);
+    return reverse ? cmp > 0 : cmp < 0;
 }
 
-typedef bool (*sort_fn_t)(const fsdir_entry* left, const fsdir_entry* right);
-
 
 void DirCache::clear()
 {
-    _entries_filtered.clear();
-    _entries_filtered.shrink_to_fit();
+    _view = nullptr;
+    _views.clear();
+    _views.shrink_to_fit();
     _entries.clear();
     _entries.shrink_to_fit();
     _current = 0;
@@ -54,12 +49,40 @@ void DirCache::clear()
 
 fsdir_entry &DirCache::new_entry()
 {
+    // listings don't include the new entry
+    if (!_views.empty())
+    {
+        _view = nullptr;
+        _views.clear();
+    }
     _entries.push_back(fsdir_entry());
     return _entries.back();
 }
 
-void DirCache::apply_filter(const char *pattern, uint16_t diropts)
+// Filters entries with pattern, into the least recently used view
+DirCache::view &DirCache::new_view(const char *pattern, uint16_t diropts)
 {
+    view *v;
+    if (_views.size() < DIRCACHE_VIEWS)
+    {
+        _views.reserve(DIRCACHE_VIEWS); // keep _view valid
+        _views.emplace_back();
+        v = &_views.back();
+    }
+    else
+    {
+        v = &_views[0];
+        for (view &o : _views)
+        {
+            if (o.last_used < v->last_used)
+                v = &o;
+        }
+    }
+
+    v->pattern = pattern != nullptr ? pattern : "";
+    v->diropts = diropts;
+    v->keys.clear();
+
 	char realpat[MAX_PATHLEN];
 	//char *thepat = nullptr;
     bool have_pattern = pattern != nullptr && pattern[0] != '\0';
@@ -70,8 +93,7 @@ void DirCache::apply_filter(const char *pattern, uint16_t diropts)
 	}
 	//thepat = filter_dirs ? realpat : (char *)pattern;
 
-    _entries_filtered.clear();
-    _entries_filtered.shrink_to_fit();
+    bool by_name = !(diropts & DIR_OPTION_FILEDATE);
 
     // Filter directory entries
     for (unsigned i=0; i<_entries.size(); ++i)
@@ -82,37 +104,105 @@ void DirCache::apply_filter(const char *pattern, uint16_t diropts)
             !entry.isDir || (entry.isDir && filter_dirs)
             ) && util_wildcard_match(entry.filename, pattern) == false)
             continue;
-        _entries_filtered.push_back(&entry);
-    }
 
-    // Choose the appropriate sorting function
-    sort_fn_t sortfn;
-    if (diropts & DIR_OPTION_FILEDATE)
-    {
-        sortfn = (diropts & DIR_OPTION_DESCENDING) ? _fsdir_sort_time_descend : _fsdir_sort_time_ascend;
+        // Fold the sort key once instead of on every comparison
+        sort_key k;
+        if (by_name)
+            k.key = _fsdir_name_key(entry.filename);
+        else
+            k.key = (uint64_t)(int64_t)entry.modified_time ^ 0x8000000000000000ULL; // signed order
+        k.index = i;
+        k.isDir = entry.isDir;
+        v->keys.push_back(k);
     }
-    else
+    v->keys.shrink_to_fit();
+
+    v->sorted.assign(v->keys.size(), 0);
+    v->sorted.shrink_to_fit();
+    return *v;
+}
+
+void DirCache::apply_filter(const char *pattern, uint16_t diropts)
+{
+    if (pattern == nullptr)
+        pattern = "";
+
+    // Reuse the listing if it was made before
+    _view = nullptr;
+    for (view &v : _views)
     {
-        sortfn = (diropts & DIR_OPTION_DESCENDING) ? _fsdir_sort_name_descend : _fsdir_sort_name_ascend;
+        if (v.diropts == diropts && v.pattern == pattern)
+        {
+            _view = &v;
+            break;
+        }
     }
+    if (_view == nullptr)
+        _view = &new_view(pattern, diropts);
+    _view->last_used = ++_use_counter;
 
-    // Sort directory entries
-    std::sort(_entries_filtered.begin(), _entries_filtered.end(), sortfn);
+    _next_sort = UINT32_MAX;
+    _window = DIRCACHE_SORT_WINDOW;
     // rewind read cursor
     _current = 0;
 }
 
+/*
+ Makes sure position pos holds its entry. Instead of sorting everything,
+ the entries up to pos are split off with nth_element and a window from
+ pos on is sorted. The window doubles while reading goes on from where the
+ last one ended, so reading the whole listing costs about as much as a
+ full sort.
+*/
+void DirCache::sort_to(uint32_t pos)
+{
+    dc_vector<sort_key> &keys = _view->keys;
+    dc_vector<uint8_t> &sorted = _view->sorted;
+    if (sorted[pos])
+        return;
+
+    // The unsorted gap holding pos
+    uint32_t lo = pos;
+    while (lo > 0 && !sorted[lo - 1])
+        lo--;
+    uint32_t hi = pos + 1;
+    const uint8_t *next = (const uint8_t *)memchr(sorted.data() + hi, 1, keys.size() - hi);
+    hi = next != nullptr ? next - sorted.data() : keys.size();
+
+    if (pos == _next_sort)
+        _window *= 2;
+    else
+        _window = DIRCACHE_SORT_WINDOW;
+    uint32_t end = hi - pos > _window ? pos + _window : hi;
+
+    sort_compare cmp;
+    cmp.entries = _entries.data();
+    cmp.by_name = !(_view->diropts & DIR_OPTION_FILEDATE);
+    // Order as before: names A-Z or dates newest first, unless descending
+    cmp.reverse = (_view->diropts & DIR_OPTION_FILEDATE) ? !(_view->diropts & DIR_OPTION_DESCENDING)
+                                                          : (_view->diropts & DIR_OPTION_DESCENDING);
+
+    if (pos > lo)
+        std::nth_element(keys.begin() + lo, keys.begin() + pos, keys.begin() + hi, cmp);
+    std::partial_sort(keys.begin() + pos, keys.begin() + end, keys.begin() + hi, cmp);
+    memset(sorted.data() + pos, 1, end - pos);
+    _next_sort = end;
+}
+
 fsdir_entry *DirCache::read()
 {
-    if(_current < _entries_filtered.size())
-        return _entries_filtered[_current++];
+    if(_view != nullptr && _current < _view->keys.size())
+    {
+        sort_to(_current);
+        return &_entries[_view->keys[_current++].index];
+    }
     else
         return nullptr;
 }
 
 uint16_t DirCache::tell()
 {
-    if(_entries_filtered.empty())
+    if(_view == nullptr || _view->keys.empty())
         return FNFS_INVALID_DIRPOS;
     else
         return _current;
@@ -120,7 +210,7 @@ uint16_t DirCache::tell()
 
 bool DirCache::seek(uint16_t pos)
 {
-    if(pos <= _entries_filtered.size())
+    if(_view != nullptr && pos <= _view->keys.size())
     {
         _current = pos;
         return true;
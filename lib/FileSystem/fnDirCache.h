@@ -1,6 +1,7 @@
 #ifndef FN_DIRCACHE_H
 #define FN_DIRCACHE_H
 
+#include <string>
 #include <vector>
 
 #ifdef ESP_PLATFORM
@@ -9,18 +10,63 @@
 
 #include "fnFS.h"
 
+// Filtered and sorted listings kept, for switching between patterns or sort orders
+#define DIRCACHE_VIEWS 4
+// Entries sorted at a time when reading, doubled while reading on
+#define DIRCACHE_SORT_WINDOW 32
+
 class DirCache
 {
 private:
 #ifdef ESP_PLATFORM
-    std::vector<fsdir_entry,PSRAMAllocator<fsdir_entry>> _entries;
-    std::vector<fsdir_entry *,PSRAMAllocator<fsdir_entry *>> _entries_filtered;
+    template <typename T> using dc_vector = std::vector<T, PSRAMAllocator<T>>;
 #else
-    std::vector<fsdir_entry> _entries;
-    std::vector<fsdir_entry *> _entries_filtered;
+    template <typename T> using dc_vector = std::vector<T>;
 #endif
+
+    // Entry as it's sorted: directories first, then by key
+    struct sort_key
+    {
+        uint64_t key;   // name prefix folded to lower case, or modified time
+        uint32_t index; // in _entries
+        bool isDir;
+    };
+
+    struct sort_compare
+    {
+        const fsdir_entry *entries;
+        bool by_name;
+        bool reverse;
+
+        bool operator()(const sort_key &left, const sort_key &right) const;
+    };
+
+    /*
+     * Entries matching a pattern, in the order for diropts. Sorting is done
+     * when entries are read: sorted[i] is set when position i holds its final
+     * entry, and the entries between two sorted positions are the ones
+     * belonging there, in any order.
+     */
+    struct view
+    {
+        std::string pattern;
+        uint16_t diropts = 0;
+        uint32_t last_used = 0;
+        dc_vector<sort_key> keys;
+        dc_vector<uint8_t> sorted;
+    };
+
+    dc_vector<fsdir_entry> _entries;
+    std::vector<view> _views;
+    view *_view = nullptr;
+    uint32_t _use_counter = 0;
+    uint32_t _next_sort = 0; // position after the last window sorted
+    uint32_t _window = DIRCACHE_SORT_WINDOW;
     uint16_t _current = 0;
 
+    view &new_view(const char *pattern, uint16_t diropts);
+    void sort_to(uint32_t pos);
+
 public:
     // DirCache();
     // ~DirCache();
@@ -36,4 +82,4 @@ public:
     bool seek(uint16_t pos);
 };
 
-#endif // FN_DIRCACHE_H
\ No newline at end of file
+#endif // FN_DIRCACHE_H
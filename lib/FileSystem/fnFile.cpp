@@ -1,8 +1,74 @@
 
 #include "fnFile.h"
 
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
 #include "../../include/debug.h"
 
-// nothing to do in base class
+// Largest run of adjacent ranges read at once (size of temporary buffer)
+#define READV_MAX_SPAN 16384
 
 FileHandler::~FileHandler() {};
+
+
+size_t FileHandler::read_at(void *ptr, size_t len, long int offset)
+{
+    if (seek(offset, SEEK_SET) != 0)
+        return 0;
+    return read(ptr, 1, len);
+}
+
+
+size_t FileHandler::readv(fnFileRange *ranges, size_t count)
+{
+    size_t total = 0;
+    size_t i = 0;
+
+    while (i < count)
+    {
+        // Collect run of ranges following each other in the file
+        size_t span = ranges[i].len;
+        bool in_place = true; // and in memory
+        size_t j = i + 1;
+        while (j < count
+               && ranges[j].offset == ranges[j - 1].offset + (long int)ranges[j - 1].len
+               && span + ranges[j].len <= READV_MAX_SPAN)
+        {
+            if ((uint8_t *)ranges[j].buf != (uint8_t *)ranges[j - 1].buf + ranges[j - 1].len)
+                in_place = false;
+            span += ranges[j].len;
+            j++;
+        }
+
+        uint8_t *buf = in_place ? (uint8_t *)ranges[i].buf : (uint8_t *)malloc(span);
+        if (buf == nullptr)
+        {
+            // No memory for the run, read ranges one by one
+            buf = (uint8_t *)ranges[i].buf;
+            span = ranges[i].len;
+            in_place = true;
+            j = i + 1;
+        }
+
+        size_t got = read_at(buf, span, ranges[i].offset);
+        total += got;
+
+        // Distribute the data
+        size_t pos = 0;
+        for (; i < j; i++)
+        {
+            size_t n = got - pos < ranges[i].len ? got - pos : ranges[i].len;
+            if (!in_place)
+                memcpy(ranges[i].buf, buf + pos, n);
+            ranges[i].done = n;
+            pos += n;
+        }
+
+        if (!in_place)
+            free(buf);
+    }
+    return total;
+}
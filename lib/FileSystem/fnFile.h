@@ -3,6 +3,17 @@
 
 #include <cstddef>
 
+/*
+ * One range of a batched read, see FileHandler::readv()
+ */
+struct fnFileRange
+{
+    long int offset;    // file offset to read from
+    void *buf;          // destination
+    size_t len;         // bytes wanted
+    size_t done;        // bytes read (set by readv)
+};
+
 /* 
  * FileHandler - abstraction of FILE from stdio
  * it allows to implement other file protocols at application layer
@@ -23,6 +34,15 @@ public:
     virtual size_t write(const void *ptr, size_t size, size_t n) = 0;
     virtual int flush() = 0;
     virtual int eof() {return 0;}; // TODO!
+
+    // Read list of ranges in one call (like preadv).
+    // Consecutive entries which are adjacent in the file are read with single request.
+    // Returns total number of bytes read, file position is undefined afterwards.
+    virtual size_t readv(fnFileRange *ranges, size_t count);
+
+protected:
+    // Read len bytes from offset (like pread), used by readv()
+    virtual size_t read_at(void *ptr, size_t len, long int offset);
 };
 
 #endif // FN_FILE_H
@@ -84,6 +84,11 @@ static std::string encode_host_path(const char *host, const char *path)
     return result;
 }
 
+std::string FileCache::cache_name(const char *host, const char *path)
+{
+    return encode_host_path(host, path);
+}
+
 static std::string get_file_path(const std::string &name)
 {
     return std::string(FILE_CACHE_DIRECTORY) + '/' + name;
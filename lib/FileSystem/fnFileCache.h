@@ -64,6 +64,12 @@ public:
     * fc_handle is deleted and cannot be used anymore.
     */
    static void remove(fc_handle *fc);
+
+   /**
+    * @brief Encode host and path into a name suitable for SD cache files
+    * @return encoded name (no directory, no extension)
+    */
+   static std::string cache_name(const char *host, const char *path);
 };
 
 #endif //!FNIO_IS_STDIO
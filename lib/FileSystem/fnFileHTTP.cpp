@@ -0,0 +1,338 @@
+#include "fnFileHTTP.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+#include "../../include/debug.h"
+
+#include "fnSystem.h"
+#include "utils.h"
+
+// http timeout in ms
+#define HTTP_GET_TIMEOUT 20000
+
+
+FileHandlerHTTP::FileHandlerHTTP(HTTP_CLIENT_CLASS *http)
+{
+    Debug_println("new FileHandlerHTTP");
+    _http = http;
+#ifdef ESP_PLATFORM
+    _psram = fnSystem.get_psram_size() > 0;
+    if (!_psram)
+        _cache_blocks = HTTP_RANGE_CACHE_BLOCKS_NO_PSRAM;
+#endif
+}
+
+
+FileHandlerHTTP::~FileHandlerHTTP()
+{
+    Debug_println("delete FileHandlerHTTP");
+    if (_http != nullptr) close(false);
+}
+
+
+FileHandler *FileHandlerHTTP::open(const std::string &url)
+{
+    HTTP_CLIENT_CLASS *http = new HTTP_CLIENT_CLASS();
+    if (http == nullptr)
+        return nullptr;
+    if (!http->begin(url))
+    {
+        Debug_println("FileHandlerHTTP::open - failed to start HTTP client");
+        delete http;
+        return nullptr;
+    }
+
+    // Ask for the first block, the response tells us the file size
+    FileHandlerHTTP *fh = new FileHandlerHTTP(http);
+    int status;
+    if (fh->_fetch(0, 1, &status))
+    {
+        Debug_printf("FileHandlerHTTP::open - %s, %lu bytes\r\n", url.c_str(), (unsigned long)fh->_size);
+        return fh;
+    }
+
+    if (status == 416 && fh->_size == 0)
+    {
+        // nothing to read from an empty file
+        Debug_printf("FileHandlerHTTP::open - %s, empty\r\n", url.c_str());
+        return fh;
+    }
+
+    if (status == 200)
+        Debug_println("FileHandlerHTTP::open - server doesn't support Range requests");
+    fh->close();
+    return nullptr;
+}
+
+
+int FileHandlerHTTP::close(bool destroy)
+{
+    Debug_println("FileHandlerHTTP::close");
+    if (_http != nullptr)
+    {
+        delete _http;
+        _http = nullptr;
+    }
+    for (http_block &b : _blocks)
+    {
+        free(b.data);
+        b.data = nullptr;
+        b.num = UINT32_MAX;
+    }
+    if (destroy) delete this;
+    return 0;
+}
+
+
+int FileHandlerHTTP::seek(long int off, int whence)
+{
+    long int pos;
+    switch (whence)
+    {
+    case SEEK_SET:
+        pos = off;
+        break;
+    case SEEK_CUR:
+        pos = (long int)_pos + off;
+        break;
+    case SEEK_END:
+        pos = (long int)_size + off;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+    if (pos < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    _pos = pos;
+    errno = 0;
+    return 0;
+}
+
+
+long int FileHandlerHTTP::tell()
+{
+    return _pos;
+}
+
+
+size_t FileHandlerHTTP::read(void *ptr, size_t size, size_t n)
+{
+    size_t bytes_requested = size * n;
+    if (bytes_requested == 0)
+        return 0;
+
+    size_t total = 0;
+    while (total < bytes_requested && _pos < _size)
+    {
+        http_block *b = _get_block(_pos / HTTP_RANGE_BLOCK_SIZE);
+        if (b == nullptr)
+        {
+            errno = EIO;
+            break;
+        }
+        uint32_t offset = _pos % HTTP_RANGE_BLOCK_SIZE;
+        if (offset >= b->len)
+            break; // server sent less than expected
+        size_t len = b->len - offset;
+        if (len > bytes_requested - total)
+            len = bytes_requested - total;
+        memcpy((uint8_t *)ptr + total, b->data + offset, len);
+        total += len;
+        _pos += len;
+    }
+    return bytes_requested == total ? n : total / size;
+}
+
+
+size_t FileHandlerHTTP::write(const void *ptr, size_t size, size_t n)
+{
+    errno = EBADF;
+    return 0;
+}
+
+
+int FileHandlerHTTP::flush()
+{
+    return 0;
+}
+
+
+int FileHandlerHTTP::eof()
+{
+    return _pos >= _size;
+}
+
+
+FileHandlerHTTP::http_block *FileHandlerHTTP::_find_block(uint32_t num)
+{
+    for (uint32_t i = 0; i < _cache_blocks; i++)
+    {
+        if (_blocks[i].num == num)
+            return &_blocks[i];
+    }
+    return nullptr;
+}
+
+
+// Returns block from memory or server, nullptr on error
+FileHandlerHTTP::http_block *FileHandlerHTTP::_get_block(uint32_t num)
+{
+    http_block *b = _find_block(num);
+    if (b == nullptr)
+    {
+        // Double the read-ahead while reads continue where the last fetch ended
+        if (num == _next_block)
+        {
+            _readahead *= 2;
+            if (_readahead > HTTP_RANGE_READAHEAD)
+                _readahead = HTTP_RANGE_READAHEAD;
+            // a fetch must not push out its own first block
+            if (_readahead > _cache_blocks)
+                _readahead = _cache_blocks;
+        }
+        else
+            _readahead = 1;
+
+        uint32_t count = 1;
+        uint32_t last = (_size - 1) / HTTP_RANGE_BLOCK_SIZE;
+        while (count < _readahead && num + count <= last && _find_block(num + count) == nullptr)
+            count++;
+
+        int status;
+        if (!_fetch(num, count, &status))
+            return nullptr;
+        b = _find_block(num);
+        if (b == nullptr)
+            return nullptr;
+    }
+    b->last_used = ++_use_counter;
+    return b;
+}
+
+
+/*
+ Requests count blocks starting at block num with a single Range request
+ and stores them in the least recently used slots.
+ On the first request (size not known yet) also sets _size.
+ Returns false on error, status is set to the HTTP status code.
+*/
+bool FileHandlerHTTP::_fetch(uint32_t num, uint32_t count, int *status)
+{
+    uint32_t first = num * HTTP_RANGE_BLOCK_SIZE;
+    uint32_t last = (num + count) * HTTP_RANGE_BLOCK_SIZE - 1;
+    if (_size > 0 && last >= _size)
+        last = _size - 1;
+
+    char range[40];
+    snprintf(range, sizeof(range), "bytes=%lu-%lu", (unsigned long)first, (unsigned long)last);
+    Debug_printf("FileHandlerHTTP::_fetch %s\r\n", range);
+
+    _http->set_header("Range", range);
+    _http->create_empty_stored_headers({"Content-Range"});
+    *status = _http->GET();
+
+    uint32_t cr_first, cr_last, cr_total;
+    bool have_range = util_parse_content_range(_http->get_header("Content-Range").c_str(), &cr_first, &cr_last, &cr_total);
+
+    if (*status != 206)
+    {
+        if (*status == 416 && have_range)
+            _size = cr_total;
+        Debug_printf("FileHandlerHTTP::_fetch - HTTP status %d\r\n", *status);
+        return false;
+    }
+    if (!have_range || cr_first != first || cr_total == 0)
+    {
+        Debug_println("FileHandlerHTTP::_fetch - missing or unexpected Content-Range");
+        return false;
+    }
+    _size = cr_total;
+    last = cr_last;
+
+    while (first <= last)
+    {
+        // Take least recently used slot
+        http_block *b = &_blocks[0];
+        for (uint32_t i = 1; i < _cache_blocks; i++)
+        {
+            if (_blocks[i].last_used < b->last_used)
+                b = &_blocks[i];
+        }
+
+        if (b->data == nullptr)
+        {
+#ifdef ESP_PLATFORM
+            b->data = (uint8_t *)heap_caps_malloc(HTTP_RANGE_BLOCK_SIZE,
+                _psram ? MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM : MALLOC_CAP_DEFAULT);
+#else
+            b->data = (uint8_t *)malloc(HTTP_RANGE_BLOCK_SIZE);
+#endif
+            if (b->data == nullptr)
+            {
+                Debug_println("FileHandlerHTTP::_fetch - failed to allocate block");
+                return false;
+            }
+        }
+
+        uint32_t len = last - first + 1;
+        if (len > HTTP_RANGE_BLOCK_SIZE)
+            len = HTTP_RANGE_BLOCK_SIZE;
+        b->num = UINT32_MAX;
+        b->len = _read_body(b->data, len);
+        if (b->len == 0)
+            return false;
+        b->num = first / HTTP_RANGE_BLOCK_SIZE;
+        b->last_used = ++_use_counter;
+        if (b->len < len)
+            break; // response ended early
+        first += len;
+    }
+
+    _next_block = last / HTTP_RANGE_BLOCK_SIZE + 1;
+    return true;
+}
+
+
+// Reads up to len bytes of response body, less if the response ends or times out
+size_t FileHandlerHTTP::_read_body(uint8_t *buf, size_t len)
+{
+    int tmout_counter = 1 + HTTP_GET_TIMEOUT / 50;
+    size_t total = 0;
+
+    while (total < len)
+    {
+        int available = _http->available();
+        if (available < 0)
+            break;
+        if (available == 0)
+        {
+            if (_http->is_transaction_done() || --tmout_counter == 0)
+                break;
+            fnSystem.delay(50); // wait
+            continue;
+        }
+
+        int to_read = (size_t)available > len - total ? len - total : available;
+        int from_read = _http->read(buf + total, to_read);
+        if (from_read <= 0)
+            break;
+        total += from_read;
+        tmout_counter = 1 + HTTP_GET_TIMEOUT / 50; // reset timeout counter
+    }
+    return total;
+}
+
+#endif //!FNIO_IS_STDIO
@@ -0,0 +1,91 @@
+#ifndef FN_FILEHTTP_H
+#define FN_FILEHTTP_H
+
+#include "fnio.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include <cstdint>
+#include <string>
+
+#ifdef ESP_PLATFORM
+#include "fnHttpClient.h"
+#define HTTP_CLIENT_CLASS fnHttpClient
+#else
+#include "mgHttpClient.h"
+#define HTTP_CLIENT_CLASS mgHttpClient
+#endif
+
+#include "fnFile.h"
+
+// Size of blocks requested with HTTP Range and kept in memory
+#define HTTP_RANGE_BLOCK_SIZE   4096
+// Number of blocks kept, least recently used are dropped first
+#define HTTP_RANGE_CACHE_BLOCKS 16
+// Number kept on boards without PSRAM, where they take internal RAM
+#define HTTP_RANGE_CACHE_BLOCKS_NO_PSRAM 2
+// Most blocks fetched with one request when reading sequentially
+#define HTTP_RANGE_READAHEAD    8
+
+
+/*
+ * Read-only file on a web server, fetched on demand with HTTP Range requests
+ * instead of downloading the whole file before the first read.
+ *
+ * Blocks are kept in a small LRU. When reads move forward block after block,
+ * each request fetches more blocks at once (up to HTTP_RANGE_READAHEAD), so a
+ * sequential load needs only a few requests. The blocks live in PSRAM; boards
+ * without it keep only HTTP_RANGE_CACHE_BLOCKS_NO_PSRAM of them.
+ */
+class FileHandlerHTTP : public FileHandler
+{
+protected:
+    struct http_block
+    {
+        uint32_t num = UINT32_MAX;
+        uint32_t len = 0;
+        uint32_t last_used = 0;
+        uint8_t *data = nullptr;
+    };
+
+    HTTP_CLIENT_CLASS *_http;
+    uint32_t _size = 0;
+    uint32_t _pos = 0;
+
+    http_block _blocks[HTTP_RANGE_CACHE_BLOCKS];
+    uint32_t _cache_blocks = HTTP_RANGE_CACHE_BLOCKS; // slots of _blocks in use
+    bool _psram = false;
+    uint32_t _use_counter = 0;
+    uint32_t _next_block = UINT32_MAX; // block following the last fetch
+    uint32_t _readahead = 1;
+
+    FileHandlerHTTP(HTTP_CLIENT_CLASS *http);
+
+    http_block *_find_block(uint32_t num);
+    http_block *_get_block(uint32_t num);
+    bool _fetch(uint32_t num, uint32_t count, int *status);
+    size_t _read_body(uint8_t *buf, size_t len);
+
+public:
+   /**
+    * @brief Open file for reading with Range requests
+    * @param url file URL
+    * @return file handler, or nullptr if the server doesn't honor Range
+    * (the caller should download the whole file then)
+    */
+    static FileHandler *open(const std::string &url);
+
+    virtual ~FileHandlerHTTP() override;
+
+    virtual int close(bool destroy=true) override;
+    virtual int seek(long int off, int whence) override;
+    virtual long int tell() override;
+    virtual size_t read(void *ptr, size_t size, size_t n) override;
+    virtual size_t write(const void *ptr, size_t size, size_t n) override;
+    virtual int flush() override;
+    virtual int eof() override;
+};
+
+#endif //!FNIO_IS_STDIO
+
+#endif // FN_FILEHTTP_H
@@ -64,6 +64,15 @@ size_t FileHandlerLocal::write(const void *ptr, size_t size, size_t n)
 }
 
 
+size_t FileHandlerLocal::read_at(void *ptr, size_t len, long int offset)
+{
+    // Debug_println("FileHandlerLocal::read_at");
+    if (std::fseek(_fh, offset, SEEK_SET) != 0)
+        return 0;
+    return std::fread(ptr, 1, len, _fh);
+}
+
+
 int FileHandlerLocal::flush()
 {
     // Debug_println("FileHandlerLocal::flush");
@@ -10,6 +10,8 @@ class FileHandlerLocal : public FileHandler
 protected:
     FILE *_fh = nullptr;
 
+    virtual size_t read_at(void *ptr, size_t len, long int offset) override;
+
 public:
     FileHandlerLocal(FILE *fh);
     virtual ~FileHandlerLocal() override;
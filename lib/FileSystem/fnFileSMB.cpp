@@ -4,6 +4,8 @@
 #include "fnFileSMB.h"
 #include "../../include/debug.h"
 
+// Times a read is retried when the connection is busy
+#define SMB_READ_RETRIES 5
 
 FileHandlerSMB::FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle)
 {
@@ -128,6 +130,34 @@ size_t FileHandlerSMB::write(const void *ptr, size_t size, size_t count)
 }
 
 
+size_t FileHandlerSMB::read_at(void *ptr, size_t len, long int offset)
+{
+    // Positional reads, no seek request needed
+    size_t bytes_read = 0;
+    int retries = 0;
+    int result;
+    while (bytes_read < len)
+    {
+        result = smb2_pread(_smb, _handle, (uint8_t *)ptr + bytes_read, (uint32_t)(len - bytes_read), offset + bytes_read);
+        if (result < 0)
+        {
+            if (errno == EAGAIN && ++retries <= SMB_READ_RETRIES)
+                continue;
+            // short count tells the caller the read failed
+            Debug_printf("FileHandlerSMB::read_at %s\n", smb2_get_error(_smb));
+            break;
+        }
+        else if (result == 0)
+        {
+            break; // EOF
+        }
+        bytes_read += result;
+        retries = 0;
+    }
+    return bytes_read;
+}
+
+
 int FileHandlerSMB::flush()
 {
     Debug_println("FileHandlerSMB::flush");
@@ -13,6 +13,8 @@ class FileHandlerSMB : public FileHandler
 protected:
     struct smb2_context *_smb;
     struct smb2fh *_handle;
+
+    virtual size_t read_at(void *ptr, size_t len, long int offset) override;
 public:
     FileHandlerSMB(struct smb2_context *smb, struct smb2fh *handle);
     virtual ~FileHandlerSMB() override;
@@ -155,6 +155,16 @@ size_t FileHandlerTNFS::write(const void *ptr, size_t size, size_t count)
 }
 
 
+size_t FileHandlerTNFS::read_at(void *ptr, size_t len, long int offset)
+{
+    Debug_println("FileHandlerTNFS::read_at");
+    // Position is tracked locally, skip LSEEK request if we are already there
+    if (tell() != offset && seek(offset, SEEK_SET) != 0)
+        return 0;
+    return read(ptr, 1, len);
+}
+
+
 int FileHandlerTNFS::flush()
 {
     Debug_println("FileHandlerTNFS::flush");
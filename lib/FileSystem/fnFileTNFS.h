@@ -13,6 +13,8 @@ protected:
     tnfsMountInfo *_mountinfo = nullptr;
     int _handle = -1;
 
+    virtual size_t read_at(void *ptr, size_t len, long int offset) override;
+
 private:
     uint8_t _bad_fd_recovery();
 
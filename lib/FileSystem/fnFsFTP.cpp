@@ -103,6 +103,9 @@ FILE  *FileSystemFTP::file_open(const char *path, const char *mode)
 #ifndef FNIO_IS_STDIO
 FileHandler *FileSystemFTP::filehandler_open(const char *path, const char *mode)
 {
+    // Unlike HTTP (FileHandlerHTTP), files are still downloaded whole before the
+    // first read. Reading on demand with REST + RETR is deferred: fnFTP has no REST,
+    // and every seek would need a new data connection and an ABOR.
     FileHandler *fh = cache_file(path, mode);
     return fh;
 }
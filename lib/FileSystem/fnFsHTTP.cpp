@@ -12,6 +12,7 @@
 
 #include "fnSystem.h"
 #include "fnFileCache.h"
+#include "fnFileHTTP.h"
 #include "string_utils.h"
 
 // http timeout in ms
@@ -105,10 +106,34 @@ FILE  *FileSystemHTTP::file_open(const char *path, const char *mode)
 #ifndef FNIO_IS_STDIO
 FileHandler *FileSystemHTTP::filehandler_open(const char *path, const char *mode)
 {
+    // Read the file on demand with Range requests, unless it's already cached
+    // or the server doesn't support them
+    if (strchr(mode, 'r') != nullptr && strchr(mode, '+') == nullptr)
+    {
+        FileHandler *fh = FileCache::open(_url->mRawUrl.c_str(), path, mode);
+        if (fh != nullptr)
+            return fh;
+
+        fh = FileHandlerHTTP::open(file_url(path));
+        if (fh != nullptr)
+            return fh;
+    }
+
     FileHandler *fh = cache_file(path, mode);
     return fh;
 }
 
+// url + '/' + path
+std::string FileSystemHTTP::file_url(const char *path)
+{
+    std::string url_str = _url->url;
+    std::string path_str = mstr::urlEncode(path);
+    if (url_str.back() != '/') url_str.push_back('/');
+    if (path_str.front() == '/') path_str.erase(0, 1);
+    url_str += path_str;
+    return url_str;
+}
+
 // Read file from HTTP path and write it to cache file
 // Return FileHandler* on success (memory or SD file), nullptr on error
 FileHandler *FileSystemHTTP::cache_file(const char *path, const char *mode)
@@ -134,13 +159,7 @@ FileHandler *FileSystemHTTP::cache_file(const char *path, const char *mode)
         Debug_println("FileSystemHTTP::cache_file() - failed to create HTTP client\n");
         return nullptr;
     }
-    // url + '/' + path
-    std::string url_str = _url->url;
-    std::string path_str = mstr::urlEncode(path);
-    if (url_str.back() != '/') url_str.push_back('/');
-    if (path_str.front() == '/') path_str.erase(0, 1);
-    url_str += path_str;
-    if (!_http->begin(url_str))
+    if (!_http->begin(file_url(path)))
     {
         Debug_println("FileSystemHTTP::cache_file - failed to start HTTP client");
         return nullptr;
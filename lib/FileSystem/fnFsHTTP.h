@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <string>
 #include <stdint.h>
 
 #ifdef ESP_PLATFORM
@@ -68,6 +69,7 @@ public:
 
 #ifndef FNIO_IS_STDIO
     FileHandler *cache_file(const char *path, const char *mode);
+    std::string file_url(const char *path);
 #endif
 
 };
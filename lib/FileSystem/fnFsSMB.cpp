@@ -9,6 +9,7 @@
 
 #include "smb2/smb2.h"
 #include "fnFileSMB.h"
+#include "fnBlockCache.h"
 
 FileSystemSMB::FileSystemSMB()
 {
@@ -169,7 +170,16 @@ FileHandler *FileSystemSMB::filehandler_open(const char *path, const char *mode)
         return nullptr;
     }
 
-    return new FileHandlerSMB(_smb, fh);
+    FileHandler *fh_smb = new FileHandlerSMB(_smb, fh);
+
+    // Read-only files are served through SD block cache
+    smb2_stat_64 st;
+    if (strchr(mode, '+') == nullptr && open_flags == O_RDONLY && BlockCache::enabled() && smb2_fstat(_smb, fh, &st) == 0 && st.smb2_size <= UINT32_MAX)
+    {
+        std::string host = std::string(_url->server) + '/' + _url->share;
+        fh_smb = BlockCache::wrap(fh_smb, host.c_str(), smb_path, (uint32_t)st.smb2_size, (uint32_t)st.smb2_mtime);
+    }
+    return fh_smb;
 }
 #endif
 
@@ -1,5 +1,6 @@
 #include "fnFsTNFS.h"
 #include "fnFileLocal.h"
+#include "fnBlockCache.h"
 
 #include <sys/stat.h>
 #include <errno.h>
@@ -204,7 +205,7 @@ FileHandler * FileSystemTNFS::filehandler_open(const char* path, const char* mod
 {
 #ifdef ESP_PLATFORM
     FILE * fh = file_open(path, mode);
-    return (fh == nullptr) ? nullptr : new FileHandlerLocal(fh);
+    return (fh == nullptr) ? nullptr : _blockcache_wrap(new FileHandlerLocal(fh), path, mode);
 #else
     if(!_started || path == nullptr)
         return nullptr;
@@ -253,9 +254,24 @@ FileHandler * FileSystemTNFS::filehandler_open(const char* path, const char* mod
         return nullptr;
     }
     errno = 0;
-    return new FileHandlerTNFS(&_mountinfo, handle);
+    return _blockcache_wrap(new FileHandlerTNFS(&_mountinfo, handle), path, mode);
 #endif
 }
+
+// Read-only files are served through SD block cache
+FileHandler * FileSystemTNFS::_blockcache_wrap(FileHandler *fh, const char *path, const char *mode)
+{
+    if (strchr(mode, 'r') == nullptr || strchr(mode, '+') != nullptr || !BlockCache::enabled())
+        return fh;
+
+    tnfsStat tstat;
+    if (tnfs_stat(&_mountinfo, &tstat, path) != TNFS_RESULT_SUCCESS || tstat.isDir)
+        return fh;
+
+    char host[sizeof(_mountinfo.hostname) + sizeof(_mountinfo.mountpath) + 8];
+    snprintf(host, sizeof(host), "%s:%u%s", _mountinfo.hostname, _mountinfo.port, _mountinfo.mountpath);
+    return BlockCache::wrap(fh, host, path, tstat.filesize, tstat.m_time);
+}
 #endif
 
 bool FileSystemTNFS::dir_open(const char * path, const char *pattern, uint16_t diropts)
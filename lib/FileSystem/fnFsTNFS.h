@@ -19,6 +19,10 @@ private:
 #endif
     char _current_dirpath[TNFS_MAX_FILELEN];
 
+#ifndef FNIO_IS_STDIO
+    FileHandler * _blockcache_wrap(FileHandler *fh, const char *path, const char *mode);
+#endif
+
 public:
     FileSystemTNFS();
     ~FileSystemTNFS();
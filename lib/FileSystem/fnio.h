@@ -22,6 +22,7 @@
 #ifdef FNIO_IS_STDIO
   #include <cstdio>
   #include <unistd.h>  // for fsync
+  #include "fnFile.h"  // for fnFileRange
   typedef std::FILE fnFile;
 #else
   #include "fnFile.h"
@@ -59,6 +60,19 @@ namespace fnio
     static inline int fclose(fnFile *f)
     { return std::fclose(f); }
 
+    static inline size_t freadv(fnFileRange *ranges, size_t count, fnFile *f)
+    {
+      size_t total = 0;
+      for (size_t i = 0; i < count; i++)
+      {
+        ranges[i].done = 0;
+        if (std::fseek(f, ranges[i].offset, SEEK_SET) == 0)
+          ranges[i].done = std::fread(ranges[i].buf, 1, ranges[i].len, f);
+        total += ranges[i].done;
+      }
+      return total;
+    }
+
 #else
     static inline size_t fread(void *ptr, size_t size, size_t n, fnFile *f) 
     { return f->read(ptr, size, n); }
@@ -81,6 +95,9 @@ namespace fnio
     static inline int fclose(fnFile *f)
     { return f->close(); }
 
+    static inline size_t freadv(fnFileRange *ranges, size_t count, fnFile *f)
+    { return f->readv(ranges, count); }
+
 #endif
 
 } // namespace fnio
@@ -141,6 +141,12 @@ int tnfs_umount(tnfsMountInfo *m_info)
     if (m_info == nullptr)
         return -1;
 
+    Debug_printf("TNFS link stats: srtt=%luus, rttvar=%luus, rto=%dms, retransmits=%lu, duplicates=%lu\r\n",
+                 (unsigned long)m_info->srtt_us, (unsigned long)m_info->rttvar_us, m_info->rto_ms,
+                 (unsigned long)m_info->retransmits, (unsigned long)m_info->duplicate_responses);
+
+    m_info->empty_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_UNMOUNT;
 
@@ -168,6 +174,10 @@ int tnfs_open(tnfsMountInfo *m_info, const char *filepath, uint16_t open_mode, u
 
     *file_handle = TNFS_INVALID_HANDLE;
 
+    // Writing may change directory listings
+    if (open_mode & TNFS_OPENMODE_WRITE)
+        m_info->invalidate_dirlistings();
+
     // Find a free slot in our table of file handles
     tnfsFileHandleInfo *pFileInf = m_info->new_filehandleinfo();
     if (pFileInf == nullptr)
@@ -685,18 +695,36 @@ int tnfs_lseek(tnfsMountInfo *m_info, int16_t file_handle, int32_t position, uin
 }
 
 /*
-    Opens directory and stores directory handle in tnfsMountInfo.dir_handle
-    sortopts = zero or more TNFS_DIRSORT flags
-    diropts = zero or more TNFS_DIROPT flags
-    pattern = zero-terminated wildcard pattern string
-    maxresults = max number of results to return or zero for unlimited
+    Sends TNFS_CMD_CLOSEDIR for the directory handle in tnfsMountInfo.dir_handle, if open
     Returns: 0: success, -1: failed to send/receive packet, other: TNFS server response
 */
-int tnfs_opendirx(tnfsMountInfo *m_info, const char *directory, uint8_t sortopts, uint8_t diropts, const char *pattern, uint16_t maxresults)
+int _tnfs_closedir_send(tnfsMountInfo *m_info)
 {
-    if (m_info == nullptr || directory == nullptr)
-        return -1;
+    if (false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
+        return TNFS_RESULT_SUCCESS;
+
+    tnfsPacket packet;
+    packet.command = TNFS_CMD_CLOSEDIR;
+    packet.payload[0] = m_info->dir_handle;
+
+    if (_tnfs_transaction(m_info, packet, 1))
+    {
+        if (packet.payload[0] == TNFS_RESULT_SUCCESS)
+        {
+            m_info->dir_handle = TNFS_INVALID_HANDLE;
+        }
+        return packet.payload[0];
+    }
+    return -1;
+}
 
+/*
+    Sends TNFS_CMD_OPENDIRX for the given listing's path and options
+    and stores directory handle in tnfsMountInfo.dir_handle
+    Returns: 0: success, -1: failed to send/receive packet, other: TNFS server response
+*/
+int _tnfs_opendirx_send(tnfsMountInfo *m_info, tnfsDirListing *pListing)
+{
 #define OFFSET_OPENDIRX_DIROPT 0
 #define OFFSET_OPENDIRX_SORTOPT 1
 #define OFFSET_OPENDIRX_MAXRESULTS 2
@@ -705,32 +733,29 @@ int tnfs_opendirx(tnfsMountInfo *m_info, const char *directory, uint8_t sortopts
 // Number of bytes before the two null-terminated strings start
 #define OPENDIRX_HEADERBYTES 4
 
-    // Throw out any existing cached directory entries
-    m_info->empty_dircache();
-
     tnfsPacket packet;
     packet.command = TNFS_CMD_OPENDIRX;
 
-    packet.payload[OFFSET_OPENDIRX_DIROPT] = diropts;
-    packet.payload[OFFSET_OPENDIRX_SORTOPT] = sortopts;
+    packet.payload[OFFSET_OPENDIRX_DIROPT] = pListing->diropts;
+    packet.payload[OFFSET_OPENDIRX_SORTOPT] = pListing->sortopts;
 
-    packet.payload[OFFSET_OPENDIRX_MAXRESULTS] = TNFS_LOBYTE_FROM_UINT16(maxresults);
-    packet.payload[OFFSET_OPENDIRX_MAXRESULTS + 1] = TNFS_HIBYTE_FROM_UINT16(maxresults);
+    packet.payload[OFFSET_OPENDIRX_MAXRESULTS] = TNFS_LOBYTE_FROM_UINT16(pListing->maxresults);
+    packet.payload[OFFSET_OPENDIRX_MAXRESULTS + 1] = TNFS_HIBYTE_FROM_UINT16(pListing->maxresults);
 
     // Copy the pattern or an empty string
     strlcpy((char *)(packet.payload + OFFSET_OPENDIRX_PATTERN),
-        pattern == nullptr ? "" : pattern,
+        pListing->pattern.c_str(),
         sizeof(packet.payload) - OPENDIRX_HEADERBYTES - 1);
 
     // Calculate the new offset to the path taking the pattern string into account
     int pathoffset = strlen((char *)(packet.payload + OFFSET_OPENDIRX_PATTERN)) + OPENDIRX_HEADERBYTES + 1;
 
-    // Copy the directory into the right spot in the packet and get its string len
-    int pathlen = _tnfs_adjust_with_full_path(m_info,
-        (char *)(packet.payload + pathoffset), directory, sizeof(packet.payload) - pathoffset);
+    // Copy the (already full) directory path into the right spot in the packet
+    strlcpy((char *)(packet.payload + pathoffset), pListing->path.c_str(), sizeof(packet.payload) - pathoffset);
+    int pathlen = strlen((char *)(packet.payload + pathoffset));
 
     Debug_printf("TNFS open directory: sortopts=0x%02x diropts=0x%02x maxresults=0x%04x pattern=\"%s\" path=\"%s\"\r\n",
-     sortopts, diropts, maxresults, (char *)(packet.payload + OFFSET_OPENDIRX_PATTERN), (char *)(packet.payload + pathoffset));
+     pListing->sortopts, pListing->diropts, pListing->maxresults, (char *)(packet.payload + OFFSET_OPENDIRX_PATTERN), (char *)(packet.payload + pathoffset));
 
     if (_tnfs_transaction(m_info, packet, pathoffset + pathlen + 1))
     {
@@ -738,6 +763,8 @@ int tnfs_opendirx(tnfsMountInfo *m_info, const char *directory, uint8_t sortopts
         {
             m_info->dir_handle = packet.payload[1];
             m_info->dir_entries = TNFS_UINT16_FROM_LOHI_BYTEPTR(packet.payload + 2);
+            m_info->dir_server_position = 0;
+            pListing->dir_entries = m_info->dir_entries;
             Debug_printf("Directory opened, handle ID: %hd, entries: %u\r\n", m_info->dir_handle, m_info->dir_entries);
         }
         return packet.payload[0];
@@ -745,15 +772,101 @@ int tnfs_opendirx(tnfsMountInfo *m_info, const char *directory, uint8_t sortopts
     return -1;
 }
 
-void _readdirx_fill_response(tnfsDirCacheEntry *pCached, tnfsStat *filestat, char *dir_entry, int dir_entry_len)
+/*
+    Opens directory for reading with tnfs_readdirx
+    sortopts = zero or more TNFS_DIRSORT flags
+    diropts = zero or more TNFS_DIROPT flags
+    pattern = zero-terminated wildcard pattern string
+    maxresults = max number of results to return or zero for unlimited
+
+    Listings are cached per mount by path, options and pattern. Reopening a
+    cached listing within TNFS_DIRLISTING_TTL needs no network traffic; after
+    that it's reused if the directory's modified time hasn't changed.
+    Otherwise the directory is opened on the server and its handle stored in
+    tnfsMountInfo.dir_handle.
+    Returns: 0: success, -1: failed to send/receive packet, other: TNFS server response
+*/
+int tnfs_opendirx(tnfsMountInfo *m_info, const char *directory, uint8_t sortopts, uint8_t diropts, const char *pattern, uint16_t maxresults)
+{
+    if (m_info == nullptr || directory == nullptr)
+        return -1;
+
+    char fullpath[TNFS_MAX_FILELEN];
+    if (_tnfs_adjust_with_full_path(m_info, fullpath, directory, sizeof(fullpath)) < 0)
+        return -1;
+
+    // Stop reading any previously open directory, and free the server's handle for it
+    if (m_info->dir_listing != nullptr)
+        tnfs_closedir(m_info);
+    else
+        _tnfs_closedir_send(m_info);
+
+    // Recursive listings can change without the directory itself changing
+    bool check_mtime = (diropts & TNFS_DIROPT_TRAVERSE) == 0;
+    tnfsStat dirstat;
+
+    tnfsDirListing *pListing = m_info->find_dirlisting(fullpath, pattern, sortopts, diropts, maxresults);
+    if (pListing != nullptr && fnSystem.millis() - pListing->validated_ms > TNFS_DIRLISTING_TTL)
+    {
+        if (check_mtime && tnfs_stat(m_info, &dirstat, directory) == TNFS_RESULT_SUCCESS
+            && dirstat.m_time == pListing->dir_mtime)
+        {
+            pListing->validated_ms = fnSystem.millis();
+        }
+        else
+        {
+            Debug_printf("TNFS directory listing for \"%s\" expired\r\n", fullpath);
+            m_info->delete_dirlisting(pListing);
+            pListing = nullptr;
+        }
+    }
+
+    if (pListing != nullptr)
+    {
+        Debug_printf("TNFS open directory from cache: path=\"%s\" entries: %u\r\n", fullpath, pListing->dir_entries);
+        // The server's handle is closed above, and only reopened when entries have to be fetched
+        m_info->dir_handle = TNFS_INVALID_HANDLE;
+        m_info->dir_entries = pListing->dir_entries;
+    }
+    else
+    {
+        pListing = m_info->new_dirlisting(fullpath, pattern, sortopts, diropts, maxresults);
+        if (pListing == nullptr)
+            return TNFS_RESULT_OUT_OF_MEMORY;
+
+        // Note when the directory was last modified before reading it
+        if (check_mtime && tnfs_stat(m_info, &dirstat, directory) == TNFS_RESULT_SUCCESS)
+            pListing->dir_mtime = dirstat.m_time;
+
+        int result = _tnfs_opendirx_send(m_info, pListing);
+        if (result != TNFS_RESULT_SUCCESS)
+        {
+            m_info->delete_dirlisting(pListing);
+            return result;
+        }
+        pListing->validated_ms = fnSystem.millis();
+    }
+
+    m_info->dir_listing = pListing;
+    m_info->dir_position = 0;
+    return TNFS_RESULT_SUCCESS;
+}
+
+void _readdirx_fill_response(const uint8_t *record, tnfsStat *filestat, char *dir_entry, int dir_entry_len)
 {
-    filestat->isDir = pCached->flags & TNFS_READDIRX_DIR ? true : false;
-    filestat->filesize = pCached->filesize;
-    filestat->m_time = pCached->m_time;
-    filestat->c_time = pCached->c_time;
+#define OFFSET_READDIRX_FLAGS 0
+#define OFFSET_READDIRX_SIZE 1
+#define OFFSET_READDIRX_MTIME 5
+#define OFFSET_READDIRX_CTIME 9
+#define OFFSET_READDIRX_PATH 13
+
+    filestat->isDir = record[OFFSET_READDIRX_FLAGS] & TNFS_READDIRX_DIR ? true : false;
+    filestat->filesize = TNFS_UINT32_FROM_LOHI_BYTEPTR(record + OFFSET_READDIRX_SIZE);
+    filestat->m_time = TNFS_UINT32_FROM_LOHI_BYTEPTR(record + OFFSET_READDIRX_MTIME);
+    filestat->c_time = TNFS_UINT32_FROM_LOHI_BYTEPTR(record + OFFSET_READDIRX_CTIME);
     filestat->a_time = 0;
 
-    strlcpy(dir_entry, pCached->entryname, dir_entry_len);
+    strlcpy(dir_entry, (const char *)record + OFFSET_READDIRX_PATH, dir_entry_len);
 
 #ifdef DEBUG
     {
@@ -772,189 +885,202 @@ void _readdirx_fill_response(tnfsDirCacheEntry *pCached, tnfsStat *filestat, cha
 }
 
 /*
-    Reads next available file using open directory handle specified in
-    tnfsMountInfo.dir_handle
-    dir_entry filled with filename up to dir_entry_len
- returns: 0: success, -1: failed to deliver/receive packet, other: TNFS error result code
+    Fetches the next batch of entries from the server into the open directory
+    listing, starting at tnfsMountInfo.dir_position. The server's directory
+    handle is (re)opened and moved there first if needed.
+    Returns: 0: success, -1: failed to deliver/receive packet, other: TNFS error result code
 */
-int tnfs_readdirx(tnfsMountInfo *m_info, tnfsStat *filestat, char *dir_entry, int dir_entry_len)
+int _tnfs_readdirx_fetch(tnfsMountInfo *m_info)
 {
-    // Check for a valid open handle ID
-    if (m_info == nullptr || false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
-        return -1;
+    tnfsDirListing *pListing = m_info->dir_listing;
+    tnfsPacket packet;
 
-    // See if we have an entry in our directory cache to return first
-    tnfsDirCacheEntry *pCached = m_info->next_dircache_entry();
-    if(pCached != nullptr)
+    if (false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
     {
-        Debug_print("tnfs_readdirx responding from cached entry\r\n");
-        _readdirx_fill_response(pCached, filestat, dir_entry, dir_entry_len);
-        return 0;
+        int result = _tnfs_opendirx_send(m_info, pListing);
+        if (result != TNFS_RESULT_SUCCESS)
+            return result;
     }
 
-    // If the cache was empty and the EOF flag was set, just respond with an EOF error
-    if(m_info->get_dircache_eof() == true)
+    if (m_info->dir_server_position != m_info->dir_position)
     {
-        Debug_print("tnfs_readdirx returning EOF based on cached value\r\n");
-        return TNFS_RESULT_END_OF_FILE;
+        packet.command = TNFS_CMD_SEEKDIR;
+        packet.payload[0] = m_info->dir_handle;
+        uint32_t pos = m_info->dir_position;
+        TNFS_UINT32_TO_LOHI_BYTEPTR(pos, packet.payload + 1);
+
+        if (!_tnfs_transaction(m_info, packet, 5))
+            return -1;
+        if (packet.payload[0] != TNFS_RESULT_SUCCESS)
+            return packet.payload[0];
+        m_info->dir_server_position = m_info->dir_position;
     }
 
-    // Invalidate the cache before loading more
-    m_info->empty_dircache();
+    // The listing only holds consecutive entries, start over if we're reading elsewhere
+    if (m_info->dir_position != pListing->end_pos())
+        pListing->reset(m_info->dir_position);
 
-#define OFFSET_READDIRX_FLAGS 0
-#define OFFSET_READDIRX_SIZE 1
-#define OFFSET_READDIRX_MTIME 5
-#define OFFSET_READDIRX_CTIME 9
-#define OFFSET_READDIRX_PATH 13
+    // Make sure a whole response fits into the last chunk
+    if (pListing->needs_chunk(TNFS_PAYLOAD_SIZE))
+    {
+        if (!m_info->reserve_dirlisting(pListing, TNFS_DIRLISTING_CHUNK_SIZE))
+            pListing->reset(m_info->dir_position);
+        if (!pListing->add_chunk())
+        {
+            pListing->reset(m_info->dir_position);
+            if (!pListing->add_chunk())
+            {
+                Debug_print("tnfs_readdirx Failed to allocate directory listing chunk!\r\n");
+                return TNFS_RESULT_OUT_OF_MEMORY;
+            }
+        }
+    }
 
-    tnfsPacket packet;
     packet.command = TNFS_CMD_READDIRX;
     packet.payload[0] = m_info->dir_handle;
     // Number of responses to read
     packet.payload[1] = TNFS_MAX_DIRCACHE_ENTRIES;
 
-    if (_tnfs_transaction(m_info, packet, 2))
-    {
-        if (packet.payload[0] == TNFS_RESULT_SUCCESS)
-        {
-            uint8_t response_count = packet.payload[1];
-            uint8_t response_status = packet.payload[2];
-            uint16_t dirpos = TNFS_UINT16_FROM_LOHI_BYTEPTR(packet.payload + 3);
+    if (!_tnfs_transaction(m_info, packet, 2))
+        return -1;
 
-            // Set our EOF flag if the server tells us there's no more after this
-            if(response_status & TNFS_READDIRX_STATUS_EOF)
-                m_info->set_dircache_eof();
+    if (packet.payload[0] == TNFS_RESULT_END_OF_FILE)
+        pListing->eof = true;
+    if (packet.payload[0] != TNFS_RESULT_SUCCESS)
+        return packet.payload[0];
 
-            Debug_printf("tnfs_readdirx resp_count=%hu, dirpos=%hu, status=%hu\r\n", response_count, dirpos, response_status);
+    uint8_t response_count = packet.payload[1];
+    uint8_t response_status = packet.payload[2];
+    uint16_t dirpos = TNFS_UINT16_FROM_LOHI_BYTEPTR(packet.payload + 3);
 
-            // Fill our directory cache using the returned values
-            int current_offset = 5;
-            for(int i = 0; i < response_count; i++)
-            {
-                tnfsDirCacheEntry *pEntry = m_info->new_dircache_entry();
-                if(pEntry != nullptr)
-                {
-                    pEntry->dirpos = dirpos + i;
-                    pEntry->flags =
-                        packet.payload[current_offset + OFFSET_READDIRX_FLAGS];
-                    pEntry->filesize =
-                        TNFS_UINT32_FROM_LOHI_BYTEPTR(packet.payload + current_offset + OFFSET_READDIRX_SIZE);
-                    pEntry->m_time =
-                        TNFS_UINT32_FROM_LOHI_BYTEPTR(packet.payload + current_offset + OFFSET_READDIRX_MTIME);
-                    pEntry->c_time =
-                        TNFS_UINT32_FROM_LOHI_BYTEPTR(packet.payload + current_offset + OFFSET_READDIRX_CTIME);
-
-                    int name_len = strlcpy(pEntry->entryname,
-                        (char *)packet.payload + current_offset + OFFSET_READDIRX_PATH, sizeof(pEntry->entryname));
-
-                    /*
-                     Adjust our offset to point to the next entry within the packet
-                     flags (1) + size (4) + mtime (4) + ctime (4) + null (1) = 14
-                    */
-                    current_offset += 14 + name_len;
-                }
-                else
-                {
-                    Debug_print("tnfs_readdirx Failed to allocate new dircache entry!\r\n");
-                    break;
-                }
-            }
+    Debug_printf("tnfs_readdirx resp_count=%hu, dirpos=%hu, status=%hu\r\n", response_count, dirpos, response_status);
 
-            int loaded = m_info->count_dircache();
-            Debug_printf("tnfs_readdirx cached %d entries\r\n", loaded);
-            // Now that we've cached our entries, return the first one
-            if(loaded > 0)
-                _readdirx_fill_response(m_info->next_dircache_entry(), filestat, dir_entry, dir_entry_len);
+    if (dirpos != pListing->end_pos())
+    {
+        // Go by the server's idea of where we are
+        Debug_printf("tnfs_readdirx expected dirpos=%hu\r\n", pListing->end_pos());
+        pListing->reset(dirpos);
+        if (!pListing->add_chunk())
+            return TNFS_RESULT_OUT_OF_MEMORY;
+        m_info->dir_position = dirpos;
+    }
+    m_info->dir_server_position = dirpos + response_count;
 
-        }
-        return packet.payload[0];
+    // Store the entries as they are, each one is:
+    // flags (1) + size (4) + mtime (4) + ctime (4) + name + null (1)
+    int current_offset = 5;
+    int loaded;
+    for (loaded = 0; loaded < response_count; loaded++)
+    {
+        int avail = sizeof(packet.payload) - current_offset - TNFS_DIRLISTING_RECORD_HEADER;
+        if (avail < 1)
+            break;
+        int name_len = strnlen((char *)packet.payload + current_offset + TNFS_DIRLISTING_RECORD_HEADER, avail);
+        if (name_len == avail)
+            break;
+
+        int record_len = TNFS_DIRLISTING_RECORD_HEADER + name_len + 1;
+        if (!pListing->append(packet.payload + current_offset, record_len))
+            break;
+        current_offset += record_len;
     }
-    return -1;
+
+    // Set our EOF flag if the server tells us there's no more after this
+    if ((response_status & TNFS_READDIRX_STATUS_EOF) && loaded == response_count)
+        pListing->eof = true;
+
+    Debug_printf("tnfs_readdirx cached %d entries\r\n", loaded);
+    return TNFS_RESULT_SUCCESS;
 }
 
 /*
-    TELLDIR
+    Reads next available file from the directory opened by tnfs_opendirx
+    dir_entry filled with filename up to dir_entry_len
+ returns: 0: success, -1: failed to deliver/receive packet, other: TNFS error result code
 */
-int tnfs_telldir(tnfsMountInfo *m_info, uint16_t *position)
+int tnfs_readdirx(tnfsMountInfo *m_info, tnfsStat *filestat, char *dir_entry, int dir_entry_len)
 {
-    if (m_info == nullptr || false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
+    // Check for an open directory
+    if (m_info == nullptr || m_info->dir_listing == nullptr)
         return -1;
 
-    if(position == nullptr)
-        return -1;
+    tnfsDirListing *pListing = m_info->dir_listing;
 
-    // First see if we're pointing at a currently-cached directory entry and return that
-    int cached = m_info->tell_dircache_entry();
-    if (cached > -1)
+    // See if we have the entry in our directory listing already
+    const uint8_t *record = pListing->get(m_info->dir_position);
+    if (record != nullptr)
     {
-        *position = cached;
-        return 0;
+        Debug_print("tnfs_readdirx responding from cached entry\r\n");
     }
-
-    tnfsPacket packet;
-    packet.command = TNFS_CMD_TELLDIR;
-    packet.payload[0] = m_info->dir_handle;
-
-    if (_tnfs_transaction(m_info, packet, 1))
+    else
     {
-        if (packet.payload[0] == TNFS_RESULT_SUCCESS)
+        // If the server told us there's nothing more, just respond with an EOF error
+        if (pListing->eof && m_info->dir_position >= pListing->end_pos())
         {
-            *position = TNFS_UINT32_FROM_LOHI_BYTEPTR(packet.payload + 1);
+            Debug_print("tnfs_readdirx returning EOF based on cached value\r\n");
+            return TNFS_RESULT_END_OF_FILE;
         }
-        return packet.payload[0];
+
+        int result = _tnfs_readdirx_fetch(m_info);
+        if (result != TNFS_RESULT_SUCCESS)
+            return result;
+
+        record = pListing->get(m_info->dir_position);
+        if (record == nullptr)
+            return TNFS_RESULT_END_OF_FILE;
     }
-    return -1;
+
+    _readdirx_fill_response(record, filestat, dir_entry, dir_entry_len);
+    m_info->dir_position++;
+    return 0;
 }
 
 /*
-    SEEKDIR
+    TELLDIR
+    We always know the position of the next entry, so this never needs the server
 */
-int tnfs_seekdir(tnfsMountInfo *m_info, uint16_t position)
+int tnfs_telldir(tnfsMountInfo *m_info, uint16_t *position)
 {
-    if (m_info == nullptr || false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
+    if (m_info == nullptr || m_info->dir_listing == nullptr)
         return -1;
 
-    // A SEEKDIR will always invalidate our directory cache
-    m_info->empty_dircache();
+    if(position == nullptr)
+        return -1;
 
-    tnfsPacket packet;
-    packet.command = TNFS_CMD_SEEKDIR;
-    packet.payload[0] = m_info->dir_handle;
-    uint32_t pos = position;
-    TNFS_UINT32_TO_LOHI_BYTEPTR(pos, packet.payload + 1);
+    *position = m_info->dir_position;
+    return 0;
+}
 
-    if (_tnfs_transaction(m_info, packet, 5))
-        return packet.payload[0];
+/*
+    SEEKDIR
+    Only moves our position, the server's directory handle is moved
+    when entries which aren't in our listing have to be fetched
+*/
+int tnfs_seekdir(tnfsMountInfo *m_info, uint16_t position)
+{
+    if (m_info == nullptr || m_info->dir_listing == nullptr)
+        return -1;
 
-    return -1;
+    m_info->dir_position = position;
+    return 0;
 }
 
 /*
-    Closes current directory handle specificed in tnfsMountInfo
+    Closes current directory, and the server's directory handle specificed in tnfsMountInfo if open
     Returns: 0: success, -1: failed to send/receive packet, other: TNFS server response
 */
 int tnfs_closedir(tnfsMountInfo *m_info)
 {
-    if (m_info == nullptr || false == TNFS_VALID_AS_UINT8(m_info->dir_handle))
+    if (m_info == nullptr || m_info->dir_listing == nullptr)
         return -1;
 
-    // Throw out any existing cached directory entries
-    m_info->empty_dircache();
+    // Keep the listing around for next time unless it's out of date
+    tnfsDirListing *pListing = m_info->dir_listing;
+    m_info->dir_listing = nullptr;
+    if (pListing->stale)
+        m_info->delete_dirlisting(pListing);
 
-    tnfsPacket packet;
-    packet.command = TNFS_CMD_CLOSEDIR;
-    packet.payload[0] = m_info->dir_handle;
-
-    if (_tnfs_transaction(m_info, packet, 1))
-    {
-        if (packet.payload[0] == TNFS_RESULT_SUCCESS)
-        {
-            m_info->dir_handle = TNFS_INVALID_HANDLE;
-        }
-        return packet.payload[0];
-    }
-    return -1;
+    return _tnfs_closedir_send(m_info);
 }
 
 /*
@@ -966,6 +1092,9 @@ int tnfs_mkdir(tnfsMountInfo *m_info, const char *directory)
     if (m_info == nullptr || directory == nullptr)
         return -1;
 
+    // Cached directory listings may no longer match
+    m_info->invalidate_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_MKDIR;
 
@@ -989,6 +1118,9 @@ int tnfs_rmdir(tnfsMountInfo *m_info, const char *directory)
     if (m_info == nullptr || directory == nullptr)
         return -1;
 
+    // Cached directory listings may no longer match
+    m_info->invalidate_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_RMDIR;
 
@@ -1066,6 +1198,9 @@ int tnfs_unlink(tnfsMountInfo *m_info, const char *filepath)
     if (m_info == nullptr || filepath == nullptr)
         return -1;
 
+    // Cached directory listings may no longer match
+    m_info->invalidate_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_UNLINK;
 
@@ -1090,6 +1225,9 @@ int tnfs_rename(tnfsMountInfo *m_info, const char *old_filepath, const char *new
     if (m_info == nullptr || old_filepath == nullptr || new_filepath == nullptr)
         return -1;
 
+    // Cached directory listings may no longer match
+    m_info->invalidate_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_RENAME;
 
@@ -1115,6 +1253,9 @@ int tnfs_chmod(tnfsMountInfo *m_info, const char *filepath, uint16_t mode)
     if (m_info == nullptr || filepath == nullptr)
         return -1;
 
+    // Cached directory listings may no longer match
+    m_info->invalidate_dirlistings();
+
     tnfsPacket packet;
     packet.command = TNFS_CMD_CHMOD;
 
@@ -1377,6 +1518,30 @@ int _tnfs_udp_recv(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt)
   returns - true if response packet was received
             false if no response received during retries/timeout period
  */
+/*
+ Commands the server may work on for a while before it answers, such as sorting
+ a big directory for OPENDIRX. They wait the fixed timeout_ms rather than the
+ adaptive one, so they aren't sent again while the server is still busy, and
+ their round trips are left out of the RTT estimate.
+*/
+static bool _tnfs_slow_command(uint8_t command)
+{
+    switch (command)
+    {
+    case TNFS_CMD_MOUNT:
+    case TNFS_CMD_OPENDIR:
+    case TNFS_CMD_OPENDIRX:
+    case TNFS_CMD_MKDIR:
+    case TNFS_CMD_RMDIR:
+    case TNFS_CMD_OPEN:
+    case TNFS_CMD_SIZE:
+    case TNFS_CMD_FREE:
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool _tnfs_transaction(tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_size)
 {
     std::lock_guard<std::recursive_mutex> lock(m_info->transaction_mutex);
@@ -1391,26 +1556,39 @@ bool _tnfs_transaction(tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_
     // Set sequence number before the transaction loop
     reqPkt.sequence_num = m_info->current_sequence_num++;
 
+    // Only round trips of requests sent exactly once are used to update the RTT estimate (Karn's algorithm)
+    bool resent = false;
+
     // Start a new retry sequence
     for (int retry = 0; retry < m_info->max_retries; retry++)
     {
+        if (resent)
+            m_info->retransmits++;
+
+        uint32_t us_start = (uint32_t)fnSystem.micros();
         switch(_tnfs_send_recv(udp, m_info, reqPkt, payload_size, pkt))
         {
             case SUCCESS:
+            if (!resent && !_tnfs_slow_command(reqPkt.command))
+                m_info->rtt_sample((uint32_t)fnSystem.micros() - us_start);
             return true;
 
             case RESET:
+            resent = true;
             retry = -1;
             continue;
 
             case FAILED:
             default:
             // fallback to retry
+            resent = true;
             break;
         }
-        
-        // Make sure we wait before retrying
-        fnSystem.delay(m_info->min_retry_ms);
+
+        // Make sure at least the server's minimum retry time has passed since we sent the request
+        uint32_t elapsed_ms = ((uint32_t)fnSystem.micros() - us_start) / 1000;
+        if (elapsed_ms < m_info->min_retry_ms)
+            fnSystem.delay(m_info->min_retry_ms - elapsed_ms);
     }
 
     Debug_printf("Retry attempts failed for host: %s, path: %s, cwd: %s\r\n", m_info->hostname, m_info->mountpath, m_info->current_working_directory);
@@ -1432,7 +1610,9 @@ _tnfs_send_recv_result _tnfs_send_recv(fnUDP &udp, tnfsMountInfo *m_info, tnfsPa
         return FAILED;
     }
 
-    // Wait for a response at most TNFS_TIMEOUT milliseconds
+    // Wait for a response at most the current retransmit timeout
+    bool slow = _tnfs_slow_command(req_pkt.command);
+    int timeout_ms = m_info->current_timeout_ms(slow);
 #ifdef ESP_PLATFORM
     int ms_start = fnSystem.millis();
 #else
@@ -1474,7 +1654,7 @@ _tnfs_send_recv_result _tnfs_send_recv(fnUDP &udp, tnfsMountInfo *m_info, tnfsPa
         fnSystem.delay_microseconds(5000); // wait more time for (remote) data to arrive
 #endif
 
-    } while ((fnSystem.millis() - ms_start) < m_info->timeout_ms); // packet receive loop
+    } while ((fnSystem.millis() - ms_start) < timeout_ms); // packet receive loop
 
     if (m_info->protocol == TNFS_PROTOCOL_UNKNOWN)
     {
@@ -1486,7 +1666,9 @@ _tnfs_send_recv_result _tnfs_send_recv(fnUDP &udp, tnfsMountInfo *m_info, tnfsPa
         return RESET;
     }
     
-    Debug_printf("Timeout after %d milliseconds. Retrying\r\n", m_info->timeout_ms);
+    Debug_printf("Timeout after %d milliseconds. Retrying\r\n", timeout_ms);
+    if (m_info->protocol == TNFS_PROTOCOL_UDP && !slow)
+        m_info->rto_backoff();
     return FAILED;
 }
 
@@ -1513,6 +1695,7 @@ _tnfs_recv_result _tnfs_recv_and_validate(fnUDP &udp, tnfsMountInfo *m_info, tnf
     if (res_pkt.sequence_num < req_pkt.sequence_num)
     {
         Debug_printf("Received delayed response! Rcvd: %x, Expected: %x\r\n", res_pkt.sequence_num, req_pkt.sequence_num);
+        m_info->duplicate_responses++;
         return NO_RESP;
     }
 
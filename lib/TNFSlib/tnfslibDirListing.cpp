@@ -0,0 +1,104 @@
+
+#include "tnfslibDirListing.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "fnSystem.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+
+tnfsDirListing::tnfsDirListing(const char *dirpath, const char *dirpattern, uint8_t sort_opts, uint8_t dir_opts, uint16_t max_results)
+    : path(dirpath)
+    , pattern(dirpattern == nullptr ? "" : dirpattern)
+    , sortopts(sort_opts)
+    , diropts(dir_opts)
+    , maxresults(max_results)
+{
+}
+
+tnfsDirListing::~tnfsDirListing()
+{
+    reset(0);
+}
+
+bool tnfsDirListing::matches(const char *dirpath, const char *dirpattern, uint8_t sort_opts, uint8_t dir_opts, uint16_t max_results) const
+{
+    return sortopts == sort_opts && diropts == dir_opts && maxresults == max_results &&
+        path == dirpath && pattern == (dirpattern == nullptr ? "" : dirpattern);
+}
+
+/*
+ Returns a pointer to the record at the given directory position
+ or null if that position isn't in the listing
+*/
+const uint8_t *tnfsDirListing::get(uint16_t pos) const
+{
+    if (pos < _base_pos || pos >= end_pos())
+        return nullptr;
+    return _entries[pos - _base_pos];
+}
+
+/*
+ Returns true if the board has PSRAM, which then holds all chunks.
+ Without it they come from internal RAM, under a smaller budget.
+*/
+bool tnfsDirListing::in_psram()
+{
+    static const bool has_psram = fnSystem.get_psram_size() > 0;
+    return has_psram;
+}
+
+/*
+ Adds an empty chunk to store records in
+ Returns false if the memory couldn't be allocated
+*/
+bool tnfsDirListing::add_chunk()
+{
+#ifdef ESP_PLATFORM
+    uint8_t *p = (uint8_t *)heap_caps_malloc(TNFS_DIRLISTING_CHUNK_SIZE,
+        in_psram() ? MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM : MALLOC_CAP_DEFAULT);
+#else
+    uint8_t *p = (uint8_t *)malloc(TNFS_DIRLISTING_CHUNK_SIZE);
+#endif
+    if (p == nullptr)
+        return false;
+
+    _chunks.push_back(p);
+    _chunk_used = 0;
+    return true;
+}
+
+/*
+ Copies a record into the listing at position end_pos()
+ Returns false if there's no room left in the last chunk
+*/
+bool tnfsDirListing::append(const uint8_t *record, size_t len)
+{
+    if (needs_chunk(len))
+        return false;
+
+    uint8_t *p = _chunks.back() + _chunk_used;
+    memcpy(p, record, len);
+    _chunk_used += len;
+    _entries.push_back(p);
+    return true;
+}
+
+/*
+ Throws out all records; the listing will continue at directory position pos
+*/
+void tnfsDirListing::reset(uint16_t pos)
+{
+    for (uint8_t *p : _chunks)
+        free(p);
+    _chunks.clear();
+    _chunk_used = TNFS_DIRLISTING_CHUNK_SIZE;
+    _entries.clear();
+    _entries.shrink_to_fit();
+    _base_pos = pos;
+    eof = false;
+}
@@ -0,0 +1,63 @@
+#ifndef _TNFSLIB_DIRLISTING_H
+#define _TNFSLIB_DIRLISTING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+#define TNFS_DIRLISTING_CHUNK_SIZE 4096 // Listing records are packed into chunks of this size
+// Directory entry as sent by TNFS_READDIRX and stored in a listing:
+// flags (1) + size (4) + mtime (4) + ctime (4) followed by the null-terminated name
+#define TNFS_DIRLISTING_RECORD_HEADER 13
+
+/*
+ A (window of a) directory listing read from the server, identified by
+ the full path and the OPENDIRX sort options, directory options and pattern.
+
+ Entries are kept in their compact READDIRX wire format, packed back to back
+ into fixed size chunks, and looked up by their directory position. The
+ listing covers the contiguous positions [base_pos(), end_pos()); reading
+ outside that window resets it to start at the new position.
+*/
+class tnfsDirListing
+{
+private:
+    std::vector<uint8_t *> _chunks;
+    uint16_t _chunk_used = TNFS_DIRLISTING_CHUNK_SIZE; // Bytes used in the last chunk
+    std::vector<const uint8_t *> _entries;
+    uint16_t _base_pos = 0;
+
+public:
+    tnfsDirListing(const char *dirpath, const char *dirpattern, uint8_t sort_opts, uint8_t dir_opts, uint16_t max_results);
+    ~tnfsDirListing();
+
+    bool matches(const char *dirpath, const char *dirpattern, uint8_t sort_opts, uint8_t dir_opts, uint16_t max_results) const;
+
+    uint16_t base_pos() const { return _base_pos; };
+    uint16_t end_pos() const { return _base_pos + _entries.size(); };
+    const uint8_t *get(uint16_t pos) const;
+    size_t bytes() const { return _chunks.size() * TNFS_DIRLISTING_CHUNK_SIZE; };
+
+    bool needs_chunk(size_t len) const { return _chunks.empty() || (size_t)(TNFS_DIRLISTING_CHUNK_SIZE - _chunk_used) < len; };
+    bool add_chunk();
+    static bool in_psram(); // Whether chunks are kept in PSRAM
+    bool append(const uint8_t *record, size_t len);
+    void reset(uint16_t pos);
+
+    std::string path; // Full path on the server
+    std::string pattern;
+    uint8_t sortopts;
+    uint8_t diropts;
+    uint16_t maxresults;
+
+    uint16_t dir_entries = 0; // Number of entries reported by OPENDIRX
+    uint32_t dir_mtime = 0; // Modification time of the directory when it was listed
+    uint64_t validated_ms = 0; // When the listing was last known to be current
+    uint32_t last_used = 0; // For LRU eviction
+    bool eof = false; // Server reported there are no entries at or after end_pos()
+    bool stale = false; // Something on the mount changed; don't reuse after the current open
+};
+
+#endif // _TNFSLIB_DIRLISTING_H
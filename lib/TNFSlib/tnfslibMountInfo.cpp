@@ -28,63 +28,186 @@ tnfsMountInfo::~tnfsMountInfo()
             _file_handles[i] = nullptr;
         }
     }
-    // Delete any remaining directory cache entries
-    empty_dircache();
+    // Delete any remaining directory listings
+    empty_dirlistings();
 }
 
-// Empty the current contents of the directory cache
-void tnfsMountInfo::empty_dircache()
+/*
+ Feeds a measured round trip time into the smoothed RTT estimator and recomputes
+ the retransmit timeout (RFC 6298): RTO = SRTT + 4 * RTTVAR
+ Only round trips for requests that weren't retransmitted should be sampled.
+*/
+void tnfsMountInfo::rtt_sample(uint32_t rtt_us)
+{
+    if (srtt_us == 0)
+    {
+        srtt_us = rtt_us;
+        rttvar_us = rtt_us / 2;
+    }
+    else
+    {
+        uint32_t delta = srtt_us > rtt_us ? srtt_us - rtt_us : rtt_us - srtt_us;
+        rttvar_us = (3 * rttvar_us + delta) / 4;
+        srtt_us = (7 * srtt_us + rtt_us) / 8;
+    }
+
+    uint32_t rto = (srtt_us + 4 * rttvar_us) / 1000;
+    if (rto < TNFS_MIN_TIMEOUT)
+        rto = TNFS_MIN_TIMEOUT;
+    else if (rto > (uint32_t)timeout_ms)
+        rto = timeout_ms;
+    rto_ms = rto;
+}
+
+/*
+ Doubles the retransmit timeout after a request timed out, up to timeout_ms
+*/
+void tnfsMountInfo::rto_backoff()
+{
+    rto_ms *= 2;
+    if (rto_ms > timeout_ms)
+        rto_ms = timeout_ms;
+}
+
+/*
+ Returns the cached listing matching the given OPENDIRX parameters or null
+ if there is none. Listings marked stale are thrown out instead.
+*/
+tnfsDirListing * tnfsMountInfo::find_dirlisting(const char *path, const char *pattern, uint8_t sortopts, uint8_t diropts, uint16_t maxresults)
 {
-    for (int i = 0; i < TNFS_MAX_DIRCACHE_ENTRIES; i++)
+    for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
     {
-        if (_dir_cache[i] != nullptr)
+        tnfsDirListing *p = _dir_listings[i];
+        if (p != nullptr && p->matches(path, pattern, sortopts, diropts, maxresults))
         {
-            delete _dir_cache[i];
-            _dir_cache[i] = nullptr;
+            if (p->stale && p != dir_listing)
+            {
+                delete_dirlisting(p);
+                return nullptr;
+            }
+            p->last_used = ++_dir_listing_uses;
+            return p;
         }
     }
-    _dir_cache_current = 0;
-    _dir_cache_count = 0;
-    _dir_cache_eof = false;
+    return nullptr;
 }
 
 /*
- Add a new entry to the directory cache and return a pointer to it
- Null is returned if we've reached TNFS_MAX_DIRCACHE_ENTRIES
+ Adds a new, empty listing, replacing the least recently used one if
+ TNFS_MAX_DIRLISTINGS are already kept
 */
-tnfsDirCacheEntry * tnfsMountInfo::new_dircache_entry()
+tnfsDirListing * tnfsMountInfo::new_dirlisting(const char *path, const char *pattern, uint8_t sortopts, uint8_t diropts, uint16_t maxresults)
 {
-    if(_dir_cache_count >= TNFS_MAX_DIRCACHE_ENTRIES)
+    int slot = -1;
+    for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
+    {
+        if (_dir_listings[i] == nullptr)
+        {
+            slot = i;
+            break;
+        }
+        if (_dir_listings[i] == dir_listing)
+            continue;
+        if (slot < 0 || _dir_listings[i]->last_used < _dir_listings[slot]->last_used)
+            slot = i;
+    }
+    if (slot < 0)
         return nullptr;
 
-    _dir_cache[_dir_cache_count] = new tnfsDirCacheEntry();
-    _dir_cache_count ++;
-    return _dir_cache[_dir_cache_count - 1];
+    delete _dir_listings[slot];
+    _dir_listings[slot] = new tnfsDirListing(path, pattern, sortopts, diropts, maxresults);
+    _dir_listings[slot]->last_used = ++_dir_listing_uses;
+    return _dir_listings[slot];
+}
+
+void tnfsMountInfo::delete_dirlisting(tnfsDirListing *pListing)
+{
+    for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
+    {
+        if (_dir_listings[i] == pListing)
+        {
+            delete _dir_listings[i];
+            _dir_listings[i] = nullptr;
+        }
+    }
+    if (dir_listing == pListing)
+        dir_listing = nullptr;
 }
 
 /*
- Return a pointer to the next unread directory cache entry
- Returns null if there are no cache entries left to read
+ Returns the bytes of directory listings a mount may keep
 */
-tnfsDirCacheEntry * tnfsMountInfo::next_dircache_entry()
+static size_t _dirlisting_budget()
 {
-    if(_dir_cache_current >= _dir_cache_count)
-        return nullptr;
+#ifdef ESP_PLATFORM
+    if (!tnfsDirListing::in_psram())
+        return TNFS_DIRLISTING_BUDGET_NO_PSRAM;
+#endif
+    return TNFS_DIRLISTING_BUDGET;
+}
 
-    _dir_cache_current++;
-    return _dir_cache[_dir_cache_current - 1];
+/*
+ Makes room for pListing to grow by the given number of bytes, throwing out
+ other listings (least recently used first) as needed.
+ Returns false if it still wouldn't fit within the budget.
+*/
+bool tnfsMountInfo::reserve_dirlisting(tnfsDirListing *pListing, size_t bytes)
+{
+    while (true)
+    {
+        size_t total = bytes;
+        int oldest = -1;
+        for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
+        {
+            tnfsDirListing *p = _dir_listings[i];
+            if (p == nullptr)
+                continue;
+            total += p->bytes();
+            if (p != pListing && p != dir_listing && p->bytes() > 0 &&
+                (oldest < 0 || p->last_used < _dir_listings[oldest]->last_used))
+                oldest = i;
+        }
+        if (total <= _dirlisting_budget())
+            return true;
+        if (oldest < 0)
+            return false;
+        delete _dir_listings[oldest];
+        _dir_listings[oldest] = nullptr;
+    }
 }
 
 /*
- Returns the directory position of the currently cached directory
- entry as provided by the server.
- Returns -1 if there is no currently cached entry.
+ Marks all listings as stale after something on the server was changed.
+ The currently open listing keeps serving its directory until it's closed.
 */
-int tnfsMountInfo::tell_dircache_entry()
+void tnfsMountInfo::invalidate_dirlistings()
+{
+    for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
+    {
+        if (_dir_listings[i] == nullptr)
+            continue;
+        if (_dir_listings[i] == dir_listing)
+            _dir_listings[i]->stale = true;
+        else
+        {
+            delete _dir_listings[i];
+            _dir_listings[i] = nullptr;
+        }
+    }
+}
+
+// Throw out all directory listings
+void tnfsMountInfo::empty_dirlistings()
 {
-    if(_dir_cache_current >= _dir_cache_count)
-        return -1;
-    return _dir_cache[_dir_cache_current]->dirpos;
+    for (int i = 0; i < TNFS_MAX_DIRLISTINGS; i++)
+    {
+        if (_dir_listings[i] != nullptr)
+        {
+            delete _dir_listings[i];
+            _dir_listings[i] = nullptr;
+        }
+    }
+    dir_listing = nullptr;
 }
 
 /*
@@ -6,11 +6,13 @@
 
 #include "fnDNS.h"
 #include "fnTcpClient.h"
+#include "tnfslibDirListing.h"
 
 
 #define TNFS_DEFAULT_PORT 16384
 #define TNFS_RETRIES 5 // Number of times to retry if we fail to send/receive a packet
 #define TNFS_TIMEOUT 2000 // This is how long we wait for a reply packet from the server before trying again
+#define TNFS_MIN_TIMEOUT 100 // Lower bound for the adaptive UDP retransmit timeout, slow commands wait TNFS_TIMEOUT
 #define TNFS_RETRY_DELAY 1000 // Default delay before retrying. Server will provide a minimum during TNFS_CMD_MOUNT
 #define TNFS_MAX_BACKOFF_DELAY 3000 // Longest we'll wait if server sends us a EAGAIN error
 #define TNFS_MAX_FILE_HANDLES 8 // Max number of file handles we'll open to the server
@@ -21,7 +23,15 @@
 #define TNFS_INVALID_HANDLE -1
 #define TNFS_INVALID_SESSION 0 // We're assuming a '0' is never a valid session ID
 
-#define TNFS_MAX_DIRCACHE_ENTRIES 32 // Max number of directory cache entries we'll store
+#define TNFS_MAX_DIRCACHE_ENTRIES 32 // Max number of directory entries we'll ask for per TNFS_READDIRX
+#define TNFS_MAX_DIRLISTINGS 4 // Max number of directory listings we'll keep per mount
+#ifndef TNFS_DIRLISTING_BUDGET
+#define TNFS_DIRLISTING_BUDGET (256 * 1024) // Max bytes of directory listings we'll keep per mount
+#endif
+#ifndef TNFS_DIRLISTING_BUDGET_NO_PSRAM
+#define TNFS_DIRLISTING_BUDGET_NO_PSRAM (16 * 1024) // The same on boards without PSRAM, where they take internal RAM
+#endif
+#define TNFS_DIRLISTING_TTL 30000 // How long (ms) a listing is trusted before checking the directory's mtime
 
 #define TNFS_PROTOCOL_UNKNOWN 0
 #define TNFS_PROTOCOL_TCP 1
@@ -56,26 +66,13 @@ struct tnfsFileHandleInfo
     char filename[TNFS_MAX_FILELEN];
 };
 
-// A place to store each directory entry we cache from a response to TNFS_READDIRX
-struct tnfsDirCacheEntry
-{
-    uint16_t dirpos;
-    uint8_t flags;
-    uint32_t filesize;
-    uint32_t m_time;
-    uint32_t c_time;
-    char entryname[TNFS_MAX_FILELEN];
-};
-
 // Everything we need to know about and keep track of for the server we're talking to
 class tnfsMountInfo
 {
 private:
     tnfsFileHandleInfo * _file_handles[TNFS_MAX_FILE_HANDLES] = { nullptr }; // Stored from server's responses to TNFS_OPEN
-    tnfsDirCacheEntry * _dir_cache[TNFS_MAX_DIRCACHE_ENTRIES] = { nullptr };
-    uint16_t _dir_cache_current = 0;
-    uint16_t _dir_cache_count = 0;
-    bool _dir_cache_eof = false;
+    tnfsDirListing * _dir_listings[TNFS_MAX_DIRLISTINGS] = { nullptr };
+    uint32_t _dir_listing_uses = 0;
 
 public:
     ~tnfsMountInfo();
@@ -89,14 +86,12 @@ public:
     void delete_filehandleinfo(uint8_t filehandle);
     void delete_filehandleinfo(tnfsFileHandleInfo * pFilehandle);
 
-    tnfsDirCacheEntry * new_dircache_entry();
-    tnfsDirCacheEntry * next_dircache_entry();
-
-    int tell_dircache_entry();
-    void empty_dircache();
-    uint16_t count_dircache() { return _dir_cache_count; };
-    void set_dircache_eof() { _dir_cache_eof = true; };
-    bool get_dircache_eof() { return _dir_cache_eof; };
+    tnfsDirListing * find_dirlisting(const char *path, const char *pattern, uint8_t sortopts, uint8_t diropts, uint16_t maxresults);
+    tnfsDirListing * new_dirlisting(const char *path, const char *pattern, uint8_t sortopts, uint8_t diropts, uint16_t maxresults);
+    void delete_dirlisting(tnfsDirListing *pListing);
+    bool reserve_dirlisting(tnfsDirListing *pListing, size_t bytes);
+    void invalidate_dirlistings();
+    void empty_dirlistings();
 
     uint8_t protocol = TNFS_PROTOCOL_UNKNOWN;
     fnTcpClient tcp_client;
@@ -116,8 +111,25 @@ public:
     int timeout_ms = TNFS_TIMEOUT;
     uint8_t current_sequence_num = 0; // Updated with each transaction to the server
 
+    // Adaptive retransmit timeout for UDP (Jacobson/Karels), updated from transaction round trips
+    uint32_t srtt_us = 0; // Smoothed round trip time; 0 until we have a first sample
+    uint32_t rttvar_us = 0; // Round trip time variation
+    int rto_ms = TNFS_TIMEOUT; // Current retransmit timeout, kept between TNFS_MIN_TIMEOUT and timeout_ms
+    uint32_t retransmits = 0; // Requests we had to send again
+    uint32_t duplicate_responses = 0; // Delayed or repeated responses we discarded
+
+    void rtt_sample(uint32_t rtt_us);
+    void rto_backoff();
+    // Commands the server may be slow to answer keep the fixed timeout
+    int current_timeout_ms(bool slow_command = false) { return protocol == TNFS_PROTOCOL_UDP && !slow_command ? rto_ms : timeout_ms; };
+
     int16_t dir_handle = TNFS_INVALID_HANDLE; // Stored from server's response to TNFS_OPENDIR
     uint16_t dir_entries = 0; // Stored from server's response to TNFS_OPENDIRX
+    // Currently open directory, served from dir_listing where possible. The server's
+    // directory handle is only opened (and positioned) when entries need to be fetched.
+    tnfsDirListing *dir_listing = nullptr;
+    uint16_t dir_position = 0; // Position of the next entry tnfs_readdirx will return
+    uint16_t dir_server_position = 0; // Position of the next entry the server's handle will return
     std::recursive_mutex transaction_mutex;
 
 #ifdef TNFS_UDP_SIMULATE_RECV_TWICE
@@ -9,4 +9,18 @@ int _tnfs_udp_recv(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt);
 
 bool _tnfs_udp_do_send(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_size);
 
+#ifdef TNFS_UDP_SIMULATE_POOR_CONNECTION
+// Stands in for the server's socket, so tests can run transactions without a network.
+// recv returns the length of the next response, or -1 if none has arrived yet.
+struct tnfsSimulatedServer
+{
+    bool (*send)(tnfsMountInfo *m_info, const tnfsPacket &pkt, uint16_t payload_size);
+    int (*recv)(tnfsMountInfo *m_info, tnfsPacket &pkt);
+};
+
+extern tnfsSimulatedServer *tnfs_udp_simulated_server;
+
+bool _tnfs_transaction(tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_size);
+#endif
+
 #endif
@@ -1,8 +1,28 @@
+#include <cstring>
+
 #include "tnfslib_udp.h"
 #include "tnfslibMountInfo.h"
 #include "../../include/debug.h"
 
 #ifdef TNFS_UDP_SIMULATE_POOR_CONNECTION
+tnfsSimulatedServer *tnfs_udp_simulated_server = nullptr;
+
+static bool _tnfs_udp_simulated_send(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_size)
+{
+    if (tnfs_udp_simulated_server != nullptr)
+        return tnfs_udp_simulated_server->send(m_info, pkt, payload_size);
+    return _tnfs_udp_do_send(udp, m_info, pkt, payload_size);
+}
+
+static int _tnfs_udp_simulated_recv(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt)
+{
+    if (tnfs_udp_simulated_server != nullptr)
+        return tnfs_udp_simulated_server->recv(m_info, pkt);
+    if (!udp->parsePacket())
+        return -1;
+    return udp->read(pkt.rawData, sizeof(pkt.rawData));
+}
+
 bool _tnfs_udp_send(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t payload_size)
 {
 #ifdef TNFS_UDP_SIMULATE_SEND_LOSS
@@ -14,10 +34,10 @@ bool _tnfs_udp_send(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt, uint16_t
 #ifdef TNFS_UDP_SIMULATE_SEND_TWICE
     if (rand() < TNFS_UDP_SIMULATE_SEND_TWICE_PROB * RAND_MAX) {
         Debug_println("TNFS_UDP_SIMULATE: send twice");
-        _tnfs_udp_do_send(udp, m_info, pkt, payload_size);
+        _tnfs_udp_simulated_send(udp, m_info, pkt, payload_size);
     }
 #endif
-    return _tnfs_udp_do_send(udp, m_info, pkt, payload_size);
+    return _tnfs_udp_simulated_send(udp, m_info, pkt, payload_size);
 }
 
 int _tnfs_udp_recv(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt)
@@ -31,19 +51,17 @@ int _tnfs_udp_recv(fnUDP *udp, tnfsMountInfo *m_info, tnfsPacket &pkt)
         return len;
     }
 #endif
-    if (!udp->parsePacket())
+    int len = _tnfs_udp_simulated_recv(udp, m_info, pkt);
+    if (len < 0)
     {
         return -1;
     }
 #ifdef TNFS_UDP_SIMULATE_RECV_LOSS
     if (rand() < TNFS_UDP_SIMULATE_RECV_LOSS_PROB * RAND_MAX) {
         Debug_println("TNFS_UDP_SIMULATE: recv loss");
-        tnfsPacket lostPkt;
-        udp->read(lostPkt.rawData, sizeof(pkt.rawData));
         return -1;
     }
 #endif
-    int len = udp->read(pkt.rawData, sizeof(pkt.rawData));
 #ifdef TNFS_UDP_SIMULATE_RECV_TWICE
     memcpy(m_info->last_packet, pkt.rawData, sizeof(m_info->last_packet));
     m_info->last_packet_len = len;
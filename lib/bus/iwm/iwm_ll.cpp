@@ -10,6 +10,7 @@
 #include <driver/rmt_encoder.h>
 
 #include "iwm_ll.h"
+#include "iwm_sp_codec.h"
 #include "iwm.h"
 #include "../device/iwm/disk2.h"
 #include "../device/iwm/fuji.h"
@@ -250,66 +251,15 @@ int IRAM_ATTR iwm_sp_ll::iwm_send_packet_spi()
   return 0;
 }
 
-#define IWM_NEXT_BIT() ({bool _v = ((src[offset / 8] << (offset % 8)) & 0x80) == 0x80; \
-      offset++; _v;})
 uint8_t iwm_ll::iwm_decode_byte(uint8_t *src, size_t src_size, unsigned int sample_frequency,
                                 int timeout, size_t *bit_offset, bool *more_avail)
 {
-  unsigned int numbits, idx;
-  uint8_t byte;
-  bool bit, current_level;
   const int spi_samples_per_cell = (CELL_US * sample_frequency) / MHZ;
-  const int half_samples = spi_samples_per_cell / 2;
-  size_t offset = *bit_offset;
-  static bool prev_level = true;
 
   // ((f_nyquist * f_over) * 18) / (1000 * 1000);
   int timeout_ctr = (sample_frequency * timeout) / MHZ;
 
-
-  *more_avail = true;
-  for (numbits = 8, byte = 0; numbits; numbits--) {
-    for (idx = bit = 0; idx < spi_samples_per_cell; idx++) {
-      if (offset / 8 >= src_size) {
-        // out of spi data, abort
-        numbits = 1;
-        *more_avail = false;
-        break;
-      }
-
-      current_level = IWM_NEXT_BIT();
-
-      // loop through 4 usec worth of samples looking for an edge
-      // if found, jump forward 2 usec and set bit = 1;
-      // otherwise, bit = 0;
-      if (prev_level != current_level) {
-        bit = true;
-        // resync the receiver - must be halfway through 4-us period at an edge
-        idx = half_samples;
-      }
-
-      prev_level = current_level;
-    }
-
-    byte <<= 1;
-    byte |= bit;
-  }
-
-  // See if there are more 1 bits
-  for (; timeout_ctr; timeout_ctr--) {
-    if (offset / 8 >= src_size) {
-      *more_avail = false;
-      break;
-    }
-    current_level = IWM_NEXT_BIT();
-    if (prev_level != current_level)
-      break;
-  }
-  if (!timeout_ctr)
-    *more_avail = false;
-
-  *bit_offset = offset;
-  return byte;
+  return decoder.decode_byte(src, src_size, spi_samples_per_cell, timeout_ctr, bit_offset, more_avail);
 }
 
 size_t iwm_ll::iwm_decode_buffer(uint8_t *src, size_t src_size, unsigned int sample_frequency,
@@ -448,13 +398,7 @@ int IRAM_ATTR iwm_sp_ll::iwm_read_packet_spi(uint8_t* buffer, int packet_len)
     }
     else if ((numgrps != 0) && (group < numgrps) && (idx == grpstart + group * 8 + 7)) // calc checksum for group of 7 bytes
     {
-      checksum ^= ((buffer[idx - 8] << (1)) & 0x80) | ((buffer[idx - 7]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (2)) & 0x80) | ((buffer[idx - 6]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (3)) & 0x80) | ((buffer[idx - 5]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (4)) & 0x80) | ((buffer[idx - 4]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (5)) & 0x80) | ((buffer[idx - 3]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (6)) & 0x80) | ((buffer[idx - 2]) & 0x7f);
-      checksum ^= ((buffer[idx - 8] << (7)) & 0x80) | ((buffer[idx - 1]) & 0x7f);
+      checksum ^= sp_group_checksum(&buffer[idx - 8]);
       group++;
     }
     else if (idx == 14 + numodd + (numodd != 0) + numgrps * 8 + 1) // decode checksum sent in packet
@@ -704,48 +648,12 @@ void iwm_sp_ll::encode_packet(uint8_t source, iwm_packet_type_t packet_type, uin
 
   if ((data != nullptr) && (num != 0))
   {
-  int grpbyte, grpcount;
-  uint8_t grpmsb;
-  uint8_t group_buffer[7];
-                                    // Calculate checksum of sector bytes before we destroy them
-    for (int count = 0; count < num; count++) // xor all the data bytes
-      checksum = checksum ^ data[count];
-
-    // Start assembling the packet at the rear and work
-    // your way to the front so we don't overwrite data
-    // we haven't encoded yet
-
     // how many groups of 7?
     numgrps = num / 7;
     numodds = num % 7;
 
-    // grps of 7
-    for (grpcount = numgrps - 1; grpcount >= 0; grpcount--) // 73
-    {
-      memcpy(group_buffer, data + numodds + (grpcount * 7), 7);
-      // add group msb byte
-      grpmsb = 0;
-      for (grpbyte = 0; grpbyte < 7; grpbyte++)
-        grpmsb = grpmsb | ((group_buffer[grpbyte] >> (grpbyte + 1)) & (0x80 >> (grpbyte + 1)));
-      // groups start after odd bytes, which is at 13 + numodds + (numodds != 0) + 1
-      int grpstart = 13 + numodds + (numodds != 0) + 1;
-      packet_buffer[grpstart + (grpcount * 8)] = grpmsb | 0x80; // set msb to one
-
-      // now add the group data bytes bits 6-0
-      for (grpbyte = 0; grpbyte < 7; grpbyte++)
-        packet_buffer[grpstart + 1 + (grpcount * 8) + grpbyte] = group_buffer[grpbyte] | 0x80;
-    }
-
-    // oddbytes
-    if(numodds)
-    {
-      packet_buffer[14] = 0x80; // init the oddmsb
-      for (int oddcnt = 0; oddcnt < numodds; oddcnt++)
-      {
-        packet_buffer[14] |= (data[oddcnt] & 0x80) >> (1 + oddcnt);
-        packet_buffer[15 + oddcnt] = data[oddcnt] | 0x80;
-      }
-    }
+    // odd bytes and groups go after the header, checksum of the data comes with them
+    checksum = sp_encode_data(data, num, packet_buffer + 14);
   }
 
   // header
@@ -791,37 +699,17 @@ size_t iwm_sp_ll::decode_data_packet(uint8_t* output_data)
 
 size_t iwm_sp_ll::decode_data_packet(uint8_t* input_data, uint8_t* output_data)
 {
-  int grpbyte, grpcount;
   uint8_t numgrps, numodd;
-  size_t numdata;
-  uint8_t bit0to6, bit7;
-  uint8_t group_buffer[8];
 
   //Handle arbitrary length packets :)
   numodd = input_data[11] & 0x7f;
   numgrps = input_data[12] & 0x7f;
-  numdata = numodd + numgrps * 7;
-  // Debug_printf("\nDecoding %d bytes",numdata);
-
-  // decode oddbyte(s), 1 in a 512 data packet
-  for(int i = 0; i < numodd; i++){
-    output_data[i] = ((input_data[13] << (i+1)) & 0x80) | (input_data[14+i] & 0x7f);
-  }
+  // Debug_printf("\nDecoding %d bytes",numodd + numgrps * 7);
 
-  // decode groups of 7, 73 grps of 7 in a 512 byte packet
-  int grpstart = 12 + numodd + (numodd != 0) + 1;
-  for (grpcount = 0; grpcount < numgrps; grpcount++)
-  {
-    memcpy(group_buffer, input_data + grpstart + (grpcount * 8), 8);
-    for (grpbyte = 0; grpbyte < 7; grpbyte++)
-    {
-      bit7 = (group_buffer[0] << (grpbyte + 1)) & 0x80;
-      bit0to6 = (group_buffer[grpbyte + 1]) & 0x7f;
-      output_data[numodd + (grpcount * 7) + grpbyte] = bit7 | bit0to6;
-    }
-  }
+  // oddbyte(s), 1 in a 512 data packet, then groups of 7, 73 grps of 7 in a 512 byte packet
+  sp_decode_data(input_data + 13, numodd, numgrps, output_data);
 
-  return numdata;
+  return numodd + numgrps * 7;
 }
 
 void iwm_sp_ll::set_output_to_spi()
@@ -14,6 +14,7 @@
 #include <freertos/semphr.h>
 
 #include "../../include/pinmap.h"
+#include "iwm_spi_decoder.h"
 
 // #define SPI_II_LEN 27000        // 200 ms at 1 mbps for disk ii + some extra
 #define TRACK_LEN 6646          // https://applesaucefdc.com/woz/reference2/
@@ -187,6 +188,7 @@ class iwm_ll
 protected:
   // SPI receiver
   spi_transaction_t rxtrans;
+  iwm_spi_decoder decoder;
 
   // low level bit-banging i/o functions
   bool iwm_req_val() { return (IWM_BIT(SP_REQ)); };
@@ -0,0 +1,172 @@
+#ifndef IWM_SP_CODEC_H
+#define IWM_SP_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SmartPort packet data encoding.
+ *
+ * Data is sent as the odd bytes (num % 7) followed by groups of 7 bytes.
+ * Each group is a byte holding the 7 MSBs (first data byte in bit 6) and
+ * then the 7 bytes with their low bits; every byte on the wire has bit 7
+ * set. The odd bytes are sent the same way with a shorter group. The
+ * packet checksum is the XOR of all data bytes.
+ *
+ * A group is handled as one 64-bit word, byte k of the group in bits
+ * 8k..8k+7. The MSBs are gathered into the group byte (and spread back
+ * out) with a single multiply, and the checksum of the group is folded
+ * from the same word, so a group costs one pass and no per-bit loops.
+ */
+
+// Bit 7 of the 7 group bytes
+#define SP_GROUP_MSBS 0x0080808080808080ULL
+// Copies bit 0 of byte k to bit 62 - 9k, which puts it in bit 6 - k of the top byte
+#define SP_GATHER_MUL 0x4020100804020100ULL
+// Copies bit 6 - k to bit 8k + 7 (copies 9 bits apart, so they never overlap)
+#define SP_SPREAD_MUL 0x0080402010080402ULL
+
+static inline uint64_t sp_load7(const uint8_t *p)
+{
+  return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+         (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48;
+}
+
+static inline void sp_store7(uint8_t *p, uint64_t w)
+{
+  p[0] = w;
+  p[1] = w >> 8;
+  p[2] = w >> 16;
+  p[3] = w >> 24;
+  p[4] = w >> 32;
+  p[5] = w >> 40;
+  p[6] = w >> 48;
+}
+
+// XOR of the 8 bytes of w
+static inline uint8_t sp_fold(uint64_t w)
+{
+  uint32_t x = (uint32_t)w ^ (uint32_t)(w >> 32);
+  x ^= x >> 16;
+  x ^= x >> 8;
+  return x;
+}
+
+// MSBs of the group bytes in w as the group byte, without bit 7 set
+static inline uint8_t sp_gather_msbs(uint64_t w)
+{
+  return (((w & SP_GROUP_MSBS) >> 7) * SP_GATHER_MUL) >> 56 & 0x7f;
+}
+
+// Inverse of sp_gather_msbs()
+static inline uint64_t sp_spread_msbs(uint8_t msbs)
+{
+  return ((uint64_t)(msbs & 0x7f) * SP_SPREAD_MUL) & SP_GROUP_MSBS;
+}
+
+/**
+ * @brief Encode a group of 7 bytes to 8 wire bytes
+ * @return XOR of the 7 data bytes
+ */
+static inline uint8_t sp_encode_group(const uint8_t *src, uint8_t *dst)
+{
+  uint64_t w = sp_load7(src);
+  // dst may overlap src, so everything is read before writing
+  dst[0] = sp_gather_msbs(w) | 0x80;
+  sp_store7(dst + 1, w | SP_GROUP_MSBS);
+  return sp_fold(w);
+}
+
+/**
+ * @brief Decode 8 wire bytes to a group of 7 bytes
+ * @return XOR of the 7 decoded bytes
+ */
+static inline uint8_t sp_decode_group(const uint8_t *src, uint8_t *dst)
+{
+  uint64_t w = (sp_load7(src + 1) & ~SP_GROUP_MSBS) | sp_spread_msbs(src[0]);
+  sp_store7(dst, w);
+  return sp_fold(w);
+}
+
+// XOR of the 7 bytes a group of 8 wire bytes decodes to
+static inline uint8_t sp_group_checksum(const uint8_t *src)
+{
+  return sp_fold((sp_load7(src + 1) & ~SP_GROUP_MSBS) | sp_spread_msbs(src[0]));
+}
+
+// Number of wire bytes for num data bytes
+static inline size_t sp_encoded_len(size_t num)
+{
+  size_t numodd = num % 7;
+  return numodd + (numodd != 0) + num / 7 * 8;
+}
+
+/**
+ * @brief Encode num data bytes (odd bytes, then groups) to wire bytes
+ * @param data data to encode; may be the same buffer as dst, since the
+ * groups are encoded from the end towards the front
+ * @param dst where the odd byte MSBs go, see sp_encoded_len()
+ * @return XOR of the data bytes
+ */
+static inline uint8_t sp_encode_data(const uint8_t *data, size_t num, uint8_t *dst)
+{
+  size_t numodd = num % 7;
+  size_t numgrps = num / 7;
+  const uint8_t *src = data + numodd + numgrps * 7;
+  uint8_t *grp = dst + numodd + (numodd != 0) + numgrps * 8;
+  uint8_t checksum = 0;
+
+  while (src != data + numodd)
+  {
+    src -= 7;
+    grp -= 8;
+    checksum ^= sp_encode_group(src, grp);
+  }
+
+  if (numodd)
+  {
+    uint8_t msbs = 0x80;
+    for (size_t i = numodd; i--;)
+    {
+      uint8_t b = data[i];
+      msbs |= (b & 0x80) >> (i + 1);
+      dst[1 + i] = b | 0x80;
+      checksum ^= b;
+    }
+    dst[0] = msbs;
+  }
+
+  return checksum;
+}
+
+/**
+ * @brief Decode wire bytes to numodd + numgrps * 7 data bytes
+ * @param src the odd byte MSBs (or first group when there are no odd bytes)
+ * @param dst decoded data; may be the same buffer as src, since the data
+ * is shorter and decoded from the front
+ * @return XOR of the decoded bytes
+ */
+static inline uint8_t sp_decode_data(const uint8_t *src, size_t numodd, size_t numgrps, uint8_t *dst)
+{
+  uint8_t checksum = 0;
+
+  if (numodd)
+  {
+    uint8_t msbs = src[0];
+    for (size_t i = 0; i < numodd; i++)
+    {
+      uint8_t b = ((msbs << (i + 1)) & 0x80) | (src[1 + i] & 0x7f);
+      dst[i] = b;
+      checksum ^= b;
+    }
+    src += numodd + 1;
+    dst += numodd;
+  }
+
+  for (; numgrps; numgrps--, src += 8, dst += 7)
+    checksum ^= sp_decode_group(src, dst);
+
+  return checksum;
+}
+
+#endif // IWM_SP_CODEC_H
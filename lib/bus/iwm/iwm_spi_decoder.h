@@ -0,0 +1,161 @@
+#ifndef IWM_SPI_DECODER_H
+#define IWM_SPI_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Decodes bytes from the oversampled RDDATA/WRDATA stream captured by SPI.
+ *
+ * Samples are bits, MSB first. A level change within a bit cell is a 1, no
+ * change is a 0. After an edge the receiver resyncs to half way through the
+ * cell. Instead of walking the samples one at a time, edges are found for 64
+ * samples at once by XOR-ing a word with a copy of itself shifted by one
+ * sample, and located by counting leading zeros.
+ *
+ * The level of the last sample seen is carried from byte to byte (and from
+ * packet to packet) in the decoder object instead of a function static.
+ */
+class iwm_spi_decoder
+{
+public:
+  bool level = true;
+
+  /**
+   * @brief Decode one byte
+   * @param src SPI samples
+   * @param src_size size of src in bytes
+   * @param samples_per_cell samples per 4 us bit cell
+   * @param timeout_samples how far to look for the next 1 bit after the byte
+   * @param bit_offset position in src, in samples; updated
+   * @param more_avail set false when the samples or the timeout run out
+   * @return decoded byte
+   */
+  inline uint8_t decode_byte(const uint8_t *src, size_t src_size, int samples_per_cell,
+                             int timeout_samples, size_t *bit_offset, bool *more_avail)
+  {
+    const size_t src_bits = src_size * 8;
+    // samples left in a cell after an edge resyncs it half way through
+    const size_t after_edge = samples_per_cell - samples_per_cell / 2 - 1;
+    size_t pos = *bit_offset;
+    uint8_t byte = 0;
+    edge_window win(src, src_size);
+
+    *more_avail = true;
+    for (int numbits = 8; numbits; numbits--)
+    {
+      size_t cell_end = pos + samples_per_cell;
+      bool bit = false;
+
+      while (true)
+      {
+        size_t limit = cell_end < src_bits ? cell_end : src_bits;
+        size_t edge = win.find(pos, limit, level);
+        if (edge == limit)
+        {
+          pos = limit;
+          break;
+        }
+        bit = true;
+        level = !level;
+        pos = edge + 1;
+        cell_end = pos + after_edge;
+      }
+
+      byte = (byte << 1) | bit;
+
+      if (pos < cell_end)
+      {
+        // out of spi data, abort
+        *more_avail = false;
+        break;
+      }
+    }
+
+    if (*more_avail)
+    {
+      // See if there are more 1 bits. The level isn't updated here, so the
+      // edge found also counts for the first bit of the next byte.
+      size_t limit = timeout_samples > 0 ? pos + timeout_samples : pos;
+      if (limit > src_bits)
+        limit = src_bits;
+      size_t edge = win.find(pos, limit, level);
+      if (edge == limit)
+      {
+        *more_avail = false;
+        pos = limit;
+      }
+      else
+        pos = edge + 1;
+    }
+
+    *bit_offset = pos;
+    return byte;
+  }
+
+private:
+  /*
+   * Edges (samples differing from the one before) for a 64 sample window
+   * of src, first sample in the MSB. The window moves forward as needed.
+   */
+  struct edge_window
+  {
+    const uint8_t *src;
+    size_t src_size;
+    uint64_t edges = 0;
+    size_t start = 0;
+    size_t end = 0;
+
+    edge_window(const uint8_t *s, size_t size) : src(s), src_size(size) {}
+
+    // Load the window at sample pos; level is that of the sample before it
+    inline void load(size_t pos, bool level)
+    {
+      size_t i = pos / 8;
+      uint64_t w = 0;
+
+      if (i + 8 <= src_size)
+      {
+        for (size_t k = 0; k < 8; k++)
+          w = (w << 8) | src[i + k];
+      }
+      else
+      {
+        for (size_t k = 0; k < 8; k++)
+          w = (w << 8) | (i + k < src_size ? src[i + k] : 0);
+      }
+      w <<= pos % 8;
+
+      edges = w ^ ((w >> 1) | ((uint64_t)level << 63));
+      start = pos;
+      end = i * 8 + 64;
+    }
+
+    /**
+     * @brief Find the first sample in [pos, limit) that differs from level,
+     * which must be the level of the sample before pos
+     * @return its position, or limit if there is none
+     */
+    inline size_t find(size_t pos, size_t limit, bool level)
+    {
+      while (pos < limit)
+      {
+        if (pos >= end)
+          load(pos, level);
+
+        size_t stop = limit < end ? limit : end;
+        uint64_t m = edges << (pos - start);
+        size_t n = stop - pos;
+        if (n < 64)
+          m &= ~(~(uint64_t)0 >> n);
+        if (m)
+          return pos + __builtin_clzll(m);
+        // no edges means all samples up to stop were at level
+        pos = stop;
+      }
+      return limit;
+    }
+  };
+};
+
+#endif // IWM_SPI_DECODER_H
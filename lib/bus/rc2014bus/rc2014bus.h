@@ -140,6 +140,10 @@ public:
         return (_i_head - _i_tail + BUFFER_SIZE) % BUFFER_SIZE;
     }
 
+    size_t room() {
+        return BUFFER_SIZE - 1 - avail();
+    }
+
 private:
     std::mutex _m;
     std::array<uint8_t, BUFFER_SIZE> _fifo;
@@ -10,6 +10,9 @@
 #include "siocpm.h"
 
 #include "fnSystem.h"
+#ifndef ESP_PLATFORM
+#include "fnReactor.h"
+#endif
 #include "fnConfig.h"
 #include "fnDNS.h"
 #include "led.h"
@@ -524,8 +527,25 @@ void systemBus::service()
 #ifndef ESP_PLATFORM
     // loop until all SIO "events" are processed
     //   true  = SIO port needs handling
-    //   false = no SIO "event" ocurred within interval
-    } while (fnSioCom.poll(1));
+    //   false = no SIO "event" pending
+    } while (fnSioCom.poll(0));
+
+    // Tell the main loop what to wait for before calling us again
+    fnReactor.watch(fnSioCom.get_fd());
+    fnReactor.wake_in(fnSioCom.idle_timeout());
+
+    // These modes poll for their data
+    if ((_udpDev != nullptr && _udpDev->udpstreamActive) ||
+        (_cpmDev != nullptr && _cpmDev->cpmActive && Config.get_cpm_enabled()) ||
+        (_modemDev != nullptr && _modemDev->modemActive && Config.get_modem_enabled()) ||
+        (_fujiDev->cassette()->is_mounted() && Config.get_cassette_enabled() && _fujiDev->cassette()->is_active()))
+        fnReactor.wake_in(1);
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (_netDev[i] != nullptr)
+            _netDev[i]->sio_interrupt_watch();
+    }
 #endif
 }
 
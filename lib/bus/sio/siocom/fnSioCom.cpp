@@ -40,6 +40,22 @@ bool SioCom::poll(int ms)
     return _sioPort->poll(ms); 
 }
 
+/*
+ Descriptor which becomes readable on "port event", -1 if there is none
+ */
+int SioCom::get_fd()
+{
+    return _sioPort->get_fd();
+}
+
+/*
+ Milliseconds until the port has to be polled again, -1 = no limit
+ */
+int SioCom::idle_timeout()
+{
+    return _sioPort->idle_timeout();
+}
+
 void SioCom::set_baudrate(uint32_t baud) 
 { 
     _sioPort->set_baudrate(baud); 
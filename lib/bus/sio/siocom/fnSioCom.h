@@ -39,6 +39,10 @@ public:
     void end();
     bool poll(int ms);
 
+    // for main loop to wait on SIO port events
+    int get_fd();
+    int idle_timeout();
+
     void set_baudrate(uint32_t baud);
     uint32_t get_baudrate();
 
@@ -43,9 +43,6 @@ NetSioPort::NetSioPort() :
     _initialized(false),
     _command_asserted(false),
     _motor_asserted(false),
-    _rxhead(0),
-    _rxtail(0),
-    _rxfull(false),
     _sync_request_num(-1),
     _sync_write_size(-1),
     _errcount(0),
@@ -69,7 +66,7 @@ void NetSioPort::begin(int baud)
 
     _command_asserted = false;
     _motor_asserted = false;
-    rxbuffer_flush();
+    _rxbuf.clear();
 
     // Wait for WiFi
     int suspend_ms = _errcount < 5 ? 400 : 2000;
@@ -177,6 +174,24 @@ bool NetSioPort::poll(int ms)
     return false;
 }
 
+/* Time until keep_alive() or resume_test() have something to do,
+   there's no limit if NetSIO isn't going to be resumed
+*/
+int NetSioPort::idle_timeout()
+{
+    uint64_t ms = fnSystem.millis();
+    uint64_t next;
+
+    if (_initialized)
+        next = (_alive_request > _alive_time ? _alive_request : _alive_time) + ALIVE_RATE_MS;
+    else if (_resume_time != 0)
+        next = _resume_time;
+    else
+        return -1;
+
+    return next > ms ? (int)(next - ms) : 0;
+}
+
 void NetSioPort::suspend(int ms)
 {
     Debug_printf("Suspending NetSIO for %d ms\n", ms);
@@ -238,47 +253,31 @@ int NetSioPort::ping(int count, int interval_ms, int timeout_ms, bool fast)
     return ok_count ? rtt_sum / ok_count : -1;
 }
 
-bool NetSioPort::rxbuffer_empty()
-{
-    return (_rxhead == _rxtail && !_rxfull);
-}
-
-bool NetSioPort::rxbuffer_put(uint8_t b) 
+/* Store received SIO data, corrupting it if the peer runs at a different baud rate.
+   On overrun the oldest bytes are dropped, as the UART would. This runs on the
+   reading thread (via wait_for_data), so dropping from the consumer side is safe.
+*/
+void NetSioPort::rxbuffer_put(uint8_t *data, size_t size)
 {
-    _rxbuf[_rxhead++] = b;
-    _rxhead %= sizeof(_rxbuf);
-    if (_rxfull) {
-        // tail byte was overwritten / lost
-        _rxtail = _rxhead;
-        return true;
+    if (_baud_peer < _baud * 90 / 100 || _baud_peer > _baud * 110 / 100)
+    {
+        uint8_t x = (uint8_t)_baud_peer ^ (uint8_t)_baud;
+        for (size_t i = 0; i < size; i++)
+            data[i] ^= x; // corrupt byte
     }
-    _rxfull = (_rxhead == _rxtail);
-    return false;
-}
-
-int NetSioPort::rxbuffer_get() 
-{
-    int b;
-    if (rxbuffer_empty())
-        return -1;
-    b = _rxbuf[_rxtail++];
-    _rxtail %= sizeof(_rxbuf);
-    _rxfull = false;
-    return b;
-}
-
-int  NetSioPort::rxbuffer_available() 
-{
-    int avail = _rxhead - _rxtail;
-    if ((avail < 0) || (avail == 0 && _rxfull))
-        avail += sizeof(_rxbuf);
-    return avail;
-}
 
-void NetSioPort::rxbuffer_flush() 
-{
-    _rxtail = _rxhead;
-    _rxfull = false;
+    if (size > _rxbuf.capacity())
+    {
+        data += size - _rxbuf.capacity();
+        size = _rxbuf.capacity();
+    }
+    size_t room = _rxbuf.room();
+    if (size > room)
+    {
+        _rxbuf.discard(size - room);
+        Debug_println("NetSIO rxbuffer overrun");
+    }
+    _rxbuf.push(data, size);
 }
 
 bool NetSioPort::resume_test()
@@ -337,7 +336,6 @@ bool NetSioPort::keep_alive()
 int NetSioPort::handle_netsio()
 {
     uint8_t rxbuf[514]; // must be able to hold whole netsio datagram, i.e. >= rxbuffer_len+2 defined in netsio.atdevice
-    uint8_t b;
     int received;
 
     if (!resume_test())
@@ -361,25 +359,14 @@ int NetSioPort::handle_netsio()
                 // [[fallthrough]]; // > No warning
 
             case NETSIO_DATA_BYTE:
-                b = rxbuf[1];
-                if (_baud_peer < _baud * 90 / 100 || _baud_peer > _baud * 110 / 100)
-                    b ^= (uint8_t)_baud_peer ^ (uint8_t)_baud; // corrupt byte
-                if (rxbuffer_put(b))
-                    Debug_println("NetSIO rxbuffer overrun");
+                rxbuffer_put(&rxbuf[1], 1);
                 break;
 
             case NETSIO_DATA_BLOCK:
                 if (received >= 2)
                 {
-                    for (int i = 1; i < received-1; i++) // TODO received-1, to test packet SNs
-                    // for (int i = 1; i < received; i++)
-                    {
-                        b = rxbuf[i];
-                        if (_baud_peer < _baud * 90 / 100 || _baud_peer > _baud * 110 / 100)
-                            b ^= (uint8_t)_baud_peer ^ (uint8_t)_baud; // corrupt byte
-                        if (rxbuffer_put(b))
-                            Debug_println("NetSIO rxbuffer overrun");
-                    }
+                    rxbuffer_put(&rxbuf[1], received - 2); // TODO received-2, to test packet SNs
+                    // rxbuffer_put(&rxbuf[1], received - 1);
                 }
                 break;
 
@@ -396,7 +383,7 @@ int NetSioPort::handle_netsio()
                 _command_asserted = true;
                 _sync_request_num = -1; // cancel any sync request
                 _sync_write_size = -1;
-                rxbuffer_flush();   // flush any stray input data
+                _rxbuf.clear();   // flush any stray input data
                 break;
 
             case NETSIO_MOTOR_OFF:
@@ -555,7 +542,7 @@ ssize_t NetSioPort::write_sock(const uint8_t *buffer, size_t size, uint32_t time
 
 bool NetSioPort::wait_for_data(uint32_t timeout_ms)
 {
-    while (rxbuffer_empty())
+    while (_rxbuf.empty())
     {
         if (!wait_sock_readable(timeout_ms))
             return false;  // timeout
@@ -594,7 +581,7 @@ bool NetSioPort::wait_for_credit(int needed)
 void NetSioPort::flush_input()
 {
     if (_initialized)
-        rxbuffer_flush();
+        _rxbuf.clear();
 }
 
 /* Clears input buffer and flushes out transmit buffer waiting at most
@@ -613,9 +600,9 @@ void NetSioPort::flush()
 */
 int NetSioPort::available()
 {
-    if (rxbuffer_empty())
+    if (_rxbuf.empty())
         handle_netsio();
-    return rxbuffer_available();
+    return _rxbuf.available();
 }
 
 /* Changes baud rate
@@ -716,7 +703,7 @@ int NetSioPort::read(void)
         Debug_println("NetSIO read() - TIMEOUT");
         return -1;
     }
-    return rxbuffer_get();
+    return _rxbuf.pop();
 }
 
 /* Since the underlying Stream calls this Read() multiple times to get more than one
@@ -736,26 +723,16 @@ size_t NetSioPort::read(uint8_t *buffer, size_t length)
         // 850 us pre-ACK delay will be added by netsio.atdevice
     }
 
-    int result;
-    int rxbytes;
-    for (rxbytes=0; rxbytes<length;)
+    size_t rxbytes = 0;
+    while (rxbytes < length)
     {
-        result = read();
-        // Debug_printf("read: %d\n", result);
-        if (result < 0)
-        {
-            break;
-        }
-        else
-        {
-            buffer[rxbytes++] = (uint8_t)result;
-        }
-
-        if (rxbytes == length)
+        if (!wait_for_data(500))
         {
-            // done
+            Debug_println("NetSIO read() - TIMEOUT");
             break;
         }
+        // take whatever arrived so far in one go
+        rxbytes += _rxbuf.pop(&buffer[rxbytes], length - rxbytes);
     }
     return rxbytes;
 }
@@ -4,6 +4,7 @@
 #include <sys/time.h>
 #include "sioport.h"
 #include "fnDNS.h"
+#include "ringbuf.h"
 
 class NetSioPort : public SioPort
 {
@@ -19,10 +20,7 @@ private:
     bool _command_asserted;
     bool _motor_asserted;
 
-    uint8_t _rxbuf[1024];
-    int _rxhead;
-    int _rxtail;
-    bool _rxfull;
+    RingBuffer<1024> _rxbuf;
 
     int _sync_request_num;  // 0..255 sync request sequence number, -1 if sync is not requested
     uint8_t _sync_ack_byte; // ACK byte to send with sync response
@@ -51,11 +49,7 @@ protected:
     bool wait_sock_writable(uint32_t timeout_ms);
     ssize_t write_sock(const uint8_t *buffer, size_t size, uint32_t timeout_ms=500);
 
-    bool rxbuffer_empty();
-    bool rxbuffer_put(uint8_t b);
-    int rxbuffer_get();
-    int rxbuffer_available();
-    void rxbuffer_flush();
+    void rxbuffer_put(uint8_t *data, size_t size);
 
 public:
     NetSioPort();
@@ -64,6 +58,9 @@ public:
     virtual void end() override;
     virtual bool poll(int ms) override;
 
+    virtual int get_fd() override { return _initialized ? _fd : -1; }
+    virtual int idle_timeout() override;
+
     virtual void set_baudrate(uint32_t baud) override;
     virtual uint32_t get_baudrate() override;
 
@@ -21,6 +21,10 @@ public:
     virtual void end() override { _uart.end(); }
     virtual bool poll(int ms) override { return _uart.poll(ms); }
 
+    // command line changes can't be waited on, keep polling the port (poll() sleeps a bit)
+    virtual int get_fd() override { return -1; }
+    virtual int idle_timeout() override { return 0; }
+
     virtual void set_baudrate(uint32_t baud) override { _uart.set_baudrate(baud); }
     virtual uint32_t get_baudrate() override { return _uart.get_baudrate(); }
 
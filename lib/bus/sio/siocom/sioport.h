@@ -18,6 +18,10 @@ public:
     virtual void end() = 0;
     virtual bool poll(int ms) = 0;
 
+    // for main loop to wait on port events
+    virtual int get_fd() = 0; // descriptor readable on port event, -1 if none
+    virtual int idle_timeout() = 0; // ms the port can go without poll(), -1 = no limit
+
     virtual void set_baudrate(uint32_t baud) = 0;
     virtual uint32_t get_baudrate() = 0;
 
@@ -134,6 +134,8 @@ public:
     void store_general_status_wait_enabled(bool status_wait_enabled);
     void store_general_encrypt_passphrase(bool encrypt_passphrase);
     bool get_general_encrypt_passphrase();
+    int get_general_blockcache_size() { return _general.blockcache_size; }
+    void store_general_blockcache_size(int blockcache_size);
 
     const char * get_network_sntpserver() { return _network.sntpserver; };
 
@@ -460,6 +462,7 @@ private:
         bool fnconfig_spifs = true;
         bool status_wait_enabled = true;
         bool encrypt_passphrase = false;
+        int blockcache_size = 0; // KB of SD card for remote disk image blocks, off until set in [General]
 #ifdef BUILD_ADAM
         bool printer_enabled = false; // Not by default.
 #else
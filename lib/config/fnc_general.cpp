@@ -99,6 +99,15 @@ bool fnConfig::get_general_encrypt_passphrase()
     return _general.encrypt_passphrase;
 }
 
+void fnConfig::store_general_blockcache_size(int blockcache_size)
+{
+    if (_general.blockcache_size == blockcache_size)
+        return;
+
+    _general.blockcache_size = blockcache_size;
+    _dirty = true;
+}
+
 void fnConfig::store_general_boot_mode(uint8_t boot_mode)
 {
     if (_general.boot_mode == boot_mode)
@@ -241,6 +250,12 @@ void fnConfig::_read_section_general(std::stringstream &ss)
             {
                 _general.encrypt_passphrase = util_string_value_is_true(value);
             }
+            else if (strcasecmp(name.c_str(), "blockcache_size") == 0)
+            {
+                int size = atoi(value.c_str());
+                if (size >= 0)
+                    _general.blockcache_size = size;
+            }
         }
     }
 }
@@ -8,6 +8,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/syslimits.h>
+#include <esp_heap_caps.h>
 
 #include "../Console.h"
 #include "../Helpers/PWDHelpers.h"
@@ -16,6 +17,7 @@
 #include "../device/fuji.h"
 #include "display.h"
 #include "meatloaf.h"
+#include "meat_media.h"
 #include "string_utils.h"
 
 char *canonicalize_file_name(const char *path);
@@ -426,6 +428,41 @@ int wget(int argc, char **argv)
     return EXIT_SUCCESS;
 }
 
+static void print_broker(const char *name, const MeatBrokerStats &stats)
+{
+    uint32_t lookups = stats.hits + stats.misses;
+    printf("%-8s %u/%u cached (peak %u), %lu hits, %lu misses (%lu%% hit rate), %lu evicted\r\n",
+           name, stats.entries, stats.capacity, stats.entries_peak,
+           stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0, stats.evictions);
+}
+
+int mlstat(int argc, char **argv)
+{
+    print_broker("Images", ImageBroker::stats());
+    print_broker("Files", FileBroker::stats());
+    print_broker("Streams", StreamBroker::stats());
+    print_broker("Caches", MediaBlockCache::brokerStats());
+
+    MediaCacheStats blocks = MediaBlockCache::stats();
+    uint32_t lookups = blocks.hits + blocks.misses;
+    printf("Blocks   %lu hits, %lu misses (%lu%% hit rate), %lu container reads, %lu KB\r\n",
+           blocks.hits, blocks.misses, lookups ? blocks.hits * 100 / lookups : 0,
+           blocks.reads, blocks.bytes_read / 1024);
+
+    MeatPoolStats pool = MeatPool::stats();
+    printf("Pool     %zu objects, %zu bytes (peak %zu), %zu of %zu KB in slabs, %lu allocations, %lu from heap\r\n",
+           pool.objects, pool.bytes, pool.bytes_peak, pool.slabs * MEATLOAF_POOL_SLAB_SIZE / 1024,
+           pool.slabs_max * MEATLOAF_POOL_SLAB_SIZE / 1024,
+           pool.allocations, pool.heap_allocations);
+
+    printf("Heap     %u KB free, %u KB lowest, %u KB largest block\r\n",
+           heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024,
+           heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL) / 1024,
+           heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) / 1024);
+
+    return EXIT_SUCCESS;
+}
+
 namespace ESP32Console::Commands
 {
     const ConsoleCommand getCatCommand()
@@ -487,4 +524,9 @@ namespace ESP32Console::Commands
     {
         return ConsoleCommand("wget", &wget, "Download url to file");
     }
+
+    const ConsoleCommand getMeatloafStatsCommand()
+    {
+        return ConsoleCommand("mlstat", &mlstat, "Show meatloaf cache hit rates and memory use");
+    }
 }
\ No newline at end of file
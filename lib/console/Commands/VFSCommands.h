@@ -31,4 +31,6 @@ namespace ESP32Console::Commands
     const ConsoleCommand getCRC32Command();
 
     const ConsoleCommand getWgetCommand();
+
+    const ConsoleCommand getMeatloafStatsCommand();
 }
\ No newline at end of file
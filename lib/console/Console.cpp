@@ -71,6 +71,7 @@ namespace ESP32Console
         registerCommand(getEditCommand());
         registerCommand(getMountCommand());
         registerCommand(getWgetCommand());
+        registerCommand(getMeatloafStatsCommand());
     }
 
     void Console::registerGPIOCommands()
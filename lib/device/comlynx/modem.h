@@ -11,6 +11,7 @@
 #include "fnTcpServer.h"
 #include "fnTcpClient.h"
 #include "modem-sniffer.h"
+#include "modem-pump.h"
 #include "libtelnet.h"
 
 /* Keep strings under 40 characters, for the benefit of 40-column users! */
@@ -67,11 +68,10 @@
 
 #define RING_INTERVAL 3000 // How often to print RING when having a new incoming connection (ms)
 #define MAX_CMD_LENGTH 256 // Maximum length for AT command
-#define TX_BUF_SIZE 256    // Buffer where to read from serial before writing to TCP (that direction is very blocking by the ESP TCP stack, so we can't do one byte a time.)
 
 #define ANSWER_TIMER_MS 1000 // milliseconds to wait before issuing CONNECT command, to simulate carrier negotiation.
 
-class lynxModem : public virtualDevice
+class lynxModem : public virtualDevice, public ModemPort
 {
 private:
 
@@ -162,9 +162,7 @@ private:
     fnTcpClient tcpClient;         // Modem client
     fnTcpServer tcpServer;         // Modem server
     unsigned long lastRingMs = 0;  // Time of last "RING" message (millis())
-    char plusCount = 0;            // Go to AT mode at "+++" sequence, that has to be counted
-    unsigned long plusTime = 0;    // When did we last receive a "+++" sequence
-    uint8_t txBuf[TX_BUF_SIZE];
+    ModemPump modemPump{this};     // Data between computer and remote end while connected
     bool cmdOutput=true;            // toggle whether to emit command output
     bool numericResultCode=false;   // Use numeric result codes? (ATV0)
     bool autoAnswer=false;          // Auto answer? (ATS0?)
@@ -209,6 +207,13 @@ private:
     void at_handle_pb();
     void at_handle_pbclear();
 
+    // ModemPort, the computer's side of modemPump
+    int port_available() override;
+    size_t port_read(uint8_t *buf, size_t len) override;
+    size_t port_write(const uint8_t *buf, size_t len) override;
+    void port_sniff_out(const uint8_t *buf, size_t len) override;
+    void port_sniff_in(const uint8_t *buf, size_t len) override;
+
 protected:
     void shutdown() override;
 
@@ -16,6 +16,7 @@
 #include "fnFsSD.h"
 #include "led.h"
 #include "utils.h"
+#include "charset.h"
 #include "display.h"
 
 #include "meat_media.h"
@@ -27,6 +28,11 @@
 // To be safe, BUFFER_SIZE should always be >=256
 #define BUFFER_SIZE 512
 
+// Background task reading ahead for iecChannelHandlerFile
+#define PREFETCH_STACKSIZE   8192
+#define PREFETCH_PRIORITY    10
+#define PREFETCH_CPUAFFINITY 0
+
 
 #define ST_OK                  0
 #define ST_SCRATCHED           1
@@ -157,18 +163,36 @@ uint8_t iecChannelHandler::write(uint8_t *data, uint8_t n)
 // -------------------------------------------------------------------------------------------------
 
 
-iecChannelHandlerFile::iecChannelHandlerFile(iecDrive *drive, MStream *stream, int fixLoadAddress) : iecChannelHandler(drive)
+iecChannelHandlerFile::iecChannelHandlerFile(iecDrive *drive, MStream *stream, int fixLoadAddress, bool prefetch) : iecChannelHandler(drive)
 {
   m_stream = stream;
   m_fixLoadAddress = fixLoadAddress;
   m_timeStart = esp_timer_get_time();
   m_byteCount = 0;
   m_transportTimeUS = 0;
+  m_waitTimeUS = 0;
+
+  m_prefetchTask = nullptr;
+  m_prefetchStart = nullptr;
+  m_prefetchDone = nullptr;
+  m_next = nullptr;
+  m_nextLen = 0;
+  m_nextStatus = ST_OK;
+  m_nextPercent = 0;
+  m_prefetchPending = false;
+  m_nextReady = false;
+  m_prefetchExit = false;
+
+  if( prefetch )
+    startPrefetch();
 }
 
 
 iecChannelHandlerFile::~iecChannelHandlerFile()
 {
+  bool prefetched = m_prefetchTask!=nullptr;
+  stopPrefetch(false);
+
   double seconds = (esp_timer_get_time()-m_timeStart) / 1000000.0;
 
   if( m_stream->mode == std::ios_base::out && m_len>0 )
@@ -181,8 +205,18 @@ iecChannelHandlerFile::~iecChannelHandlerFile()
   Debug_printv("%s %lu bytes in %0.2f seconds @ %0.2fcps", m_stream->mode == std::ios_base::in ? "Sent" : "Received", m_byteCount, seconds, cps);
 
   double tseconds = m_transportTimeUS / 1000000.0;
-  cps = m_byteCount / (seconds-tseconds);
-  Debug_printv("Transport (network/sd) took %0.3f seconds, pure IEC transfers @ %0.2fcps", tseconds, cps);
+  if( prefetched )
+    {
+      // with prefetch, the bus only stalls when the next buffer isn't ready yet
+      double wseconds = m_waitTimeUS / 1000000.0;
+      cps = m_byteCount / (seconds-wseconds);
+      Debug_printv("Transport (network/sd) took %0.3f seconds, bus waited %0.3f seconds for it, pure IEC transfers @ %0.2fcps", tseconds, wseconds, cps);
+    }
+  else
+    {
+      cps = m_byteCount / (seconds-tseconds);
+      Debug_printv("Transport (network/sd) took %0.3f seconds, pure IEC transfers @ %0.2fcps", tseconds, cps);
+    }
 
 #ifdef ENABLE_DISPLAY
     DISPLAY.idle();
@@ -193,6 +227,78 @@ iecChannelHandlerFile::~iecChannelHandlerFile()
 }
 
 
+void iecChannelHandlerFile::startPrefetch()
+{
+  m_next = new uint8_t[BUFFER_SIZE];
+  m_prefetchStart = xSemaphoreCreateBinary();
+  m_prefetchDone = xSemaphoreCreateBinary();
+
+  // The bus is serviced on core 1, so read from the stream on core 0
+  if( m_prefetchStart==nullptr || m_prefetchDone==nullptr ||
+      xTaskCreatePinnedToCore(prefetchTask, "iec_prefetch", PREFETCH_STACKSIZE, this,
+                              PREFETCH_PRIORITY, &m_prefetchTask, PREFETCH_CPUAFFINITY)!=pdPASS )
+    {
+      Debug_printv("Error: could not start prefetch task, reading synchronously");
+      m_prefetchTask = nullptr;
+      stopPrefetch();
+    }
+}
+
+
+void iecChannelHandlerFile::stopPrefetch(bool keepData)
+{
+  if( m_prefetchTask!=nullptr )
+    {
+      if( m_prefetchPending )
+        {
+          // let a fill in progress finish, then move the stream back to where
+          // the bus is, so callers of getStream() carry on from there
+          xSemaphoreTake(m_prefetchDone, portMAX_DELAY);
+          m_prefetchPending = false;
+
+          // if it can't go back, readBufferData() still sends what was read
+          if( keepData && m_nextStatus==ST_OK && m_nextLen>0 )
+            m_nextReady = !m_stream->seek(m_stream->position()-m_nextLen);
+        }
+
+      m_prefetchExit = true;
+      xSemaphoreGive(m_prefetchStart);
+      xSemaphoreTake(m_prefetchDone, portMAX_DELAY);
+      m_prefetchTask = nullptr;
+    }
+
+  if( m_prefetchStart!=nullptr ) { vSemaphoreDelete(m_prefetchStart); m_prefetchStart = nullptr; }
+  if( m_prefetchDone!=nullptr )  { vSemaphoreDelete(m_prefetchDone);  m_prefetchDone = nullptr; }
+  if( !keepData )
+    m_nextReady = false;
+  if( !m_nextReady )
+    {
+      delete [] m_next;
+      m_next = nullptr;
+    }
+}
+
+
+void iecChannelHandlerFile::prefetchTask(void *arg)
+{
+  iecChannelHandlerFile *handler = (iecChannelHandlerFile *) arg;
+
+  while( true )
+    {
+      xSemaphoreTake(handler->m_prefetchStart, portMAX_DELAY);
+      if( handler->m_prefetchExit )
+        break;
+
+      handler->m_nextStatus = handler->fillBuffer(handler->m_next, &handler->m_nextLen, &handler->m_nextPercent);
+      xSemaphoreGive(handler->m_prefetchDone);
+    }
+
+  // the handler may be gone as soon as this is given
+  xSemaphoreGive(handler->m_prefetchDone);
+  vTaskDelete(nullptr);
+}
+
+
 uint8_t iecChannelHandlerFile::writeBufferData()
 {
   /*
@@ -218,7 +324,7 @@ uint8_t iecChannelHandlerFile::writeBufferData()
 }
 
 
-uint8_t iecChannelHandlerFile::readBufferData()
+uint8_t iecChannelHandlerFile::fillBuffer(uint8_t *buffer, size_t *len, uint8_t *percent)
 {
   /*
   // if m_stream is within a disk image then m_stream->mode does not get initialized properly!
@@ -231,41 +337,95 @@ uint8_t iecChannelHandlerFile::readBufferData()
       if (m_stream->size() == 0)
         return ST_FILE_NOT_FOUND;
 
-#ifdef ENABLE_DISPLAY
-      // send progress percentage
-      uint8_t percent = (m_stream->position() * 100) / m_stream->size();
-      DISPLAY.progress = percent;
-#endif
+      // may run in the prefetch task, so readBufferData() shows it
+      *percent = (m_stream->position() * 100) / m_stream->size();
 
+      size_t n;
       if( m_fixLoadAddress>=0 && m_stream->position()==0 )
         {
           uint64_t t = esp_timer_get_time();
-          m_len = m_stream->read(m_data, BUFFER_SIZE);
+          n = m_stream->read(buffer, BUFFER_SIZE);
           m_transportTimeUS += (esp_timer_get_time()-t);
-          if( m_len>=2 )
+          if( n>=2 )
             {
-              m_data[0] = (m_fixLoadAddress & 0x00FF);
-              m_data[1] = (m_fixLoadAddress & 0xFF00) >> 8;
+              buffer[0] = (m_fixLoadAddress & 0x00FF);
+              buffer[1] = (m_fixLoadAddress & 0xFF00) >> 8;
             }
           m_fixLoadAddress = -1;
         }
       else
-        m_len = 0;
+        n = 0;
 
       // try to fill buffer
-      while( m_len<BUFFER_SIZE && !m_stream->eos() )
+      while( n<BUFFER_SIZE && !m_stream->eos() )
         {
           uint64_t t = esp_timer_get_time();
-          m_len += m_stream->read(m_data+m_len, BUFFER_SIZE-m_len);
+          n += m_stream->read(buffer+n, BUFFER_SIZE-n);
           m_transportTimeUS += (esp_timer_get_time()-t);
         }
 
-      m_byteCount += m_len;
+      *len = n;
     }
 
   return ST_OK;
 }
 
+
+uint8_t iecChannelHandlerFile::readBufferData()
+{
+  uint8_t st, percent = 0;
+
+  if( m_prefetchPending )
+    {
+      // next buffer should (mostly) be ready by now, only wait for the rest
+      uint64_t t = esp_timer_get_time();
+      xSemaphoreTake(m_prefetchDone, portMAX_DELAY);
+      m_waitTimeUS += (esp_timer_get_time()-t);
+      m_prefetchPending = false;
+
+      std::swap(m_data, m_next);
+      m_len = m_nextLen;
+      percent = m_nextPercent;
+      st = m_nextStatus;
+    }
+  else if( m_nextReady )
+    {
+      // read ahead before prefetching stopped
+      std::swap(m_data, m_next);
+      m_len = m_nextLen;
+      percent = m_nextPercent;
+      st = ST_OK;
+      m_nextReady = false;
+      delete [] m_next;
+      m_next = nullptr;
+    }
+  else
+    {
+      uint64_t t = esp_timer_get_time();
+      st = fillBuffer(m_data, &m_len, &percent);
+      m_waitTimeUS += (esp_timer_get_time()-t);
+    }
+
+  if( st==ST_OK )
+    {
+      m_byteCount += m_len;
+
+#ifdef ENABLE_DISPLAY
+      // send progress percentage
+      DISPLAY.progress = percent;
+#endif
+
+      // start reading the next buffer while this one goes out over the bus
+      if( m_prefetchTask!=nullptr && m_len==BUFFER_SIZE && !m_stream->eos() )
+        {
+          m_prefetchPending = true;
+          xSemaphoreGive(m_prefetchStart);
+        }
+    }
+
+  return st;
+}
+
 // -------------------------------------------------------------------------------------------------
 
 
@@ -275,13 +435,13 @@ iecChannelHandlerDir::iecChannelHandlerDir(iecDrive *drive, MFile *dir) : iecCha
   m_headerLine = 1;
   
   std::string url = m_dir->host;
-  url = mstr::toPETSCII2(url);
+  charset::utf8_to_petscii(url);
   std::string path = m_dir->path;
-  path = mstr::toPETSCII2(path);
+  charset::utf8_to_petscii(path);
   std::string archive = m_dir->media_archive;
-  archive = mstr::toPETSCII2(archive);
+  charset::utf8_to_petscii(archive);
   std::string image = m_dir->media_image;
-  image = mstr::toPETSCII2(image);
+  charset::utf8_to_petscii(image);
   
   m_headers.clear();
   if( url.size()>0 )     addExtraInfo("URL", url);
@@ -413,8 +573,8 @@ uint8_t iecChannelHandlerDir::readBufferData()
           std::string name = entry->name;
           if ( !entry->isPETSCII )
             {
-              name = mstr::toPETSCII2( name );
-              ext  = mstr::toPETSCII2( ext );
+              charset::utf8_to_petscii( name );
+              charset::utf8_to_petscii( ext );
             }
           mstr::replaceAll(name, "\\", "/");
           
@@ -515,6 +675,7 @@ iecDrive::iecDrive(uint8_t devnum) : IECFileDevice(devnum)
 #endif
   for(int i=0; i<16; i++) 
     m_channels[i] = nullptr;
+  m_prefetchChannel = nullptr;
 }
 
 
@@ -529,6 +690,7 @@ iecDrive::~iecDrive()
 bool iecDrive::open(uint8_t channel, const char *cname)
 {
   Debug_printv("iecDrive::open(#%d, %d, \"%s\")", m_devnr, channel, cname);
+  stopPrefetch();
   
 #ifdef USE_VDRIVE
   if( m_vdrive!=nullptr && (strncmp(cname, "//", 2)==0 || strncmp(cname, "ML:", 3)==0 || strstr(cname, "://")!=NULL) )
@@ -719,7 +881,11 @@ bool iecDrive::open(uint8_t channel, const char *cname)
                 {
                   Debug_printv("Stream created for file [%s]", f->url.c_str());
                   // new_stream will be deleted in iecChannelHandlerFile destructor
-                  m_channels[channel] = new iecChannelHandlerFile(this, new_stream, f->isDirectory() ? 0x0801 : -1);
+                  // read ahead on files that take more than one buffer to load
+                  bool prefetch = (mode == std::ios_base::in) && new_stream->size()>BUFFER_SIZE;
+                  iecChannelHandlerFile *handler = new iecChannelHandlerFile(this, new_stream, f->isDirectory() ? 0x0801 : -1, prefetch);
+                  if( prefetch ) m_prefetchChannel = handler;
+                  m_channels[channel] = handler;
                   m_numOpenChannels++;
                   setStatusCode(ST_OK);
           
@@ -765,6 +931,9 @@ void iecDrive::close(uint8_t channel)
 #endif
   if( m_channels[channel] != nullptr )
     {
+      // the handler stops its own prefetch task
+      stopPrefetch(m_channels[channel]);
+      if( m_channels[channel]==m_prefetchChannel ) m_prefetchChannel = nullptr;
       delete m_channels[channel];
       m_channels[channel] = nullptr;
       if( m_numOpenChannels>0 ) m_numOpenChannels--;
@@ -798,7 +967,10 @@ uint8_t iecDrive::write(uint8_t channel, uint8_t *data, uint8_t dataLen, bool eo
           return 0;
         }
       else
-        return handler->write(data, dataLen);
+        {
+          stopPrefetch(handler);
+          return handler->write(data, dataLen);
+        }
     }
 }
 
@@ -828,6 +1000,7 @@ uint8_t iecDrive::read(uint8_t channel, uint8_t *data, uint8_t maxDataLen, bool
         }
       else
       {
+          stopPrefetch(handler);
           uint8_t bytes_read = handler->read(data, maxDataLen);
           if( m_statusCode==ST_FILE_NOT_FOUND)
           {
@@ -847,6 +1020,7 @@ void iecDrive::execute(const char *cmd, uint8_t cmdLen)
   Debug_printv("iecDrive::execute(#%d, \"%s\", %d)", m_devnr, cmd, cmdLen);
 
   std::string command = std::string(cmd, cmdLen);
+  stopPrefetch();
 
   // set status code to OK, failing commands below will set it to the appropriate error code
   setStatusCode(ST_OK);
@@ -1424,6 +1598,7 @@ void iecDrive::reset()
   IECFileDevice::reset();
 
   ImageBroker::clear();
+  MediaBlockCache::clear();
 
 #ifdef ENABLE_DISPLAY
   DISPLAY.idle();
@@ -1434,6 +1609,19 @@ void iecDrive::reset()
 }
 
 
+void iecDrive::stopPrefetch(iecChannelHandler *keep)
+{
+  // only one stream is read from another task at a time, and never while
+  // something else on this drive uses the file system
+  if( m_prefetchChannel!=nullptr && m_prefetchChannel!=keep )
+    {
+      Debug_printv("Stopping prefetch on drive #%d", m_devnr);
+      m_prefetchChannel->stopPrefetch();
+      m_prefetchChannel = nullptr;
+    }
+}
+
+
 void iecDrive::set_cwd(std::string path)
 {
     // Isolate path
@@ -1502,6 +1690,7 @@ mediatype_t iecDrive::mount(FILE *f, const char *filename, uint32_t disksize, me
   
   Debug_printv("DRIVE[#%d] URL[%s] MOUNT[%s]", m_devnr, url.c_str(), filename);
   
+  stopPrefetch();
   m_cwd.reset( MFSOwner::File( url ) );
   
   return MediaType::discover_mediatype(filename); // MEDIATYPE_UNKNOWN
@@ -7,6 +7,9 @@
 #include <cstring>
 #include <unordered_map>
 #include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #include "../../bus/iec/IECFileDevice.h"
 #include "../../media/media.h"
@@ -50,18 +53,38 @@ class iecChannelHandler
 class iecChannelHandlerFile : public iecChannelHandler
 {
  public: 
-  iecChannelHandlerFile(iecDrive *drive, MStream *stream, int fixLoadAddress = -1);
+  // with prefetch, a background task reads the next buffer from the stream
+  // while the current one is being sent over the bus
+  iecChannelHandlerFile(iecDrive *drive, MStream *stream, int fixLoadAddress = -1, bool prefetch = false);
   virtual ~iecChannelHandlerFile();
 
   virtual uint8_t readBufferData();
   virtual uint8_t writeBufferData();
-  virtual MStream *getStream() override { return m_stream; };
+  // the caller is about to use the stream directly, so prefetching stops
+  virtual MStream *getStream() override { stopPrefetch(); return m_stream; };
+
+  // the stream is read synchronously from here on
+  void stopPrefetch(bool keepData = true);
 
  private:
+  uint8_t fillBuffer(uint8_t *buffer, size_t *len, uint8_t *percent);
+  void startPrefetch();
+  static void prefetchTask(void *arg);
+
   MStream  *m_stream;
   int       m_fixLoadAddress;
   uint32_t  m_byteCount;
-  uint64_t  m_timeStart, m_transportTimeUS;
+  uint64_t  m_timeStart, m_transportTimeUS, m_waitTimeUS;
+
+  TaskHandle_t      m_prefetchTask;
+  SemaphoreHandle_t m_prefetchStart, m_prefetchDone;
+  uint8_t  *m_next;          // buffer filled by the prefetch task
+  size_t    m_nextLen;
+  uint8_t   m_nextStatus;
+  uint8_t   m_nextPercent;     // progress at m_next, shown once it goes out
+  bool      m_prefetchPending; // m_next is being filled
+  bool      m_nextReady;       // m_next was filled before prefetching stopped
+  bool      m_prefetchExit;
 };
 
 
@@ -272,8 +295,12 @@ class iecDrive : public IECFileDevice
 
   void set_cwd(std::string path);
 
+  // stop the prefetch task before anything but its own channel uses the filesystem
+  void stopPrefetch(iecChannelHandler *keep = nullptr);
+
   std::unique_ptr<MFile> m_cwd;   // current working directory
   iecChannelHandler *m_channels[16];
+  iecChannelHandlerFile *m_prefetchChannel; // the one channel allowed to read ahead
   uint8_t m_statusCode, m_statusTrk, m_numOpenChannels;
 #ifdef USE_VDRIVE
   VDrive   *m_vdrive;
@@ -14,6 +14,7 @@
 #include "../../hardware/led.h"
 
 #include "utils.h"
+#include "charset.h"
 
 #include "status_error_codes.h"
 #include "NetworkProtocolFactory.h"
@@ -388,7 +389,8 @@ void iecNetwork::parse_bite()
  
     //bites += "\"";
     //Debug_printv("[%s]", bites.c_str());
-    channel_data.receiveBuffer = mstr::toPETSCII2(bites);
+    charset::utf8_to_petscii(bites);
+    channel_data.receiveBuffer = std::move(bites);
 }
 
 void iecNetwork::set_translation_mode()
@@ -11,6 +11,7 @@
 #include "fuji.h"
 
 #include "fujiCmd.h"
+#include "fujiCopy.h"
 #include "httpService.h"
 #include "fnSystem.h"
 #include "fnConfig.h"
@@ -422,15 +423,12 @@ void iwmFuji::iwm_ctrl_set_boot_config() // SP CTRL command
 	}
 }
 
-// Do SIO copy
+// Do SmartPort copy
 void iwmFuji::iwm_ctrl_copy_file()
 {
 	std::string copySpec;
 	std::string sourcePath;
 	std::string destPath;
-	fnFile *sourceFile;
-	fnFile *destFile;
-	char *dataBuf;
 	unsigned char sourceSlot;
 	unsigned char destSlot;
 
@@ -439,6 +437,12 @@ void iwmFuji::iwm_ctrl_copy_file()
 	copySpec = std::string((char *)&data_buffer[2]);
 	Debug_printf("copySpec: %s\n", copySpec.c_str());
 
+	if (sourceSlot >= MAX_HOSTS || destSlot >= MAX_HOSTS || copySpec.find_first_of("|") == std::string::npos)
+	{
+		err_result = SP_ERR_BADCTL;
+		return;
+	}
+
 	// Chop up copyspec.
 	sourcePath = copySpec.substr(0, copySpec.find_first_of("|"));
 	destPath = copySpec.substr(copySpec.find_first_of("|") + 1);
@@ -455,22 +459,10 @@ void iwmFuji::iwm_ctrl_copy_file()
 	_fnHosts[sourceSlot].mount();
 	_fnHosts[destSlot].mount();
 
-	// Open files...
-	sourceFile = _fnHosts[sourceSlot].fnfile_open(sourcePath.c_str(), (char *)sourcePath.c_str(), sourcePath.size() + 1, "rb");
-	destFile = _fnHosts[destSlot].fnfile_open(destPath.c_str(), (char *)destPath.c_str(), destPath.size() + 1, "wb");
-
-	dataBuf = (char *)malloc(532);
-	size_t count = 0;
-	do
-	{
-		count = fnio::fread(dataBuf, 1, 532, sourceFile);
-		fnio::fwrite(dataBuf, 1, count, destFile);
-	} while (count > 0);
-
-	// copyEnd:
-	fnio::fclose(sourceFile);
-	fnio::fclose(destFile);
-	free(dataBuf);
+	// Reading and writing overlap in the copy tasks, we only wait for the result
+	fujiCopy copy;
+	if (!copy.start(_fnHosts[sourceSlot], sourcePath.c_str(), _fnHosts[destSlot], destPath.c_str()) || !copy.wait())
+		err_result = SP_ERR_IOERROR;
 }
 
 // Mount all
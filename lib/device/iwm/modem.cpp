@@ -12,8 +12,6 @@
 #include "fnConfig.h"
 #include "led.h"
 
-#define RECVBUFSIZE 512
-
 #define MODEM_TASK_PRIORITY 10
 #define MODEM_TASK_CPU 0
 
@@ -1073,6 +1071,45 @@ void iwmModem::modemCommand()
     cmd = "";
 }
 
+int iwmModem::port_available()
+{
+#ifdef ESP_PLATFORM // OS
+    return uxQueueMessagesWaiting(mtxq);
+#else
+    return 0;
+#endif
+}
+
+size_t iwmModem::port_read(uint8_t *buf, size_t len)
+{
+    return modem_read(buf, len);
+}
+
+size_t iwmModem::port_write(const uint8_t *buf, size_t len)
+{
+    return modem_write((uint8_t *)buf, len);
+}
+
+size_t iwmModem::port_room()
+{
+#ifdef ESP_PLATFORM // OS
+    // modem_write() waits for space, don't give it more than there is
+    return uxQueueSpacesAvailable(mrxq);
+#else
+    return SIZE_MAX;
+#endif
+}
+
+void iwmModem::port_sniff_out(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpOutput(buf, len);
+}
+
+void iwmModem::port_sniff_in(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpInput(buf, len);
+}
+
 /*
   Handle incoming & outgoing data for modem
 */
@@ -1081,6 +1118,10 @@ void iwmModem::handle_modem()
     /**** AT command mode ****/
     if (cmdMode == true)
     {
+        // Nothing buffered during a call may go out on the next one
+        if (!tcpClient.connected())
+            modemPump.reset();
+
         if (answerHack == true)
         {
             Debug_printf("XXX ANSWERHACK !!! SENDING ATA! ");
@@ -1210,97 +1251,20 @@ void iwmModem::handle_modem()
             }
         }
 
-#ifdef ESP_PLATFORM // OS
-        int sioBytesAvail = uxQueueMessagesWaiting(mtxq);
-#else
-        int sioBytesAvail;
-#endif
-        // send from Atari to Fujinet
-        if (sioBytesAvail && tcpClient.connected())
-        {
-            // In telnet in worst case we have to escape every uint8_t
-            // so leave half of the buffer always free
-            // int max_buf_size;
-            // if (telnet == true)
-            //  max_buf_size = TX_BUF_SIZE / 2;
-            // else
-            //  max_buf_size = TX_BUF_SIZE;
-
-            // Read from serial, the amount available up to
-            // maximum size of the buffer
-            int sioBytesRead = modem_read(&txBuf[0], // SIO_UART.readBytes(&txBuf[0],
-                                          (sioBytesAvail > TX_BUF_SIZE) ? TX_BUF_SIZE : sioBytesAvail);
-
-            // Disconnect if going to AT mode with "+++" sequence
-            for (int i = 0; i < (int)sioBytesRead; i++)
-            {
-                if (txBuf[i] == '+')
-                    plusCount++;
-                else
-                    plusCount = 0;
-                if (plusCount >= 3)
-                {
-                    plusTime = fnSystem.millis();
-                }
-                if (txBuf[i] != '+')
-                {
-                    plusCount = 0;
-                }
-            }
-
-            // Write the buffer to TCP finally
-            if (use_telnet == true)
-            {
-                telnet_send(telnet, (const char *)txBuf, sioBytesRead);
-            }
-            else
-                tcpClient.write(&txBuf[0], sioBytesRead);
-
-            // And send it off to the sniffer, if enabled.
-            modemSniffer->dumpOutput(&txBuf[0], sioBytesRead);
-            _lasttime = fnSystem.millis();
-        }
-
-        // read from Fujinet to Atari
-        unsigned char buf[RECVBUFSIZE];
-        int bytesAvail = 0;
-
-        // check to see how many bytes are avail to read
-        while ((bytesAvail = tcpClient.available()) > 0)
-        {
-            // read as many as our buffer size will take (RECVBUFSIZE)
-            unsigned int bytesRead =
-                tcpClient.read(buf, (bytesAvail > RECVBUFSIZE) ? RECVBUFSIZE : bytesAvail);
-
-            if (use_telnet == true)
-            {
-                telnet_recv(telnet, (const char *)buf, bytesRead);
-            }
-            else
-            {
-                modem_write(buf, bytesRead);
-            }
-
-            // And dump to sniffer, if enabled.
-            modemSniffer->dumpInput(buf, bytesRead);
+        // Exchange data between the computer and the remote end
+        if (modemPump.service(tcpClient, use_telnet ? telnet : nullptr, fnSystem.millis()))
             _lasttime = fnSystem.millis();
-        }
     }
 
     // If we have received "+++" as last bytes from serial port and there
     // has been over a second without any more bytes, go back to command mode.
-    if (plusCount >= 3)
+    if (modemPump.escaped(fnSystem.millis()))
     {
-        if (fnSystem.millis() - plusTime > 1000)
-        {
-            Debug_println("Going back to command mode");
-
-            at_cmd_println("OK");
+        Debug_println("Going back to command mode");
 
-            cmdMode = true;
+        at_cmd_println("OK");
 
-            plusCount = 0;
-        }
+        cmdMode = true;
     }
 
     // Go to command mode if TCP disconnected and not in command mode
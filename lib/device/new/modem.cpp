@@ -12,8 +12,6 @@
 
 #include "utils.h"
 
-#define RECVBUFSIZE 1024
-
 /* Tested this delay several times on an 800 with Incognito
    using HSIO routines. Anything much lower gave inconsistent
    firmware loading. Delay is unnoticeable when running at
@@ -990,6 +988,34 @@ void adamModem::modemCommand()
     cmd = "";
 }
 
+int adamModem::port_available()
+{
+    // Nothing is read from the bus UART yet, it carries the AdamNet traffic
+    return 0;
+}
+
+size_t adamModem::port_read(uint8_t *buf, size_t len)
+{
+    return fnUartBUS.readBytes(buf, len);
+}
+
+size_t adamModem::port_write(const uint8_t *buf, size_t len)
+{
+    size_t written = fnUartBUS.write(buf, len);
+    fnUartBUS.flush();
+    return written;
+}
+
+void adamModem::port_sniff_out(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpOutput(buf, len);
+}
+
+void adamModem::port_sniff_in(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpInput(buf, len);
+}
+
 /*
   Handle incoming & outgoing data for modem
 */
@@ -998,6 +1024,10 @@ void adamModem::sio_handle_modem()
     /**** AT command mode ****/
     if (cmdMode == true)
     {
+        // Nothing buffered during a call may go out on the next one
+        if (!tcpClient.connected())
+            modemPump.reset();
+
         if (answerHack == true)
         {
             Debug_printf("XXX ANSWERHACK !!! SENDING ATA! ");
@@ -1123,96 +1153,20 @@ void adamModem::sio_handle_modem()
             }
         }
 
-        //int sioBytesAvail = SIO_UART.available();
-        int sioBytesAvail = std::min(0, fnUartBUS.available());
-
-        // send from Atari to Fujinet
-        if (sioBytesAvail && tcpClient.connected())
-        {
-            // In telnet in worst case we have to escape every uint8_t
-            // so leave half of the buffer always free
-            //int max_buf_size;
-            //if (telnet == true)
-            //  max_buf_size = TX_BUF_SIZE / 2;
-            //else
-            //  max_buf_size = TX_BUF_SIZE;
-
-            // Read from serial, the amount available up to
-            // maximum size of the buffer
-            int sioBytesRead = fnUartBUS.readBytes(&txBuf[0], //SIO_UART.readBytes(&txBuf[0],
-                                                   (sioBytesAvail > TX_BUF_SIZE) ? TX_BUF_SIZE : sioBytesAvail);
-
-            // Disconnect if going to AT mode with "+++" sequence
-            for (int i = 0; i < (int)sioBytesRead; i++)
-            {
-                if (txBuf[i] == '+')
-                    plusCount++;
-                else
-                    plusCount = 0;
-                if (plusCount >= 3)
-                {
-                    plusTime = fnSystem.millis();
-                }
-                if (txBuf[i] != '+')
-                {
-                    plusCount = 0;
-                }
-            }
-
-            // Write the buffer to TCP finally
-            if (use_telnet == true)
-            {
-                telnet_send(telnet, (const char *)txBuf, sioBytesRead);
-            }
-            else
-                tcpClient.write(&txBuf[0], sioBytesRead);
-
-            // And send it off to the sniffer, if enabled.
-            modemSniffer->dumpOutput(&txBuf[0], sioBytesRead);
+        // Exchange data between the computer and the remote end
+        if (modemPump.service(tcpClient, use_telnet ? telnet : nullptr, fnSystem.millis()))
             _lasttime = fnSystem.millis();
-        }
-
-        // read from Fujinet to Atari
-        unsigned char buf[RECVBUFSIZE];
-        int bytesAvail = 0;
-
-        // check to see how many bytes are avail to read
-        while ((bytesAvail = tcpClient.available()) > 0)
-        {
-            // read as many as our buffer size will take (RECVBUFSIZE)
-            unsigned int bytesRead =
-                tcpClient.read(buf, (bytesAvail > RECVBUFSIZE) ? RECVBUFSIZE : bytesAvail);
-
-            if (use_telnet == true)
-            {
-                telnet_recv(telnet, (const char *)buf, bytesRead);
-            }
-            else
-            {
-                fnUartBUS.write(buf, bytesRead);
-                fnUartBUS.flush();
-            }
-
-            // And dump to sniffer, if enabled.
-            modemSniffer->dumpInput(buf, bytesRead);
-            _lasttime = fnSystem.millis();
-        }
     }
 
     // If we have received "+++" as last bytes from serial port and there
     // has been over a second without any more bytes, go back to command mode.
-    if (plusCount >= 3)
+    if (modemPump.escaped(fnSystem.millis()))
     {
-        if (fnSystem.millis() - plusTime > 1000)
-        {
-            Debug_println("Going back to command mode");
+        Debug_println("Going back to command mode");
 
-            at_cmd_println("OK");
-    
-            cmdMode = true;
+        at_cmd_println("OK");
 
-            plusCount = 0;
-        }
+        cmdMode = true;
     }
 
     // Go to command mode if TCP disconnected and not in command mode
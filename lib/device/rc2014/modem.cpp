@@ -16,8 +16,6 @@
 #include "utils.h"
 
 
-#define RECVBUFSIZE 1024
-
 /* Tested this delay several times on an 800 with Incognito
    using HSIO routines. Anything much lower gave inconsistent
    firmware loading. Delay is unnoticeable when running at
@@ -1033,6 +1031,40 @@ void rc2014Modem::modemCommand()
     cmd = "";
 }
 
+int rc2014Modem::port_available()
+{
+    return streamFifoTx.avail();
+}
+
+size_t rc2014Modem::port_read(uint8_t *buf, size_t len)
+{
+    streamFifoTx.pop(buf, len);
+    return len;
+}
+
+size_t rc2014Modem::port_write(const uint8_t *buf, size_t len)
+{
+    size_t written = 0;
+    while (written < len && !streamFifoRx.is_full())
+        streamFifoRx.push(buf[written++]);
+    return written;
+}
+
+size_t rc2014Modem::port_room()
+{
+    return streamFifoRx.room();
+}
+
+void rc2014Modem::port_sniff_out(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpOutput(buf, len);
+}
+
+void rc2014Modem::port_sniff_in(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpInput(buf, len);
+}
+
 /*
   Handle incoming & outgoing data for modem
 */
@@ -1041,6 +1073,10 @@ void rc2014Modem::rc2014_handle_stream()
     /**** AT command mode ****/
     if (cmdMode)
     {
+        // Nothing buffered during a call may go out on the next one
+        if (!tcpClient.connected())
+            modemPump.reset();
+
         if (answerHack)
         {
             Debug_printf("XXX ANSWERHACK !!! SENDING ATA! ");
@@ -1148,95 +1184,20 @@ void rc2014Modem::rc2014_handle_stream()
             }
         }
 
-        //int sioBytesAvail = SIO_UART.available();
-        int sioBytesAvail = streamFifoTx.avail();
-
-        // send from Atari to Fujinet
-        if (sioBytesAvail && tcpClient.connected())
-        {
-            // In telnet in worst case we have to escape every uint8_t
-            // so leave half of the buffer always free
-            //int max_buf_size;
-            //if (telnet == true)
-            //  max_buf_size = TX_BUF_SIZE / 2;
-            //else
-            //  max_buf_size = TX_BUF_SIZE;
-
-            // Read from serial, the amount available up to
-            // maximum size of the buffer
-            int sioBytesRead = (sioBytesAvail > TX_BUF_SIZE) ? TX_BUF_SIZE : sioBytesAvail;
-            streamFifoTx.pop(&txBuf[0], sioBytesRead);
-
-            // Disconnect if going to AT mode with "+++" sequence
-            for (int i = 0; i < (int)sioBytesRead; i++)
-            {
-                if (txBuf[i] == '+')
-                    plusCount++;
-                else
-                    plusCount = 0;
-                if (plusCount >= 3)
-                {
-                    plusTime = fnSystem.millis();
-                }
-                if (txBuf[i] != '+')
-                {
-                    plusCount = 0;
-                }
-            }
-
-            // Write the buffer to TCP finally
-            if (use_telnet == true)
-            {
-                telnet_send(telnet, (const char *)txBuf, sioBytesRead);
-            }
-            else
-                tcpClient.write(&txBuf[0], sioBytesRead);
-
-            // And send it off to the sniffer, if enabled.
-            modemSniffer->dumpOutput(&txBuf[0], sioBytesRead);
-            _lasttime = fnSystem.millis();
-        }
-
-        // read from Fujinet to Atari
-        unsigned char buf[RECVBUFSIZE];
-        int bytesAvail = 0;
-
-        // check to see how many bytes are avail to read
-        while ((bytesAvail = tcpClient.available()) > 0)
-        {
-            // read as many as our buffer size will take (RECVBUFSIZE)
-            unsigned int bytesRead =
-                tcpClient.read(buf, (bytesAvail > RECVBUFSIZE) ? RECVBUFSIZE : bytesAvail);
-
-            if (use_telnet == true)
-            {
-                telnet_recv(telnet, (const char *)buf, bytesRead);
-            }
-            else
-            {
-                streamFifoRx.push(buf, bytesRead);
-            }
-
-            // And dump to sniffer, if enabled.
-            modemSniffer->dumpInput(buf, bytesRead);
+        // Exchange data between the computer and the remote end
+        if (modemPump.service(tcpClient, use_telnet ? telnet : nullptr, fnSystem.millis()))
             _lasttime = fnSystem.millis();
-        }
     }
 
     // If we have received "+++" as last bytes from serial port and there
     // has been over a second without any more bytes, go back to command mode.
-    if (plusCount >= 3)
+    if (modemPump.escaped(fnSystem.millis()))
     {
-        if (fnSystem.millis() - plusTime > 1000)
-        {
-            Debug_println("Going back to command mode");
+        Debug_println("Going back to command mode");
 
-            at_cmd_println("OK");
-    
-            cmdMode = true;
+        at_cmd_println("OK");
 
-            plusCount = 0;
-        }
+        cmdMode = true;
     }
 
     // Go to command mode if TCP disconnected and not in command mode
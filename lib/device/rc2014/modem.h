@@ -13,6 +13,7 @@
 #include "fnTcpServer.h"
 #include "fnTcpClient.h"
 #include "modem-sniffer.h"
+#include "modem-pump.h"
 #include "libtelnet.h"
 
 /* Keep strings under 40 characters, for the benefit of 40-column users! */
@@ -72,11 +73,9 @@
 
 #define ANSWER_TIMER_MS 1000 // milliseconds to wait before issuing CONNECT command, to simulate carrier negotiation.
 
-class rc2014Modem : public virtualDevice
+class rc2014Modem : public virtualDevice, public ModemPort
 {
 private:
-    static constexpr int TX_BUF_SIZE = 256;
-
 #define RESULT_CODE_OK              0
 #define RESULT_CODE_CONNECT         1
 #define RESULT_CODE_RING            2
@@ -164,9 +163,7 @@ private:
     fnTcpClient tcpClient;         // Modem client
     fnTcpServer tcpServer;         // Modem server
     unsigned long lastRingMs = 0;  // Time of last "RING" message (millis())
-    char plusCount = 0;            // Go to AT mode at "+++" sequence, that has to be counted
-    unsigned long plusTime = 0;    // When did we last receive a "+++" sequence
-    uint8_t txBuf[TX_BUF_SIZE];
+    ModemPump modemPump{this};     // Data between computer and remote end while connected
     bool cmdOutput=true;            // toggle whether to emit command output
     bool numericResultCode=false;   // Use numeric result codes? (ATV0)
     bool autoAnswer=false;          // Auto answer? (ATS0?)
@@ -211,6 +208,14 @@ private:
     void at_handle_pb();
     void at_handle_pbclear();
 
+    // ModemPort, the computer's side of modemPump
+    int port_available() override;
+    size_t port_read(uint8_t *buf, size_t len) override;
+    size_t port_write(const uint8_t *buf, size_t len) override;
+    size_t port_room() override;
+    void port_sniff_out(const uint8_t *buf, size_t len) override;
+    void port_sniff_in(const uint8_t *buf, size_t len) override;
+
     uint8_t response[1024];
 
 protected:
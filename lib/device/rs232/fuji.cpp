@@ -9,6 +9,7 @@
 
 #include "../../../include/debug.h"
 
+#include "fujiCopy.h"
 #include "fnSystem.h"
 #include "fnConfig.h"
 #include "fsFlash.h"
@@ -338,20 +339,9 @@ void rs232Fuji::rs232_copy_file()
     std::string sourcePath;
     std::string destPath;
     uint8_t ck;
-    fnFile *sourceFile;
-    fnFile *destFile;
-    char *dataBuf;
     unsigned char sourceSlot;
     unsigned char destSlot;
 
-    dataBuf = (char *)malloc(532);
-
-    if (dataBuf == nullptr)
-    {
-        rs232_error();
-        return;
-    }
-
     memset(&csBuf, 0, sizeof(csBuf));
 
     ck = bus_to_peripheral(csBuf, sizeof(csBuf));
@@ -359,7 +349,6 @@ void rs232Fuji::rs232_copy_file()
     if (ck != rs232_checksum(csBuf, sizeof(csBuf)))
     {
         rs232_error();
-        free(dataBuf);
         return;
     }
 
@@ -371,21 +360,18 @@ void rs232Fuji::rs232_copy_file()
     if (copySpec.empty() || copySpec.find_first_of("|") == std::string::npos)
     {
         rs232_error();
-        free(dataBuf);
         return;
     }
 
     if (cmdFrame.aux1 < 1 || cmdFrame.aux1 > 8)
     {
         rs232_error();
-        free(dataBuf);
         return;
     }
 
     if (cmdFrame.aux2 < 1 || cmdFrame.aux2 > 8)
     {
         rs232_error();
-        free(dataBuf);
         return;
     }
 
@@ -410,39 +396,15 @@ void rs232Fuji::rs232_copy_file()
     _fnHosts[sourceSlot].mount();
     _fnHosts[destSlot].mount();
 
-    // Open files...
-    sourceFile = _fnHosts[sourceSlot].fnfile_open(sourcePath.c_str(), (char *)sourcePath.c_str(), sourcePath.size() + 1, "r");
-
-    if (sourceFile == nullptr)
-    {
-        rs232_error();
-        free(dataBuf);
-        return;
-    }
-
-    destFile = _fnHosts[destSlot].fnfile_open(destPath.c_str(), (char *)destPath.c_str(), destPath.size() + 1, "w");
-
-    if (destFile == nullptr)
+    // Reading and writing overlap in the copy tasks, we only wait for the result
+    fujiCopy copy;
+    if (!copy.start(_fnHosts[sourceSlot], sourcePath.c_str(), _fnHosts[destSlot], destPath.c_str()) || !copy.wait())
     {
         rs232_error();
-        fnio::fclose(sourceFile);
-        free(dataBuf);
         return;
     }
 
-    size_t count = 0;
-    do
-    {
-        count = fnio::fread(dataBuf, 1, 532, sourceFile);
-        fnio::fwrite(dataBuf, 1, count, destFile);
-    } while (count > 0);
-
     rs232_complete();
-
-    // copyEnd:
-    fnio::fclose(sourceFile);
-    fnio::fclose(destFile);
-    free(dataBuf);
 }
 
 // Mount all
@@ -22,6 +22,7 @@
 
 #include "directoryPageGroup.h"
 #include "fujiCmd.h"
+#include "fujiCopy.h"
 #include "httpService.h"
 #include "fnSystem.h"
 #include "fnConfig.h"
@@ -547,22 +548,8 @@ void sioFuji::sio_copy_file()
     std::string sourcePath;
     std::string destPath;
     uint8_t ck;
-    fnFile *sourceFile;
-    fnFile *destFile;
-    char *dataBuf;
     unsigned char sourceSlot;
     unsigned char destSlot;
-#ifndef ESP_PLATFORM
-    uint64_t poll_ts = fnSystem.millis();
-#endif
-
-    dataBuf = (char *)malloc(532);
-
-    if (dataBuf == nullptr)
-    {
-        sio_error();
-        return;
-    }
 
     memset(&csBuf, 0, sizeof(csBuf));
 
@@ -571,7 +558,6 @@ void sioFuji::sio_copy_file()
     if (ck != sio_checksum(csBuf, sizeof(csBuf)))
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
@@ -583,21 +569,18 @@ void sioFuji::sio_copy_file()
     if (copySpec.empty() || copySpec.find_first_of("|") == std::string::npos)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
     if (cmdFrame.aux1 < 1 || cmdFrame.aux1 > 8)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
     if (cmdFrame.aux2 < 1 || cmdFrame.aux2 > 8)
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
@@ -622,74 +605,35 @@ void sioFuji::sio_copy_file()
     _fnHosts[sourceSlot].mount();
     _fnHosts[destSlot].mount();
 
-    // Open files...
-    sourceFile = _fnHosts[sourceSlot].fnfile_open(sourcePath.c_str(), (char *)sourcePath.c_str(), sourcePath.size() + 1, FILE_READ);
-
-    if (sourceFile == nullptr)
+    // Reading and writing overlap in the copy tasks, we only wait for the result
+    fujiCopy copy;
+    if (!copy.start(_fnHosts[sourceSlot], sourcePath.c_str(), _fnHosts[destSlot], destPath.c_str()))
     {
         sio_error();
-        free(dataBuf);
         return;
     }
 
-    destFile = _fnHosts[destSlot].fnfile_open(destPath.c_str(), (char *)destPath.c_str(), destPath.size() + 1, FILE_WRITE);
-
-    if (destFile == nullptr)
-    {
-        sio_error();
-        fnio::fclose(sourceFile);
-        free(dataBuf);
-        return;
-    }
-
-    size_t readCount = 0;
-    size_t readTotal = 0;
-    size_t writeCount = 0;
-    size_t expected = _fnHosts[sourceSlot].file_size(sourceFile); // get the filesize
-    bool err = false;
-    do
-    {
-#ifndef ESP_PLATFORM
+#ifdef ESP_PLATFORM
+    bool ok = copy.wait();
+#else
+    uint64_t poll_ts = fnSystem.millis();
+    bool ok = copy.wait([&poll_ts]() {
         if (fnSioCom.get_sio_mode() == SioCom::sio_mode::NETSIO && fnSystem.millis() - poll_ts > 1000)
         {
             fnSioCom.poll(1);
             poll_ts = fnSystem.millis();
         }
+    });
 #endif
-        readCount = fnio::fread(dataBuf, 1, 532, sourceFile);
-        readTotal += readCount;
-        // Check if we got enough bytes on the read
-        if (readCount < 532 && readTotal != expected)
-        {
-            err = true;
-            break;
-        }
-        writeCount = fnio::fwrite(dataBuf, 1, readCount, destFile);
-        // Check if we sent enough bytes on the write
-        if (writeCount != readCount)
-        {
-            err = true;
-            break;
-        }
-        Debug_printf("Copy File: %d bytes of %d\n", readTotal, expected);
-    } while (readTotal < expected);
 
-    if (err == true)
-    {
-        // Remove the destination file and error
-        _fnHosts[destSlot].file_remove((char *)destPath.c_str());
-        sio_error();
-        Debug_printf("Copy File Error! wCount: %d, rCount: %d, rTotal: %d, Expect: %d\n", writeCount, readCount, readTotal, expected);
-    }
+    if (ok)
+        sio_complete();
     else
     {
-        sio_complete();
+        Debug_printf("Copy File Error! rTotal: %lu, wTotal: %lu, Expect: %ld\n",
+                     (unsigned long)copy.bytes_read, (unsigned long)copy.bytes_written, copy.total);
+        sio_error();
     }
-
-    // copyEnd:
-    fnio::fclose(sourceFile);
-    fnio::fclose(destFile);
-    free(dataBuf);
 }
 
 // Mount all
@@ -13,8 +13,6 @@
 
 #include "utils.h"
 
-#define RECVBUFSIZE 1024
-
 #define SIO_MODEMCMD_LOAD_RELOCATOR 0x21
 #define SIO_MODEMCMD_LOAD_HANDLER 0x26
 #define SIO_MODEMCMD_TYPE1_POLL 0x3F
@@ -1578,6 +1576,33 @@ void modem::modemCommand()
     cmd = "";
 }
 
+int modem::port_available()
+{
+    return SYSTEM_BUS.uart->available();
+}
+
+size_t modem::port_read(uint8_t *buf, size_t len)
+{
+    return SYSTEM_BUS.uart->readBytes(buf, len);
+}
+
+size_t modem::port_write(const uint8_t *buf, size_t len)
+{
+    ssize_t written = SYSTEM_BUS.uart->write(buf, len);
+    SYSTEM_BUS.uart->flush();
+    return written > 0 ? written : 0;
+}
+
+void modem::port_sniff_out(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpOutput(buf, len);
+}
+
+void modem::port_sniff_in(const uint8_t *buf, size_t len)
+{
+    modemSniffer->dumpInput(buf, len);
+}
+
 /*
   Handle incoming & outgoing data for modem
 */
@@ -1586,6 +1611,10 @@ void modem::sio_handle_modem()
     /**** AT command mode ****/
     if (cmdMode == true)
     {
+        // Nothing buffered during a call may go out on the next one
+        if (!tcpClient.connected())
+            modemPump.reset();
+
         if (answerHack == true)
         {
             Debug_printf("XXX ANSWERHACK !!! SENDING ATA! ");
@@ -1735,105 +1764,22 @@ void modem::sio_handle_modem()
             }
         }
 
-        int sioBytesAvail = SYSTEM_BUS.uart->available();
-        //int sioBytesAvail = std::min(0, SYSTEM_BUS.uart->available());
-
-        // send from Atari to Fujinet
-        if (sioBytesAvail && tcpClient.connected())
-        {
-            fnLedManager.set(eLed::LED_BT,true);
-            
-            // In telnet in worst case we have to escape every uint8_t
-            // so leave half of the buffer always free
-            //int max_buf_size;
-            //if (telnet == true)
-            //  max_buf_size = TX_BUF_SIZE / 2;
-            //else
-            //  max_buf_size = TX_BUF_SIZE;
-
-            // Read from serial, the amount available up to
-            // maximum size of the buffer
-            int sioBytesRead = SYSTEM_BUS.uart->readBytes(&txBuf[0], //SIO_UART.readBytes(&txBuf[0],
-                                                   (sioBytesAvail > TX_BUF_SIZE) ? TX_BUF_SIZE : sioBytesAvail);
-
-            // Disconnect if going to AT mode with "+++" sequence
-            for (int i = 0; i < (int)sioBytesRead; i++)
-            {
-                if (txBuf[i] == '+')
-                    plusCount++;
-                else
-                    plusCount = 0;
-                if (plusCount >= 3)
-                {
-                    plusTime = fnSystem.millis();
-                }
-                if (txBuf[i] != '+')
-                {
-                    plusCount = 0;
-                }
-            }
-
-            // Write the buffer to TCP finally
-            if (use_telnet == true)
-            {
-                telnet_send(telnet, (const char *)txBuf, sioBytesRead);
-            }
-            else
-            {
-                tcpClient.write(&txBuf[0], sioBytesRead);
-            }
-            // And send it off to the sniffer, if enabled.
-            modemSniffer->dumpOutput(&txBuf[0], sioBytesRead);
-            _lasttime = fnSystem.millis();
-
-            fnLedManager.set(eLed::LED_BT,false);
-        }
-
-        // read from Fujinet to Atari
-        unsigned char buf[RECVBUFSIZE];
-        int bytesAvail = 0;
-
-        // check to see how many bytes are avail to read
-        while ((bytesAvail = tcpClient.available()) > 0)
-        {
-            fnLedManager.set(eLed::LED_BT,true);
-
-            // read as many as our buffer size will take (RECVBUFSIZE)
-            unsigned int bytesRead =
-                tcpClient.read(buf, (bytesAvail > RECVBUFSIZE) ? RECVBUFSIZE : bytesAvail);
-
-            if (use_telnet == true)
-            {
-                telnet_recv(telnet, (const char *)buf, bytesRead);
-            }
-            else
-            {
-                SYSTEM_BUS.uart->write(buf, bytesRead);
-                SYSTEM_BUS.uart->flush();
-            }
-
-            fnLedManager.set(eLed::LED_BT,false);
- 
-            // And dump to sniffer, if enabled.
-            modemSniffer->dumpInput(buf, bytesRead);
+        // Exchange data between the computer and the remote end
+        fnLedManager.set(eLed::LED_BT,true);
+        if (modemPump.service(tcpClient, use_telnet ? telnet : nullptr, fnSystem.millis()))
             _lasttime = fnSystem.millis();
-        }
+        fnLedManager.set(eLed::LED_BT,false);
     }
 
     // If we have received "+++" as last bytes from serial port and there
     // has been over a second without any more bytes, go back to command mode.
-    if (plusCount >= 3)
+    if (modemPump.escaped(fnSystem.millis()))
     {
-        if (fnSystem.millis() - plusTime > 1000)
-        {
-            Debug_println("Going back to command mode");
+        Debug_println("Going back to command mode");
 
-            at_cmd_println("OK");
-    
-            cmdMode = true;
+        at_cmd_println("OK");
 
-            plusCount = 0;
-        }
+        cmdMode = true;
     }
 
     // Go to command mode if TCP disconnected and not in command mode
@@ -17,6 +17,9 @@
 
 #include "fnSystem.h"
 #include "utils.h"
+#ifndef ESP_PLATFORM
+#include "fnReactor.h"
+#endif
 
 #include "status_error_codes.h"
 #include "TCP.h"
@@ -985,6 +988,24 @@ void sioNetwork::sio_poll_interrupt()
     }
 }
 
+#ifndef ESP_PLATFORM
+void sioNetwork::sio_interrupt_watch()
+{
+    if (protocol == nullptr || protocol->interruptEnable == false)
+        return;
+
+    // PROCEED stays asserted until the host reads or closes, that comes in as a command
+    if (protocol->forceStatus == true || status.rxBytesWaiting > 0 || status.connected == 0)
+        return;
+
+    int fd = protocol->get_fd();
+    if (fd >= 0)
+        fnReactor.watch(fd);
+    else
+        fnReactor.wake_in(INTERRUPT_POLL_MS);
+}
+#endif
+
 /** PRIVATE METHODS ************************************************************/
 
 /**
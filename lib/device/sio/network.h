@@ -32,6 +32,11 @@
 
 #define NEWDATA_SIZE 65535
 
+/**
+ * How often PROCEED is checked for protocols without a socket to wait on (FujiNet-PC)
+ */
+#define INTERRUPT_POLL_MS 10
+
 class sioNetwork : public virtualDevice
 {
 
@@ -132,6 +137,13 @@ public:
      */
     void sio_poll_interrupt();
 
+#ifndef ESP_PLATFORM
+    /**
+     * Tell fnReactor what to wait for before PROCEED may need to change.
+     */
+    void sio_interrupt_watch();
+#endif
+
     /**
      * Process incoming SIO command for device 0x7X
      * @param comanddata incoming 4 bytes containing command and aux bytes
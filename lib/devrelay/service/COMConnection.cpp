@@ -16,8 +16,9 @@ void COMConnection::send_data(const std::vector<uint8_t> &data)
 		return;
 	}
 
-	const auto slip_data = SLIP::encode(data);
-	sp_nonblocking_write(port_, slip_data.data(), slip_data.size());
+	std::lock_guard<std::mutex> lock(send_mutex_);
+	const size_t slip_size = encode_frame(data);
+	sp_nonblocking_write(port_, send_buffer_.data(), slip_size);
 }
 
 void COMConnection::create_read_channel()
@@ -29,21 +30,7 @@ void COMConnection::create_read_channel()
 			int bytes_read = sp_nonblocking_read(self->port_, buffer.data(), buffer.size());
 			if (bytes_read > 0)
 			{
-				std::vector<std::vector<uint8_t>> decoded_packets = SLIP::split_into_packets(buffer.data(), buffer.size());
-				if (!decoded_packets.empty())
-				{
-					for (const auto &packet : decoded_packets)
-					{
-						if (!packet.empty())
-						{
-							{
-								std::lock_guard<std::mutex> lock(self->data_mutex_);
-								self->data_map_[packet[0]] = packet;
-							}
-							self->data_cv_.notify_all();
-						}
-					}
-				}
+				self->receive_data(buffer.data(), bytes_read);
 			}
 		}
 	});
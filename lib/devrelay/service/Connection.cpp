@@ -64,6 +64,39 @@ std::vector<uint8_t> Connection::wait_for_request()
 	return std::vector<uint8_t>();
 }
 
+size_t Connection::encode_frame(const std::vector<uint8_t> &data)
+{
+	size_t max_size = SLIP::max_encoded_size(data.size());
+	if (send_buffer_.size() < max_size)
+	{
+		send_buffer_.resize(max_size);
+	}
+	return SLIP::encode(data.data(), data.size(), send_buffer_.data());
+}
+
+// Called from the reading thread with whatever was received, which may hold
+// several frames or only part of one.
+void Connection::receive_data(const uint8_t *data, size_t len)
+{
+	while (len > 0)
+	{
+		size_t used = decoder_.feed(data, len);
+		data += used;
+		len -= used;
+
+		if (decoder_.has_frame())
+		{
+			// The first byte of every request and response is its id
+			const uint8_t *frame = decoder_.frame();
+			{
+				std::lock_guard<std::mutex> lock(data_mutex_);
+				data_map_[frame[0]].assign(frame, frame + decoder_.frame_size());
+			}
+			data_cv_.notify_all();
+		}
+	}
+}
+
 void Connection::join()
 {
 	if (reading_thread_.joinable())
@@ -11,6 +11,8 @@
 #include <thread>
 #include <vector>
 
+#include "../slip/SLIP.h"
+
 class Connection
 {
 public:
@@ -32,6 +34,15 @@ private:
 	std::atomic<bool> is_connected_{false};
 
 protected:
+	// SLIP encodes data into send_buffer_, caller must hold send_mutex_
+	size_t encode_frame(const std::vector<uint8_t> &data);
+	// Decodes received bytes, complete frames are queued for the waiting side
+	void receive_data(const uint8_t *data, size_t len);
+
+	std::vector<uint8_t> send_buffer_;
+	std::mutex send_mutex_;
+	SLIPDecoder decoder_;
+
 	std::map<uint8_t, std::vector<uint8_t>> data_map_;
 	std::thread reading_thread_;
 
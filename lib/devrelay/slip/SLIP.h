@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <stdint.h>
 #include <vector>
 
@@ -9,11 +10,184 @@
 #define SLIP_ESC_END 0334 /* ESC ESC_END means END data byte */
 #define SLIP_ESC_ESC 0335 /* ESC ESC_ESC means ESC data byte */
 
+#define SLIP_MAX_FRAME 65536 /* decoded frames longer than this are dropped */
+
 class SLIP
 {
 public:
 	// these encode and decode exactly one SLIP frame, and expect it to be sane.
 	static std::vector<uint8_t> encode(const std::vector<uint8_t> &data);
 	static std::vector<uint8_t> decode(const std::vector<uint8_t> &data);
-	static std::vector<std::vector<uint8_t>> split_into_packets(const uint8_t *data, size_t bytes_read);
+
+	// Largest possible encoded size of len data bytes (every byte escaped, plus END at both ends)
+	static constexpr size_t max_encoded_size(size_t len) { return 2 * len + 2; }
+
+	// Encode one frame into out, which must hold max_encoded_size(len) bytes.
+	// Runs of bytes which need no escaping are found with memchr and copied as a whole.
+	// Returns the number of bytes written.
+	static size_t encode(const uint8_t *data, size_t len, uint8_t *out)
+	{
+		uint8_t *o = out;
+		const uint8_t *end = data + len;
+
+		*o++ = SLIP_END;
+		while (data < end)
+		{
+			const uint8_t *special = find_special(data, end - data);
+			size_t run = special - data;
+			memcpy(o, data, run);
+			o += run;
+			data = special;
+			if (data < end)
+			{
+				*o++ = SLIP_ESC;
+				*o++ = (*data++ == SLIP_END) ? SLIP_ESC_END : SLIP_ESC_ESC;
+			}
+		}
+		*o++ = SLIP_END;
+
+		return o - out;
+	}
+
+	// First END or ESC byte in data, or data + len if there is none
+	static const uint8_t *find_special(const uint8_t *data, size_t len)
+	{
+		const uint8_t *e = static_cast<const uint8_t *>(memchr(data, SLIP_END, len));
+		if (e != nullptr)
+			len = e - data;
+		const uint8_t *s = static_cast<const uint8_t *>(memchr(data, SLIP_ESC, len));
+		if (s != nullptr)
+			return s;
+		return e != nullptr ? e : data + len;
+	}
+};
+
+/*
+ * Incremental SLIP decoder for a byte stream arriving in arbitrary chunks.
+ *
+ * feed() consumes bytes up to and including the END closing a frame, then
+ * frame() / frame_size() give the decoded frame until the next feed(). The
+ * frame buffer is reused, so no memory is allocated once it has grown to
+ * the largest frame seen. Empty frames (END END) are skipped, frames with
+ * an invalid escape or longer than max_frame are dropped.
+ *
+ *   while (len > 0) {
+ *       size_t used = decoder.feed(data, len);
+ *       data += used; len -= used;
+ *       if (decoder.has_frame()) handle(decoder.frame(), decoder.frame_size());
+ *   }
+ */
+class SLIPDecoder
+{
+public:
+	explicit SLIPDecoder(size_t max_frame = SLIP_MAX_FRAME) : max_frame_(max_frame) {}
+
+	size_t feed(const uint8_t *data, size_t len)
+	{
+		const uint8_t *p = data;
+		const uint8_t *end = data + len;
+
+		if (has_frame_)
+		{
+			has_frame_ = false;
+			size_ = 0;
+		}
+
+		while (p < end)
+		{
+			switch (state_)
+			{
+			case State::Sync:
+				// Nothing is known about bytes before the first END
+				p = static_cast<const uint8_t *>(memchr(p, SLIP_END, end - p));
+				if (p == nullptr)
+					return len;
+				p++;
+				size_ = 0;
+				state_ = State::Frame;
+				break;
+
+			case State::Escape:
+				if (*p == SLIP_ESC_END)
+					append(SLIP_END);
+				else if (*p == SLIP_ESC_ESC)
+					append(SLIP_ESC);
+				else
+				{
+					// invalid escape, drop the frame
+					state_ = State::Sync;
+					break;
+				}
+				p++;
+				state_ = State::Frame;
+				break;
+
+			case State::Frame:
+			{
+				const uint8_t *special = SLIP::find_special(p, end - p);
+				append(p, special - p);
+				p = special;
+				if (p == end)
+					break;
+				if (*p++ == SLIP_ESC)
+				{
+					state_ = State::Escape;
+					break;
+				}
+				// END: complete frame, unless it's empty or was too long
+				if (size_ > 0 && size_ <= max_frame_)
+				{
+					has_frame_ = true;
+					return p - data;
+				}
+				size_ = 0;
+				break;
+			}
+			}
+		}
+
+		return len;
+	}
+
+	bool has_frame() const { return has_frame_; }
+	const uint8_t *frame() const { return buffer_.data(); }
+	size_t frame_size() const { return has_frame_ ? size_ : 0; }
+
+	// Forget any partial frame, wait for the next END
+	void reset()
+	{
+		state_ = State::Sync;
+		size_ = 0;
+		has_frame_ = false;
+	}
+
+private:
+	enum class State
+	{
+		Sync,	// waiting for END
+		Frame,	// in a frame
+		Escape	// in a frame, after ESC
+	};
+
+	void append(const uint8_t *data, size_t len)
+	{
+		if (len == 0)
+			return;
+		// keep counting past max_frame_ so the frame is dropped at its END
+		if (size_ + len <= max_frame_)
+		{
+			if (buffer_.size() < size_ + len)
+				buffer_.resize(size_ + len);
+			memcpy(buffer_.data() + size_, data, len);
+		}
+		size_ += len;
+	}
+
+	void append(uint8_t b) { append(&b, 1); }
+
+	std::vector<uint8_t> buffer_;
+	size_t size_ = 0;
+	size_t max_frame_;
+	State state_ = State::Sync;
+	bool has_frame_ = false;
 };
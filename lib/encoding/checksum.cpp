@@ -0,0 +1,90 @@
+#include "checksum.h"
+
+#include <array>
+
+namespace {
+
+using crc_tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// Table k advances the CRC of a byte by k further zero bytes, so eight
+// lookups can be combined to consume eight bytes at once.
+constexpr crc_tables make_crc_tables()
+{
+    crc_tables t{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t rem = i;
+        for (int j = 0; j < 8; j++)
+            rem = (rem & 1) ? (rem >> 1) ^ 0xedb88320 : rem >> 1;
+        t[0][i] = rem;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+        for (int k = 1; k < 8; k++)
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+    return t;
+}
+
+// Generated at compile time so it lives in flash instead of RAM
+constexpr crc_tables crc_table = make_crc_tables();
+
+constexpr uint32_t ADLER_MOD = 65521;
+// Largest n such that 255n(n+1)/2 + (n+1)(ADLER_MOD-1) still fits in 32 bits
+constexpr size_t ADLER_NMAX = 5552;
+
+} // namespace
+
+uint32_t Checksum::crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+
+    while (len >= 8)
+    {
+        uint32_t lo = crc ^ ((uint32_t)buf[0] | (uint32_t)buf[1] << 8 | (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24);
+        uint32_t hi = (uint32_t)buf[4] | (uint32_t)buf[5] << 8 | (uint32_t)buf[6] << 16 | (uint32_t)buf[7] << 24;
+
+        crc = crc_table[7][lo & 0xff] ^ crc_table[6][(lo >> 8) & 0xff] ^
+              crc_table[5][(lo >> 16) & 0xff] ^ crc_table[4][lo >> 24] ^
+              crc_table[3][hi & 0xff] ^ crc_table[2][(hi >> 8) & 0xff] ^
+              crc_table[1][(hi >> 16) & 0xff] ^ crc_table[0][hi >> 24];
+
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *buf++) & 0xff];
+
+    return ~crc;
+}
+
+uint32_t Checksum::adler32(uint32_t adler, const uint8_t *buf, size_t len)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = (adler >> 16) & 0xffff;
+
+    while (len > 0)
+    {
+        size_t n = len < ADLER_NMAX ? len : ADLER_NMAX;
+        len -= n;
+
+        while (n >= 4)
+        {
+            s1 += buf[0]; s2 += s1;
+            s1 += buf[1]; s2 += s1;
+            s1 += buf[2]; s2 += s1;
+            s1 += buf[3]; s2 += s1;
+            buf += 4;
+            n -= 4;
+        }
+        while (n--)
+        {
+            s1 += *buf++;
+            s2 += s1;
+        }
+
+        s1 %= ADLER_MOD;
+        s2 %= ADLER_MOD;
+    }
+
+    return (s2 << 16) | s1;
+}
@@ -0,0 +1,37 @@
+/*
+ * Buffer-at-a-time CRC-32 and Adler-32 checksums
+ *
+ * CRC-32 uses the zlib/PNG polynomial (0xEDB88320, reflected) with a
+ * slice-by-8 table so eight input bytes are folded in per step.
+ * Adler-32 defers the modulo until just before the sums could overflow.
+ *
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstdint>
+#include <cstddef>
+
+class Checksum {
+public:
+    /**
+     * crc32 - Continue a CRC-32 over another buffer
+     * @crc: Value returned by a previous call, or 0 to start
+     * @buf: Data to add
+     * @len: Length of the data
+     * Returns: Updated CRC-32
+     */
+    static uint32_t crc32(uint32_t crc, const uint8_t *buf, size_t len);
+
+    /**
+     * adler32 - Continue an Adler-32 over another buffer
+     * @adler: Value returned by a previous call, or 1 to start
+     * @buf: Data to add
+     * @len: Length of the data
+     * Returns: Updated Adler-32
+     */
+    static uint32_t adler32(uint32_t adler, const uint8_t *buf, size_t len);
+};
+
+#endif // CHECKSUM_H
@@ -1,5 +1,6 @@
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
 
 #include "hash.h"
 #include <mbedtls/version.h>
@@ -52,6 +53,7 @@ void Hash::add_data(const std::string& data) {
 
 void Hash::clear() {
     accumulated_data.clear();
+    stream.reset();
 }
 
 size_t Hash::hash_length(Algorithm algorithm, bool is_hex) const {
@@ -77,19 +79,12 @@ size_t Hash::hash_length(Algorithm algorithm, bool is_hex) const {
 
 void Hash::compute(Algorithm algorithm, bool clear_data) {
     hash_output.clear();
-    switch (algorithm) {
-        case Algorithm::SHA1:
-            compute_sha1();
-            break;
-        case Algorithm::SHA256:
-            compute_sha256();
-            break;
-        case Algorithm::SHA512:
-            compute_sha512();
-            break;
-        default:
-            break;
+
+    Context ctx;
+    if (ctx.init(algorithm) && ctx.update(accumulated_data.data(), accumulated_data.size())) {
+        ctx.finish(hash_output);
     }
+
     if (clear_data) {
         clear();
     }
@@ -103,106 +98,163 @@ std::string Hash::output_hex() const {
     return bytes_to_hex(hash_output);
 }
 
-void Hash::compute_sha1() {
-    mbedtls_sha1_context ctx;
-    mbedtls_sha1_init(&ctx);
-    
-    hash_output.resize(20);
-    
+bool Hash::begin(Algorithm algorithm) {
+    hash_output.clear();
+    return stream.init(algorithm);
+}
+
+bool Hash::update(const uint8_t *data, size_t len) {
+    return stream.update(data, len);
+}
+
+bool Hash::update_from_file(fnFile *f) {
+    return stream.update_from_file(f);
+}
+
+bool Hash::finish() {
+    return stream.finish(hash_output);
+}
+
 #if MBEDTLS_VERSION_NUMBER >= 0x02070000 && MBEDTLS_VERSION_NUMBER < 0x03000000
-    int err = 0;
+// Use newer API that returns status code
+#define HASH_MBEDTLS_CALL(fn, ...) (fn##_ret(__VA_ARGS__) == 0)
+#else
+// Use legacy API
+#define HASH_MBEDTLS_CALL(fn, ...) (fn(__VA_ARGS__), true)
+#endif
+
+Hash::Context::~Context() {
+    reset();
+}
+
+bool Hash::Context::init(Algorithm algorithm) {
+    reset();
 
-    // Use newer API that returns status code
-    if ((err = mbedtls_sha1_starts_ret(&ctx)) != 0) {
-        mbedtls_sha1_free(&ctx);
-        return; // Handle error appropriately
+    bool ok = false;
+    switch (algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_init(&_ctx.md5);
+            ok = HASH_MBEDTLS_CALL(mbedtls_md5_starts, &_ctx.md5);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_init(&_ctx.sha1);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha1_starts, &_ctx.sha1);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_init(&_ctx.sha256);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha256_starts, &_ctx.sha256, 0);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_init(&_ctx.sha512);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha512_starts, &_ctx.sha512, 0);
+            break;
+        default:
+            return false;
     }
-    
-    if ((err = mbedtls_sha1_update_ret(&ctx, accumulated_data.data(), accumulated_data.size())) != 0) {
-        mbedtls_sha1_free(&ctx);
-        return; // Handle error appropriately
+
+    _algorithm = algorithm;
+    if (!ok) {
+        reset();
     }
-    
-    if ((err = mbedtls_sha1_finish_ret(&ctx, hash_output.data())) != 0) {
-        mbedtls_sha1_free(&ctx);
-        return; // Handle error appropriately
+    return ok;
+}
+
+bool Hash::Context::update(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return _algorithm != Algorithm::UNKNOWN;
+    }
+
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            return HASH_MBEDTLS_CALL(mbedtls_md5_update, &_ctx.md5, data, len);
+        case Algorithm::SHA1:
+            return HASH_MBEDTLS_CALL(mbedtls_sha1_update, &_ctx.sha1, data, len);
+        case Algorithm::SHA256:
+            return HASH_MBEDTLS_CALL(mbedtls_sha256_update, &_ctx.sha256, data, len);
+        case Algorithm::SHA512:
+            return HASH_MBEDTLS_CALL(mbedtls_sha512_update, &_ctx.sha512, data, len);
+        default:
+            return false;
     }
-#else
-    // Use legacy API
-    mbedtls_sha1_starts(&ctx);
-    mbedtls_sha1_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    mbedtls_sha1_finish(&ctx, hash_output.data());
-#endif
-    
-    mbedtls_sha1_free(&ctx);
 }
 
-void Hash::compute_sha256() {
-    mbedtls_sha256_context ctx;
-    mbedtls_sha256_init(&ctx);
-    
-    hash_output.resize(32);
-    
-#if MBEDTLS_VERSION_NUMBER >= 0x02070000 && MBEDTLS_VERSION_NUMBER < 0x03000000
-    int err = 0;
+// Hashes everything from the current position to the end of the file, one small chunk at a time
+bool Hash::Context::update_from_file(fnFile *f) {
+    if (f == nullptr) {
+        return false;
+    }
 
-    // Use newer API that returns status code
-    if ((err = mbedtls_sha256_starts_ret(&ctx, 0)) != 0) {
-        mbedtls_sha256_free(&ctx);
-        return; // Handle error appropriately
+    // A read error stops fread() the same way the end of the file does, so
+    // check afterwards that the whole file was hashed
+    long int start = fnio::ftell(f);
+    if (start < 0 || fnio::fseek(f, 0, SEEK_END) != 0) {
+        return false;
     }
-    
-    if ((err = mbedtls_sha256_update_ret(&ctx, accumulated_data.data(), accumulated_data.size())) != 0) {
-        mbedtls_sha256_free(&ctx);
-        return; // Handle error appropriately
+    long int end = fnio::ftell(f);
+    if (end < 0 || fnio::fseek(f, start, SEEK_SET) != 0) {
+        return false;
     }
-    
-    if ((err = mbedtls_sha256_finish_ret(&ctx, hash_output.data())) != 0) {
-        mbedtls_sha256_free(&ctx);
-        return; // Handle error appropriately
+
+    uint8_t buf[512];
+    size_t n;
+    long int total = 0;
+    while ((n = fnio::fread(buf, 1, sizeof(buf), f)) > 0) {
+        if (!update(buf, n)) {
+            return false;
+        }
+        total += n;
     }
-#else
-    // Use legacy API
-    mbedtls_sha256_starts(&ctx, 0);
-    mbedtls_sha256_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    mbedtls_sha256_finish(&ctx, hash_output.data());
-#endif
-    
-    mbedtls_sha256_free(&ctx);
+    return start + total >= end;
 }
 
-void Hash::compute_sha512() {
-    mbedtls_sha512_context ctx;
-    mbedtls_sha512_init(&ctx);
-    
-    hash_output.resize(64);
-    
-#if MBEDTLS_VERSION_NUMBER >= 0x02070000 && MBEDTLS_VERSION_NUMBER < 0x03000000
-    int err = 0;
-
-    // Use newer API that returns status code
-    if ((err = mbedtls_sha512_starts_ret(&ctx, 0)) != 0) {
-        mbedtls_sha512_free(&ctx);
-        return; // Handle error appropriately
+bool Hash::Context::finish(std::vector<uint8_t>& output) {
+    bool ok = false;
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            output.resize(16);
+            ok = HASH_MBEDTLS_CALL(mbedtls_md5_finish, &_ctx.md5, output.data());
+            break;
+        case Algorithm::SHA1:
+            output.resize(20);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha1_finish, &_ctx.sha1, output.data());
+            break;
+        case Algorithm::SHA256:
+            output.resize(32);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha256_finish, &_ctx.sha256, output.data());
+            break;
+        case Algorithm::SHA512:
+            output.resize(64);
+            ok = HASH_MBEDTLS_CALL(mbedtls_sha512_finish, &_ctx.sha512, output.data());
+            break;
+        default:
+            break;
     }
-    
-    if ((err = mbedtls_sha512_update_ret(&ctx, accumulated_data.data(), accumulated_data.size())) != 0) {
-        mbedtls_sha512_free(&ctx);
-        return; // Handle error appropriately
+
+    if (!ok) {
+        output.clear();
     }
-    
-    if ((err = mbedtls_sha512_finish_ret(&ctx, hash_output.data())) != 0) {
-        mbedtls_sha512_free(&ctx);
-        return; // Handle error appropriately
+    reset();
+    return ok;
+}
+
+void Hash::Context::reset() {
+    switch (_algorithm) {
+        case Algorithm::MD5:
+            mbedtls_md5_free(&_ctx.md5);
+            break;
+        case Algorithm::SHA1:
+            mbedtls_sha1_free(&_ctx.sha1);
+            break;
+        case Algorithm::SHA256:
+            mbedtls_sha256_free(&_ctx.sha256);
+            break;
+        case Algorithm::SHA512:
+            mbedtls_sha512_free(&_ctx.sha512);
+            break;
+        default:
+            break;
     }
-#else
-    // Use legacy API
-    mbedtls_sha512_starts(&ctx, 0);
-    mbedtls_sha512_update(&ctx, accumulated_data.data(), accumulated_data.size());
-    mbedtls_sha512_finish(&ctx, hash_output.data());
-#endif
-    
-    mbedtls_sha512_free(&ctx);
+    _algorithm = Algorithm::UNKNOWN;
 }
 
 std::string Hash::bytes_to_hex(const std::vector<uint8_t>& bytes) const {
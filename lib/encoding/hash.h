@@ -8,12 +8,40 @@
 #include <mbedtls/sha256.h>
 #include <mbedtls/sha512.h>
 
+#include "fnio.h"
+
 class Hash {
 public:
     enum class Algorithm {
         UNKNOWN = -1, MD5, SHA1, SHA256, SHA512
     };
 
+    // Incremental hash state: init() once, update() with each chunk as it arrives, then finish()
+    class Context {
+    public:
+        Context() {}
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+        ~Context();
+
+        bool init(Algorithm algorithm);
+        bool update(const uint8_t *data, size_t len);
+        bool update_from_file(fnFile *f);
+        bool finish(std::vector<uint8_t>& output);
+        void reset();
+
+        Algorithm algorithm() const { return _algorithm; }
+
+    private:
+        Algorithm _algorithm = Algorithm::UNKNOWN;
+        union {
+            mbedtls_md5_context md5;
+            mbedtls_sha1_context sha1;
+            mbedtls_sha256_context sha256;
+            mbedtls_sha512_context sha512;
+        } _ctx;
+    };
+
     Hash();
     ~Hash();
 
@@ -25,16 +53,20 @@ public:
     std::vector<uint8_t> output_binary() const;
     std::string output_hex() const;
 
+    // Streaming alternative to add_data()/compute() when the algorithm is known up front
+    bool begin(Algorithm algorithm);
+    bool update(const uint8_t *data, size_t len);
+    bool update_from_file(fnFile *f);
+    bool finish();
+
     static Hash::Algorithm to_algorithm(uint8_t value);
     static Hash::Algorithm from_string(std::string hash_name);
 
 private:
     std::vector<uint8_t> accumulated_data;
     std::vector<uint8_t> hash_output;
+    Context stream;
 
-    void compute_sha1();
-    void compute_sha256();
-    void compute_sha512();
     std::string bytes_to_hex(const std::vector<uint8_t>& bytes) const;
 };
 
@@ -0,0 +1,585 @@
+/**
+ * Streaming JSON document for #FujiNet
+ */
+
+#include "fnJsonStream.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Forget the document
+ */
+void FNJSONStream::clear()
+{
+    _text.clear();
+    _text.shrink_to_fit();
+    _stack.clear();
+    _stack.shrink_to_fit();
+    _state = State::Value;
+    _started = false;
+    _key = false;
+    _low = false;
+    _number_len = 0;
+}
+
+/**
+ * Document can't be valid any more, let go of it
+ */
+bool FNJSONStream::fail()
+{
+    _state = State::Error;
+    _text.clear();
+    _text.shrink_to_fit();
+    _stack.clear();
+    _stack.shrink_to_fit();
+    return false;
+}
+
+/**
+ * A value is complete
+ */
+void FNJSONStream::value_end()
+{
+    _state = _stack.empty() ? State::Done : State::AfterValue;
+}
+
+/**
+ * First character of a value
+ */
+bool FNJSONStream::value_start(char c)
+{
+    switch (c)
+    {
+    case '{':
+    case '[':
+        if (_stack.size() >= FNJSON_NESTING_LIMIT)
+            return fail();
+        _stack.push_back(c);
+        _state = c == '{' ? State::ObjectFirst : State::ArrayFirst;
+        break;
+    case '"':
+        _key = false;
+        _state = State::String;
+        break;
+    case 't':
+        _literal = "true";
+        break;
+    case 'f':
+        _literal = "false";
+        break;
+    case 'n':
+        _literal = "null";
+        break;
+    default:
+        if (c != '-' && (c < '0' || c > '9'))
+            return fail();
+        _number[0] = c;
+        _number_len = 1;
+        _state = State::Number;
+        break;
+    }
+
+    if (c == 't' || c == 'f' || c == 'n')
+    {
+        _literal_pos = 1;
+        _state = State::Literal;
+    }
+    _text.push_back(c);
+    return true;
+}
+
+/**
+ * Number ended, it has to be one strtod() takes as a whole
+ */
+bool FNJSONStream::number_end()
+{
+    char *end;
+    _number[_number_len] = '\0';
+    strtod(_number, &end);
+    if (end != _number + _number_len)
+        return fail();
+    value_end();
+    return true;
+}
+
+/**
+ * Check the next bytes and keep them, less the whitespace
+ */
+bool FNJSONStream::feed(const char *data, size_t len)
+{
+    const char *p = data;
+    const char *end = data + len;
+
+    while (p < end && _state != State::Done && _state != State::Error)
+    {
+        char c = *p;
+
+        // cJSON stops at NUL, so does the document
+        if (c == '\0')
+            return finish();
+
+        if (!_started)
+        {
+            _started = true;
+            if ((uint8_t)c == 0xEF)
+            {
+                _state = State::Bom1;
+                p++;
+                continue;
+            }
+        }
+
+        switch (_state)
+        {
+        case State::String:
+        {
+            // copy up to the end of string or the next escape
+            const char *q = p;
+            while (q < end && *q != '"' && *q != '\\' && *q != '\0')
+                q++;
+            _text.insert(_text.end(), p, q);
+            p = q;
+            if (p == end || *p == '\0')
+                continue;
+            _text.push_back(*p);
+            if (*p++ == '\\')
+                _state = State::Escape;
+            else if (_key)
+                _state = State::Colon;
+            else
+                value_end();
+            continue;
+        }
+
+        case State::Escape:
+            switch (c)
+            {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                _state = State::String;
+                break;
+            case 'u':
+                _hex = 0;
+                _hex_count = 0;
+                _low = false;
+                _state = State::Hex;
+                break;
+            default:
+                return fail();
+            }
+            break;
+
+        case State::Hex:
+        {
+            if (!isxdigit((unsigned char)c))
+                return fail();
+            _hex = (_hex << 4) | (isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) - 'a' + 10));
+            if (++_hex_count < 4)
+                break;
+            bool low = _hex >= 0xDC00 && _hex <= 0xDFFF;
+            if (_low != low)
+                return fail(); // lone surrogate
+            if (!_low && _hex >= 0xD800 && _hex <= 0xDBFF)
+                _state = State::LowEscape;
+            else
+                _state = State::String;
+            break;
+        }
+
+        case State::LowEscape:
+            if (c != '\\')
+                return fail();
+            _state = State::LowU;
+            break;
+
+        case State::LowU:
+            if (c != 'u')
+                return fail();
+            _hex = 0;
+            _hex_count = 0;
+            _low = true;
+            _state = State::Hex;
+            break;
+
+        case State::Number:
+            if ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == 'e' || c == 'E' || c == '.')
+            {
+                if (_number_len == FNJSON_NUMBER_MAX)
+                    return fail();
+                _number[_number_len++] = c;
+                break;
+            }
+            // ended by c, which is looked at again in the next state
+            if (!number_end())
+                return false;
+            continue;
+
+        case State::Literal:
+            if (c != _literal[_literal_pos])
+                return fail();
+            if (_literal[++_literal_pos] == '\0')
+                value_end();
+            break;
+
+        case State::Bom1:
+            if ((uint8_t)c != 0xBB)
+                return fail();
+            _state = State::Bom2;
+            p++;
+            continue;
+
+        case State::Bom2:
+            if ((uint8_t)c != 0xBF)
+                return fail();
+            _state = State::Value;
+            p++;
+            continue;
+
+        default:
+            // Between tokens, skip whitespace (as cJSON, anything up to space)
+            if ((uint8_t)c <= ' ')
+            {
+                p++;
+                continue;
+            }
+
+            switch (_state)
+            {
+            case State::Value:
+                if (!value_start(c))
+                    return false;
+                p++;
+                continue;
+
+            case State::ArrayFirst:
+                if (c == ']')
+                {
+                    _stack.pop_back();
+                    value_end();
+                    break;
+                }
+                if (!value_start(c))
+                    return false;
+                p++;
+                continue;
+
+            case State::ObjectFirst:
+            case State::Key:
+                if (c == '}' && _state == State::ObjectFirst)
+                {
+                    _stack.pop_back();
+                    value_end();
+                    break;
+                }
+                if (c != '"')
+                    return fail();
+                _key = true;
+                _state = State::String;
+                break;
+
+            case State::Colon:
+                if (c != ':')
+                    return fail();
+                _state = State::Value;
+                break;
+
+            case State::AfterValue:
+                if (c == ',')
+                    _state = _stack.back() == '{' ? State::Key : State::Value;
+                else if ((c == ']' && _stack.back() == '[') || (c == '}' && _stack.back() == '{'))
+                {
+                    _stack.pop_back();
+                    value_end();
+                }
+                else
+                    return fail();
+                break;
+
+            default:
+                return fail();
+            }
+            break;
+        }
+
+        // c is part of the document
+        _text.push_back(c);
+        p++;
+    }
+
+    return _state != State::Error;
+}
+
+/**
+ * All bytes are in
+ */
+bool FNJSONStream::finish()
+{
+    if (_state == State::Number && !number_end())
+        return false;
+    if (_state != State::Done)
+        return fail();
+
+    _stack.clear();
+    _stack.shrink_to_fit();
+    _text.shrink_to_fit();
+    return true;
+}
+
+/**
+ * Position of the quote closing the string starting at pos
+ */
+size_t FNJSONStream::skip_string(size_t pos) const
+{
+    const char *text = _text.data();
+    const char *end = text + _text.size();
+    const char *p = text + pos + 1;
+
+    while (true)
+    {
+        const char *q = (const char *)memchr(p, '"', end - p);
+        if (q == nullptr)
+            return _text.size(); // can't happen, the text was checked
+        // escaped if there's an odd number of backslashes before it
+        const char *b = q;
+        while (b > p && b[-1] == '\\')
+            b--;
+        if (((q - b) & 1) == 0)
+            return q - text;
+        p = q + 1;
+    }
+}
+
+/**
+ * Position after the value starting at pos
+ */
+size_t FNJSONStream::skip_value(size_t pos) const
+{
+    const char *text = _text.data();
+    size_t size = _text.size();
+
+    switch (text[pos])
+    {
+    case '"':
+        return skip_string(pos) + 1;
+
+    case '{':
+    case '[':
+    {
+        int depth = 0;
+        for (; pos < size; pos++)
+        {
+            char c = text[pos];
+            if (c == '"')
+                pos = skip_string(pos);
+            else if (c == '{' || c == '[')
+                depth++;
+            else if ((c == '}' || c == ']') && --depth == 0)
+                return pos + 1;
+        }
+        return size;
+    }
+
+    default:
+        // number or literal
+        while (pos < size && text[pos] != ',' && text[pos] != ']' && text[pos] != '}')
+            pos++;
+        return pos;
+    }
+}
+
+static unsigned hex4(const char *p)
+{
+    unsigned value = 0;
+    for (int i = 0; i < 4; i++)
+        value = (value << 4) | (isdigit((unsigned char)p[i]) ? p[i] - '0' : (tolower((unsigned char)p[i]) - 'a' + 10));
+    return value;
+}
+
+/**
+ * Object key as cJSON has it, from the quote at pos to the quote at end
+ */
+std::string FNJSONStream::decode_key(size_t pos, size_t end) const
+{
+    const char *p = _text.data() + pos + 1;
+    const char *e = _text.data() + end;
+    std::string key;
+
+    while (p < e)
+    {
+        if (*p != '\\')
+        {
+            key += *p++;
+            continue;
+        }
+        p++;
+        switch (*p)
+        {
+        case 'b': key += '\b'; break;
+        case 'f': key += '\f'; break;
+        case 'n': key += '\n'; break;
+        case 'r': key += '\r'; break;
+        case 't': key += '\t'; break;
+        case 'u':
+        {
+            unsigned code = hex4(p + 1);
+            p += 4;
+            if (code >= 0xD800 && code <= 0xDBFF)
+            {
+                code = 0x10000 + (((code & 0x3FF) << 10) | (hex4(p + 3) & 0x3FF));
+                p += 6;
+            }
+            // UTF-8
+            if (code < 0x80)
+                key += (char)code;
+            else if (code < 0x800)
+            {
+                key += (char)(0xC0 | (code >> 6));
+                key += (char)(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                key += (char)(0xE0 | (code >> 12));
+                key += (char)(0x80 | ((code >> 6) & 0x3F));
+                key += (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                key += (char)(0xF0 | (code >> 18));
+                key += (char)(0x80 | ((code >> 12) & 0x3F));
+                key += (char)(0x80 | ((code >> 6) & 0x3F));
+                key += (char)(0x80 | (code & 0x3F));
+            }
+            break;
+        }
+        default: // '"', '\\' and '/'
+            key += *p;
+            break;
+        }
+        p++;
+    }
+
+    // cJSON keys end at an escaped NUL
+    key.resize(strlen(key.c_str()));
+    return key;
+}
+
+/**
+ * Does the key match the pointer token, as compare_pointers() in cJSON_Utils
+ */
+static bool key_matches(const char *name, const char *pointer)
+{
+    for (; *name != '\0' && *pointer != '\0' && *pointer != '/'; name++, pointer++)
+    {
+        if (*pointer == '~')
+        {
+            // ~0 is '~' and ~1 is '/'
+            if ((pointer[1] != '0' || *name != '~') && (pointer[1] != '1' || *name != '/'))
+                return false;
+            pointer++;
+        }
+        else if (tolower((unsigned char)*name) != tolower((unsigned char)*pointer))
+            return false;
+    }
+    return (*pointer != '\0' && *pointer != '/') == (*name != '\0');
+}
+
+/**
+ * Array index from the pointer token, as decode_array_index_from_pointer() in cJSON_Utils
+ */
+static bool array_index(const char *pointer, size_t *index)
+{
+    size_t value = 0;
+    size_t pos;
+
+    // no leading zeroes
+    if (pointer[0] == '0' && pointer[1] != '\0' && pointer[1] != '/')
+        return false;
+
+    for (pos = 0; pointer[pos] >= '0' && pointer[0] <= '9'; pos++)
+        value = 10 * value + (size_t)(pointer[pos] - '0');
+
+    if (pointer[pos] != '\0' && pointer[pos] != '/')
+        return false;
+
+    *index = value;
+    return true;
+}
+
+/**
+ * Walk the text to the value the pointer selects
+ */
+bool FNJSONStream::find(const char *pointer, size_t *start, size_t *len) const
+{
+    if (!valid() || pointer == nullptr)
+        return false;
+
+    const char *text = _text.data();
+    size_t pos = 0;
+
+    while (*pointer == '/')
+    {
+        pointer++;
+
+        if (text[pos] == '[')
+        {
+            size_t index;
+            if (!array_index(pointer, &index))
+                return false;
+            pos++;
+            if (text[pos] == ']')
+                return false;
+            for (; index > 0; index--)
+            {
+                pos = skip_value(pos);
+                if (text[pos] == ']')
+                    return false;
+                pos++; // ','
+            }
+        }
+        else if (text[pos] == '{')
+        {
+            pos++;
+            while (true)
+            {
+                if (text[pos] == '}')
+                    return false;
+                size_t key_end = skip_string(pos);
+                bool match = key_matches(decode_key(pos, key_end).c_str(), pointer);
+                pos = key_end + 2; // past '"' and ':'
+                if (match)
+                    break;
+                pos = skip_value(pos);
+                if (text[pos] == ',')
+                    pos++;
+            }
+        }
+        else
+            return false;
+
+        while (*pointer != '\0' && *pointer != '/')
+            pointer++;
+    }
+
+    *start = pos;
+    *len = skip_value(pos) - pos;
+    return true;
+}
+
+/**
+ * Parse just the value the pointer selects
+ */
+cJSON *FNJSONStream::get(const char *pointer) const
+{
+    size_t start, len;
+    if (!find(pointer, &start, &len))
+        return nullptr;
+    return cJSON_ParseWithLength(_text.data() + start, len);
+}
@@ -0,0 +1,115 @@
+/**
+ * Streaming JSON document for #FujiNet
+ *
+ * The document is checked as it arrives, chunk by chunk, and kept as
+ * compact text (whitespace outside strings removed) instead of a cJSON
+ * tree. A query walks the text to the value a JSON pointer selects and
+ * only that value is turned into cJSON.
+ */
+
+#ifndef FNJSONSTREAM_H
+#define FNJSONSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cJSON.h>
+
+#ifdef ESP_PLATFORM
+#include "../../include/PSRAMAllocator.h"
+#endif
+
+// Deepest nesting accepted, as cJSON
+#define FNJSON_NESTING_LIMIT 1000
+// Longest number accepted, as cJSON
+#define FNJSON_NUMBER_MAX 63
+
+class FNJSONStream
+{
+public:
+    // Forget the document, ready for a new one
+    void clear();
+
+    /**
+     * @brief Add the next bytes of the document
+     * @return false once the document can't be valid JSON any more
+     */
+    bool feed(const char *data, size_t len);
+
+    /**
+     * @brief No more bytes to come
+     * @return true if the bytes fed make one JSON value
+     */
+    bool finish();
+
+    bool valid() const { return _state == State::Done; }
+
+    // The compact document text
+    const char *data() const { return _text.data(); }
+    size_t size() const { return _text.size(); }
+
+    /**
+     * @brief Find the value a JSON pointer selects, as cJSONUtils_GetPointer()
+     * (object keys are compared ignoring case, a pointer not starting with
+     * '/' selects the whole document)
+     * @param start offset of the value in data()
+     * @param len length of the value
+     * @return false if there is no such value
+     */
+    bool find(const char *pointer, size_t *start, size_t *len) const;
+
+    // Parse the value a JSON pointer selects, nullptr if none. Free with cJSON_Delete()
+    cJSON *get(const char *pointer) const;
+
+private:
+    enum class State : uint8_t
+    {
+        Bom1,        // after first byte of UTF-8 BOM
+        Bom2,        // after second byte of UTF-8 BOM
+        Value,       // a value has to follow
+        ArrayFirst,  // after '[', a value or ']'
+        ObjectFirst, // after '{', a key or '}'
+        Key,         // after ',' in object, a key
+        Colon,       // after key
+        AfterValue,  // ',' or end of container
+        String,
+        Escape,      // after '\' in string
+        Hex,         // in \uXXXX
+        LowEscape,   // after \uD800-\uDBFF, wants '\' of the low surrogate
+        LowU,        // wants 'u' of the low surrogate
+        Number,
+        Literal,     // true, false or null
+        Done,        // top level value complete, anything after is ignored
+        Error
+    };
+
+#ifdef ESP_PLATFORM
+    std::vector<char, PSRAMAllocator<char>> _text;
+#else
+    std::vector<char> _text;
+#endif
+    std::vector<char> _stack; // open containers, '{' or '['
+    State _state = State::Value;
+    bool _started = false;    // non-whitespace seen
+    bool _key = false;        // string is an object key
+    bool _low = false;        // \uXXXX is a low surrogate
+    uint8_t _hex_count = 0;
+    uint16_t _hex = 0;
+    const char *_literal = nullptr;
+    uint8_t _literal_pos = 0;
+    char _number[FNJSON_NUMBER_MAX + 1];
+    uint8_t _number_len = 0;
+
+    bool value_start(char c);
+    void value_end();
+    bool number_end();
+    bool fail();
+
+    size_t skip_string(size_t pos) const;
+    size_t skip_value(size_t pos) const;
+    std::string decode_key(size_t pos, size_t end) const;
+};
+
+#endif /* FNJSONSTREAM_H */
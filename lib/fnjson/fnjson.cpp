@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <ostream>
 #include "string_utils.h"
+#include "charset.h"
 #include "../../include/debug.h"
 #include "../utils/utils.h"
 
@@ -84,14 +85,15 @@ void FNJSON::setReadQuery(const std::string &queryString, uint8_t queryParam)
 }
 
 /**
- * Resolve query string
+ * Resolve query string, only the value found is parsed
  */
 cJSON *FNJSON::resolveQuery()
 {
-    if (_queryString.empty())
-        return _json;
+    if (_json != nullptr)
+        cJSON_Delete(_json);
 
-    return cJSONUtils_GetPointer(_json, _queryString.c_str());
+    _json = _document.get(_queryString.c_str());
+    return _json;
 }
 
 /**
@@ -138,23 +140,13 @@ std::string FNJSON::processString(std::string in)
         {
             Debug_printf("Applying international charset mapping\r\n");
             // yes, mapping to international charset
-            std::string mapFrom[] = {"á", "ù", "Ñ", "É", "ç", "ô", "ò", "ì", "£", "ï", "ü", "ä", "Ö", "ú", "ó", "ö", "Ü", "â", "û", "î", "é", "è", "ñ", "ê", "å", "à", "Å", "¡", "Ä", "ß"};
-            std::string mapTo[] = {"\x00", "\x01", "\x02", "\x03", "\x04", "\x05", "\x06", "\x07", "\x08", "\x09", "\x0a", "\x0b", "\x0c", "\x0d", "\x0e", "\x0f", "\x10", "\x11", "\x12", "\x13", "\x14", "\x15", "\x16", "\x17", "\x18", "\x19", "\x1a", "\x60", "\x7b", "ss"};
-            int elementCount = sizeof(mapFrom) / sizeof(mapFrom[0]);
-            for (int elementIndex = 0; elementIndex < elementCount; elementIndex++)
-                if (in.find(mapFrom[elementIndex]) != std::string::npos)
-                    in.replace(in.find(mapFrom[elementIndex]), std::string(mapFrom[elementIndex]).size(), mapTo[elementIndex]);
+            charset::utf8_to_atascii(in, true);
         }
         else
         {
             Debug_printf("Applying umlaut removal mapping\r\n");
             // no, mapping to normal ASCI (workaround)
-            std::string mapFrom[] = {"Ä", "Ö", "Ü", "ä", "ö", "ü", "ß", "é", "è", "á", "à", "ó", "ò", "ú", "ù"};
-            std::string mapTo[] = {"Ae", "Oe", "Ue", "ae", "oe", "ue", "ss", "e", "e", "a", "a", "o", "o", "u", "u"};
-            int elementCount = sizeof(mapFrom) / sizeof(mapFrom[0]);
-            for (int elementIndex = 0; elementIndex < elementCount; elementIndex++)
-                if (in.find(mapFrom[elementIndex]) != std::string::npos)
-                    in.replace(in.find(mapFrom[elementIndex]), std::string(mapFrom[elementIndex]).size(), mapTo[elementIndex]);
+            charset::utf8_to_atascii(in, false);
         }
 
     }
@@ -298,6 +290,8 @@ int FNJSON::readValueLen()
 
 /**
  * Parse data from protocol
+ * The document is checked as it's read and kept as compact text, queries
+ * then parse only the value they select.
  */
 bool FNJSON::parse()
 {
@@ -305,17 +299,17 @@ bool FNJSON::parse()
 
     if (_json != nullptr)
     {
-        // delete and set to null. we only set a new _json value if the parsebuffer is not empty
         cJSON_Delete(_json);
         _json = nullptr;
     }
+    _item = nullptr;
+    _document.clear();
 
     if (_protocol == nullptr)
     {
         // Debug_printf("FNJSON::parse() - NULL protocol.\r\n");
         return false;
     }
-    _parseBuffer.clear();
     _protocol->status(&ns);
 #ifdef VERBOSE_PROTOCOL
     Debug_printf("json parse, initial status: ns.rxBW: %d, ns.conn: %d, ns.err: %d\r\n", ns.rxBytesWaiting, ns.connected, ns.error);
@@ -331,7 +325,8 @@ bool FNJSON::parse()
         if (ns.rxBytesWaiting > 0)
         {
             _protocol->read(ns.rxBytesWaiting);
-            _parseBuffer += *_protocol->receiveBuffer;
+            // keep reading an invalid document to its end, but don't keep it
+            _document.feed(_protocol->receiveBuffer->data(), _protocol->receiveBuffer->size());
             _protocol->receiveBuffer->clear();
         }
         _protocol->status(&ns);
@@ -340,21 +335,17 @@ bool FNJSON::parse()
 #endif
     }
 
-    // Debug_printf("S: %s\r\n", _parseBuffer.c_str());
-    // only try and parse the buffer if it has data. Empty response doesn't need parsing.
-    if (!_parseBuffer.empty())
-    {
-        _json = cJSON_Parse(_parseBuffer.c_str());
-    }
-
-    if (_json == nullptr)
+    if (!_document.finish())
     {
 #ifdef VERBOSE_PROTOCOL
-        Debug_printf("FNJSON::parse() - Could not parse JSON, parseBuffer length: %d\r\n", _parseBuffer.size());
+        Debug_printf("FNJSON::parse() - Could not parse JSON\r\n");
 #endif
         return false;
     }
 
+#ifdef VERBOSE_PROTOCOL
+    Debug_printf("FNJSON::parse() - %u bytes kept\r\n", (unsigned)_document.size());
+#endif
     return true;
 }
 
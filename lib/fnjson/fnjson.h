@@ -13,6 +13,7 @@
 #include <string.h>
 
 #include "../network-protocol/Protocol.h"
+#include "fnJsonStream.h"
 
 class FNJSON
 {
@@ -41,7 +42,7 @@ private:
     uint8_t _queryParam = 0;
     std::string lineEnding;
     std::string getValue(cJSON *item);
-    std::string _parseBuffer;
+    FNJSONStream _document;
 };
 
 #endif /* JSON_H */
\ No newline at end of file
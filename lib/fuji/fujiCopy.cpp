@@ -0,0 +1,467 @@
+#include "fujiCopy.h"
+
+#include <cstdlib>
+#include <cstring>
+#include "compat_string.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#else
+#include <chrono>
+#endif
+
+#include "../../include/debug.h"
+
+#include "fnSystem.h"
+
+
+std::mutex fujiCopy::_status_mutex;
+fujiCopy *fujiCopy::_current = nullptr;
+fujiCopyStatus fujiCopy::_last;
+uint32_t fujiCopy::_copies = 0;
+
+fujiCopy::fujiCopy(int buffers, size_t buffer_size)
+{
+    _num_buffers = buffers > 0 ? buffers : 1;
+    _buffer_size = buffer_size;
+    _dst_fullpath[0] = '\0';
+}
+
+fujiCopy::~fujiCopy()
+{
+    if (_running)
+        wait();
+    free_buffers();
+}
+
+bool fujiCopy::alloc_buffers()
+{
+#ifdef ESP_PLATFORM
+    bool psram = fnSystem.get_psram_size() > 0;
+    if (!psram)
+    {
+        _num_buffers = 1;
+        if (_buffer_size > COPY_BUFFER_SIZE_NO_PSRAM)
+            _buffer_size = COPY_BUFFER_SIZE_NO_PSRAM;
+    }
+#endif
+
+    _buffers = (uint8_t **)calloc(_num_buffers, sizeof(uint8_t *));
+    if (_buffers == nullptr)
+        return false;
+
+    for (int i = 0; i < _num_buffers; i++)
+    {
+#ifdef ESP_PLATFORM
+        _buffers[i] = (uint8_t *)heap_caps_malloc(_buffer_size,
+            psram ? MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM : MALLOC_CAP_DEFAULT);
+#else
+        _buffers[i] = (uint8_t *)malloc(_buffer_size);
+#endif
+        if (_buffers[i] == nullptr)
+        {
+            // Make do with what we have, one buffer still works without overlap
+            Debug_printf("fujiCopy: only %d of %d buffers allocated\r\n", i, _num_buffers);
+            _num_buffers = i;
+            break;
+        }
+    }
+    return _num_buffers > 0;
+}
+
+void fujiCopy::free_buffers()
+{
+    if (_buffers == nullptr)
+        return;
+    for (int i = 0; i < _num_buffers; i++)
+        free(_buffers[i]);
+    free(_buffers);
+    _buffers = nullptr;
+}
+
+bool fujiCopy::start(fujiHost &src_host, const char *src_path, fujiHost &dst_host, const char *dst_path)
+{
+    if (_running)
+        return false;
+
+    char src_fullpath[MAX_PATHLEN];
+    fnFile *src = src_host.fnfile_open(src_path, src_fullpath, sizeof(src_fullpath), FILE_READ);
+    if (src == nullptr)
+    {
+        Debug_printf("fujiCopy: couldn't open source \"%s\"\r\n", src_path);
+        return false;
+    }
+
+    fnFile *dst = dst_host.fnfile_open(dst_path, _dst_fullpath, sizeof(_dst_fullpath), FILE_WRITE);
+    if (dst == nullptr)
+    {
+        Debug_printf("fujiCopy: couldn't open destination \"%s\"\r\n", dst_path);
+        fnio::fclose(src);
+        return false;
+    }
+
+    // The same host can't take a read and a write at once, so only one
+    // buffer goes around and reads and writes take turns
+    if (!start(src, dst, src_host.file_size(src), &src_host == &dst_host))
+    {
+        dst_host.file_remove(_dst_fullpath);
+        return false;
+    }
+    _dst_host = &dst_host;
+    return true;
+}
+
+bool fujiCopy::start(fnFile *src, fnFile *dst, long size, bool one_buffer)
+{
+    if (_running)
+    {
+        fnio::fclose(src);
+        fnio::fclose(dst);
+        return false;
+    }
+
+    _src = src;
+    _dst = dst;
+    _dst_host = nullptr;
+    total = size;
+    if (one_buffer)
+        _num_buffers = 1;
+
+    bytes_read = 0;
+    bytes_written = 0;
+    _failed = false;
+    _ended = false;
+
+    // Shown as running before the tasks start counting
+    {
+        std::lock_guard<std::mutex> lock(_status_mutex);
+        _current = this;
+        _copies++;
+    }
+
+    if (!alloc_buffers() || !start_tasks())
+    {
+        Debug_println("fujiCopy: couldn't start copy");
+        free_buffers();
+        fnio::fclose(_src);
+        fnio::fclose(_dst);
+        _src = _dst = nullptr;
+
+        std::lock_guard<std::mutex> lock(_status_mutex);
+        _failed = true;
+        _current = nullptr;
+        _last = progress();
+        return false;
+    }
+
+    Debug_printf("fujiCopy: %ld bytes, %d buffers of %u\r\n", total, _num_buffers, (unsigned)_buffer_size);
+    _running = true;
+    return true;
+}
+
+bool fujiCopy::wait(const std::function<void()> &poll)
+{
+    if (!_running)
+        return false;
+
+    wait_tasks(poll);
+    _running = false;
+
+    {
+        std::lock_guard<std::mutex> lock(_status_mutex);
+        _current = nullptr;
+        _last = progress();
+    }
+
+    fnio::fclose(_src);
+    fnio::fclose(_dst);
+    _src = _dst = nullptr;
+    free_buffers();
+
+    if (_failed)
+    {
+        Debug_printf("fujiCopy: failed, read %lu written %lu of %ld\r\n",
+                     (unsigned long)bytes_read, (unsigned long)bytes_written, total);
+        // Don't leave a partial file behind
+        if (_dst_host != nullptr)
+            _dst_host->file_remove(_dst_fullpath);
+        return false;
+    }
+
+    Debug_printf("fujiCopy: done, %lu bytes\r\n", (unsigned long)bytes_written);
+    return true;
+}
+
+// Called with _status_mutex held
+fujiCopyStatus fujiCopy::progress()
+{
+    fujiCopyStatus s;
+    s.copies = _copies;
+    s.busy = _current == this;
+    s.failed = _failed;
+    s.bytes_read = bytes_read;
+    s.bytes_written = bytes_written;
+    s.total = total;
+    return s;
+}
+
+fujiCopyStatus fujiCopy::status()
+{
+    std::lock_guard<std::mutex> lock(_status_mutex);
+    if (_current != nullptr)
+        return _current->progress();
+    return _last;
+}
+
+/*
+ Reads the source into free buffers until the expected size or end of file.
+ The last chunk read is marked, so the writer knows when to stop.
+*/
+void fujiCopy::read_loop()
+{
+    while (true)
+    {
+        chunk c = take_free();
+        c.len = 0;
+        c.last = true;
+
+        if (!_failed)
+        {
+            c.len = fnio::fread(_buffers[c.buf], 1, _buffer_size, _src);
+            bytes_read += c.len;
+            // Check if we got enough bytes on the read
+            if (c.len < _buffer_size && total >= 0 && bytes_read != (uint32_t)total)
+                _failed = true;
+            c.last = _failed || c.len < _buffer_size || (total >= 0 && bytes_read >= (uint32_t)total);
+        }
+
+        put_full(c);
+        if (c.last)
+            break;
+    }
+}
+
+// Writes filled buffers to the destination and hands them back
+void fujiCopy::write_loop()
+{
+    while (true)
+    {
+        chunk c = take_full();
+        if (c.buf < 0)
+            break;
+
+        if (!_failed && c.len > 0)
+        {
+            size_t written = fnio::fwrite(_buffers[c.buf], 1, c.len, _dst);
+            bytes_written += written;
+            // Check if we sent enough bytes on the write
+            if (written != c.len)
+                _failed = true;
+        }
+
+        bool last = c.last;
+        put_free(c);
+        if (last)
+            break;
+    }
+}
+
+#ifdef ESP_PLATFORM
+
+void fujiCopy::reader_task(void *arg)
+{
+    fujiCopy *copy = (fujiCopy *)arg;
+    copy->read_loop();
+    xSemaphoreGive(copy->_task_done);
+    vTaskDelete(NULL);
+}
+
+void fujiCopy::writer_task(void *arg)
+{
+    fujiCopy *copy = (fujiCopy *)arg;
+    copy->write_loop();
+    copy->_ended = true;
+    xSemaphoreGive(copy->_task_done);
+    vTaskDelete(NULL);
+}
+
+bool fujiCopy::start_tasks()
+{
+    _free_q = xQueueCreate(_num_buffers, sizeof(chunk));
+    _full_q = xQueueCreate(_num_buffers + 1, sizeof(chunk));
+    _task_done = xSemaphoreCreateCounting(2, 0);
+    if (_free_q == nullptr || _full_q == nullptr || _task_done == nullptr)
+    {
+        wait_tasks(nullptr);
+        return false;
+    }
+
+    for (int i = 0; i < _num_buffers; i++)
+        put_free({i, 0, false});
+
+    if (xTaskCreate(writer_task, "copy_write", COPY_STACKSIZE, this, COPY_PRIORITY, nullptr) != pdPASS)
+    {
+        wait_tasks(nullptr);
+        return false;
+    }
+    if (xTaskCreate(reader_task, "copy_read", COPY_STACKSIZE, this, COPY_PRIORITY, nullptr) != pdPASS)
+    {
+        // stop the writer
+        _failed = true;
+        put_full({-1, 0, true});
+        xSemaphoreTake(_task_done, portMAX_DELAY);
+        wait_tasks(nullptr);
+        return false;
+    }
+    return true;
+}
+
+// Waits for both tasks to end (if they were started) and deletes the queues
+void fujiCopy::wait_tasks(const std::function<void()> &poll)
+{
+    if (_running)
+    {
+        uint64_t report = fnSystem.millis();
+        for (int ended = 0; ended < 2;)
+        {
+            if (xSemaphoreTake(_task_done, pdMS_TO_TICKS(COPY_POLL_MS)) == pdTRUE)
+            {
+                ended++;
+                continue;
+            }
+            if (poll)
+                poll();
+            if (fnSystem.millis() - report >= 1000)
+            {
+                Debug_printf("Copy File: %lu bytes of %ld\r\n", (unsigned long)bytes_written, total);
+                report = fnSystem.millis();
+            }
+        }
+    }
+
+    if (_free_q != nullptr)
+        vQueueDelete(_free_q);
+    if (_full_q != nullptr)
+        vQueueDelete(_full_q);
+    if (_task_done != nullptr)
+        vSemaphoreDelete(_task_done);
+    _free_q = _full_q = nullptr;
+    _task_done = nullptr;
+}
+
+void fujiCopy::put_free(const chunk &c)
+{
+    xQueueSend(_free_q, &c, portMAX_DELAY);
+}
+
+fujiCopy::chunk fujiCopy::take_free()
+{
+    chunk c;
+    xQueueReceive(_free_q, &c, portMAX_DELAY);
+    return c;
+}
+
+void fujiCopy::put_full(const chunk &c)
+{
+    xQueueSend(_full_q, &c, portMAX_DELAY);
+}
+
+fujiCopy::chunk fujiCopy::take_full()
+{
+    chunk c;
+    xQueueReceive(_full_q, &c, portMAX_DELAY);
+    return c;
+}
+
+#else
+
+bool fujiCopy::start_tasks()
+{
+    _free_q.clear();
+    _full_q.clear();
+    for (int i = 0; i < _num_buffers; i++)
+        _free_q.push_back({i, 0, false});
+
+    try
+    {
+        _writer = std::thread([this]() {
+            write_loop();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _ended = true;
+            _cond.notify_all();
+        });
+    }
+    catch (const std::system_error &e)
+    {
+        return false;
+    }
+    try
+    {
+        _reader = std::thread([this]() { read_loop(); });
+    }
+    catch (const std::system_error &e)
+    {
+        // stop the writer
+        _failed = true;
+        put_full({-1, 0, true});
+        _writer.join();
+        return false;
+    }
+    return true;
+}
+
+void fujiCopy::wait_tasks(const std::function<void()> &poll)
+{
+    uint64_t report = fnSystem.millis();
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_cond.wait_for(lock, std::chrono::milliseconds(COPY_POLL_MS), [this]() { return _ended.load(); }))
+                break;
+        }
+        if (poll)
+            poll();
+        if (fnSystem.millis() - report >= 1000)
+        {
+            Debug_printf("Copy File: %lu bytes of %ld\r\n", (unsigned long)bytes_written, total);
+            report = fnSystem.millis();
+        }
+    }
+    _writer.join();
+    _reader.join();
+}
+
+void fujiCopy::put_free(const chunk &c)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free_q.push_back(c);
+    _cond.notify_all();
+}
+
+fujiCopy::chunk fujiCopy::take_free()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this]() { return !_free_q.empty(); });
+    chunk c = _free_q.front();
+    _free_q.pop_front();
+    return c;
+}
+
+void fujiCopy::put_full(const chunk &c)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _full_q.push_back(c);
+    _cond.notify_all();
+}
+
+fujiCopy::chunk fujiCopy::take_full()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this]() { return !_full_q.empty(); });
+    chunk c = _full_q.front();
+    _full_q.pop_front();
+    return c;
+}
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef _FUJI_COPY_
+#define _FUJI_COPY_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#endif
+
+#include "fujiHost.h"
+
+// Buffers in the pool, and their size; more buffers let a slow side catch up
+#ifndef COPY_BUFFERS
+#define COPY_BUFFERS 4
+#endif
+#ifndef COPY_BUFFER_SIZE
+#define COPY_BUFFER_SIZE 16384
+#endif
+// Without PSRAM there is one buffer in internal RAM, the size the copy commands always used
+#define COPY_BUFFER_SIZE_NO_PSRAM 532
+
+#define COPY_STACKSIZE 8192
+#define COPY_PRIORITY 5
+// How often wait() calls its poll function and reports progress
+#define COPY_POLL_MS 100
+
+// Progress of the running copy, or of the last one
+struct fujiCopyStatus
+{
+    uint32_t copies = 0; // copies started since boot
+    bool busy = false;   // a copy is running
+    bool failed = false;
+    uint32_t bytes_read = 0;
+    uint32_t bytes_written = 0;
+    long total = -1; // source file size, -1 if unknown
+};
+
+/*
+ * Copies a file from one host to another with a reader and a writer task,
+ * so reading the next buffer from the source overlaps writing the last one
+ * to the destination. Buffers go around between the two through a queue
+ * of free buffers and a queue of filled ones. The pool is kept in PSRAM;
+ * boards without it copy through a single small buffer, one step at a time.
+ *
+ * The copy commands still wait() for the result: SIO, RS232 and SmartPort
+ * all report it in the command's reply, and the computer waits for that
+ * reply. Only reading and writing overlap, the command doesn't return any
+ * sooner. Other tasks, like the web UI, follow the copy through status().
+ *
+ *   fujiCopy copy;
+ *   if (!copy.start(srcHost, srcPath, dstHost, dstPath)) error...
+ *   bool ok = copy.wait();
+ */
+class fujiCopy
+{
+public:
+    // Progress, can be read while the copy runs
+    std::atomic<uint32_t> bytes_read{0};
+    std::atomic<uint32_t> bytes_written{0};
+    long total = -1; // source file size, -1 if unknown
+
+    fujiCopy(int buffers = COPY_BUFFERS, size_t buffer_size = COPY_BUFFER_SIZE);
+    ~fujiCopy();
+
+    /**
+     * @brief Open both files and start copying
+     * @param src_path source path, relative to the source host prefix
+     * @param dst_path destination path, relative to the destination host prefix
+     * @return false if a file couldn't be opened or the tasks couldn't be started
+     */
+    bool start(fujiHost &src_host, const char *src_path, fujiHost &dst_host, const char *dst_path);
+
+    /**
+     * @brief Start copying between files that are already open. The copy
+     * closes both when it ends, or right away if it can't start.
+     * @param size source file size, -1 if unknown
+     * @param one_buffer reads and writes take turns instead of overlapping
+     * @return false if the tasks couldn't be started
+     */
+    bool start(fnFile *src, fnFile *dst, long size, bool one_buffer = false);
+
+    // True until the copy has ended
+    bool busy() { return _running && !_ended; }
+
+    /**
+     * @brief Wait for the copy to end, then close the files. The destination
+     * is removed if the copy failed.
+     * @param poll called about every COPY_POLL_MS while waiting
+     * @return true if the whole file was copied
+     */
+    bool wait(const std::function<void()> &poll = nullptr);
+
+    // Buffers in use and their size, once started
+    int buffers() { return _num_buffers; }
+    size_t buffer_size() { return _buffer_size; }
+
+    // Progress of the running copy, or the last one if none is running
+    static fujiCopyStatus status();
+
+private:
+    struct chunk
+    {
+        int buf;
+        size_t len;
+        bool last; // no more chunks after this one
+    };
+
+    int _num_buffers;
+    size_t _buffer_size;
+    uint8_t **_buffers = nullptr;
+
+    fnFile *_src = nullptr;
+    fnFile *_dst = nullptr;
+    fujiHost *_dst_host = nullptr;
+    char _dst_fullpath[MAX_PATHLEN];
+
+    bool _running = false;
+    std::atomic<bool> _ended{false};
+    std::atomic<bool> _failed{false};
+
+    static std::mutex _status_mutex; // for the three below
+    static fujiCopy *_current;
+    static fujiCopyStatus _last;
+    static uint32_t _copies;
+    fujiCopyStatus progress();
+
+#ifdef ESP_PLATFORM
+    QueueHandle_t _free_q = nullptr;
+    QueueHandle_t _full_q = nullptr;
+    SemaphoreHandle_t _task_done = nullptr; // given by each task as it ends
+    static void reader_task(void *arg);
+    static void writer_task(void *arg);
+#else
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<chunk> _free_q;
+    std::deque<chunk> _full_q;
+    std::thread _reader;
+    std::thread _writer;
+#endif
+
+    bool alloc_buffers();
+    void free_buffers();
+    bool start_tasks();
+    void wait_tasks(const std::function<void()> &poll);
+
+    void put_free(const chunk &c);
+    chunk take_free();
+    void put_full(const chunk &c);
+    chunk take_full();
+
+    void read_loop();
+    void write_loop();
+};
+
+#endif // _FUJI_COPY_
@@ -0,0 +1,208 @@
+#ifndef ESP_PLATFORM
+
+#include "fnReactor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include "compat_inet.h"
+#include "fnSystem.h"
+
+#include "../../include/debug.h"
+
+// Events taken from the kernel per wait(), more are left for the next one
+#define REACTOR_MAX_EVENTS 16
+
+Reactor fnReactor;
+
+bool Reactor::begin()
+{
+#ifdef __linux__
+    if (_epoll_fd >= 0)
+        return true;
+
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd < 0)
+    {
+        Debug_printf("Reactor: epoll_create1 failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd >= 0)
+    {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = _event_fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &ev);
+    }
+    else
+        Debug_printf("Reactor: eventfd failed: %s\n", strerror(errno));
+#endif
+    return true;
+}
+
+void Reactor::end()
+{
+#ifdef __linux__
+    if (_event_fd >= 0)
+        close(_event_fd);
+    if (_epoll_fd >= 0)
+        close(_epoll_fd);
+    _event_fd = _epoll_fd = -1;
+#endif
+    _watched.clear();
+    _next.clear();
+    _timeout = -1;
+}
+
+void Reactor::watch(int fd)
+{
+    if (fd < 0)
+        return;
+    if (std::find(_next.begin(), _next.end(), fd) == _next.end())
+        _next.push_back(fd);
+}
+
+void Reactor::wake_in(int ms)
+{
+    if (ms < 0)
+        return;
+    if (_timeout < 0 || ms < _timeout)
+        _timeout = ms;
+}
+
+void Reactor::wake()
+{
+#ifdef __linux__
+    // write() is async-signal-safe
+    if (_event_fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t result = write(_event_fd, &one, sizeof(one));
+        (void)result;
+    }
+#endif
+}
+
+int Reactor::wait(int max_ms)
+{
+    int timeout = max_ms;
+    if (_timeout >= 0 && (timeout < 0 || _timeout < timeout))
+        timeout = _timeout;
+    _timeout = -1;
+
+    int result;
+#ifdef __linux__
+    if (_epoll_fd >= 0)
+    {
+        update_epoll();
+
+        struct epoll_event events[REACTOR_MAX_EVENTS];
+        result = epoll_wait(_epoll_fd, events, REACTOR_MAX_EVENTS, timeout);
+        if (result < 0)
+        {
+            // a signal, main loop checks for shutdown next
+            if (errno == EINTR)
+                result = 0;
+            else
+                Debug_printf("Reactor: epoll_wait failed: %s\n", strerror(errno));
+        }
+        for (int i = 0; i < result; i++)
+        {
+            if (events[i].data.fd == _event_fd)
+            {
+                uint64_t count;
+                ssize_t n = read(_event_fd, &count, sizeof(count));
+                (void)n;
+            }
+        }
+        _next.clear();
+        return result;
+    }
+#endif
+
+    result = wait_select(timeout);
+    _next.clear();
+    return result;
+}
+
+#ifdef __linux__
+// Bring the epoll set in line with the descriptors watched for this wait()
+void Reactor::update_epoll()
+{
+    for (int fd : _watched)
+    {
+        // fails if fd was closed meanwhile, which removed it already
+        if (std::find(_next.begin(), _next.end(), fd) == _next.end())
+            epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    for (int fd : _next)
+    {
+        if (std::find(_watched.begin(), _watched.end(), fd) != _watched.end())
+            continue;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST)
+            Debug_printf("Reactor: can't watch fd %d: %s\n", fd, strerror(errno));
+    }
+
+    _watched = _next;
+}
+#endif
+
+// Without epoll, select() over the descriptors watched for this wait()
+int Reactor::wait_select(int timeout_ms)
+{
+    if (_next.empty())
+    {
+        // nothing to wait on, wake() can't help either
+        fnSystem.delay(timeout_ms >= 0 ? timeout_ms : REACTOR_MAX_WAIT_MS);
+        return 0;
+    }
+
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    int maxfd = -1;
+    for (int fd : _next)
+    {
+        FD_SET(fd, &readfds);
+        if (fd > maxfd)
+            maxfd = fd;
+    }
+
+    timeval timeout_tv;
+    timeval *ptv = nullptr;
+    if (timeout_ms >= 0)
+    {
+        timeout_tv.tv_sec = timeout_ms / 1000;
+        timeout_tv.tv_usec = (timeout_ms % 1000) * 1000;
+        ptv = &timeout_tv;
+    }
+
+    int result = select(maxfd + 1, &readfds, nullptr, nullptr, ptv);
+    if (result < 0)
+    {
+        int err = compat_getsockerr();
+#if defined(_WIN32)
+        if (err != WSAEINTR)
+#else
+        if (err != EINTR)
+#endif
+            Debug_printf("Reactor: select failed: %d\n", err);
+        return -1;
+    }
+    return result;
+}
+
+#endif // !ESP_PLATFORM
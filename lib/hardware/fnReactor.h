@@ -0,0 +1,62 @@
+#ifndef FNREACTOR_H
+#define FNREACTOR_H
+
+#include <vector>
+
+// Longest the main loop sleeps, even if nothing asked to be woken earlier
+#define REACTOR_MAX_WAIT_MS 100
+
+/*
+ * Event loop for FujiNet-PC main loop
+ *
+ * Instead of polling every service in a tight loop, each service tells the
+ * reactor what it waits for before it needs to be called again: a readable
+ * descriptor (watch) or a time (wake_in). The main loop then sleeps in wait()
+ * until one of these happens.
+ *
+ * Descriptors are watched for one wait() only, so services call watch() on
+ * every pass. On Linux they're kept in an epoll set, which is only changed
+ * when a descriptor comes or goes; elsewhere wait() uses select().
+ *
+ * A descriptor closed and reopened under the same number between two passes
+ * drops out of the epoll set unnoticed, REACTOR_MAX_WAIT_MS limits how long
+ * such an event can be missed.
+ */
+class Reactor
+{
+private:
+    std::vector<int> _watched; // descriptors in the epoll set
+    std::vector<int> _next;    // descriptors to watch in the next wait()
+    int _timeout = -1;         // ms until the earliest wake_in(), -1 = none
+
+#ifdef __linux__
+    int _epoll_fd = -1;
+    int _event_fd = -1; // for wake()
+
+    void update_epoll();
+#endif
+
+    int wait_select(int timeout_ms);
+
+public:
+    bool begin();
+    void end();
+
+    // Return from the next wait() when fd is readable
+    void watch(int fd);
+    // Return from the next wait() within ms milliseconds, ms < 0 is ignored
+    void wake_in(int ms);
+    // Return from wait() now, safe to call from other threads and signal handlers
+    void wake();
+
+    /**
+     * @brief Sleep until a watched descriptor is readable, wake() is called,
+     * or the time from wake_in() or max_ms has passed
+     * @return number of ready descriptors, 0 on timeout, -1 on error
+     */
+    int wait(int max_ms);
+};
+
+extern Reactor fnReactor;
+
+#endif // FNREACTOR_H
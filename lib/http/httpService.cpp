@@ -195,25 +195,12 @@ void fnHttpService::send_header_footer(httpd_req_t *req, int headfoot)
     }
     else
     {
-        size_t sz = FileSystem::filesize(fInput) + 1;
-        char *buf = (char *)calloc(sz, 1);
-        if (buf == NULL)
-        {
-            Debug_printf("Couldn't allocate %u bytes to load file contents!\n", sz);
-        }
-        else
-        {
-            fread(buf, 1, sz, fInput);
-            string contents(buf);
-            contents = fnHttpServiceParser::parse_contents(contents);
-
-            httpd_resp_sendstr_chunk(req, contents.c_str());
-        }
-        free(buf);
-    }
-
-    if (fInput != nullptr)
+        // Sent as part of the page being built, so no closing empty chunk here
+        fnHttpServiceParser::send_parsed(fpath.c_str(), fInput, [req](const char *data, size_t len) {
+            return httpd_resp_send_chunk(req, data, len) == ESP_OK;
+        });
         fclose(fInput);
+    }
 }
 
 /* Send file content after parsing for replaceable strings
@@ -240,28 +227,20 @@ void fnHttpService::send_file_parsed(httpd_req_t *req, const char *filename)
     {
         // Set the response content type
         set_file_content_type(req, filename);
-        // We're going to load the whole thing into memory, so watch out for big files!
-        size_t sz = FileSystem::filesize(fInput) + 1;
-        char *buf = (char *)calloc(sz, 1);
-        if (buf == NULL)
-        {
-            Debug_printf("Couldn't allocate %u bytes to load file contents!\n", sz);
-            err = fnwserr_memory;
-        }
-        else
-        {
-            fread(buf, 1, sz, fInput);
-            string contents(buf);
-            contents = fnHttpServiceParser::parse_contents(contents);
+        // Send the file in chunks as the tags are substituted
+        bool sent = false;
+        bool ok = fnHttpServiceParser::send_parsed(filename, fInput, [req, &sent](const char *data, size_t len) {
+            sent = true;
+            return httpd_resp_send_chunk(req, data, len) == ESP_OK;
+        });
+        fclose(fInput);
 
-            httpd_resp_send(req, contents.c_str(), contents.length());
-        }
-        free(buf);
+        if (ok || sent)
+            httpd_resp_send_chunk(req, NULL, 0);
+        else
+            err = fnwserr_memory;
     }
 
-    if (fInput != nullptr)
-        fclose(fInput);
-
     if (err != fnwserr_noerrr)
         return_http_error(req, err);
 }
@@ -582,40 +561,33 @@ esp_err_t fnHttpService::get_handler_modem_sniffer(httpd_req_t *req)
         return ESP_OK;
     }
 
-    FILE *sOutput = modemSniffer->closeOutputAndProvideReadHandle();
-#ifdef VERBOSE_HTTP
-    Debug_printf("Got file handle %p\n", sOutput);
-#endif
-    if (sOutput == nullptr)
+    // The log is kept compressed, send it out as it's decompressed
+    bool header_sent = false;
+    size_t total = 0;
+    bool found = modemSniffer->closeOutputAndStream([&](const char *text, size_t len) {
+        if (!header_sent)
+        {
+            set_file_content_type(req, "modem-sniffer.txt");
+            header_sent = true;
+        }
+        total += len;
+        return httpd_resp_send_chunk(req, text, len) == ESP_OK;
+    });
+
+    if (!found && !header_sent)
     {
         fnHTTPD.addToErrMsg("Unable to open modem sniffer output.\n");
         send_file(req, "error_page.html");
         return ESP_OK;
     }
 
-    set_file_content_type(req, "modem-sniffer.txt");
-
-    // Finally, write the data
-    // Send the file content out in chunks
-    char *buf = (char *)malloc(FNWS_SEND_BUFF_SIZE);
-    size_t count = 0, total = 0;
-    do
-    {
-        count = fread((uint8_t *)buf, 1, FNWS_SEND_BUFF_SIZE, sOutput);
-        // Debug_printf("fread %d, %d\n", count, errno);
-        total += count;
-
-        httpd_resp_send_chunk(req, buf, count);
-    } while (count > 0);
-
-#ifdef VERBOSE_HTTP
-    Debug_printf("Sent %u bytes total from sniffer file\n", total);
-#endif
-
-    free(buf);
-    fclose(sOutput);
+    if (!header_sent)
+        set_file_content_type(req, "modem-sniffer.txt");
+    // Finish the chunked response
+    httpd_resp_send_chunk(req, nullptr, 0);
 
 #ifdef VERBOSE_HTTP
+    Debug_printf("Sent %u bytes total from sniffer log\n", total);
     Debug_printf("Sniffer dump completed.\n");
 #endif
 
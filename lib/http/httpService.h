@@ -19,10 +19,10 @@ If a file has an extention pre-determined to support parsing (see/update
     fnHttpServiceParser::is_parsable() for a the list) then the
     following happens:
 
-    * The entire file contents are loaded into an in-memory string.
-    * Anything with the pattern <%PARSE_TAG%> is replaced with an
-    * appropriate value as determined by the
-    *       string substitute_tag(const string &tag)
+    * The file is scanned once for <%PARSE_TAG%> patterns (the positions
+    * are kept for later requests) and sent in FNWS_SEND_BUFF_SIZE chunks,
+    * with each tag replaced with an appropriate value as determined by the
+    *       string substitute_tag(int tagid)
     * function.
 */
 
@@ -1,6 +1,8 @@
 
 #include "httpServiceParser.h"
 
+#include <cstring>
+#include <map>
 #include <sstream>
 
 #include "../../include/debug.h"
@@ -9,6 +11,8 @@
 #include "fnConfig.h"
 #include "fnWiFi.h"
 #include "fsFlash.h"
+#include "fnBlockCache.h"
+#include "fujiCopy.h"
 #include "httpService.h"
 #include "fuji.h"
 
@@ -16,255 +20,285 @@ using namespace std;
 
 #define MAX_PRINTER_LIST_BUFFER (2048)
 
-const string fnHttpServiceParser::substitute_tag(const string &tag)
+enum tagids
 {
-    enum tagids
-    {
-        FN_HOSTNAME = 0,
+    FN_HOSTNAME = 0,
 #ifndef ESP_PLATFORM
-        FN_DEVICE_NAME,
-        FN_LABEL,
+    FN_DEVICE_NAME,
+    FN_LABEL,
 #endif
-        FN_VERSION,
-        FN_IPADDRESS,
-        FN_IPMASK,
-        FN_IPGATEWAY,
-        FN_IPDNS,
-        FN_WIFISSID,
-        FN_WIFIBSSID,
-        FN_WIFIMAC,
-        FN_WIFIDETAIL,
+    FN_VERSION,
+    FN_IPADDRESS,
+    FN_IPMASK,
+    FN_IPGATEWAY,
+    FN_IPDNS,
+    FN_WIFISSID,
+    FN_WIFIBSSID,
+    FN_WIFIMAC,
+    FN_WIFIDETAIL,
 #ifndef ESP_PLATFORM
-        FN_UNAME,
+    FN_UNAME,
 #endif
-        FN_SPIFFS_SIZE,
-        FN_SPIFFS_USED,
-        FN_SD_SIZE,
-        FN_SD_USED,
-        FN_UPTIME_STRING,
-        FN_UPTIME,
-        FN_CURRENTTIME,
-        FN_TIMEZONE,
-        FN_ROTATION_SOUNDS,
-        FN_UDPSTREAM_HOST,
-        FN_HEAPSIZE,
-        FN_SYSSDK,
-        FN_SYSCPUREV,
-        FN_BUSVOLTS,
-        FN_SIO_HSINDEX,
-        FN_SIO_HSBAUD,
-        FN_PRINTER1_MODEL,
-        FN_PRINTER1_PORT,
-        FN_PLAY_RECORD,
-        FN_PULLDOWN,
-        FN_CASSETTE_ENABLED,
-        FN_CONFIG_ENABLED,
-        FN_CONFIG_NG,
-        FN_STATUS_WAIT_ENABLED,
-        FN_BOOT_MODE,
-        FN_PRINTER_ENABLED,
-        FN_MODEM_ENABLED,
-        FN_MODEM_SNIFFER_ENABLED,
+    FN_SPIFFS_SIZE,
+    FN_SPIFFS_USED,
+    FN_SD_SIZE,
+    FN_SD_USED,
+    FN_BLOCKCACHE_HITS,
+    FN_BLOCKCACHE_MISSES,
+    FN_BLOCKCACHE_EVICTIONS,
+    FN_BLOCKCACHE_USED,
+    FN_BLOCKCACHE_SIZE,
+    FN_COPY_STATE,
+    FN_COPY_BYTES_READ,
+    FN_COPY_BYTES_WRITTEN,
+    FN_COPY_TOTAL,
+    FN_UPTIME_STRING,
+    FN_UPTIME,
+    FN_CURRENTTIME,
+    FN_TIMEZONE,
+    FN_ROTATION_SOUNDS,
+    FN_UDPSTREAM_HOST,
+    FN_HEAPSIZE,
+    FN_SYSSDK,
+    FN_SYSCPUREV,
+    FN_BUSVOLTS,
+    FN_SIO_HSINDEX,
+    FN_SIO_HSBAUD,
+    FN_PRINTER1_MODEL,
+    FN_PRINTER1_PORT,
+    FN_PLAY_RECORD,
+    FN_PULLDOWN,
+    FN_CASSETTE_ENABLED,
+    FN_CONFIG_ENABLED,
+    FN_CONFIG_NG,
+    FN_STATUS_WAIT_ENABLED,
+    FN_BOOT_MODE,
+    FN_PRINTER_ENABLED,
+    FN_MODEM_ENABLED,
+    FN_MODEM_SNIFFER_ENABLED,
 #ifndef ESP_PLATFORM
-        FN_SERIAL_PORT,
-        FN_SERIAL_PORT_BAUD,
-        FN_SERIAL_COMMAND,
-        FN_SERIAL_PROCEED,
-        FN_SIO_HSTEXT,
+    FN_SERIAL_PORT,
+    FN_SERIAL_PORT_BAUD,
+    FN_SERIAL_COMMAND,
+    FN_SERIAL_PROCEED,
+    FN_SIO_HSTEXT,
 #endif
-        FN_BOIP_ENABLED,
-        FN_BOIP_HOST,
-        FN_DRIVE1HOST,
-        FN_DRIVE2HOST,
-        FN_DRIVE3HOST,
-        FN_DRIVE4HOST,
-        FN_DRIVE5HOST,
-        FN_DRIVE6HOST,
-        FN_DRIVE7HOST,
-        FN_DRIVE8HOST,
+    FN_BOIP_ENABLED,
+    FN_BOIP_HOST,
+    FN_DRIVE1HOST,
+    FN_DRIVE2HOST,
+    FN_DRIVE3HOST,
+    FN_DRIVE4HOST,
+    FN_DRIVE5HOST,
+    FN_DRIVE6HOST,
+    FN_DRIVE7HOST,
+    FN_DRIVE8HOST,
 #ifndef ESP_PLATFORM
-        FN_DRIVE1BROWSER,
-        FN_DRIVE2BROWSER,
-        FN_DRIVE3BROWSER,
-        FN_DRIVE4BROWSER,
-        FN_DRIVE5BROWSER,
-        FN_DRIVE6BROWSER,
-        FN_DRIVE7BROWSER,
-        FN_DRIVE8BROWSER,
+    FN_DRIVE1BROWSER,
+    FN_DRIVE2BROWSER,
+    FN_DRIVE3BROWSER,
+    FN_DRIVE4BROWSER,
+    FN_DRIVE5BROWSER,
+    FN_DRIVE6BROWSER,
+    FN_DRIVE7BROWSER,
+    FN_DRIVE8BROWSER,
 #endif
-        FN_DRIVE1MOUNT,
-        FN_DRIVE2MOUNT,
-        FN_DRIVE3MOUNT,
-        FN_DRIVE4MOUNT,
-        FN_DRIVE5MOUNT,
-        FN_DRIVE6MOUNT,
-        FN_DRIVE7MOUNT,
-        FN_DRIVE8MOUNT,
-        FN_HOST1,
-        FN_HOST2,
-        FN_HOST3,
-        FN_HOST4,
-        FN_HOST5,
-        FN_HOST6,
-        FN_HOST7,
-        FN_HOST8,
-        FN_DRIVE1DEVICE,
-        FN_DRIVE2DEVICE,
-        FN_DRIVE3DEVICE,
-        FN_DRIVE4DEVICE,
-        FN_DRIVE5DEVICE,
-        FN_DRIVE6DEVICE,
-        FN_DRIVE7DEVICE,
-        FN_DRIVE8DEVICE,
-        FN_HOST1PREFIX,
-        FN_HOST2PREFIX,
-        FN_HOST3PREFIX,
-        FN_HOST4PREFIX,
-        FN_HOST5PREFIX,
-        FN_HOST6PREFIX,
-        FN_HOST7PREFIX,
-        FN_HOST8PREFIX,
-        FN_ERRMSG,
-        FN_HARDWARE_VER,
-        FN_PRINTER_LIST,
-        FN_ENCRYPT_PASSPHRASE_ENABLED,
-        FN_APETIME_ENABLED,
-        FN_CPM_ENABLED,
-        FN_CPM_CCP,
-        FN_ALT_CFG,
-        FN_PCLINK_ENABLED,
-        FN_LASTTAG
-    };
+    FN_DRIVE1MOUNT,
+    FN_DRIVE2MOUNT,
+    FN_DRIVE3MOUNT,
+    FN_DRIVE4MOUNT,
+    FN_DRIVE5MOUNT,
+    FN_DRIVE6MOUNT,
+    FN_DRIVE7MOUNT,
+    FN_DRIVE8MOUNT,
+    FN_HOST1,
+    FN_HOST2,
+    FN_HOST3,
+    FN_HOST4,
+    FN_HOST5,
+    FN_HOST6,
+    FN_HOST7,
+    FN_HOST8,
+    FN_DRIVE1DEVICE,
+    FN_DRIVE2DEVICE,
+    FN_DRIVE3DEVICE,
+    FN_DRIVE4DEVICE,
+    FN_DRIVE5DEVICE,
+    FN_DRIVE6DEVICE,
+    FN_DRIVE7DEVICE,
+    FN_DRIVE8DEVICE,
+    FN_HOST1PREFIX,
+    FN_HOST2PREFIX,
+    FN_HOST3PREFIX,
+    FN_HOST4PREFIX,
+    FN_HOST5PREFIX,
+    FN_HOST6PREFIX,
+    FN_HOST7PREFIX,
+    FN_HOST8PREFIX,
+    FN_ERRMSG,
+    FN_HARDWARE_VER,
+    FN_PRINTER_LIST,
+    FN_ENCRYPT_PASSPHRASE_ENABLED,
+    FN_APETIME_ENABLED,
+    FN_CPM_ENABLED,
+    FN_CPM_CCP,
+    FN_ALT_CFG,
+    FN_PCLINK_ENABLED,
+    FN_LASTTAG
+};
 
-    const char *tagids[FN_LASTTAG] =
-    {
-        "FN_HOSTNAME",
+static const char *tag_names[FN_LASTTAG] =
+{
+    "FN_HOSTNAME",
 #ifndef ESP_PLATFORM
-        "FN_DEVICE_NAME",
-        "FN_LABEL",
+    "FN_DEVICE_NAME",
+    "FN_LABEL",
 #endif
-        "FN_VERSION",
-        "FN_IPADDRESS",
-        "FN_IPMASK",
-        "FN_IPGATEWAY",
-        "FN_IPDNS",
-        "FN_WIFISSID",
-        "FN_WIFIBSSID",
-        "FN_WIFIMAC",
-        "FN_WIFIDETAIL",
+    "FN_VERSION",
+    "FN_IPADDRESS",
+    "FN_IPMASK",
+    "FN_IPGATEWAY",
+    "FN_IPDNS",
+    "FN_WIFISSID",
+    "FN_WIFIBSSID",
+    "FN_WIFIMAC",
+    "FN_WIFIDETAIL",
 #ifndef ESP_PLATFORM
-        "FN_UNAME",
+    "FN_UNAME",
 #endif
-        "FN_SPIFFS_SIZE",
-        "FN_SPIFFS_USED",
-        "FN_SD_SIZE",
-        "FN_SD_USED",
-        "FN_UPTIME_STRING",
-        "FN_UPTIME",
-        "FN_CURRENTTIME",
-        "FN_TIMEZONE",
-        "FN_ROTATION_SOUNDS",
-        "FN_UDPSTREAM_HOST",
-        "FN_HEAPSIZE",
-        "FN_SYSSDK",
-        "FN_SYSCPUREV",
-        "FN_BUSVOLTS",
-        "FN_SIO_HSINDEX",
-        "FN_SIO_HSBAUD",
-        "FN_PRINTER1_MODEL",
-        "FN_PRINTER1_PORT",
-        "FN_PLAY_RECORD",
-        "FN_PULLDOWN",
-        "FN_CASSETTE_ENABLED",
-        "FN_CONFIG_ENABLED",
-        "FN_CONFIG_NG",
-        "FN_STATUS_WAIT_ENABLED",
-        "FN_BOOT_MODE",
-        "FN_PRINTER_ENABLED",
-        "FN_MODEM_ENABLED",
-        "FN_MODEM_SNIFFER_ENABLED",
+    "FN_SPIFFS_SIZE",
+    "FN_SPIFFS_USED",
+    "FN_SD_SIZE",
+    "FN_SD_USED",
+    "FN_BLOCKCACHE_HITS",
+    "FN_BLOCKCACHE_MISSES",
+    "FN_BLOCKCACHE_EVICTIONS",
+    "FN_BLOCKCACHE_USED",
+    "FN_BLOCKCACHE_SIZE",
+    "FN_COPY_STATE",
+    "FN_COPY_BYTES_READ",
+    "FN_COPY_BYTES_WRITTEN",
+    "FN_COPY_TOTAL",
+    "FN_UPTIME_STRING",
+    "FN_UPTIME",
+    "FN_CURRENTTIME",
+    "FN_TIMEZONE",
+    "FN_ROTATION_SOUNDS",
+    "FN_UDPSTREAM_HOST",
+    "FN_HEAPSIZE",
+    "FN_SYSSDK",
+    "FN_SYSCPUREV",
+    "FN_BUSVOLTS",
+    "FN_SIO_HSINDEX",
+    "FN_SIO_HSBAUD",
+    "FN_PRINTER1_MODEL",
+    "FN_PRINTER1_PORT",
+    "FN_PLAY_RECORD",
+    "FN_PULLDOWN",
+    "FN_CASSETTE_ENABLED",
+    "FN_CONFIG_ENABLED",
+    "FN_CONFIG_NG",
+    "FN_STATUS_WAIT_ENABLED",
+    "FN_BOOT_MODE",
+    "FN_PRINTER_ENABLED",
+    "FN_MODEM_ENABLED",
+    "FN_MODEM_SNIFFER_ENABLED",
 #ifndef ESP_PLATFORM
-        "FN_SERIAL_PORT",
-        "FN_SERIAL_PORT_BAUD",
-        "FN_SERIAL_COMMAND",
-        "FN_SERIAL_PROCEED",
-        "FN_SIO_HSTEXT",
+    "FN_SERIAL_PORT",
+    "FN_SERIAL_PORT_BAUD",
+    "FN_SERIAL_COMMAND",
+    "FN_SERIAL_PROCEED",
+    "FN_SIO_HSTEXT",
 #endif
-        "FN_BOIP_ENABLED",
-        "FN_BOIP_HOST",
-        "FN_DRIVE1HOST",
-        "FN_DRIVE2HOST",
-        "FN_DRIVE3HOST",
-        "FN_DRIVE4HOST",
-        "FN_DRIVE5HOST",
-        "FN_DRIVE6HOST",
-        "FN_DRIVE7HOST",
-        "FN_DRIVE8HOST",
+    "FN_BOIP_ENABLED",
+    "FN_BOIP_HOST",
+    "FN_DRIVE1HOST",
+    "FN_DRIVE2HOST",
+    "FN_DRIVE3HOST",
+    "FN_DRIVE4HOST",
+    "FN_DRIVE5HOST",
+    "FN_DRIVE6HOST",
+    "FN_DRIVE7HOST",
+    "FN_DRIVE8HOST",
 #ifndef ESP_PLATFORM
-        "FN_DRIVE1BROWSER",
-        "FN_DRIVE2BROWSER",
-        "FN_DRIVE3BROWSER",
-        "FN_DRIVE4BROWSER",
-        "FN_DRIVE5BROWSER",
-        "FN_DRIVE6BROWSER",
-        "FN_DRIVE7BROWSER",
-        "FN_DRIVE8BROWSER",
+    "FN_DRIVE1BROWSER",
+    "FN_DRIVE2BROWSER",
+    "FN_DRIVE3BROWSER",
+    "FN_DRIVE4BROWSER",
+    "FN_DRIVE5BROWSER",
+    "FN_DRIVE6BROWSER",
+    "FN_DRIVE7BROWSER",
+    "FN_DRIVE8BROWSER",
 #endif
-        "FN_DRIVE1MOUNT",
-        "FN_DRIVE2MOUNT",
-        "FN_DRIVE3MOUNT",
-        "FN_DRIVE4MOUNT",
-        "FN_DRIVE5MOUNT",
-        "FN_DRIVE6MOUNT",
-        "FN_DRIVE7MOUNT",
-        "FN_DRIVE8MOUNT",
-        "FN_HOST1",
-        "FN_HOST2",
-        "FN_HOST3",
-        "FN_HOST4",
-        "FN_HOST5",
-        "FN_HOST6",
-        "FN_HOST7",
-        "FN_HOST8",
-        "FN_DRIVE1DEVICE",
-        "FN_DRIVE2DEVICE",
-        "FN_DRIVE3DEVICE",
-        "FN_DRIVE4DEVICE",
-        "FN_DRIVE5DEVICE",
-        "FN_DRIVE6DEVICE",
-        "FN_DRIVE7DEVICE",
-        "FN_DRIVE8DEVICE",
-        "FN_HOST1PREFIX",
-        "FN_HOST2PREFIX",
-        "FN_HOST3PREFIX",
-        "FN_HOST4PREFIX",
-        "FN_HOST5PREFIX",
-        "FN_HOST6PREFIX",
-        "FN_HOST7PREFIX",
-        "FN_HOST8PREFIX",
-        "FN_ERRMSG",
-        "FN_HARDWARE_VER",
-        "FN_PRINTER_LIST",
-        "FN_ENCRYPT_PASSPHRASE_ENABLED",
-        "FN_APETIME_ENABLED",
-        "FN_CPM_ENABLED",
-        "FN_CPM_CCP",
-        "FN_ALT_CFG",
-        "FN_PCLINK_ENABLED",
-    };
-
-    stringstream resultstream;
+    "FN_DRIVE1MOUNT",
+    "FN_DRIVE2MOUNT",
+    "FN_DRIVE3MOUNT",
+    "FN_DRIVE4MOUNT",
+    "FN_DRIVE5MOUNT",
+    "FN_DRIVE6MOUNT",
+    "FN_DRIVE7MOUNT",
+    "FN_DRIVE8MOUNT",
+    "FN_HOST1",
+    "FN_HOST2",
+    "FN_HOST3",
+    "FN_HOST4",
+    "FN_HOST5",
+    "FN_HOST6",
+    "FN_HOST7",
+    "FN_HOST8",
+    "FN_DRIVE1DEVICE",
+    "FN_DRIVE2DEVICE",
+    "FN_DRIVE3DEVICE",
+    "FN_DRIVE4DEVICE",
+    "FN_DRIVE5DEVICE",
+    "FN_DRIVE6DEVICE",
+    "FN_DRIVE7DEVICE",
+    "FN_DRIVE8DEVICE",
+    "FN_HOST1PREFIX",
+    "FN_HOST2PREFIX",
+    "FN_HOST3PREFIX",
+    "FN_HOST4PREFIX",
+    "FN_HOST5PREFIX",
+    "FN_HOST6PREFIX",
+    "FN_HOST7PREFIX",
+    "FN_HOST8PREFIX",
+    "FN_ERRMSG",
+    "FN_HARDWARE_VER",
+    "FN_PRINTER_LIST",
+    "FN_ENCRYPT_PASSPHRASE_ENABLED",
+    "FN_APETIME_ENABLED",
+    "FN_CPM_ENABLED",
+    "FN_CPM_CCP",
+    "FN_ALT_CFG",
+    "FN_PCLINK_ENABLED",
+};
 
-    // Debug_printf("Substituting tag '%s'\n", tag.c_str());
+// Templates scanned so far, by file name
+static std::map<std::string, fnHttpTemplate> templates;
 
-    int tagid;
-    for (tagid = 0; tagid < FN_LASTTAG; tagid++)
+int fnHttpServiceParser::find_tag(const char *tag)
+{
+    for (int tagid = 0; tagid < FN_LASTTAG; tagid++)
     {
-        if (0 == tag.compare(tagids[tagid]))
-        {
-            break;
-        }
+        if (strcmp(tag, tag_names[tagid]) == 0)
+            return tagid;
     }
+    return -1;
+}
+
+const string fnHttpServiceParser::substitute_tag(const string &tag)
+{
+    int tagid = find_tag(tag.c_str());
+    // Unknown tags are replaced with their name
+    if (tagid < 0)
+        return tag;
+    return substitute_tag(tagid);
+}
+
+const string fnHttpServiceParser::substitute_tag(int tagid)
+{
+
+    stringstream resultstream;
 
     int drive_slot, host_slot;
     char disk_id;
@@ -331,6 +365,46 @@ const string fnHttpServiceParser::substitute_tag(const string &tag)
     case FN_SD_USED:
         resultstream << fnSDFAT.used_bytes();
         break;
+#ifndef FNIO_IS_STDIO
+    case FN_BLOCKCACHE_HITS:
+        resultstream << BlockCache::stats().hits;
+        break;
+    case FN_BLOCKCACHE_MISSES:
+        resultstream << BlockCache::stats().misses;
+        break;
+    case FN_BLOCKCACHE_EVICTIONS:
+        resultstream << BlockCache::stats().evictions;
+        break;
+    case FN_BLOCKCACHE_USED:
+        resultstream << BlockCache::stats().used;
+        break;
+    case FN_BLOCKCACHE_SIZE:
+        resultstream << BlockCache::stats().budget;
+        break;
+#else
+    case FN_BLOCKCACHE_HITS:
+    case FN_BLOCKCACHE_MISSES:
+    case FN_BLOCKCACHE_EVICTIONS:
+    case FN_BLOCKCACHE_USED:
+    case FN_BLOCKCACHE_SIZE:
+        resultstream << 0;
+        break;
+#endif
+    case FN_COPY_STATE:
+        {
+            fujiCopyStatus copy = fujiCopy::status();
+            resultstream << (copy.copies == 0 ? "None" : copy.busy ? "Copying" : copy.failed ? "Failed" : "Done");
+        }
+        break;
+    case FN_COPY_BYTES_READ:
+        resultstream << fujiCopy::status().bytes_read;
+        break;
+    case FN_COPY_BYTES_WRITTEN:
+        resultstream << fujiCopy::status().bytes_written;
+        break;
+    case FN_COPY_TOTAL:
+        resultstream << fujiCopy::status().total;
+        break;
     case FN_UPTIME_STRING:
         resultstream << format_uptime();
         break;
@@ -628,7 +702,6 @@ const string fnHttpServiceParser::substitute_tag(const string &tag)
         resultstream << Config.get_config_filename();
         break;
     default:
-        resultstream << tag;
         break;
     }
     // Debug_printf("Substitution result: \"%s\"\n", resultstream.str().c_str());
@@ -645,6 +718,70 @@ bool fnHttpServiceParser::is_parsable(const char *extension)
     return false;
 }
 
+/* Scan a file for <% and %> tags once, the result is kept for later requests
+ as long as the file size stays the same.
+ Returns nullptr if the file couldn't be read.
+*/
+const fnHttpTemplate *fnHttpServiceParser::get_template(const char *filename, FILE *f)
+{
+    long size = FileSystem::filesize(f);
+    auto it = templates.find(filename);
+    if (it != templates.end() && (long)it->second.size() == size)
+        return &it->second;
+
+    fnHttpTemplate tmpl;
+    char buf[FNWS_SEND_BUFF_SIZE];
+    size_t count;
+    fseek(f, 0, SEEK_SET);
+    while ((count = fread(buf, 1, sizeof(buf), f)) > 0)
+        tmpl.scan(buf, count, find_tag);
+    tmpl.scan_end();
+
+    if ((long)tmpl.size() != size)
+    {
+        Debug_printf("Failed to scan \"%s\" for tags\n", filename);
+        return nullptr;
+    }
+#ifdef VERBOSE_HTTP
+    Debug_printf("Scanned \"%s\": %u segments\n", filename, (unsigned)tmpl.segments().size());
+#endif
+    templates[filename] = std::move(tmpl);
+    return &templates[filename];
+}
+
+/* Send an open file with tags substituted, in pieces of at most FNWS_SEND_BUFF_SIZE
+ Returns false if the file couldn't be read or send() failed
+*/
+bool fnHttpServiceParser::send_parsed(const char *filename, FILE *f, const fnHttpTemplate::send_fn &send)
+{
+    const fnHttpTemplate *tmpl = get_template(filename, f);
+    if (tmpl == nullptr)
+        return false;
+
+    char *buf = (char *)malloc(FNWS_SEND_BUFF_SIZE);
+    if (buf == nullptr)
+    {
+        Debug_printf("Couldn't allocate %u bytes to send file contents!\n", (unsigned)FNWS_SEND_BUFF_SIZE);
+        return false;
+    }
+
+    // Segments are in file order, so only skipped tags need a seek
+    long pos = -1;
+    auto read = [f, &pos](uint32_t offset, char *dst, size_t len) -> size_t
+    {
+        if (pos != (long)offset && fseek(f, offset, SEEK_SET) != 0)
+            return 0;
+        size_t count = fread(dst, 1, len, f);
+        pos = offset + count;
+        return count;
+    };
+    auto substitute = [](int tagid) { return substitute_tag(tagid); };
+
+    bool ok = tmpl->render(read, substitute, send, buf, FNWS_SEND_BUFF_SIZE);
+    free(buf);
+    return ok;
+}
+
 /* Look for anything between <% and %> tags
  And send that to a routine that looks for suitable substitutions
  Returns string with subtitutions in place
@@ -6,12 +6,13 @@ If a file has an extention pre-determined to support parsing (see/update
     fnHttpServiceParser::is_parsable() for a the list) then the
     following happens:
 
-    * The entire file contents are loaded into an in-memory string.
-    * Anything with the pattern <%PARSE_TAG%> is replaced with an
-    * appropriate value as determined by the 
-    *       string substitute_tag(const string &tag)
+    * The file is scanned once for the positions of <%PARSE_TAG%> tags
+    * (see fnHttpTemplate), and the result kept for later requests.
+    * The file is sent in FNWS_SEND_BUFF_SIZE pieces, with each tag
+    * replaced with an appropriate value as determined by the
+    *       string substitute_tag(int tagid)
     * function.
-    * 
+    *
 See const fnHttpServiceParser::substitute_tag() for
 currently supported tags.
 
@@ -19,15 +20,22 @@ currently supported tags.
 #ifndef HTTPSERVICEPARSER_H
 #define HTTPSERVICEPARSER_H
 
+#include <cstdio>
 #include <string>
 
+#include "httpTemplate.h"
+
 class fnHttpServiceParser
 {
     static std::string format_uptime();
     static long uptime_seconds();
+    static int find_tag(const char *tag);
     static const std::string substitute_tag(const std::string &tag);
+    static const std::string substitute_tag(int tagid);
+    static const fnHttpTemplate *get_template(const char *filename, FILE *f);
 public:
     static std::string parse_contents(const std::string &contents);
+    static bool send_parsed(const char *filename, FILE *f, const fnHttpTemplate::send_fn &send);
     static bool is_parsable(const char *extension);
 };
 
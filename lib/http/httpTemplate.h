@@ -0,0 +1,185 @@
+/* FujiNet web server template
+
+A parsable file (see fnHttpServiceParser) is scanned once into a list of
+segments: ranges of the file sent as they are, and <%TAG%> ids. Rendering
+reads the literal ranges back from the file and fills a fixed size buffer,
+which is sent every time it fills up, so a page never has to be held in
+memory as a whole.
+
+Scanning gives the same result as fnHttpServiceParser::parse_contents():
+unknown tags are replaced with their name, and a "<%" without a closing
+"%>" is sent as it is.
+*/
+#ifndef HTTPTEMPLATE_H
+#define HTTPTEMPLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Longest tag name looked up, longer tags can't be known ones
+#define HTTP_TEMPLATE_TAG_MAX 48
+
+class fnHttpTemplate
+{
+public:
+    // Tag name to id, or -1 if the tag isn't known
+    typedef std::function<int(const char *name)> lookup_fn;
+    // Reads up to len bytes from offset in the file, returns bytes read
+    typedef std::function<size_t(uint32_t offset, char *buf, size_t len)> read_fn;
+    // Value of tag id
+    typedef std::function<std::string(int tagid)> substitute_fn;
+    // Sends len bytes, returns false to abort
+    typedef std::function<bool(const char *data, size_t len)> send_fn;
+
+    struct segment
+    {
+        uint32_t offset; // literal range, or tag name in the file
+        uint32_t len;
+        int tagid;       // -1 for a literal range
+    };
+
+    /**
+     * @brief Scan a file given in consecutive pieces
+     * Call scan() for every piece, then scan_end().
+     */
+    void scan(const char *data, size_t len, const lookup_fn &lookup)
+    {
+        for (size_t i = 0; i < len; i++, _size++)
+        {
+            char c = data[i];
+            if (!_in_tag)
+            {
+                if (_last == '<' && c == '%')
+                {
+                    _in_tag = true;
+                    _tag_start = _size - 1;
+                    _name_len = 0;
+                    _last = 0;
+                    continue;
+                }
+                _last = c;
+                continue;
+            }
+
+            if (_last == '%' && c == '>')
+            {
+                // name ends before the '%'
+                uint32_t name_start = _tag_start + 2;
+                uint32_t name_len = _size - 1 - name_start;
+                add_literal(_literal_start, _tag_start - _literal_start);
+                int tagid = -1;
+                if (name_len <= HTTP_TEMPLATE_TAG_MAX)
+                {
+                    _name[name_len] = '\0';
+                    tagid = lookup(_name);
+                }
+                if (tagid < 0)
+                    add_literal(name_start, name_len);
+                else
+                    _segments.push_back({name_start, name_len, tagid});
+                _literal_start = _size + 1;
+                _in_tag = false;
+                _last = 0;
+                continue;
+            }
+            if (_name_len < HTTP_TEMPLATE_TAG_MAX + 1)
+                _name[_name_len++] = c;
+            _last = c;
+        }
+    }
+
+    void scan_end()
+    {
+        // everything after the last tag, including an unclosed "<%"
+        add_literal(_literal_start, _size - _literal_start);
+        _in_tag = false;
+        _last = 0;
+        _segments.shrink_to_fit();
+    }
+
+    // Size of the scanned file
+    uint32_t size() const { return _size; }
+
+    const std::vector<segment> &segments() const { return _segments; }
+
+    /**
+     * @brief Send the file with tags substituted
+     * @param buf buffer collecting output until bufsize bytes can be sent
+     * @return false if reading or sending failed
+     */
+    bool render(const read_fn &read, const substitute_fn &substitute, const send_fn &send,
+                char *buf, size_t bufsize) const
+    {
+        size_t used = 0;
+
+        for (const segment &s : _segments)
+        {
+            if (s.tagid < 0)
+            {
+                uint32_t offset = s.offset;
+                uint32_t left = s.len;
+                while (left > 0)
+                {
+                    size_t n = bufsize - used < left ? bufsize - used : left;
+                    size_t got = read(offset, buf + used, n);
+                    if (got == 0)
+                        return false;
+                    used += got;
+                    offset += got;
+                    left -= got;
+                    if (used == bufsize)
+                    {
+                        if (!send(buf, used))
+                            return false;
+                        used = 0;
+                    }
+                }
+                continue;
+            }
+
+            std::string value = substitute(s.tagid);
+            const char *p = value.data();
+            size_t left = value.size();
+            while (left > 0)
+            {
+                size_t n = bufsize - used < left ? bufsize - used : left;
+                memcpy(buf + used, p, n);
+                used += n;
+                p += n;
+                left -= n;
+                if (used == bufsize)
+                {
+                    if (!send(buf, used))
+                        return false;
+                    used = 0;
+                }
+            }
+        }
+
+        if (used > 0)
+            return send(buf, used);
+        return true;
+    }
+
+private:
+    void add_literal(uint32_t offset, uint32_t len)
+    {
+        if (len > 0)
+            _segments.push_back({offset, len, -1});
+    }
+
+    std::vector<segment> _segments;
+    uint32_t _size = 0;
+    uint32_t _literal_start = 0;
+    uint32_t _tag_start = 0;
+    bool _in_tag = false;
+    char _last = 0;
+    char _name[HTTP_TEMPLATE_TAG_MAX + 2];
+    size_t _name_len = 0;
+};
+
+#endif // HTTPTEMPLATE_H
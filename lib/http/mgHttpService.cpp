@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include "fnSystem.h"
+#include "fnReactor.h"
 #include "fnConfig.h"
 #include "fnWiFi.h"
 #include "fsFlash.h"
@@ -139,38 +140,33 @@ void fnHttpService::send_file_parsed(struct mg_connection *c, const char *filena
     }
     else
     {
-        // We're going to load the whole thing into memory, so watch out for big files!
-        size_t sz = FileSystem::filesize(fInput) + 1;
-        char *buf = (char *)calloc(sz, 1);
-        if (buf == NULL)
-        {
-            Debug_printf("Couldn't allocate %u bytes to load file contents!\n", (unsigned)sz);
-            err = fnwserr_memory;
-        }
-        else
-        {
-            size_t bytes_read = fread(buf, 1, sz - 1, fInput); // sz - 1 because we added 1 for null terminator
-            if (bytes_read < (sz - 1)) {
-                Debug_printf("Warning: Only read %u of %u bytes from file\n", (unsigned)bytes_read, (unsigned)(sz - 1));
-            }
-            string contents(buf);
-            free(buf);
-            contents = fnHttpServiceParser::parse_contents(contents);
-
+        // Headers go out with the first chunk, until then an error can still be reported
+        bool sent = false;
+        auto start_reply = [c, filename, &sent]() {
             mg_printf(c, "HTTP/1.1 200 OK\r\n");
             // Set the response content type
             set_file_content_type(c, filename);
-            // Set the expected length of the content
-            size_t len = contents.length();
-            mg_printf(c, "Content-Length: %lu\r\n\r\n", (unsigned long)len);
-            // Send parsed content
-            mg_send(c, contents.c_str(), len);
+            mg_printf(c, "Transfer-Encoding: chunked\r\n\r\n");
+            sent = true;
+        };
+        bool ok = fnHttpServiceParser::send_parsed(filename, fInput, [c, &sent, &start_reply](const char *data, size_t len) {
+            if (!sent)
+                start_reply();
+            mg_http_write_chunk(c, data, len);
+            return true;
+        });
+        fclose(fInput);
+
+        if (!ok && !sent)
+            err = fnwserr_memory;
+        else
+        {
+            if (!sent)
+                start_reply();
+            mg_http_write_chunk(c, "", 0);
         }
     }
 
-    if (fInput != nullptr)
-        fclose(fInput);
-
     if (err != fnwserr_noerrr)
         return_http_error(c, err);
 }
@@ -722,8 +718,28 @@ void fnHttpService::stop()
 
 void fnHttpService::service()
 {
-    if (state.hServer != nullptr)
-        mg_mgr_poll(state.hServer, 0);
+    if (state.hServer == nullptr)
+        return;
+
+    mg_mgr_poll(state.hServer, 0);
+
+    // Tell the main loop what to wait for before calling us again
+#if MG_ENABLE_EPOLL
+    // mongoose keeps its sockets in an epoll set, which is readable when any of them is
+    fnReactor.watch(state.hServer->epoll_fd);
+#endif
+    for (struct mg_connection *c = state.hServer->conns; c != nullptr; c = c->next)
+    {
+#if MG_ENABLE_EPOLL
+        // mongoose asks for EPOLLOUT in its next poll only, ask now for replies queued in this one
+        if (c->send.len > 0)
+            MG_EPOLL_MOD(c, 1);
+#else
+        fnReactor.watch((int)(size_t)c->fd);
+        if (c->send.len > 0)
+            fnReactor.wake_in(1);
+#endif
+    }
 }
 
 #endif // !ESP_PLATFORM
@@ -4,6 +4,7 @@
 //#include "meat_broker.h"
 #include "../meat_media.h"
 #include "endianness.h"
+#include "charset.h"
 
 // D64 Utility Functions
 
@@ -34,7 +35,7 @@ bool D64MStream::seekBlock(uint64_t index, uint8_t offset)
 
     // Debug_printv("track[%d] sector[%d] speedZone[%d] sectorOffset[%d]", track, sector, speedZone(track), sectorOffset);
 
-    return containerStream->seek((index * block_size) + offset);
+    return seekContainer((index * block_size) + offset);
 }
 
 bool D64MStream::seekSector(uint8_t track, uint8_t sector, uint8_t offset)
@@ -82,7 +83,7 @@ bool D64MStream::seekSector(uint8_t track, uint8_t sector, uint8_t offset)
 
     //Debug_printv("track[%d] sector[%d] speedZone[%d] sectorOffset[%d]", track, sector, speedZone(track), sectorOffset);
 
-    return containerStream->seek((sectorOffset * block_size) + offset);
+    return seekContainer((sectorOffset * block_size) + offset);
 }
 
 bool D64MStream::seekSector(std::vector<uint8_t> trackSectorOffset)
@@ -90,6 +91,68 @@ bool D64MStream::seekSector(std::vector<uint8_t> trackSectorOffset)
     return seekSector(trackSectorOffset[0], trackSectorOffset[1], trackSectorOffset[2]);
 }
 
+uint8_t D64MStream::blockTrack(uint32_t index, uint32_t &track_start)
+{
+    uint16_t c = partitions[partition].block_allocation_map.size() - 1;
+    uint8_t end_track = partitions[partition].block_allocation_map[c].end_track;
+
+    uint32_t start = 0;
+    for (uint8_t track = 1; track <= end_track; track++)
+    {
+        uint16_t count = getSectorCount(track);
+        if (index < start + count)
+        {
+            track_start = start;
+            return track;
+        }
+        start += count;
+    }
+
+    return 0;
+}
+
+void D64MStream::cacheWindow(uint32_t block, uint32_t &first, uint32_t &count)
+{
+    uint32_t start = 0;
+    uint8_t track = blockTrack(block, start);
+    if (block_size != MEATLOAF_CACHE_BLOCK_SIZE || track == 0)
+        return MMediaStream::cacheWindow(block, first, count);
+
+    // Files and the directory are chains of sectors, mostly on one track
+    // until it's full, so read the track the chain is on
+    first = start;
+    count = getSectorCount(track);
+    if (count > MEATLOAF_CACHE_READAHEAD)
+    {
+        // Too long, just read on from here
+        count = std::min((uint32_t)MEATLOAF_CACHE_READAHEAD, start + count - block);
+        first = block;
+    }
+}
+
+bool D64MStream::cachePinned(uint32_t block)
+{
+    uint32_t start = 0;
+    uint8_t track = blockTrack(block, start);
+    if (block_size != MEATLOAF_CACHE_BLOCK_SIZE || track == 0)
+        return false;
+
+    // The header, directory and BAM are read for every listing and every file
+    uint8_t sector = block - start;
+    for (const auto &p : partitions)
+    {
+        if (track == p.header_track || track == p.directory_track)
+            return true;
+        for (const auto &bam : p.block_allocation_map)
+        {
+            if (track == bam.track && sector == bam.sector)
+                return true;
+        }
+    }
+
+    return false;
+}
+
 std::string D64MStream::readBlock(uint8_t track, uint8_t sector)
 {
     return "";
@@ -215,7 +278,7 @@ bool D64MStream::seekEntry( std::string filename )
             uint8_t i = entryFilename.find_first_of(0xA0);
             entryFilename = entryFilename.substr(0, i);
             //mstr::rtrimA0(entryFilename);
-            entryFilename = mstr::toUTF8(entryFilename);
+            charset::petscii_to_utf8(entryFilename);
 
             //Debug_printv("index[%d] track[%d] sector[%d] filename[%s] entry.filename[%.16s]", index, track, sector, filename.c_str(), entryFilename.c_str());
 
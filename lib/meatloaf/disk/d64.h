@@ -223,6 +223,12 @@ public:
     bool seekSector( uint8_t track, uint8_t sector, uint8_t offset = 0 ) override;
     bool seekSector( std::vector<uint8_t> trackSectorOffset ) override;
 
+    // Track of block index, 0 if past the last track; track_start is the index of its sector 0
+    uint8_t blockTrack( uint32_t index, uint32_t &track_start );
+
+    void cacheWindow( uint32_t block, uint32_t &first, uint32_t &count ) override;
+    bool cachePinned( uint32_t block ) override;
+
 
     uint16_t getSectorCount( uint16_t track )
     {
@@ -9,7 +9,7 @@
 uint32_t P00MStream::readFile(uint8_t* buf, uint32_t size) {
     uint32_t bytesRead = 0;
 
-    bytesRead += containerStream->read(buf, size);
+    bytesRead += readContainer(buf, size);
     _position += bytesRead;
 
     return bytesRead;
@@ -31,8 +31,8 @@ protected:
     };
 
     bool readHeader() override {
-        containerStream->seek(0x00);
-        if (containerStream->read((uint8_t*)&header, sizeof(header)))
+        seekContainer(0x00);
+        if (readContainer((uint8_t*)&header, sizeof(header)))
             return true;
 
         return false;
@@ -0,0 +1,163 @@
+#ifndef MEATLOAF_BROKER
+#define MEATLOAF_BROKER
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/********************************************************
+ * Bounded LRU cache of objects by url
+ *
+ * The broker hands out shared_ptrs, so dropping an entry
+ * only drops the broker's reference: whoever still holds
+ * the object keeps it. When full, the least recently used
+ * entry nobody else holds goes first.
+ ********************************************************/
+
+struct MeatBrokerStats {
+    size_t entries = 0;
+    size_t entries_peak = 0;
+    size_t capacity = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t evictions = 0;
+};
+
+template<class V>
+class MeatBroker {
+public:
+    explicit MeatBroker(size_t capacity) {
+        _stats.capacity = capacity;
+    }
+
+    /**
+     * @brief The cached object for url, or create(url) cached in its place
+     * @param create returns a new V* or nullptr; nullptr is not cached
+     */
+    template<class F>
+    std::shared_ptr<V> obtain(const std::string& url, F create)
+    {
+        auto value = find(url);
+        if (value != nullptr)
+            return value;
+
+        value.reset(create(url));
+        if (value != nullptr)
+            insert(url, value);
+        return value;
+    }
+
+    // The cached object for url, or nullptr
+    std::shared_ptr<V> find(const std::string& url)
+    {
+        for (auto& e : _entries)
+        {
+            if (e.url == url)
+            {
+                _stats.hits++;
+                e.used = ++_tick;
+                return e.value;
+            }
+        }
+
+        _stats.misses++;
+        return nullptr;
+    }
+
+    void insert(const std::string& url, std::shared_ptr<V> value)
+    {
+        if (_stats.capacity == 0)
+            return;
+
+        // Taken once, so the entries don't move around the heap
+        if (_entries.capacity() < _stats.capacity)
+            _entries.reserve(_stats.capacity);
+
+        if (_entries.size() == _stats.capacity)
+            evict();
+
+        _entries.push_back({url, std::move(value), ++_tick});
+        _stats.entries = _entries.size();
+        if (_stats.entries > _stats.entries_peak)
+            _stats.entries_peak = _stats.entries;
+    }
+
+    void dispose(const std::string& url)
+    {
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            if (_entries[i].url == url)
+            {
+                remove(i);
+                break;
+            }
+        }
+    }
+
+    // Drop the holder's reference, and url's entry too if that was the last one
+    void release(const std::string& url, std::shared_ptr<V>& value)
+    {
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            // A newer object may have taken the url since this one was evicted
+            if (_entries[i].url == url && _entries[i].value == value)
+            {
+                value.reset();
+                if (_entries[i].value.use_count() == 1)
+                    remove(i);
+                return;
+            }
+        }
+        value.reset();
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _stats.entries = 0;
+    }
+
+    const MeatBrokerStats& stats() const {
+        return _stats;
+    }
+
+private:
+    struct entry {
+        std::string url;
+        std::shared_ptr<V> value;
+        uint32_t used;
+    };
+
+    std::vector<entry> _entries;
+    uint32_t _tick = 0;
+    MeatBrokerStats _stats;
+
+    void evict()
+    {
+        size_t victim = 0;
+        bool victim_held = true;
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            bool held = _entries[i].value.use_count() > 1;
+            if ((victim_held && !held) ||
+                (held == victim_held && _entries[i].used < _entries[victim].used))
+            {
+                victim = i;
+                victim_held = held;
+            }
+        }
+        remove(victim);
+        _stats.evictions++;
+    }
+
+    void remove(size_t i)
+    {
+        if (i + 1 != _entries.size())
+            _entries[i] = std::move(_entries.back());
+        _entries.pop_back();
+        _stats.entries = _entries.size();
+    }
+};
+
+#endif // MEATLOAF_BROKER
@@ -0,0 +1,270 @@
+#include "meat_cache.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+#include "../../include/debug.h"
+
+std::mutex MediaBlockCache::_shared_mutex;
+MediaCacheStats MediaBlockCache::_stats;
+
+static MeatBroker<MediaBlockCache> cache_repo(MEATLOAF_BROKER_CACHES);
+
+static void* cache_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    // PSRAM only: without it, reading uncached beats taking this much internal RAM
+    return heap_caps_malloc(size, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+#else
+    return malloc(size);
+#endif
+}
+
+static void cache_free(void* p)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(p);
+#else
+    free(p);
+#endif
+}
+
+MediaBlockCache::MediaBlockCache(uint32_t container_size)
+{
+    _size = container_size;
+    _slots = (slot*)cache_alloc(SLOTS * sizeof(slot));
+    _data = (uint8_t*)cache_alloc(SLOTS * MEATLOAF_CACHE_BLOCK_SIZE);
+    _fetch = (uint8_t*)cache_alloc(MEATLOAF_CACHE_READAHEAD * MEATLOAF_CACHE_BLOCK_SIZE);
+    if (_slots == nullptr || _data == nullptr || _fetch == nullptr)
+    {
+        Debug_printv("No memory for block cache");
+        cache_free(_slots);
+        cache_free(_data);
+        cache_free(_fetch);
+        _slots = nullptr;
+        _data = nullptr;
+        _fetch = nullptr;
+        return;
+    }
+
+    for (size_t i = 0; i < SLOTS; i++)
+        _slots[i] = {EMPTY, 0, false};
+}
+
+MediaBlockCache::~MediaBlockCache()
+{
+    cache_free(_slots);
+    cache_free(_data);
+    cache_free(_fetch);
+}
+
+size_t MediaBlockCache::lookup(uint32_t block)
+{
+    // Reads mostly stay in one block, or move to the next
+    if (_slots[_last].block == block)
+        return _last;
+
+    for (size_t i = 0; i < SLOTS; i++)
+        if (_slots[i].block == block)
+            return i;
+
+    return SLOTS;
+}
+
+bool MediaBlockCache::find(uint32_t block, uint32_t offset, uint8_t* buf, uint32_t len)
+{
+    bool hit;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t i = lookup(block);
+        hit = i != SLOTS;
+        if (hit)
+        {
+            _slots[i].used = ++_tick;
+            _last = i;
+            memcpy(buf, _data + i * MEATLOAF_CACHE_BLOCK_SIZE + offset, len);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_shared_mutex);
+    if (hit)
+        _stats.hits++;
+    else
+        _stats.misses++;
+    return hit;
+}
+
+// A free slot, or the least recently used unpinned one
+size_t MediaBlockCache::take(bool pinned)
+{
+    size_t victim = SLOTS;
+    for (size_t i = 0; i < SLOTS; i++)
+    {
+        if (_slots[i].block == EMPTY)
+        {
+            victim = i;
+            break;
+        }
+        if (!_slots[i].pinned && (victim == SLOTS || _slots[i].used < _slots[victim].used))
+            victim = i;
+    }
+
+    // There are MEATLOAF_CACHE_PINNED more slots than pinned blocks, so never SLOTS
+    _slots[victim].pinned = pinned && _pinned < MEATLOAF_CACHE_PINNED;
+    if (_slots[victim].pinned)
+        _pinned++;
+    return victim;
+}
+
+bool MediaBlockCache::fetch(MStream* src, uint32_t block, uint32_t first, uint32_t count, const std::function<bool(uint32_t)>& pinned,
+                            uint32_t offset, uint8_t* buf, uint32_t len)
+{
+    if (count == 0)
+        count = 1;
+    if (count > MEATLOAF_CACHE_READAHEAD)
+        count = MEATLOAF_CACHE_READAHEAD;
+
+    // A window that leaves out the block is no use, read on from it instead
+    if (block < first || block >= first + count)
+        first = block;
+
+    uint32_t pos = first * MEATLOAF_CACHE_BLOCK_SIZE;
+    if (pos >= _size)
+        return false;
+
+    uint32_t want = count * MEATLOAF_CACHE_BLOCK_SIZE;
+    if (want > _size - pos)
+        want = _size - pos;
+
+    // Held while reading, _fetch is shared with the other streams
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!src->seek(pos))
+        return false;
+
+    // Streams may stop at the end of what they have buffered, or of an HTTP range
+    uint32_t got = 0;
+    while (got < want)
+    {
+        uint32_t n = src->read(_fetch + got, want - got);
+        if (n == 0)
+            break;
+        got += n;
+    }
+    {
+        std::lock_guard<std::mutex> shared_lock(_shared_mutex);
+        _stats.reads++;
+        _stats.bytes_read += got;
+    }
+    //Debug_printv("first[%lu] count[%lu] got[%lu]", first, count, got);
+
+    bool found = false;
+    for (uint32_t at = 0; at < got; at += MEATLOAF_CACHE_BLOCK_SIZE)
+    {
+        uint32_t b = first + at / MEATLOAF_CACHE_BLOCK_SIZE;
+        size_t i = lookup(b);
+        if (i == SLOTS)
+            i = take(pinned(b));
+        _slots[i].block = b;
+        _slots[i].used = ++_tick;
+
+        uint8_t* data = _data + i * MEATLOAF_CACHE_BLOCK_SIZE;
+        uint32_t n = got - at;
+        if (n >= MEATLOAF_CACHE_BLOCK_SIZE)
+            n = MEATLOAF_CACHE_BLOCK_SIZE;
+        else
+            memset(data + n, 0, MEATLOAF_CACHE_BLOCK_SIZE - n);
+        memcpy(data, _fetch + at, n);
+
+        if (b == block)
+        {
+            memcpy(buf, data + offset, len);
+            found = true;
+            _last = i;
+        }
+    }
+
+    return found;
+}
+
+void MediaBlockCache::invalidate(uint32_t pos, uint32_t size)
+{
+    if (size == 0)
+        return;
+
+    uint32_t first = pos / MEATLOAF_CACHE_BLOCK_SIZE;
+    uint32_t last = (pos + size - 1) / MEATLOAF_CACHE_BLOCK_SIZE;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t i = 0; i < SLOTS; i++)
+    {
+        if (_slots[i].block != EMPTY && _slots[i].block >= first && _slots[i].block <= last)
+        {
+            if (_slots[i].pinned)
+                _pinned--;
+            _slots[i] = {EMPTY, 0, false};
+        }
+    }
+}
+
+std::shared_ptr<MediaBlockCache> MediaBlockCache::obtain(const std::string& url, uint32_t container_size)
+{
+    if (container_size == 0)
+        return nullptr;
+
+    std::shared_ptr<MediaBlockCache> cache;
+    if (url.empty())
+    {
+        // Nothing to share it by
+        cache = std::make_shared<MediaBlockCache>(container_size);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(_shared_mutex);
+        cache = cache_repo.find(url);
+
+        // The image has changed
+        if (cache != nullptr && cache->containerSize() != container_size)
+        {
+            cache_repo.dispose(url);
+            cache = nullptr;
+        }
+
+        if (cache == nullptr)
+        {
+            cache = std::make_shared<MediaBlockCache>(container_size);
+            if (cache->valid())
+                cache_repo.insert(url, cache);
+        }
+    }
+
+    if (!cache->valid())
+        return nullptr;
+    return cache;
+}
+
+void MediaBlockCache::release(const std::string& url, std::shared_ptr<MediaBlockCache>& cache)
+{
+    std::lock_guard<std::mutex> lock(_shared_mutex);
+    cache_repo.release(url, cache);
+}
+
+void MediaBlockCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_shared_mutex);
+    cache_repo.clear();
+}
+
+MediaCacheStats MediaBlockCache::stats()
+{
+    std::lock_guard<std::mutex> lock(_shared_mutex);
+    return _stats;
+}
+
+MeatBrokerStats MediaBlockCache::brokerStats()
+{
+    std::lock_guard<std::mutex> lock(_shared_mutex);
+    return cache_repo.stats();
+}
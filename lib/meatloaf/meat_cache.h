@@ -0,0 +1,115 @@
+#ifndef MEATLOAF_CACHE
+#define MEATLOAF_CACHE
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "meatloaf.h"
+
+/********************************************************
+ * Block cache for media container streams
+ *
+ * Disk and tape images are read in 256 byte blocks, and
+ * every track/sector link hop used to be a seek on the
+ * container stream: for an image on HTTP or TNFS, another
+ * request. The cache sits between an MMediaStream and its
+ * container. A miss reads a whole window of blocks (for
+ * disks, the track the chain is on) in one go. Blocks the
+ * media marks as pinned, the directory and BAM, are never
+ * dropped. Streams on the same container url share one
+ * cache, so a LOAD finds the blocks the directory listing
+ * already read. They may be on different tasks, so blocks
+ * are copied out under the cache's lock. The cache goes
+ * when its last stream does: an image changed in place,
+ * even to the same size, is read afresh when next opened.
+ ********************************************************/
+
+#define MEATLOAF_CACHE_BLOCK_SIZE 256
+// Blocks kept besides the pinned ones
+#ifndef MEATLOAF_CACHE_BLOCKS
+#define MEATLOAF_CACHE_BLOCKS 64
+#endif
+// Most pinned blocks; the directory track of a D81 is 40
+#define MEATLOAF_CACHE_PINNED 48
+// Most blocks one container read fetches
+#define MEATLOAF_CACHE_READAHEAD 24
+// Caches findable by url; when full one is dropped even if
+// streams hold it, and they keep it but no longer share it
+#define MEATLOAF_BROKER_CACHES 2
+
+struct MediaCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t reads = 0;      // container reads, one per miss
+    uint32_t bytes_read = 0;
+};
+
+class MediaBlockCache {
+public:
+    MediaBlockCache(uint32_t container_size);
+    ~MediaBlockCache();
+
+    bool valid() const {
+        return _data != nullptr;
+    }
+
+    uint32_t containerSize() const {
+        return _size;
+    }
+
+    // Copy len bytes at offset in block to buf, false if the block isn't cached
+    bool find(uint32_t block, uint32_t offset, uint8_t* buf, uint32_t len);
+
+    /**
+     * @brief Read count blocks starting at first from src into the cache,
+     * then copy len bytes at offset in block to buf
+     * @param block the block that was missing, within the window
+     * @param pinned says which blocks must stay cached
+     * @return false if block couldn't be read
+     */
+    bool fetch(MStream* src, uint32_t block, uint32_t first, uint32_t count, const std::function<bool(uint32_t)>& pinned,
+               uint32_t offset, uint8_t* buf, uint32_t len);
+
+    // Drop the blocks covering size bytes at pos, after a write
+    void invalidate(uint32_t pos, uint32_t size);
+
+    // The cache for url, shared by all streams on it
+    static std::shared_ptr<MediaBlockCache> obtain(const std::string& url, uint32_t container_size);
+    // A stream is done with the cache for url
+    static void release(const std::string& url, std::shared_ptr<MediaBlockCache>& cache);
+    static void clear();
+
+    // All caches together
+    static MediaCacheStats stats();
+    static MeatBrokerStats brokerStats();
+
+private:
+    struct slot {
+        uint32_t block;
+        uint32_t used;
+        bool pinned;
+    };
+
+    static const uint32_t EMPTY = UINT32_MAX;
+    static const size_t SLOTS = MEATLOAF_CACHE_BLOCKS + MEATLOAF_CACHE_PINNED;
+
+    uint32_t _size = 0;
+    slot* _slots = nullptr;
+    uint8_t* _data = nullptr;   // SLOTS blocks
+    uint8_t* _fetch = nullptr;  // MEATLOAF_CACHE_READAHEAD blocks
+    size_t _pinned = 0;
+    size_t _last = 0;           // the slot find() returned last
+    uint32_t _tick = 0;
+    std::mutex _mutex;          // for all of the above but _size
+
+    static std::mutex _shared_mutex; // for _stats and the caches by url
+    static MediaCacheStats _stats;
+
+    size_t lookup(uint32_t block);
+    size_t take(bool pinned);
+};
+
+#endif // MEATLOAF_CACHE
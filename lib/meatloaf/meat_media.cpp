@@ -1,6 +1,8 @@
 #include "meat_media.h"
 
-std::unordered_map<std::string, MMediaStream*> ImageBroker::image_repo;
+#include <cstring>
+
+MeatBroker<MMediaStream> ImageBroker::image_repo(MEATLOAF_BROKER_IMAGES);
 
 // Utility Functions
 
@@ -160,17 +162,74 @@ void MMediaStream::close()
 
 uint32_t MMediaStream::readContainer(uint8_t *buf, uint32_t size)
 {
-    return containerStream->read(buf, size);
+    if ( _cache == nullptr )
+    {
+        uint32_t bytesRead = containerStream->read(buf, size);
+        _container_position += bytesRead;
+        return bytesRead;
+    }
+
+    if ( _container_position >= _cache->containerSize() )
+        return 0;
+    if ( size > _cache->containerSize() - _container_position )
+        size = _cache->containerSize() - _container_position;
+
+    uint32_t bytesRead = 0;
+    while ( bytesRead < size )
+    {
+        uint32_t block = _container_position / MEATLOAF_CACHE_BLOCK_SIZE;
+        uint32_t offset = _container_position % MEATLOAF_CACHE_BLOCK_SIZE;
+
+        uint32_t n = std::min(size - bytesRead, (uint32_t)(MEATLOAF_CACHE_BLOCK_SIZE - offset));
+        if ( !_cache->find(block, offset, buf + bytesRead, n) )
+        {
+            uint32_t first = block;
+            uint32_t count = 1;
+            cacheWindow(block, first, count);
+            if ( !_cache->fetch(containerStream.get(), block, first, count, [this](uint32_t b) { return cachePinned(b); },
+                                offset, buf + bytesRead, n) )
+                break;
+        }
+
+        bytesRead += n;
+        _container_position += n;
+    }
+
+    return bytesRead;
 }
 uint32_t MMediaStream::writeContainer(uint8_t *buf, uint32_t size)
 {
-    return containerStream->read(buf, size);
+    if ( _cache != nullptr )
+    {
+        // The container is wherever the last cache miss left it
+        _cache->invalidate(_container_position, size);
+        if ( !containerStream->seek(_container_position) )
+            return 0;
+    }
+
+    uint32_t bytesWritten = containerStream->write(buf, size);
+    _container_position += bytesWritten;
+    return bytesWritten;
+}
+bool MMediaStream::seekContainer(uint32_t pos)
+{
+    if ( _cache == nullptr )
+    {
+        if ( !containerStream->seek(pos) )
+            return false;
+    }
+    else if ( pos > _cache->containerSize() )
+        return false;
+
+    // With a cache, nothing is read until a block is missing
+    _container_position = pos;
+    return true;
 }
 
 uint8_t MMediaStream::read() 
 {
     uint8_t b = 0;
-    containerStream->read( &b, 1 );
+    readContainer( &b, 1 );
     _position++;
     return b;
 }
@@ -204,7 +263,7 @@ std::string MMediaStream::readUntil( uint8_t delimiter )
     std::string bytes = "";
     do
     {
-        s = containerStream->read( &b, 1 );
+        s = readContainer( &b, 1 );
         _position += s;
         if ( b != delimiter )
         {
@@ -220,7 +279,7 @@ std::string MMediaStream::readUntil( uint8_t delimiter )
 std::string MMediaStream::readString( uint8_t size )
 {
     uint8_t b[size];
-    if ( auto s = containerStream->read( b, size ) )
+    if ( auto s = readContainer( b, size ) )
     {
         _position += s;
         return std::string((char *)b);
@@ -232,7 +291,7 @@ std::string MMediaStream::readStringUntil( uint8_t delimiter )
 {
     uint8_t b = 0;
     std::stringstream ss;
-    while( containerStream->read( &b, 1 ) )
+    while( readContainer( &b, 1 ) )
     {
         _position++;
         if ( b == delimiter )
@@ -248,12 +307,12 @@ uint32_t MMediaStream::write(const uint8_t *buf, uint32_t size) {
 // seek = (offset) => this.containerStream.seek(offset + this.media_header_size);
 bool MMediaStream::seek(uint32_t offset) {
     _position = media_data_offset + offset;
-    return containerStream->seek( _position ); 
+    return seekContainer( _position ); 
 }
 // seekCurrent = (offset) => this.containerStream.seekCurrent(offset);
 bool MMediaStream::seekCurrent(uint32_t offset) {
     _position += offset;
-    return containerStream->seek( _position );
+    return seekContainer( _position );
 }
 
 uint32_t MMediaStream::seekFileSize( uint8_t start_track, uint8_t start_sector )
@@ -3,6 +3,7 @@
 #define MEATLOAF_MEDIA
 
 #include "meatloaf.h"
+#include "meat_cache.h"
 
 #include <map>
 #include <bitset>
@@ -26,11 +27,13 @@ public:
         containerStream = is;
         _is_open = true;
         has_subdirs = false;
+        _cache = MediaBlockCache::obtain(is->url, is->size());
     }
 
     ~MMediaStream() {
         //Debug_printv("close");
         close();
+        MediaBlockCache::release(containerStream->url, _cache);
     }
 
     std::string url;
@@ -80,6 +83,8 @@ protected:
 
     bool seekCalled = false;
     std::shared_ptr<MStream> containerStream;
+    std::shared_ptr<MediaBlockCache> _cache;
+    uint32_t _container_position = 0;
 
     bool _is_open = false;
 
@@ -121,8 +126,19 @@ protected:
             return ( _size / block_size );
     }
 
+    // All container access goes through these, and the block cache if there is one
     virtual uint32_t readContainer(uint8_t *buf, uint32_t size);
     virtual uint32_t writeContainer(uint8_t *buf, uint32_t size);
+    bool seekContainer(uint32_t pos);
+
+    // Blocks a cache miss on block reads; by default the ones after it
+    virtual void cacheWindow(uint32_t block, uint32_t &first, uint32_t &count) {
+        first = block;
+        count = MEATLOAF_CACHE_READAHEAD;
+    }
+    // Blocks the cache keeps while the image is in use
+    virtual bool cachePinned(uint32_t block) { return false; };
+
     virtual uint32_t readFile(uint8_t* buf, uint32_t size) = 0;
     virtual uint32_t writeFile(uint8_t* buf, uint32_t size) = 0;
     virtual std::string decodeType(uint8_t file_type, bool show_hidden = false);
@@ -163,66 +179,60 @@ private:
 /********************************************************
  * Utility implementations
  ********************************************************/
+// Most images the broker keeps open
+#ifndef MEATLOAF_BROKER_IMAGES
+#define MEATLOAF_BROKER_IMAGES 4
+#endif
+
 class ImageBroker {
-    static std::unordered_map<std::string, MMediaStream*> image_repo;
+    static MeatBroker<MMediaStream> image_repo;
 public:
-    template<class T> static T* obtain(std::string url) 
+    template<class T> static std::shared_ptr<T> obtain(std::string url) 
     {
-        //Debug_printv("streams[%d] url[%s]", image_repo.size(), url.c_str());
+        //Debug_printv("streams[%d] url[%s]", image_repo.stats().entries, url.c_str());
 
         // obviously you have to supply STREAMFILE.url to this function!
-        if(image_repo.find(url)!=image_repo.end()) {
-            return (T*)image_repo.at(url);
-        }
-
-        // create and add stream to broker if not found
-        auto newFile = MFSOwner::File(url);
+        return std::static_pointer_cast<T>(image_repo.obtain(url, [](const std::string& url) -> MMediaStream* {
+            // create and add stream to broker if not found
+            std::unique_ptr<MFile> newFile(MFSOwner::File(url));
+            if ( newFile == nullptr )
+                return nullptr;
 
-        T* newStream = (T*)newFile->getSourceStream();
+            auto newStream = (MMediaStream*)newFile->getSourceStream();
 
-        if ( newStream != nullptr )
-        {
-            // Are we at the root of the pathInStream?
-            if ( newFile->pathInStream == "")
-            {
-                Debug_printv("DIRECTORY [%s]", url.c_str());
-            }
-            else
+            if ( newStream != nullptr )
             {
-                Debug_printv("SINGLE FILE [%s]", url.c_str());
+                // Are we at the root of the pathInStream?
+                if ( newFile->pathInStream == "")
+                {
+                    Debug_printv("DIRECTORY [%s]", url.c_str());
+                }
+                else
+                {
+                    Debug_printv("SINGLE FILE [%s]", url.c_str());
+                }
             }
 
-            image_repo.insert(std::make_pair(url, newStream));
             return newStream;
-        }
-
-        delete newFile;
-        return nullptr;
+        }));
     }
 
-    static MMediaStream* obtain(std::string url) {
+    static std::shared_ptr<MMediaStream> obtain(std::string url) {
         return obtain<MMediaStream>(url);
     }
 
     static void dispose(std::string url) {
-        if(image_repo.find(url)!=image_repo.end()) {
-            auto toDelete = image_repo.at(url);
-            image_repo.erase(url);
-            delete toDelete;
-        }
-        Debug_printv("streams[%d]", image_repo.size());
-    }
-
-    static void validate() {
-        
+        image_repo.dispose(url);
+        Debug_printv("streams[%d]", image_repo.stats().entries);
     }
 
     static void clear() {
-        std::for_each(image_repo.begin(), image_repo.end(), [](auto& pair) {
-            delete pair.second;
-        });
         image_repo.clear();
     }
+
+    static const MeatBrokerStats& stats() {
+        return image_repo.stats();
+    }
 };
 
 #endif // MEATLOAF_MEDIA
@@ -0,0 +1,139 @@
+#include "meat_pool.h"
+
+#include <new>
+#include <cstdlib>
+
+#include "fnSystem.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+std::mutex MeatPool::_mutex;
+MeatPool::slot* MeatPool::_free[MEATLOAF_POOL_MAX_OBJECT / MEATLOAF_POOL_GRAIN];
+uint8_t* MeatPool::_slabs[MEATLOAF_POOL_SLABS];
+MeatPoolStats MeatPool::_stats;
+
+static uint8_t* slab_alloc()
+{
+#ifdef ESP_PLATFORM
+    // Keep the slabs out of internal RAM if we can
+    void* p = heap_caps_malloc(MEATLOAF_POOL_SLAB_SIZE, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+    if (p == nullptr)
+        p = heap_caps_malloc(MEATLOAF_POOL_SLAB_SIZE, MALLOC_CAP_DEFAULT);
+    return (uint8_t*)p;
+#else
+    return (uint8_t*)malloc(MEATLOAF_POOL_SLAB_SIZE);
+#endif
+}
+
+static size_t slab_limit()
+{
+    static const size_t limit = fnSystem.get_psram_size() > 0 ? MEATLOAF_POOL_SLABS : MEATLOAF_POOL_SLABS_NO_PSRAM;
+    return limit;
+}
+
+// Put a new slab on the free list for slot_size
+bool MeatPool::carve(size_t slot_size)
+{
+    if (_stats.slabs == slab_limit())
+        return false;
+
+    uint8_t* slab = slab_alloc();
+    if (slab == nullptr)
+        return false;
+    _slabs[_stats.slabs++] = slab;
+
+    slot*& head = _free[slot_size / MEATLOAF_POOL_GRAIN - 1];
+    for (size_t offset = 0; offset + slot_size <= MEATLOAF_POOL_SLAB_SIZE; offset += slot_size)
+    {
+        slot* s = (slot*)(slab + offset);
+        s->next = head;
+        head = s;
+    }
+    return true;
+}
+
+bool MeatPool::owns(void* p)
+{
+    for (size_t i = 0; i < _stats.slabs; i++)
+        if ((uint8_t*)p >= _slabs[i] && (uint8_t*)p < _slabs[i] + MEATLOAF_POOL_SLAB_SIZE)
+            return true;
+    return false;
+}
+
+// Count a live object, once it has its memory
+void MeatPool::count(size_t size)
+{
+    _stats.objects++;
+    _stats.bytes += size;
+    if (_stats.bytes > _stats.bytes_peak)
+        _stats.bytes_peak = _stats.bytes;
+}
+
+void* MeatPool::allocate(size_t size)
+{
+    size_t slot_size = (size + MEATLOAF_POOL_GRAIN - 1) / MEATLOAF_POOL_GRAIN * MEATLOAF_POOL_GRAIN;
+    void* p = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stats.allocations++;
+
+        if (slot_size > 0 && slot_size <= MEATLOAF_POOL_MAX_OBJECT)
+        {
+            slot*& head = _free[slot_size / MEATLOAF_POOL_GRAIN - 1];
+            if (head != nullptr || carve(slot_size))
+            {
+                p = head;
+                head = head->next;
+                count(size);
+                return p;
+            }
+        }
+        _stats.heap_allocations++;
+    }
+
+    // Built without exceptions, so out of memory is nullptr; the operator new
+    // that calls this is noexcept, which makes the new expression nullptr too
+    p = ::operator new(size, std::nothrow);
+    if (p != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        count(size);
+    }
+    return p;
+}
+
+void MeatPool::release(void* p, size_t size)
+{
+    if (p == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stats.objects--;
+        _stats.bytes -= size;
+
+        if (owns(p))
+        {
+            size_t slot_size = (size + MEATLOAF_POOL_GRAIN - 1) / MEATLOAF_POOL_GRAIN * MEATLOAF_POOL_GRAIN;
+            slot* s = (slot*)p;
+            slot*& head = _free[slot_size / MEATLOAF_POOL_GRAIN - 1];
+            s->next = head;
+            head = s;
+            return;
+        }
+    }
+
+    ::operator delete(p);
+}
+
+MeatPoolStats MeatPool::stats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    MeatPoolStats stats = _stats;
+    stats.slabs_max = slab_limit();
+    return stats;
+}
@@ -0,0 +1,68 @@
+#ifndef MEATLOAF_POOL
+#define MEATLOAF_POOL
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/********************************************************
+ * Object pool for MFile and MStream
+ *
+ * A directory walk creates and deletes an MFile for every
+ * entry. Taking those from the general heap leaves it full
+ * of holes on a long session, until a LOAD can't get the
+ * buffer it needs. Instead they come from slabs that are
+ * never given back, cut into slots of one size each, and
+ * a deleted object's slot goes on a free list for the next
+ * object of the same size.
+ ********************************************************/
+
+// Slot sizes are multiples of this
+#define MEATLOAF_POOL_GRAIN 32
+// Larger objects come from the heap
+#define MEATLOAF_POOL_MAX_OBJECT 1024
+#define MEATLOAF_POOL_SLAB_SIZE 4096
+// Once all slabs are in use, new objects come from the heap
+#ifndef MEATLOAF_POOL_SLABS
+#define MEATLOAF_POOL_SLABS 32
+#endif
+// Without PSRAM the slabs come from internal RAM and are never given back,
+// so only a few are taken there
+#ifndef MEATLOAF_POOL_SLABS_NO_PSRAM
+#define MEATLOAF_POOL_SLABS_NO_PSRAM 4
+#endif
+
+struct MeatPoolStats {
+    size_t slabs = 0;         // slabs allocated, MEATLOAF_POOL_SLAB_SIZE each
+    size_t slabs_max = 0;     // slabs it may allocate, fewer without PSRAM
+    size_t objects = 0;       // live objects, pooled or not
+    size_t bytes = 0;         // bytes in live objects
+    size_t bytes_peak = 0;    // high water mark of bytes
+    uint32_t allocations = 0;
+    uint32_t heap_allocations = 0; // too large, or the pool was full
+};
+
+class MeatPool {
+public:
+    // nullptr when out of memory
+    static void* allocate(size_t size);
+    static void release(void* p, size_t size);
+
+    static MeatPoolStats stats();
+
+private:
+    struct slot {
+        slot* next;
+    };
+
+    static std::mutex _mutex;
+    static slot* _free[MEATLOAF_POOL_MAX_OBJECT / MEATLOAF_POOL_GRAIN];
+    static uint8_t* _slabs[MEATLOAF_POOL_SLABS];
+    static MeatPoolStats _stats;
+
+    static bool carve(size_t slot_size);
+    static void count(size_t size);
+    static bool owns(void* p);
+};
+
+#endif // MEATLOAF_POOL
@@ -7,8 +7,8 @@
 #include <vector>
 #include <sstream>
 
-std::unordered_map<std::string, MFile*> FileBroker::file_repo;
-std::unordered_map<std::string, MStream*> StreamBroker::stream_repo;
+MeatBroker<MFile> FileBroker::file_repo(MEATLOAF_BROKER_FILES);
+MeatBroker<MStream> StreamBroker::stream_repo(MEATLOAF_BROKER_STREAMS);
 
 #ifdef FLASH_SPIFFS
 #include "esp_spiffs.h"
@@ -17,6 +17,9 @@
 #include "string_utils.h"
 #include "U8Char.h"
 
+#include "meat_broker.h"
+#include "meat_pool.h"
+
 #define _MEAT_NO_DATA_AVAIL (std::ios_base::eofbit)
 
 static const std::ios_base::iostate ndabit = _MEAT_NO_DATA_AVAIL;
@@ -64,6 +67,9 @@ public:
         //Debug_printv("dstr url[%s]", url.c_str());
     };
 
+    static void* operator new(size_t size) noexcept { return MeatPool::allocate(size); }
+    static void operator delete(void* p, size_t size) { MeatPool::release(p, size); }
+
     std::ios_base::openmode mode;
     std::string url = "";
 
@@ -188,6 +194,9 @@ public:
         //Debug_printv("dtor path[%s]", path.c_str());
     };
 
+    static void* operator new(size_t size) noexcept { return MeatPool::allocate(size); }
+    static void operator delete(void* p, size_t size) { MeatPool::release(p, size); }
+
     bool isPETSCII = false;
     bool isWritable = false;
     std::string media_header;
@@ -501,23 +510,32 @@ namespace Meat {
  * Utility implementations
  ********************************************************/
 
+// Most objects each broker keeps
+#ifndef MEATLOAF_BROKER_FILES
+#define MEATLOAF_BROKER_FILES 8
+#endif
+#ifndef MEATLOAF_BROKER_STREAMS
+#define MEATLOAF_BROKER_STREAMS 4
+#endif
+
 class FileBroker {
-    static std::unordered_map<std::string, MFile*> file_repo;
+    static MeatBroker<MFile> file_repo;
 public:
-    template<class T> static T* obtain(std::string url, MFile* sourceFile) 
+    template<class T> static std::shared_ptr<T> obtain(std::string url) 
     {
-        //Debug_printv("streams[%d] url[%s]", file_repo.size(), url.c_str());
+        //Debug_printv("files[%d] url[%s]", file_repo.stats().entries, url.c_str());
 
         // obviously you have to supply STREAMFILE.url to this function!
-        if(file_repo.find(url)!=file_repo.end())
+        auto cached = file_repo.find(url);
+        if ( cached != nullptr )
         {
             Debug_printv("Reusing Existing MFile url[%s]", url.c_str());
-            return (T*)file_repo.at(url);
+            return std::static_pointer_cast<T>(cached);
         }
 
-        // create and add stream to broker if not found
-        Debug_printv("Creating New Stream url[%s]", url.c_str());
-        auto newFile = MFSOwner::File(url);
+        // create and add file to broker if not found
+        Debug_printv("Creating New MFile url[%s]", url.c_str());
+        std::shared_ptr<T> newFile((T*)MFSOwner::File(url));
 
         if ( newFile != nullptr )
         {
@@ -525,57 +543,57 @@ public:
             if ( newFile->pathInStream == "")
             {
                 Debug_printv("ROOT FILESYSTEM... CACHING [%s]", url.c_str());
-                file_repo.insert(std::make_pair(url, newFile));
+                file_repo.insert(url, newFile);
             }
             else
             {
                 Debug_printv("SINGLE FILE... DON'T CACHE [%s]", url.c_str());
             }
-            
-            return newFile;
         }
 
-        delete newFile;
-        return nullptr;
+        return newFile;
     }
 
-    static MFile* obtain(std::string url, MFile* sourceFile) {
-        return obtain<MFile>(url, sourceFile);
+    static std::shared_ptr<MFile> obtain(std::string url) {
+        return obtain<MFile>(url);
     }
 
     static void dispose(std::string url) {
-        if(file_repo.find(url)!=file_repo.end()) {
-            auto toDelete = file_repo.at(url);
-            file_repo.erase(url);
-            delete toDelete;
-        }
-        Debug_printv("streams[%d]", file_repo.size());
+        file_repo.dispose(url);
+        Debug_printv("files[%d]", file_repo.stats().entries);
     }
 
-    static void validate() {
-        
+    static void clear() {
+        file_repo.clear();
+    }
+
+    static const MeatBrokerStats& stats() {
+        return file_repo.stats();
     }
 };
 
 class StreamBroker {
-    static std::unordered_map<std::string, MStream*> stream_repo;
+    static MeatBroker<MStream> stream_repo;
 public:
-    template<class T> static T* obtain(std::string url, std::ios_base::openmode mode) 
+    template<class T> static std::shared_ptr<T> obtain(std::string url, std::ios_base::openmode mode) 
     {
-        //Debug_printv("streams[%d] url[%s]", stream_repo.size(), url.c_str());
+        //Debug_printv("streams[%d] url[%s]", stream_repo.stats().entries, url.c_str());
 
         // obviously you have to supply STREAMFILE.url to this function!
-        if(stream_repo.find(url)!=stream_repo.end())
+        auto cached = stream_repo.find(url);
+        if ( cached != nullptr )
         {
             Debug_printv("Reusing Existing Stream url[%s]", url.c_str());
-            return (T*)stream_repo.at(url);
+            return std::static_pointer_cast<T>(cached);
         }
 
         // create and add stream to broker if not found
         Debug_printv("Creating New Stream url[%s]", url.c_str());
-        auto newFile = MFSOwner::File(url);
+        std::unique_ptr<MFile> newFile(MFSOwner::File(url));
+        if ( newFile == nullptr )
+            return nullptr;
 
-        T* newStream = (T*)newFile->createStream(mode);
+        std::shared_ptr<T> newStream((T*)newFile->createStream(mode));
 
         if ( newStream != nullptr )
         {
@@ -583,35 +601,32 @@ public:
             if ( newFile->pathInStream == "")
             {
                 Debug_printv("ROOT FILESYSTEM... CACHING [%s]", url.c_str());
-                stream_repo.insert(std::make_pair(url, newStream));
+                stream_repo.insert(url, newStream);
             }
             else
             {
                 Debug_printv("SINGLE FILE... DON'T CACHE [%s]", url.c_str());
             }
-            
-            return newStream;
         }
 
-        delete newFile;
-        return nullptr;
+        return newStream;
     }
 
-    static MStream* obtain(std::string url, std::ios_base::openmode mode) {
+    static std::shared_ptr<MStream> obtain(std::string url, std::ios_base::openmode mode) {
         return obtain<MStream>(url, mode);
     }
 
     static void dispose(std::string url) {
-        if(stream_repo.find(url)!=stream_repo.end()) {
-            auto toDelete = stream_repo.at(url);
-            stream_repo.erase(url);
-            delete toDelete;
-        }
-        Debug_printv("streams[%d]", stream_repo.size());
+        stream_repo.dispose(url);
+        Debug_printv("streams[%d]", stream_repo.stats().entries);
     }
 
-    static void validate() {
-        
+    static void clear() {
+        stream_repo.clear();
+    }
+
+    static const MeatBrokerStats& stats() {
+        return stream_repo.stats();
     }
 };
 #endif // MEATLOAF_FILE
@@ -2,6 +2,8 @@
 
 #include <esp_idf_version.h>
 
+#include <algorithm>
+
 #include "meatloaf.h"
 
 #include "../../../include/debug.h"
@@ -365,8 +367,9 @@ uint32_t MeatHttpClient::read(uint8_t* buf, uint32_t size) {
         if (bytesRead >= 0) {
             _position+=bytesRead;
 
+            // End of this range; ask for the rest of what the caller wants in one go
             if (bytesRead < size)
-                openAndFetchHeaders(lastMethod, _position);
+                openAndFetchHeaders(lastMethod, _position, std::max(size - bytesRead, (uint32_t)HTTP_BLOCK_SIZE));
         }
         if (bytesRead < 0)
             return 0;
@@ -489,9 +492,9 @@ esp_err_t MeatHttpClient::_http_event_handler(esp_http_client_event_t *evt)
                 //Debug_printv("Content-Range: %s",evt->header_value);
                 if(meatClient != nullptr) {
                     meatClient->isFriendlySkipper = true;
-                    auto cr = util_tokenize(evt->header_value, '/');
-                    if( cr.size() > 1 )
-                        meatClient->_range_size = std::stoi(cr[1]);
+                    uint32_t first, last, total;
+                    if( util_parse_content_range(evt->header_value, &first, &last, &total) && total > 0 )
+                        meatClient->_range_size = total;
                 }
                 //Debug_printv("size[%lu] isFriendlySkipper[%d]", meatClient->_range_size, meatClient->isFriendlySkipper);
             }
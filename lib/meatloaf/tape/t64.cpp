@@ -77,8 +77,8 @@ bool T64MStream::seekEntry( uint16_t index )
     //Debug_printv("----------");
     //Debug_printv("index[%d] sectorOffset[%d] entryOffset[%d] entry_index[%d]", index, sectorOffset, entryOffset, entry_index);
 
-    containerStream->seek(entryOffset);
-    containerStream->read((uint8_t *)&entry, sizeof(entry));
+    seekContainer(entryOffset);
+    readContainer((uint8_t *)&entry, sizeof(entry));
 
     //Debug_printv("r[%d] file_type[%02X] file_name[%.16s]", r, entry.file_type, entry.filename);
 
@@ -109,7 +109,7 @@ uint32_t T64MStream::readFile(uint8_t* buf, uint32_t size) {
     }
     else
     {
-        bytesRead += containerStream->read(buf, size);
+        bytesRead += readContainer(buf, size);
     }
 
     return bytesRead;
@@ -142,7 +142,7 @@ bool T64MStream::seekPath(std::string path) {
 
         // Set position to beginning of file
         _position = 0;
-        containerStream->seek(entry.data_offset);
+        seekContainer(entry.data_offset);
 
         Debug_printv("File Size: size[%lu] available[%lu] position[%lu]", _size, available(), _position);
 
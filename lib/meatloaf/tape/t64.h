@@ -38,8 +38,8 @@ protected:
     };
 
     bool readHeader() override {
-        containerStream->seek(0x28);
-        if (containerStream->read((uint8_t*)&header, 24))
+        seekContainer(0x28);
+        if (readContainer((uint8_t*)&header, 24))
             return true;
         
         return false;
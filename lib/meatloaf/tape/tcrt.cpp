@@ -114,8 +114,8 @@ bool TCRTMStream::seekEntry( uint16_t index )
     //Debug_printv("----------");
     //Debug_printv("index[%d] entryOffset[%d] entry_index[%d]", (index + 1), entryOffset, entry_index);
 
-    containerStream->seek(entryOffset);
-    containerStream->read((uint8_t *)&entry, sizeof(entry));
+    seekContainer(entryOffset);
+    readContainer((uint8_t *)&entry, sizeof(entry));
 
     //uint32_t file_start_address = (0xD8 + (entry.file_start_address[0] << 8 | entry.file_start_address[1] << 16));
     //uint32_t file_size = (entry.file_size[0] | (entry.file_size[1] << 8) | (entry.file_size[2] << 16)) + 2; // 2 bytes for load address
@@ -148,7 +148,7 @@ uint32_t TCRTMStream::readFile(uint8_t* buf, uint32_t size) {
     }
     else
     {
-        bytesRead += containerStream->read(buf, size);
+        bytesRead += readContainer(buf, size);
     }
 
     return bytesRead;
@@ -178,7 +178,7 @@ bool TCRTMStream::seekPath(std::string path) {
         // Set position to beginning of file
         _position = 0;
         uint32_t file_start_address = (0xD8 + (entry.file_start_address[0] << 8 | entry.file_start_address[1] << 16));
-        containerStream->seek(file_start_address);
+        seekContainer(file_start_address);
 
         Debug_printv("File Size: size[%ld] available[%ld]", _size, available());
         
@@ -39,8 +39,8 @@ protected:
     };
 
     bool readHeader() override {
-        containerStream->seek(0x18);
-        if (containerStream->read((uint8_t*)&header, sizeof(header)))
+        seekContainer(0x18);
+        if (readContainer((uint8_t*)&header, sizeof(header)))
             return true;
 
         return false;
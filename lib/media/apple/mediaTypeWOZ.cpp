@@ -245,7 +245,10 @@ bool MediaTypeWOZ::woz2_read_tracks()
     for (int i=0; i<MAX_TRACKS; i++)
         Debug_printf("\n%d, %d, %lu", trks[i].start_block, trks[i].block_count, trks[i].bit_count);
 #endif
-    // read WOZ tracks into RAM
+    // read WOZ tracks into RAM, tracks usually follow each other so read them in one batch
+    fnFileRange ranges[MAX_TRACKS];
+    int range_track[MAX_TRACKS];
+    size_t range_count = 0;
     for (int i=0; i<MAX_TRACKS; i++)
     {
         size_t s = std::max(trks[i].block_count * 512, WOZ1_TRACK_LEN);
@@ -259,8 +262,11 @@ bool MediaTypeWOZ::woz2_read_tracks()
             if (bitstream != nullptr)
             {
                 Debug_printf("\nReading %d bytes of track %d into location %lx", s, i, trk_data[i]);
-                fnio::fseek(_media_fileh, trks[i].start_block * 512, SEEK_SET);
-                fnio::fread(bitstream->data, 1, s, _media_fileh);
+                ranges[range_count].offset = trks[i].start_block * 512;
+                ranges[range_count].buf = bitstream->data;
+                ranges[range_count].len = s;
+                range_track[range_count] = i;
+                range_count++;
                 bitstream->len_blocks = trks[i].block_count;
                 bitstream->len_bytes = s;
                 bitstream->len_bits = trks[i].bit_count;
@@ -274,6 +280,17 @@ bool MediaTypeWOZ::woz2_read_tracks()
             }
         }
     }
+    fnio::freadv(ranges, range_count, _media_fileh);
+    // tracks are padded up to WOZ1_TRACK_LEN, only their blocks must be there
+    for (size_t r = 0; r < range_count; r++)
+    {
+        int i = range_track[r];
+        if (ranges[r].done < (size_t)trks[i].block_count * 512)
+        {
+            Debug_printf("\nShort read of track %d: %u of %d bytes", i, (unsigned)ranges[r].done, trks[i].block_count * 512);
+            return true;
+        }
+    }
     return false;
 }
 
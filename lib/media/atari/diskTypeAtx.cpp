@@ -4,6 +4,7 @@
 
 #include <memory.h>
 #include <string.h>
+#include <algorithm>
 #ifdef ESP_PLATFORM
   #include <esp_timer.h>
   #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
@@ -72,18 +73,17 @@
 #define MAX_RETRIES_1050 1
 #define MAX_RETRIES_810 4
 
-AtxTrack::~AtxTrack()
-{
-    if (data != nullptr)
-        delete[] data;
-
-    data = nullptr;
-};
-
 AtxTrack::AtxTrack(){
 
 };
 
+// Orders sectors by number (stable, duplicates keep their order) for find_sector()
+void AtxTrack::sort_sectors()
+{
+    std::stable_sort(sectors.begin(), sectors.end(),
+                     [](const AtxSector &a, const AtxSector &b) { return a.number < b.number; });
+}
+
 AtxSector::~AtxSector(){
 
 };
@@ -105,6 +105,39 @@ MediaTypeATX::~MediaTypeATX()
         esp_timer_stop(_atx_timer);
         esp_timer_delete(_atx_timer);
     }
+#endif
+    if (_atx_data != nullptr)
+        free(_atx_data);
+}
+
+// Allocate buffer for the sector data of the whole image, only in PSRAM:
+// without it, tracks allocate their own smaller buffers instead
+static uint8_t *_atx_data_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    return (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+#else
+    return (uint8_t *)malloc(size);
+#endif
+}
+
+// Trim the image data buffer, keeping it in PSRAM
+static uint8_t *_atx_data_realloc(uint8_t *p, size_t size)
+{
+#ifdef ESP_PLATFORM
+    return (uint8_t *)heap_caps_realloc(p, size, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+#else
+    return (uint8_t *)realloc(p, size);
+#endif
+}
+
+// Allocate one track's sector data buffer
+static uint8_t *_atx_track_data_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    return (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+#else
+    return (uint8_t *)malloc(size);
 #endif
 }
 
@@ -253,16 +286,22 @@ void MediaTypeATX::_process_sector(AtxTrack &track, AtxSector *psector, uint16_t
     if ((psector->status & ATX_SECTOR_STATUS_MISSING_DATA) == 0)
     {
         // Make sure we have a reasonable offset and data to copy
-        if (track.data != nullptr && psector->start_data >= track.offset_to_data_start)
+        if (track.data_size != 0 && psector->start_data >= track.offset_to_data_start)
         {
             // Adjust the start_data value by the number of bytes into the Track Record the data chunk started
             uint32_t data_offset = psector->start_data - track.offset_to_data_start;
-            memcpy(_disk_sectorbuff, track.data + data_offset, sectorsize);
+            uint32_t copy_size = sectorsize;
+            if (data_offset >= track.data_size)
+                copy_size = 0;
+            else if (data_offset + copy_size > track.data_size)
+                copy_size = track.data_size - data_offset;
+            const uint8_t *data = _atx_data != nullptr ? _atx_data + track.data_offset : track.data.get();
+            memcpy(_disk_sectorbuff, data + data_offset, copy_size);
         }
         else
         {
-            Debug_printf("## Invalid sector data offset (%lu < %lu) or track data buffer (%p)\r\n",
-                         psector->start_data, track.offset_to_data_start, track.data);
+            Debug_printf("## Invalid sector data offset (%lu < %lu) or track data size (%lu)\r\n",
+                         psector->start_data, track.offset_to_data_start, track.data_size);
             // Act as if the ATX_SECTOR_STATUS_MISSING_DATA bit was set
             _disk_controller_status |= DISK_CTRL_STATUS_SECTOR_MISSING;
         }
@@ -314,6 +353,41 @@ void MediaTypeATX::_process_sector(AtxTrack &track, AtxSector *psector, uint16_t
     }
 }
 
+// Finds the copy of the sector (there may be duplicates) closest to the current drive head position
+AtxSector *AtxTrack::find_sector(uint8_t sectornum, uint16_t current_pos)
+{
+    // Sectors are ordered by number, jump to the first copy of the one we want
+    auto it = std::lower_bound(sectors.begin(), sectors.end(), sectornum,
+                               [](const AtxSector &sector, uint8_t num) { return sector.number < num; });
+
+    AtxSector *pSector = nullptr;
+    for (; it != sectors.end() && it->number == sectornum; ++it)
+    {
+        if (pSector == nullptr)
+        {
+            pSector = &(*it);
+        }
+        else
+        // Compare the distance from the head to this sector and the head to the previous matching sector
+        {
+            int diff_this = it->position - current_pos;
+            int diff_last = pSector->position - current_pos;
+
+            // Conditions under which to replace the last matching sector:
+            if (
+                (diff_this == 0) ||                                          // We're currently over the right sector
+                (diff_this > 0 && diff_last < 0) ||                          // This sector is ahead of the current pos and the last was behind
+                (diff_this > 0 && diff_last > 0 && diff_this < diff_last) || // Both are ahead but this one is closer
+                (diff_this < 0 && diff_last < 0 && diff_this < diff_last)    // Both are behind but this one is closer
+            )
+            {
+                pSector = &(*it);
+            }
+        }
+    }
+    return pSector;
+}
+
 // Copies data for given track sector into disk buffer and sets status bits as appropriate
 // Returns TRUE on error reading sector
 bool MediaTypeATX::_copy_track_sector_data(uint8_t tracknum, uint8_t sectornum, uint16_t sectorsize)
@@ -333,36 +407,7 @@ bool MediaTypeATX::_copy_track_sector_data(uint8_t tracknum, uint8_t sectornum,
     {
         retries--;
 
-        // Iterate through every sector stored for this track and find the one closest to the current drive head position
-        uint16_t current_pos = _get_head_position();
-        AtxSector *pSector = nullptr;
-        for (auto &it : track.sectors)
-        {
-            if (it.number == sectornum)
-            {
-                if (pSector == nullptr)
-                {
-                    pSector = &it;
-                }
-                else
-                // Compare the distance from the head to this sector and the head to the previous matching sector
-                {
-                    int diff_this = it.position - current_pos;
-                    int diff_last = pSector->position - current_pos;
-
-                    // Conditions under which to replace the last matching sector:
-                    if (
-                        (diff_this == 0) ||                                          // We're currently over the right sector
-                        (diff_this > 0 && diff_last < 0) ||                          // This sector is ahead of the current pos and the last was behind
-                        (diff_this > 0 && diff_last > 0 && diff_this < diff_last) || // Both are ahead but this one is closer
-                        (diff_this < 0 && diff_last < 0 && diff_this < diff_last)    // Both are behind but this one is closer
-                    )
-                    {
-                        pSector = &it;
-                    }
-                }
-            }
-        }
+        AtxSector *pSector = track.find_sector(sectornum, _get_head_position());
 
         if (pSector != nullptr)
         {
@@ -514,8 +559,8 @@ bool MediaTypeATX::_load_atx_chunk_sector_data(chunk_header_t &chunk_hdr, AtxTra
     #endif
 
     // Just in case we already read data for this track
-    if (track.data != nullptr)
-        delete[] track.data;
+    track.data_size = 0;
+    track.data.reset();
 
     // We take the number of bytes to read from the chunk length header value
     int data_size = chunk_hdr.length - sizeof(chunk_hdr);
@@ -523,22 +568,46 @@ bool MediaTypeATX::_load_atx_chunk_sector_data(chunk_header_t &chunk_hdr, AtxTra
     // Skip if there's nothing to do
     if (data_size == 0)
         return true;
-    
-    // Attempt to the sector data
-#ifdef ESP_PLATFORM
-    track.data = (uint8_t *)heap_caps_malloc(data_size * sizeof(uint8_t), MALLOC_CAP_DEFAULT);
-#else
-    track.data = new uint8_t[data_size];
-#endif
+
+    if (data_size < 0)
+        return false;
+
+    // Sector data goes to the next free part of the image data buffer, or a buffer of its own
+    uint8_t *data;
+    if (_atx_data != nullptr)
+    {
+        if (_atx_data_used + data_size > _atx_data_size)
+        {
+            Debug_printf("sector data chunk of %d bytes doesn't fit image data buffer (%lu/%lu)\r\n",
+                         data_size, _atx_data_used, _atx_data_size);
+            return false;
+        }
+        data = _atx_data + _atx_data_used;
+    }
+    else
+    {
+        track.data.reset(_atx_track_data_alloc(data_size));
+        data = track.data.get();
+        if (data == nullptr)
+        {
+            Debug_printf("failed to allocate %d bytes for sector data chunk\r\n", data_size);
+            return false;
+        }
+    }
 
     int i;
-    if ((i = fnio::fread(track.data, 1, data_size, _disk_fileh)) != data_size)
+    if ((i = fnio::fread(data, 1, data_size, _disk_fileh)) != data_size)
     {
         Debug_printf("failed reading %d sector data chunk bytes (%d, %d)\r\n", data_size, i, errno);
-        delete[] track.data;
-        track.data = nullptr;
+        track.data.reset();
         return false;
     }
+    track.data_size = data_size;
+    if (_atx_data != nullptr)
+    {
+        track.data_offset = _atx_data_used;
+        _atx_data_used += data_size;
+    }
 
     /*
     The start_data value in each sector header is an offset into the overall Track Record,
@@ -769,6 +838,9 @@ bool MediaTypeATX::_load_atx_track_record(uint32_t length)
     while ((i = _load_atx_track_chunk(trk_hdr, track)) == 0)
         ;
 
+    // Chunks refer to sectors by index, so only now order them for lookups
+    track.sort_sectors();
+
     return i == 1; // Return FALSE on error condition
 }
 
@@ -908,14 +980,39 @@ mediatype_t MediaTypeATX::mount(fnFile *f, uint32_t disksize)
 
     _disk_fileh = f;
 
+    // Sector data can't be bigger than the image, allocate once and trim after loading
+    _atx_data_size = disksize != 0 ? disksize : hdr.end;
+    _atx_data_used = 0;
+    if (_atx_data != nullptr)
+        free(_atx_data);
+    _atx_data = _atx_data_alloc(_atx_data_size);
+    if (_atx_data == nullptr)
+    {
+        Debug_printf("no PSRAM for %lu bytes of ATX data, allocating per track\r\n", _atx_data_size);
+        _atx_data_size = 0;
+    }
+
     // Load all the actual ATX records into memory (return immediately if we fail)
     if (_load_atx_data(hdr) == false)
     {
         _disk_fileh = nullptr;
         _tracks.clear();
+        free(_atx_data);
+        _atx_data = nullptr;
         return MEDIATYPE_UNKNOWN;
     }
 
+    // Give back what the headers took, data is referenced by offsets so it may move
+    if (_atx_data != nullptr && _atx_data_used < _atx_data_size)
+    {
+        uint8_t *p = _atx_data_realloc(_atx_data, _atx_data_used > 0 ? _atx_data_used : 1);
+        if (p != nullptr)
+        {
+            _atx_data = p;
+            _atx_data_size = _atx_data_used;
+        }
+    }
+
     _disk_num_sectors = 720;
 
 #ifdef ESP_PLATFORM
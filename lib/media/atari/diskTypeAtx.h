@@ -6,6 +6,8 @@
 #include "../../include/PSRAMAllocator.h"
 #endif
 
+#include <cstdlib>
+#include <memory>
 #include <vector>
 
 #include "network.h"
@@ -137,6 +139,12 @@ public:
     AtxSector(sector_header_t & header);
 };
 
+// Frees a track's own sector data buffer
+struct AtxTrackDataFree
+{
+    void operator()(uint8_t *p) const { free(p); }
+};
+
 class AtxTrack
 {
 public:
@@ -153,18 +161,23 @@ public:
     uint32_t record_bytes_read = 0;
     uint32_t offset_to_data_start = 0;
 
-    // Actual sector data
-    uint8_t * data = nullptr;
+    // Location of the track's sector data chunk within the image data buffer (MediaTypeATX::_atx_data),
+    // or the track's own buffer when there's no PSRAM to hold the whole image
+    uint32_t data_offset = 0;
+    uint32_t data_size = 0;
+    std::unique_ptr<uint8_t, AtxTrackDataFree> data;
 
-    // Actual sectors
+    // Actual sectors, ordered by sector number once the track is loaded
 #ifdef ESP_PLATFORM
     std::vector<AtxSector,PSRAMAllocator<AtxSector>> sectors;
 #else
     std::vector<AtxSector> sectors;
 #endif
 
-    ~AtxTrack();
     AtxTrack();
+
+    void sort_sectors();
+    AtxSector *find_sector(uint8_t sectornum, uint16_t current_pos);
 };
 
 class MediaTypeATX : public MediaType
@@ -204,6 +217,11 @@ private:
     // ATX header.end - normally the size of the entire ATX file
     uint32_t _atx_size = 0;
 
+    // Sector data of all tracks, one contiguous buffer in PSRAM (nullptr if there's none)
+    uint8_t *_atx_data = nullptr;
+    uint32_t _atx_data_size = 0;
+    uint32_t _atx_data_used = 0;
+
     bool _load_atx_data(atx_header_t &atx_hdr);
     bool _load_atx_record();
     bool _load_atx_track_record(uint32_t length);
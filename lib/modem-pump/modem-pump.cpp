@@ -0,0 +1,252 @@
+/**
+ * modem data pump for FujiNet
+ */
+
+#include "modem-pump.h"
+
+#include <cstring>
+
+// The second byte of an escaped IAC, sent from here instead of copying the data
+static const uint8_t iac_byte = TELNET_IAC;
+
+bool ModemPump::service(fnTcpClient &tcp, telnet_t *telnet, uint64_t now)
+{
+    size_t moved = from_port(tcp, now);
+    moved += to_net(tcp, telnet != nullptr);
+
+    // Keep reading while the remote end sends and the computer takes it
+    size_t in;
+    do
+    {
+        in = from_net(tcp);
+        moved += in + to_port(telnet);
+    } while (in > 0);
+
+    return moved > 0;
+}
+
+bool ModemPump::escaped(uint64_t now)
+{
+    if (_escape_count < MODEM_ESCAPE_COUNT || now - _escape_time <= MODEM_ESCAPE_GUARD_MS)
+        return false;
+
+    _escape_count = 0;
+    return true;
+}
+
+void ModemPump::reset()
+{
+    _to_net.clear();
+    _to_port.clear();
+    _escape_count = 0;
+    _iac_pending = false;
+}
+
+// Only the run of escape characters at the very end matters, so look from
+// the end and stop at the first other byte instead of checking every byte.
+int ModemPump::count_escape(int count, const uint8_t *buf, size_t len)
+{
+    size_t run = 0;
+    while (run < len && buf[len - 1 - run] == MODEM_ESCAPE_CHAR)
+        run++;
+
+    if (run < len)
+        count = 0;
+    // Only "at least MODEM_ESCAPE_COUNT" matters, don't let it grow
+    count += run < MODEM_ESCAPE_COUNT ? run : MODEM_ESCAPE_COUNT;
+    return count < MODEM_ESCAPE_COUNT ? count : MODEM_ESCAPE_COUNT;
+}
+
+// Computer to buffer, read straight into the free space
+size_t ModemPump::from_port(fnTcpClient &tcp, uint64_t now)
+{
+    if (!tcp.connected())
+        return 0;
+
+    int avail = _port->port_available();
+    if (avail <= 0)
+        return 0;
+
+    uint8_t *span[2];
+    size_t span_len[2];
+    _to_net.write_spans(&span[0], &span_len[0], &span[1], &span_len[1]);
+
+    size_t total = 0;
+    for (int i = 0; i < 2 && (size_t)avail > total; i++)
+    {
+        size_t want = (size_t)avail - total;
+        if (want > span_len[i])
+            want = span_len[i];
+        if (want == 0)
+            break;
+
+        size_t got = _port->port_read(span[i], want);
+        if (got == 0)
+            break;
+
+        _escape_count = count_escape(_escape_count, span[i], got);
+        _port->port_sniff_out(span[i], got);
+        total += got;
+        if (got < want)
+            break;
+    }
+
+    if (total == 0)
+        return 0;
+
+    if (_escape_count >= MODEM_ESCAPE_COUNT)
+        _escape_time = now;
+
+    _to_net.commit(total);
+    return total;
+}
+
+/**
+ * Buffer to the remote end as one gathered write, without copying.
+ * For telnet, each IAC (0xFF) in the data has to be doubled: memchr() finds
+ * them, the data is cut after each one and a separate one byte segment
+ * sends the second IAC.
+ */
+size_t ModemPump::to_net(fnTcpClient &tcp, bool telnet)
+{
+    size_t total = 0;
+
+    while (!_to_net.empty() || _iac_pending)
+    {
+        const uint8_t *span[2];
+        size_t span_len[2];
+        _to_net.read_spans(&span[0], &span_len[0], &span[1], &span_len[1]);
+
+        fnTcpSegment segments[FNTCP_MAX_SEGMENTS];
+        int count = 0;
+        size_t wire_len = 0;
+
+        if (_iac_pending)
+            segments[count++] = {&iac_byte, 1};
+
+        bool full = false;
+        for (int i = 0; i < 2 && !full; i++)
+        {
+            const uint8_t *p = span[i];
+            size_t len = span_len[i];
+            while (len > 0)
+            {
+                // Out of segments, the rest goes in the next write
+                if (count + 2 > FNTCP_MAX_SEGMENTS)
+                {
+                    full = true;
+                    break;
+                }
+
+                const uint8_t *iac = telnet ? (const uint8_t *)memchr(p, TELNET_IAC, len) : nullptr;
+                size_t run = iac != nullptr ? iac - p + 1 : len;
+                segments[count++] = {p, run};
+                if (iac != nullptr)
+                    segments[count++] = {&iac_byte, 1};
+                p += run;
+                len -= run;
+            }
+        }
+
+        for (int i = 0; i < count; i++)
+            wire_len += segments[i].size;
+
+        int sent = tcp.write_some(segments, count);
+        if (sent <= 0)
+            break;
+
+        // Work out how many buffered bytes went out
+        size_t remaining = sent;
+        size_t used = 0;
+        for (int i = 0; i < count && remaining > 0; i++)
+        {
+            size_t n = remaining < segments[i].size ? remaining : segments[i].size;
+            remaining -= n;
+            if (segments[i].data == &iac_byte)
+                _iac_pending = false;
+            else
+            {
+                used += n;
+                if (telnet && n == segments[i].size && segments[i].data[n - 1] == TELNET_IAC)
+                    _iac_pending = true;
+            }
+        }
+
+        _to_net.discard(used);
+        total += used;
+
+        // Socket full, try again next time
+        if ((size_t)sent < wire_len)
+            break;
+    }
+
+    return total;
+}
+
+// Remote end to buffer, read straight into the free space
+size_t ModemPump::from_net(fnTcpClient &tcp)
+{
+    int avail = tcp.available();
+    if (avail <= 0)
+        return 0;
+
+    uint8_t *span[2];
+    size_t span_len[2];
+    _to_port.write_spans(&span[0], &span_len[0], &span[1], &span_len[1]);
+
+    size_t total = 0;
+    for (int i = 0; i < 2 && (size_t)avail > total; i++)
+    {
+        size_t want = (size_t)avail - total;
+        if (want > span_len[i])
+            want = span_len[i];
+        if (want == 0)
+            break;
+
+        int got = tcp.read(span[i], want);
+        if (got <= 0)
+            break;
+
+        _port->port_sniff_in(span[i], got);
+        total += got;
+        if ((size_t)got < want)
+            break;
+    }
+
+    _to_port.commit(total);
+    return total;
+}
+
+// Buffer to the computer, through telnet if the connection speaks it.
+// No more than the port has room for, the rest waits in the buffer.
+size_t ModemPump::to_port(telnet_t *telnet)
+{
+    const uint8_t *span[2];
+    size_t span_len[2];
+    _to_port.read_spans(&span[0], &span_len[0], &span[1], &span_len[1]);
+
+    size_t room = _port->port_room();
+    size_t total = 0;
+    for (int i = 0; i < 2 && span_len[i] > 0 && room > 0; i++)
+    {
+        size_t len = span_len[i] < room ? span_len[i] : room;
+        size_t n;
+        if (telnet != nullptr)
+        {
+            // The telnet event handler writes the data to the computer. Decoding
+            // only ever drops bytes, so what it writes fits in room too.
+            telnet_recv(telnet, (const char *)span[i], len);
+            n = len;
+        }
+        else
+            n = _port->port_write(span[i], len);
+
+        total += n;
+        room -= n;
+        if (n < span_len[i])
+            break;
+    }
+
+    _to_port.discard(total);
+    return total;
+}
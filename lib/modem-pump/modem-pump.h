@@ -0,0 +1,104 @@
+/**
+ * modem data pump for FujiNet
+ * moves bytes between the computer and the remote end while a modem is
+ * connected, the same for every bus.
+ */
+
+#ifndef MODEM_PUMP_H
+#define MODEM_PUMP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fnTcpClient.h"
+#include "libtelnet.h"
+#include "ringbuf.h"
+
+// Buffer each way; 4096 bytes is about a third of a second at 115200 baud
+#define MODEM_PUMP_BUF_SIZE 4096
+// Silence after "+++" before going back to command mode
+#define MODEM_ESCAPE_GUARD_MS 1000
+#define MODEM_ESCAPE_CHAR '+'
+#define MODEM_ESCAPE_COUNT 3
+
+/**
+ * The computer's side of the modem, as each bus provides it
+ */
+class ModemPort
+{
+public:
+    virtual ~ModemPort() {}
+
+    // Bytes from the computer waiting to be read
+    virtual int port_available() = 0;
+
+    // Read up to len bytes from the computer, return bytes read
+    virtual size_t port_read(uint8_t *buf, size_t len) = 0;
+
+    // Write up to len bytes to the computer, return bytes taken (less when full)
+    virtual size_t port_write(const uint8_t *buf, size_t len) = 0;
+
+    // Bytes the computer side can take right now; a port whose writes wait
+    // until the bytes are sent takes any amount
+    virtual size_t port_room() { return SIZE_MAX; }
+
+    // Bytes going out to the remote end, for the sniffer
+    virtual void port_sniff_out(const uint8_t *buf, size_t len) {}
+
+    // Bytes coming in from the remote end, for the sniffer
+    virtual void port_sniff_in(const uint8_t *buf, size_t len) {}
+};
+
+class ModemPump
+{
+public:
+    ModemPump(ModemPort *port) : _port(port) {}
+
+    ModemPump(const ModemPump &) = delete;
+    ModemPump &operator=(const ModemPump &) = delete;
+
+    /**
+     * @brief Move whatever is waiting each way
+     * @param tcp connection to the remote end
+     * @param telnet telnet state if the connection speaks telnet, otherwise nullptr
+     * @param now fnSystem.millis()
+     * @return true if any bytes moved
+     */
+    bool service(fnTcpClient &tcp, telnet_t *telnet, uint64_t now);
+
+    /**
+     * @brief Check for the escape sequence, "+++" followed by
+     * MODEM_ESCAPE_GUARD_MS of silence from the computer
+     * @return true once when it happened
+     */
+    bool escaped(uint64_t now);
+
+    // Forget buffered bytes and escape state, after a hang up
+    void reset();
+
+    // Bytes buffered toward the remote end and toward the computer
+    size_t pending_to_net() const { return _to_net.available(); }
+    size_t pending_to_port() const { return _to_port.available(); }
+
+    /**
+     * @brief Number of escape characters ending the data so far
+     * @param count the number before buf
+     */
+    static int count_escape(int count, const uint8_t *buf, size_t len);
+
+private:
+    ModemPort *_port;
+    RingBuffer<MODEM_PUMP_BUF_SIZE> _to_net;  // from the computer
+    RingBuffer<MODEM_PUMP_BUF_SIZE> _to_port; // from the remote end
+
+    int _escape_count = 0;
+    uint64_t _escape_time = 0;
+    bool _iac_pending = false; // IAC sent, its doubling not yet
+
+    size_t from_port(fnTcpClient &tcp, uint64_t now);
+    size_t to_net(fnTcpClient &tcp, bool telnet);
+    size_t from_net(fnTcpClient &tcp);
+    size_t to_port(telnet_t *telnet);
+};
+
+#endif /* MODEM_PUMP_H */
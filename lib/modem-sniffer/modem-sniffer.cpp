@@ -5,11 +5,41 @@
 
 #include <string.h>
 #include <errno.h>
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#else
+#include <system_error>
+#endif
 
 #include "modem-sniffer.h"
 
+#include "lz4.h"
+
 #include "../../include/debug.h"
 
+#include "fnSystem.h"
+
+// Worst case text for one byte, or for a direction label
+#define SNIFFER_TEXT_MARGIN 32
+#define SNIFFER_PACKED_SIZE LZ4_COMPRESSBOUND(SNIFFER_SEGMENT_SIZE)
+
+// Captures are cut into records this size, well under the ring size
+#define SNIFFER_RECORD_MAX (SNIFFER_RING_SIZE / 4)
+
+static void *sniffer_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void *p = heap_caps_malloc(size, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+    if (p == nullptr)
+        p = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+    return p;
+#else
+    return malloc(size);
+#endif
+}
+
 ModemSniffer::ModemSniffer(FileSystem *_fs, bool _enable)
 {
     // if (_fs == nullptr)
@@ -26,145 +56,430 @@ ModemSniffer::~ModemSniffer()
 {
     Debug_printf("ModemSniffer::~ModemSniffer()\n");
 
-    if (_file != nullptr)
+    stopWriter();
+    delete _ring;
+    _ring = nullptr;
+}
+
+size_t ModemSniffer::getOutputSize()
+{
+    return _log_size;
+}
+
+void ModemSniffer::closeOutput()
+{
+    Debug_print("ModemSniffer::closeOutput\n");
+
+    stopWriter();
+}
+
+bool ModemSniffer::closeOutputAndStream(const std::function<bool(const char *, size_t)> &send)
+{
+    Debug_print("ModemSniffer::closeOutputAndStream()\n");
+
+    closeOutput();
+    if (activeFS == nullptr)
+        return false;
+
+    // Stop reading as soon as send() fails
+    bool more = true;
+    auto pass = [&](const char *text, size_t len) {
+        if (more)
+            more = send(text, len);
+        return more;
+    };
+
+    bool found = false;
+    if (activeFS->exists(SNIFFER_PREVIOUS_FILE))
     {
-        Debug_printf("Closing" SNIFFER_OUTPUT_FILE "\n");
-        fclose(_file);
-        _file = nullptr;
+        if (_rotated)
+            pass("[older capture dropped]\n", 24);
+        found = streamFile(SNIFFER_PREVIOUS_FILE, pass);
     }
+    if (more)
+        found |= streamFile(SNIFFER_OUTPUT_FILE, pass);
+
+    return found;
 }
 
-size_t ModemSniffer::getOutputSize()
+// Decompress one log file a segment at a time, stopping at the first damaged one
+bool ModemSniffer::streamFile(const char *path, const std::function<bool(const char *, size_t)> &send)
+{
+    FILE *f = activeFS->file_open(path); // read-only.
+    if (f == nullptr)
+    {
+        Debug_printf("Error opening sniffer output: %d - %s\n", errno, strerror(errno));
+        return false;
+    }
+
+    char *text = (char *)sniffer_alloc(SNIFFER_SEGMENT_SIZE + SNIFFER_TEXT_MARGIN);
+    char *packed = (char *)sniffer_alloc(SNIFFER_PACKED_SIZE);
+    size_t total = 0;
+
+    segment_header h;
+    while (text != nullptr && packed != nullptr && fread(&h, sizeof(h), 1, f) == 1)
+    {
+        if (h.raw_len > SNIFFER_SEGMENT_SIZE + SNIFFER_TEXT_MARGIN || h.stored_len > SNIFFER_PACKED_SIZE ||
+            h.stored_len > h.raw_len || fread(packed, 1, h.stored_len, f) != h.stored_len)
+            break;
+
+        const char *out = packed;
+        if (h.stored_len < h.raw_len)
+        {
+            if (LZ4_decompress_safe(packed, text, h.stored_len, h.raw_len) != (int)h.raw_len)
+                break;
+            out = text;
+        }
+
+        total += h.raw_len;
+        if (!send(out, h.raw_len))
+            break;
+    }
+
+    Debug_printf("Sent %u bytes from %s\n", (unsigned)total, path);
+
+    free(text);
+    free(packed);
+    fclose(f);
+    return true;
+}
+
+void ModemSniffer::restartOutput()
 {
     if (_file != nullptr)
-        return FileSystem::filesize(_file);
+        fclose(_file);
 
-    long result = activeFS->filesize(SNIFFER_OUTPUT_FILE);
+    activeFS->remove(SNIFFER_PREVIOUS_FILE);
+    _file = activeFS->file_open(SNIFFER_OUTPUT_FILE, "wb"); // This should create/truncate the file
+    _file_size = 0;
+    _file_text = 0;
+    _previous_text = 0;
+    _log_size = 0;
+    _rotated = false;
 
-    return result == -1 ? 0 : result;
+    Debug_printf("ModemSniffer::restartOutput(%p)\n", _file);
 }
 
-void ModemSniffer::closeOutput()
+void ModemSniffer::rotateOutput()
 {
-    Debug_print("ModemSniffer::closeOutput\n");
+    fclose(_file);
 
-#ifdef ESP_PLATFORM
-// jk: why?
-    if (_file == nullptr)
+    if (_previous_text > 0)
+        _rotated = true;
+    activeFS->remove(SNIFFER_PREVIOUS_FILE);
+    activeFS->rename(SNIFFER_OUTPUT_FILE, SNIFFER_PREVIOUS_FILE);
+    _file = activeFS->file_open(SNIFFER_OUTPUT_FILE, "wb");
+    _previous_text = _file_text;
+    _file_text = 0;
+    _file_size = 0;
+    _log_size = _previous_text;
+
+    Debug_printf("ModemSniffer::rotateOutput(%p)\n", _file);
+}
+
+void ModemSniffer::dumpInput(const uint8_t *buf, unsigned short len)
+{
+    capture(INPUT, buf, len);
+}
+
+void ModemSniffer::dumpOutput(const uint8_t *buf, unsigned short len)
+{
+    capture(OUTPUT, buf, len);
+}
+
+/**
+ * Bus side: copy the bytes into the ring and return, the writer task does
+ * the rest. When the ring is full the bytes are counted and dropped rather
+ * than slowing down the modem. Only one thread may capture.
+ */
+void ModemSniffer::capture(_direction dir, const uint8_t *buf, size_t len)
+{
+    if (enable == false)
+        return;
+
+    if (!_running)
+        startWriter();
+    if (!_running)
+        return;
+
+    while (len > 0)
     {
-        _file = activeFS->file_open(SNIFFER_OUTPUT_FILE, "r+"); // Seeks don't work right if we use "append" mode - use "r+"
-        
-        if (_file == nullptr)
+        size_t n = len < SNIFFER_RECORD_MAX ? len : SNIFFER_RECORD_MAX;
+        record_header h = {(uint8_t)dir, (uint8_t)(n & 0xFF), (uint8_t)(n >> 8)};
+
+        uint8_t *span[2];
+        size_t span_len[2];
+        if (_ring->write_spans(&span[0], &span_len[0], &span[1], &span_len[1]) < sizeof(h) + n)
         {
-            Debug_printf("Error opening sniffer output: %d\n", errno);
+            _dropped += len;
             return;
         }
 
-        fseek(_file, 0, SEEK_END);
+        // Header and data go in together, so the writer never sees half a record
+        size_t pos = 0;
+        auto put = [&](const uint8_t *src, size_t count) {
+            if (pos < span_len[0])
+            {
+                size_t first = span_len[0] - pos < count ? span_len[0] - pos : count;
+                memcpy(span[0] + pos, src, first);
+                src += first;
+                count -= first;
+                pos += first;
+            }
+            if (count > 0)
+            {
+                memcpy(span[1] + (pos - span_len[0]), src, count);
+                pos += count;
+            }
+        };
+        put((const uint8_t *)&h, sizeof(h));
+        put(buf, n);
+        _ring->commit(pos);
+
+        buf += n;
+        len -= n;
+    }
+}
+
+void ModemSniffer::startWriter()
+{
+    std::lock_guard<std::mutex> lock(_task_mutex);
+
+    if (_running || activeFS == nullptr)
+        return;
+
+    if (_ring == nullptr)
+        _ring = new (std::nothrow) RingBuffer<SNIFFER_RING_SIZE>;
+    _text = (char *)sniffer_alloc(SNIFFER_SEGMENT_SIZE + SNIFFER_TEXT_MARGIN);
+    _packed = (char *)sniffer_alloc(SNIFFER_PACKED_SIZE);
+    _lz4_state = sniffer_alloc(LZ4_sizeofState());
+    if (_ring != nullptr && _text != nullptr && _packed != nullptr && _lz4_state != nullptr)
+        restartOutput();
+
+    if (_file == nullptr)
+    {
+        // Don't try again for every byte
+        Debug_printf("ModemSniffer: can't start capture, sniffer disabled\n");
+        enable = false;
+        freeWriter();
+        return;
+    }
+
+    _ring->clear();
+    _dropped = 0;
+    _text_len = 0;
+    direction = INIT;
+    _stop = false;
+
+#ifdef ESP_PLATFORM
+    _task_done = xSemaphoreCreateBinary();
+    if (_task_done != nullptr &&
+        xTaskCreate(writer_task, "sniffer", SNIFFER_STACKSIZE, this, SNIFFER_PRIORITY, nullptr) == pdPASS)
+        _running = true;
+#else
+    try
+    {
+        _writer = std::thread([this]() { writeLoop(); });
+        _running = true;
+    }
+    catch (const std::system_error &e)
+    {
     }
 #endif
 
-    if (_file != nullptr)
+    if (!_running)
     {
-        // Close the file
-        fflush(_file);
-        fclose(_file);
-        _file = nullptr;
+        Debug_printf("ModemSniffer: can't start writer task\n");
+        enable = false;
+        freeWriter();
     }
 }
 
-FILE *ModemSniffer::closeOutputAndProvideReadHandle()
+// Waits for the writer task to write out what's left
+void ModemSniffer::stopWriter()
 {
-    Debug_print("ModemSniffer::closeOutputAndProvideReadHandle()\n");
+    std::lock_guard<std::mutex> lock(_task_mutex);
 
-    closeOutput();
-    FILE *result = activeFS->file_open(SNIFFER_OUTPUT_FILE); // read-only.
-    if (result == nullptr)
+    if (_running)
     {
-        Debug_printf("Error opening sniffer output: %d - %s\n", errno, strerror(errno));
+        _stop = true;
+#ifdef ESP_PLATFORM
+        xSemaphoreTake(_task_done, portMAX_DELAY);
+#else
+        _writer.join();
+#endif
+        _running = false;
     }
 
-    return result;
+    freeWriter();
 }
 
-void ModemSniffer::restartOutput()
+void ModemSniffer::freeWriter()
 {
+#ifdef ESP_PLATFORM
+    if (_task_done != nullptr)
+        vSemaphoreDelete(_task_done);
+    _task_done = nullptr;
+#endif
+
     if (_file != nullptr)
+    {
         fclose(_file);
+        _file = nullptr;
+    }
 
-    _file = activeFS->file_open(SNIFFER_OUTPUT_FILE, "wb"); // This should create/truncate the file
+    free(_text);
+    free(_packed);
+    free(_lz4_state);
+    _text = _packed = nullptr;
+    _lz4_state = nullptr;
+}
 
-    Debug_printf("ModemSniffer::restartOutput(%p)\n", _file);
+#ifdef ESP_PLATFORM
+void ModemSniffer::writer_task(void *arg)
+{
+    ModemSniffer *sniffer = (ModemSniffer *)arg;
+    sniffer->writeLoop();
+    xSemaphoreGive(sniffer->_task_done);
+    vTaskDelete(NULL);
 }
+#endif
 
-void ModemSniffer::dumpInput(uint8_t *buf, unsigned short len)
+void ModemSniffer::writeLoop()
 {
-    if (enable == false)
-        return;
+    uint64_t last = fnSystem.millis();
 
-    if (_file == nullptr)
+    while (!_stop)
     {
-        restartOutput();
+        if (drain())
+            last = fnSystem.millis();
+        else if (_text_len > 0 && fnSystem.millis() - last >= SNIFFER_IDLE_FLUSH_MS)
+            writeSegment();
+
+        fnSystem.delay(SNIFFER_DRAIN_MS);
+    }
+
+    drain();
+    writeSegment();
+}
+
+// Format everything in the ring, return true if there was anything
+bool ModemSniffer::drain()
+{
+    bool any = false;
+
+    uint32_t dropped = _dropped.exchange(0);
+    if (dropped > 0)
+    {
+        char note[48];
+        int n = snprintf(note, sizeof(note), "\n\n[%lu bytes not captured]", (unsigned long)dropped);
+        append(note, n);
+        direction = INIT;
+        any = true;
     }
 
-    if (direction != INPUT)
+    record_header h;
+    while (_ring->available() >= sizeof(h))
     {
-        fprintf(_file, "\n\nINCOMING: ");
-        Debug_printf("\n\nINCOMING: ");
+        _ring->pop((uint8_t *)&h, sizeof(h));
+        size_t len = h.len_lo | (h.len_hi << 8);
+
+        const uint8_t *span[2];
+        size_t span_len[2];
+        _ring->read_spans(&span[0], &span_len[0], &span[1], &span_len[1]);
+        size_t first = span_len[0] < len ? span_len[0] : len;
+        format(h.dir, span[0], first);
+        format(h.dir, span[1], len - first);
+        _ring->discard(len);
+        any = true;
     }
 
-    direction = INPUT;
+    return any;
+}
+
+void ModemSniffer::format(uint8_t dir, const uint8_t *buf, size_t len)
+{
+    static const char hex_lower[] = "0123456789abcdef";
+    static const char hex_upper[] = "0123456789ABCDEF";
 
-    for (int i = 0; i < len; i++)
+    if (len > 0 && direction != dir)
     {
+        if (dir == INPUT)
+            append("\n\nINCOMING: ", 12);
+        else
+            append("\n\nOUTGOING: ", 12);
+        direction = (_direction)dir;
+    }
+
+    // Incoming bytes have always been shown in lower case hex, outgoing in upper case
+    const char *hex = dir == INPUT ? hex_lower : hex_upper;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (_text_len + SNIFFER_TEXT_MARGIN > SNIFFER_SEGMENT_SIZE)
+            writeSegment();
+
+        char *p = _text + _text_len;
         if (buf[i] > 0x20 && buf[i] < 0x7F)
         {
             // Printable ASCII character.
-            fprintf(_file, "'%c' ", buf[i]);
-            Debug_printf("'%c' ", buf[i]);
+            p[0] = '\'';
+            p[1] = buf[i];
+            p[2] = '\'';
+            p[3] = ' ';
+            _text_len += 4;
         }
         else
         {
             // non-printable ASCII character.
-            fprintf(_file, "%02x ", buf[i]);
-            Debug_printf("%02x ", buf[i]);
+            p[0] = hex[buf[i] >> 4];
+            p[1] = hex[buf[i] & 0x0F];
+            p[2] = ' ';
+            _text_len += 3;
         }
     }
-    fflush(_file);
 }
 
-void ModemSniffer::dumpOutput(uint8_t *buf, unsigned short len)
+void ModemSniffer::append(const char *text, size_t len)
 {
-    if (enable == false)
-        return;
+    if (_text_len + len + SNIFFER_TEXT_MARGIN > SNIFFER_SEGMENT_SIZE)
+        writeSegment();
+    memcpy(_text + _text_len, text, len);
+    _text_len += len;
+}
 
-    if (_file == nullptr)
+// Compress the text so far and append it to the log, rotating when the file is full
+void ModemSniffer::writeSegment()
+{
+    if (_text_len == 0 || _file == nullptr)
     {
-        restartOutput();
+        _text_len = 0;
+        return;
     }
 
-    if (direction != OUTPUT)
+    segment_header h;
+    h.raw_len = _text_len;
+    int packed = LZ4_compress_fast_extState(_lz4_state, _text, _packed, (int)_text_len, SNIFFER_PACKED_SIZE, 1);
+    const char *data = _packed;
+    if (packed <= 0 || (size_t)packed >= _text_len)
     {
-        fprintf(_file, "\n\nOUTGOING: ");
-        Debug_printf("\n\nOUTGOING: ");
+        // Didn't shrink, store it as it is
+        h.stored_len = _text_len;
+        data = _text;
     }
+    else
+        h.stored_len = packed;
 
-    direction = OUTPUT;
+    size_t size = sizeof(h) + h.stored_len;
+    if (_file_size > 0 && _file_size + size > SNIFFER_LOG_MAX / 2)
+        rotateOutput();
 
-    for (int i = 0; i < len; i++)
+    if (_file != nullptr && fwrite(&h, sizeof(h), 1, _file) == 1 && fwrite(data, 1, h.stored_len, _file) == h.stored_len)
     {
-        if (buf[i] > 0x20 && buf[i] < 0x7F)
-        {
-            // Printable ASCII character.
-            fprintf(_file, "'%c' ", buf[i]);
-            Debug_printf("'%c' ", buf[i]);
-        }
-        else
-        {
-            // non-printable ASCII character.
-            fprintf(_file, "%02X ", buf[i]);
-            Debug_printf("%02X ", buf[i]);
-        }
+        fflush(_file);
+        _file_size += size;
+        _file_text += _text_len;
+        _log_size = _previous_text + _file_text;
     }
-    fflush(_file);
+
+    _text_len = 0;
 }
@@ -1,22 +1,57 @@
 /**
  * modem sniffer library for FujiNet
  * logs character streams from MODEM.
+ *
+ * The bus side only copies the bytes into a lock-free ring. A background
+ * task drains the ring, formats the text, and appends it to the log in
+ * LZ4 compressed segments. The log rotates between two files, so it never
+ * grows past SNIFFER_LOG_MAX.
  */
 
 #ifndef MODEM_SNIFFER_H
 #define MODEM_SNIFFER_H
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
 
 #include <stdio.h>
 
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
 #include "fnFS.h"
+#include "ringbuf.h"
 
 
 // using namespace std;
 
 #define SNIFFER_OUTPUT_FILE "/rs232dump"
+// The log before the last rotation
+#define SNIFFER_PREVIOUS_FILE "/rs232dump.1"
+
+// Capture ring between the bus and the writer task; bytes beyond it are dropped, not waited for
+#define SNIFFER_RING_SIZE 8192
+// Formatted text per compressed segment
+#define SNIFFER_SEGMENT_SIZE 4096
+// Both log files together, compressed
+#ifndef SNIFFER_LOG_MAX
+#define SNIFFER_LOG_MAX (256 * 1024)
+#endif
+// How often the writer task drains the ring
+#define SNIFFER_DRAIN_MS 20
+// Write a partial segment after this long without new bytes
+#define SNIFFER_IDLE_FLUSH_MS 2000
+
+#define SNIFFER_STACKSIZE 4096
+#define SNIFFER_PRIORITY 2
 
 class ModemSniffer
 {
@@ -35,29 +70,31 @@ public:
     virtual ~ModemSniffer();
 
     /**
-     * Return the output size of the current dump file
+     * Return the size of the captured text, uncompressed
      */
     size_t getOutputSize();
 
     /**
-     * Close the dump output
+     * Write out everything captured so far and close the log
      */
     void closeOutput();
 
     /**
-     * Dump output to file
+     * Capture bytes going to the remote end
      */
-    void dumpOutput(uint8_t *buf, unsigned short len);
+    void dumpOutput(const uint8_t *buf, unsigned short len);
 
     /**
-     * Dump input to file
+     * Capture bytes coming from the remote end
      */
-    void dumpInput(uint8_t *buf, unsigned short len);
+    void dumpInput(const uint8_t *buf, unsigned short len);
 
     /**
-     * Close output, and return a R/O file handle for web interface.
+     * @brief Close output, then pass the decompressed log to send, oldest first
+     * @param send called with each piece of text, returns false to stop
+     * @return false if there is no log
      */
-    FILE *closeOutputAndProvideReadHandle();
+    bool closeOutputAndStream(const std::function<bool(const char *, size_t)> &send);
 
     /**
      * Set enable flag
@@ -91,6 +128,56 @@ private:
         OUTPUT
     } direction;
 
+    // Each capture in the ring is a direction byte and a 16 bit length, then the data
+    struct record_header
+    {
+        uint8_t dir;
+        uint8_t len_lo;
+        uint8_t len_hi;
+    };
+
+    // Each segment in the log files: text length, then stored length (equal if not compressed)
+    struct segment_header
+    {
+        uint32_t raw_len;
+        uint32_t stored_len;
+    };
+
+    RingBuffer<SNIFFER_RING_SIZE> *_ring = nullptr;
+    std::atomic<uint32_t> _dropped{0}; // bytes the ring had no room for
+
+    std::mutex _task_mutex; // start and stop only, never taken for a capture
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _stop{false};
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t _task_done = nullptr;
+    static void writer_task(void *arg);
+#else
+    std::thread _writer;
+#endif
+
+    // Writer task state
+    char *_text = nullptr;  // formatted text of the segment being built
+    size_t _text_len = 0;
+    char *_packed = nullptr; // compressed segment
+    void *_lz4_state = nullptr;
+    size_t _file_size = 0;     // compressed bytes in SNIFFER_OUTPUT_FILE
+    size_t _file_text = 0;     // text bytes in SNIFFER_OUTPUT_FILE
+    size_t _previous_text = 0; // text bytes in SNIFFER_PREVIOUS_FILE
+    std::atomic<size_t> _log_size{0};
+    bool _rotated = false;  // the oldest text has been dropped
+
+    void capture(_direction dir, const uint8_t *buf, size_t len);
+    void startWriter();
+    void stopWriter();
+    void freeWriter();
+    void writeLoop();
+    bool drain();
+    void format(uint8_t dir, const uint8_t *buf, size_t len);
+    void append(const char *text, size_t len);
+    void writeSegment();
+    bool streamFile(const char *path, const std::function<bool(const char *, size_t)> &send);
+
 protected:
     /**
      * Pointer to ESP32 filesystem
@@ -103,15 +190,15 @@ protected:
     FILE *_file = nullptr;
 
     /**
-     * Output buffer
+     * Recreate SNIFFER_OUTPUT_FILE
      */
-    std::string outputBuffer;
+    void restartOutput();
 
     /**
-     * Recreate SNIFFER_OUTPUT_FILE
+     * Start a new SNIFFER_OUTPUT_FILE, keeping the current one as SNIFFER_PREVIOUS_FILE
      */
-    void restartOutput();
+    void rotateOutput();
 
 };
 
-#endif /* MODEM_SNIFFER_H */
\ No newline at end of file
+#endif /* MODEM_SNIFFER_H */
@@ -13,56 +13,13 @@
 #include "status_error_codes.h"
 #include "utils.h"
 #include "string_utils.h"
+#include "Translation.h"
 
 #include <vector>
 
 
 using namespace std;
 
-#define ASCII_BELL 0x07
-#define ASCII_BACKSPACE 0x08
-#define ASCII_TAB 0x09
-#define ASCII_LF 0x0A
-#define ASCII_CR 0x0D
-#define ATASCII_EOL 0x9B
-#define ATASCII_DEL 0x7E
-#define ATASCII_TAB 0x7F
-#define ATASCII_BUZZER 0xFD
-
-#define STR_ASCII_BELL "\x07"
-#define STR_ASCII_BACKSPACE "\x08"
-#define STR_ASCII_TAB "\x09"
-#define STR_ASCII_LF "\x0a"
-#define STR_ASCII_CR "\x0d"
-#define STR_ASCII_CRLF "\x0d\x0a"
-#define STR_ATASCII_EOL "\x9b"
-#define STR_ATASCII_DEL "\x7e"
-#define STR_ATASCII_TAB "\x7f"
-#define STR_ATASCII_BUZZER "\xfd"
-
-/**
- * NWD
- * We only have 2 bits for translations (see NetworkProtocol::open)
- * but we need to translate LF to CR or CRLF to just CR
- * The only solution is to change the behaviour of the Apple2
- * version.  It may make more sense to have the Atari be the odd
- * one in the future rather than the Apple2
- */
-
-#ifdef BUILD_APPLE
-#define EOL 0x0D
-#define STR_EOL "\x0d"
-#else
-#define EOL 0x9B
-#define STR_EOL "\x9b"
-#endif
-
-
-#define TRANSLATION_MODE_NONE 0
-#define TRANSLATION_MODE_CR 1
-#define TRANSLATION_MODE_LF 2
-#define TRANSLATION_MODE_CRLF 3
-#define TRANSLATION_MODE_PETSCII 4
 
 /**
  * ctor - Initialize network protocol object.
@@ -206,36 +163,7 @@ void NetworkProtocol::translate_receive_buffer()
     if (translation_mode == 0)
         return;
 
-    #ifdef BUILD_ATARI
-    replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_BELL, ATASCII_BUZZER);
-    replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_BACKSPACE, ATASCII_DEL);
-    replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_TAB, ATASCII_TAB);
-    #endif   
-
-    switch (translation_mode)
-    {
-    case TRANSLATION_MODE_CR:
-        replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_CR, EOL);
-        break;
-    case TRANSLATION_MODE_LF:
-        replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_LF, EOL);
-        break;
-    case TRANSLATION_MODE_CRLF:
-    #ifndef BUILD_APPLE
-        // With Apple2, we would be translating CR to CR; a waste of CPU
-        replace(receiveBuffer->begin(), receiveBuffer->end(), ASCII_CR, EOL);
-    #endif
-        break;
-    case TRANSLATION_MODE_PETSCII:
-#ifdef VERBOSE_PROTOCOL
-        Debug_printf("!!! PETSCII !!!\r\n");
-#endif
-        *receiveBuffer = mstr::toUTF8(*receiveBuffer);
-        break;
-    }
-
-    if (translation_mode == TRANSLATION_MODE_CRLF)
-        receiveBuffer->erase(std::remove(receiveBuffer->begin(), receiveBuffer->end(), '\n'), receiveBuffer->end());
+    NetworkTranslation::get(translation_mode, NetworkTranslation::DIRECTION_RECEIVE)->apply(*receiveBuffer);
 }
 
 /**
@@ -250,27 +178,7 @@ unsigned short NetworkProtocol::translate_transmit_buffer()
     if (translation_mode == 0)
         return transmitBuffer->length();
 
-    #ifdef BUILD_ATARI
-    util_replaceAll(*transmitBuffer, STR_ATASCII_BUZZER, STR_ASCII_BELL);
-    util_replaceAll(*transmitBuffer, STR_ATASCII_DEL, STR_ASCII_BACKSPACE);
-    util_replaceAll(*transmitBuffer, STR_ATASCII_TAB, STR_ASCII_TAB);
-    #endif
-
-    switch (translation_mode)
-    {
-    case TRANSLATION_MODE_CR:
-        util_replaceAll(*transmitBuffer, STR_EOL, STR_ASCII_CR);
-        break;
-    case TRANSLATION_MODE_LF:
-        util_replaceAll(*transmitBuffer, STR_EOL, STR_ASCII_LF);
-        break;
-    case TRANSLATION_MODE_CRLF:
-        util_replaceAll(*transmitBuffer, STR_EOL, STR_ASCII_CRLF);
-        break;
-    case TRANSLATION_MODE_PETSCII:
-        *transmitBuffer = mstr::toUTF8(*transmitBuffer);
-        break;
-    }
+    NetworkTranslation::get(translation_mode, NetworkTranslation::DIRECTION_TRANSMIT)->apply(*transmitBuffer);
 
     return transmitBuffer->length();
 }
@@ -181,6 +181,12 @@ public:
      */
     virtual bool status(NetworkStatus *status);
 
+    /**
+     * @brief Return socket which becomes readable when status() may change.
+     * @return socket descriptor, or -1 if status() has to be polled.
+     */
+    virtual int get_fd() { return -1; }
+
     /**
      * @brief Return a DSTATS byte for a requested COMMAND byte.
      * @param cmd The Command (0x00-0xFF) for which DSTATS is requested.
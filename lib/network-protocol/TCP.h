@@ -56,6 +56,11 @@ public:
      */
     virtual bool status(NetworkStatus *status);
 
+    /**
+     * @brief Return client socket, -1 if not connected.
+     */
+    virtual int get_fd() { return client.fd(); }
+
     /**
      * @brief Return a DSTATS byte for a requested COMMAND byte.
      * @param cmd The Command (0x00-0xFF) for which DSTATS is requested.
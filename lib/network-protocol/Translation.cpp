@@ -0,0 +1,233 @@
+/**
+ * Network Protocol translation tables
+ */
+
+#include "Translation.h"
+
+#include <mutex>
+
+#include "string_utils.h"
+
+#define ASCII_BELL 0x07
+#define ASCII_BACKSPACE 0x08
+#define ASCII_TAB 0x09
+#define ASCII_LF 0x0A
+#define ASCII_CR 0x0D
+#define ATASCII_EOL 0x9B
+#define ATASCII_DEL 0x7E
+#define ATASCII_TAB 0x7F
+#define ATASCII_BUZZER 0xFD
+
+/**
+ * NWD
+ * We only have 2 bits for translations (see NetworkProtocol::open)
+ * but we need to translate LF to CR or CRLF to just CR
+ * The only solution is to change the behaviour of the Apple2
+ * version.  It may make more sense to have the Atari be the odd
+ * one in the future rather than the Apple2
+ */
+
+#ifdef BUILD_APPLE
+#define EOL 0x0D
+#else
+#define EOL 0x9B
+#endif
+
+// Modes above PETSCII only get the platform mappings, so they share a slot.
+#define TRANSLATION_SLOTS (TRANSLATION_MODE_PETSCII + 2)
+
+static std::mutex _tables_mutex;
+static NetworkTranslation *_tables[NetworkTranslation::DIRECTION_COUNT][TRANSLATION_SLOTS];
+
+const NetworkTranslation *NetworkTranslation::get(unsigned char mode, direction_t dir)
+{
+    unsigned char slot = mode <= TRANSLATION_MODE_PETSCII ? mode : TRANSLATION_MODE_PETSCII + 1;
+
+    std::lock_guard<std::mutex> lock(_tables_mutex);
+    if (_tables[dir][slot] == nullptr)
+        _tables[dir][slot] = new NetworkTranslation(mode, dir);
+
+    return _tables[dir][slot];
+}
+
+NetworkTranslation::NetworkTranslation(unsigned char mode, direction_t dir)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        std::string out = translate_byte(mode, dir, (char)i);
+
+        table[i].len = out.size();
+        out.copy(table[i].out, sizeof(table[i].out));
+
+        if (out.size() > 1)
+            expands = true;
+
+        if (out.size() != 1 || (uint8_t)out[0] != i)
+            identity = false;
+    }
+}
+
+/**
+ * Reference translation of a single byte, used to build the table. The
+ * steps (and their order) are those the protocols have always applied to
+ * whole buffers; each is per-byte, so their composition is too.
+ */
+std::string NetworkTranslation::translate_byte(unsigned char mode, direction_t dir, char c) const
+{
+    std::string s(1, c);
+
+    if (mode == TRANSLATION_MODE_NONE)
+        return s;
+
+    if (dir == DIRECTION_RECEIVE)
+    {
+#ifdef BUILD_ATARI
+        if (c == ASCII_BELL)
+            s[0] = (char)ATASCII_BUZZER;
+        else if (c == ASCII_BACKSPACE)
+            s[0] = (char)ATASCII_DEL;
+        else if (c == ASCII_TAB)
+            s[0] = (char)ATASCII_TAB;
+#endif
+
+        switch (mode)
+        {
+        case TRANSLATION_MODE_CR:
+            if (s[0] == ASCII_CR)
+                s[0] = (char)EOL;
+            break;
+        case TRANSLATION_MODE_LF:
+            if (s[0] == ASCII_LF)
+                s[0] = (char)EOL;
+            break;
+        case TRANSLATION_MODE_CRLF:
+            if (s[0] == ASCII_CR)
+                s[0] = (char)EOL;
+            else if (s[0] == ASCII_LF)
+                s.clear();
+            break;
+        case TRANSLATION_MODE_PETSCII:
+            s = mstr::toUTF8(s);
+            break;
+        }
+    }
+    else
+    {
+#ifdef BUILD_ATARI
+        if ((uint8_t)c == ATASCII_BUZZER)
+            s[0] = ASCII_BELL;
+        else if ((uint8_t)c == ATASCII_DEL)
+            s[0] = ASCII_BACKSPACE;
+        else if ((uint8_t)c == ATASCII_TAB)
+            s[0] = ASCII_TAB;
+#endif
+
+        switch (mode)
+        {
+        case TRANSLATION_MODE_CR:
+            if ((uint8_t)s[0] == EOL)
+                s[0] = ASCII_CR;
+            break;
+        case TRANSLATION_MODE_LF:
+            if ((uint8_t)s[0] == EOL)
+                s[0] = ASCII_LF;
+            break;
+        case TRANSLATION_MODE_CRLF:
+            if ((uint8_t)s[0] == EOL)
+                s = "\x0d\x0a";
+            break;
+        case TRANSLATION_MODE_PETSCII:
+            s = mstr::toUTF8(s);
+            break;
+        }
+    }
+
+    return s;
+}
+
+void NetworkTranslation::apply(std::string &buf) const
+{
+    if (identity || buf.empty())
+        return;
+
+    size_t in_len = buf.size();
+
+    if (!expands)
+    {
+        // Output never outruns input: map and compact front to back.
+        char *p = &buf[0];
+        size_t w = 0;
+
+        for (size_t r = 0; r < in_len; r++)
+        {
+            const entry_t &e = table[(uint8_t)p[r]];
+            if (e.len != 0)
+                p[w++] = e.out[0];
+        }
+
+        if (w != in_len)
+            buf.resize(w);
+        return;
+    }
+
+    // Work out the output size, and whether the output ever lags (drops)
+    // or leads (expansions) the input, to pick a safe in-place direction.
+    size_t out_len = 0;
+    bool lags = false;
+    bool leads = false;
+    {
+        const char *p = buf.data();
+        for (size_t r = 0; r < in_len; r++)
+        {
+            out_len += table[(uint8_t)p[r]].len;
+            if (out_len < r + 1)
+                lags = true;
+            else if (out_len > r + 1)
+                leads = true;
+        }
+    }
+
+    if (!leads)
+    {
+        char *p = &buf[0];
+        size_t w = 0;
+
+        for (size_t r = 0; r < in_len; r++)
+        {
+            const entry_t &e = table[(uint8_t)p[r]];
+            for (uint8_t i = 0; i < e.len; i++)
+                p[w++] = e.out[i];
+        }
+
+        buf.resize(w);
+    }
+    else if (!lags)
+    {
+        // Grow once, then fill back to front so writes stay behind reads.
+        buf.resize(out_len);
+        char *p = &buf[0];
+        size_t w = out_len;
+
+        for (size_t r = in_len; r-- > 0;)
+        {
+            const entry_t &e = table[(uint8_t)p[r]];
+            for (uint8_t i = e.len; i-- > 0;)
+                p[--w] = e.out[i];
+        }
+    }
+    else
+    {
+        // Both drops and expansions with crossing positions; translate
+        // into a scratch buffer instead.
+        std::string out;
+        out.reserve(out_len);
+
+        for (size_t r = 0; r < in_len; r++)
+        {
+            const entry_t &e = table[(uint8_t)buf[r]];
+            out.append(e.out, e.len);
+        }
+
+        buf.swap(out);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef NETWORKTRANSLATION_H
+#define NETWORKTRANSLATION_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Translation modes, set from aux2 (see NetworkProtocol::open)
+ */
+#define TRANSLATION_MODE_NONE 0
+#define TRANSLATION_MODE_CR 1
+#define TRANSLATION_MODE_LF 2
+#define TRANSLATION_MODE_CRLF 3
+#define TRANSLATION_MODE_PETSCII 4
+
+/**
+ * Byte-wise translation of network data shared by all protocols.
+ *
+ * Every translation mode is compiled, per direction, into one 256-entry
+ * table giving the 0-3 bytes each input byte becomes. apply() then runs a
+ * single in-place pass over the buffer, only growing it when the mode can
+ * expand bytes (EOL to CRLF, PETSCII to UTF-8).
+ */
+class NetworkTranslation
+{
+public:
+    enum direction_t
+    {
+        DIRECTION_RECEIVE = 0,
+        DIRECTION_TRANSMIT,
+        DIRECTION_COUNT
+    };
+
+    /**
+     * Return the (lazily built, shared) table for a mode and direction.
+     * @param mode translation_mode from the protocol
+     * @param dir DIRECTION_RECEIVE or DIRECTION_TRANSMIT
+     * @return translation table, never nullptr.
+     */
+    static const NetworkTranslation *get(unsigned char mode, direction_t dir);
+
+    /**
+     * Translate buf in place.
+     * @param buf the buffer to translate
+     */
+    void apply(std::string &buf) const;
+
+    /**
+     * @return true if this table leaves every byte unchanged.
+     */
+    bool is_identity() const { return identity; }
+
+private:
+    struct entry_t
+    {
+        uint8_t len;
+        char out[3];
+    };
+
+    entry_t table[256];
+    bool expands = false;
+    bool identity = true;
+
+    NetworkTranslation(unsigned char mode, direction_t dir);
+
+    std::string translate_byte(unsigned char mode, direction_t dir, char c) const;
+};
+
+#endif /* NETWORKTRANSLATION_H */
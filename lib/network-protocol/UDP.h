@@ -54,6 +54,11 @@ public:
      */
     virtual bool status(NetworkStatus *status);
 
+    /**
+     * @brief Return UDP socket, -1 if not open.
+     */
+    virtual int get_fd() { return udp.fd(); }
+
     /**
      * @brief Return a DSTATS byte for a requested COMMAND byte.
      * @param cmd The Command (0x00-0xFF) for which DSTATS is requested.
@@ -1,5 +1,7 @@
 #include "png_printer.h"
 
+#include "checksum.h"
+
 #include "../../include/debug.h"
 
 
@@ -15,61 +17,14 @@ void pngPrinter::uint32_to_array(uint32_t src, uint8_t dest[4])
     dest[3] = (uint8_t)(src & 0xff);
 }
 
-uint32_t pngPrinter::update_adler32(uint32_t adler, uint8_t data)
+uint32_t pngPrinter::update_adler32(uint32_t adler, const uint8_t *buf, size_t len)
 {
-    // https://gist.github.com/kornelski/710db9d30a64db0807c5bfbdbdecf85e
-    unsigned s1 = adler & 0xffff;
-    unsigned s2 = (adler >> 16) & 0xffff;
-
-    s1 += data;
-    s1 %= 65521;
-
-    s2 += s1;
-    s2 %= 65521;
-
-    return (s2 << 16) | s1;
+    return Checksum::adler32(adler, buf, len);
 }
 
 uint32_t pngPrinter::rc_crc32(uint32_t crc, const uint8_t *buf, size_t len)
-// https://rosettacode.org/wiki/CRC-32#Implementation_2
 {
-    static uint32_t table[256];
-    static int have_table = 0;
-    uint32_t rem;
-    uint8_t octet;
-    int i, j;
-    const uint8_t *p, *q;
-
-    /* This check is not thread safe; there is no mutex. */
-    if (have_table == 0)
-    {
-        /* Calculate CRC table. */
-        for (i = 0; i < 256; i++)
-        {
-            rem = i; /* remainder from polynomial division */
-            for (j = 0; j < 8; j++)
-            {
-                if (rem & 1)
-                {
-                    rem >>= 1;
-                    rem ^= 0xedb88320;
-                }
-                else
-                    rem >>= 1;
-            }
-            table[i] = rem;
-        }
-        have_table = 1;
-    }
-
-    crc = ~crc;
-    q = buf + len;
-    for (p = buf; p < q; p++)
-    {
-        octet = *p; /* Cast to unsigned octet. */
-        crc = (crc >> 8) ^ table[(crc & 0xff) ^ octet];
-    }
-    return ~crc;
+    return Checksum::crc32(crc, buf, len);
 }
 
 // uint32_t pngPrinter::rc_crc32(uint32_t crc, uint8_t c)
@@ -228,8 +183,8 @@ void pngPrinter::png_data()
 
     // Compute data size
     // imgSize = (width + 1) * height; // +1 per line for filter 0's
-    uint32_t numBlocks = imgSize / DEFLATE_MAX_BLOCK_SIZE;
-    if (imgSize % DEFLATE_MAX_BLOCK_SIZE != 0)
+    uint32_t numBlocks = imgSize / maxBlkSize;
+    if (imgSize % maxBlkSize != 0)
         numBlocks++; // Round up
 
     dataSize += numBlocks * 5; // 5 bytes per DEFLATE uncompressed block header
@@ -270,61 +225,59 @@ void pngPrinter::png_add_data(uint8_t *buf, uint32_t n)
         // at beginning of block?
         if (blk_pos == 0)
         {
-            blkSize = DEFLATE_MAX_BLOCK_SIZE;
-            uint8_t c = 0;
+            blkSize = maxBlkSize;
+            uint8_t final_block = 0;
             if (imgSize - img_pos <= (uint32_t)blkSize)
             {
-                c = 1; // final block
+                final_block = 1;
                 blkSize = (uint16_t)(imgSize - img_pos);
             }
 
             Debug_println("Writing ZLIB block header.");
-            // write out block header
-            crc_value = rc_crc32(crc_value, c);
-            fputc(c, _file);
-
-            // write out block size
-            c = (uint8_t)(blkSize >> 0);
-            crc_value = rc_crc32(crc_value, c);
-            fputc(c, _file);
-            c = (uint8_t)(blkSize >> 8);
-            crc_value = rc_crc32(crc_value, c);
-            fputc(c, _file);
-            c = (uint8_t)((blkSize >> 0) ^ 0xFF);
-            crc_value = rc_crc32(crc_value, c);
-            fputc(c, _file);
-            c = (uint8_t)((blkSize >> 8) ^ 0xFF);
-            crc_value = rc_crc32(crc_value, c);
-            fputc(c, _file);
+            // block header followed by the block size and its complement
+            uint8_t header[] = {
+                final_block,
+                (uint8_t)(blkSize >> 0),
+                (uint8_t)(blkSize >> 8),
+                (uint8_t)((blkSize >> 0) ^ 0xFF),
+                (uint8_t)((blkSize >> 8) ^ 0xFF)};
+            crc_value = rc_crc32(crc_value, header, sizeof(header));
+            fwrite(header, 1, sizeof(header), _file);
 
             //printf("new block\r\n");
         }
 
-        //at beginning of a line?
-        if (Xpos == 0)
+        //at beginning of a line? the filter byte may be the last one of a block
+        if (Xpos == 0 && img_pos % (width + 1) == 0)
         {
             Debug_printf("Starting PNG line %d ... ",Ypos);
             c = 0;
             crc_value = rc_crc32(crc_value, c);
-            adler_value = update_adler32(adler_value, c);
+            adler_value = update_adler32(adler_value, &c, 1);
             fputc(c, _file);
             //printf("\nnew line %d ", c);
 
             img_pos++;
             blk_pos++;
         }
-
-        // put byte from buffer
-        c = buf[idx];
-        crc_value = rc_crc32(crc_value, c);
-        adler_value = update_adler32(adler_value, c);
-        fputc(c, _file);
-        //printf("%d ", c);
-
-        Xpos++;
-        idx++;
-        img_pos++;
-        blk_pos++;
+        else
+        {
+            // put as much of the buffer as fits in the rest of this line and block
+            uint32_t run = n - idx;
+            if (run > (uint32_t)(width - Xpos))
+                run = width - Xpos;
+            if (run > (uint32_t)(blkSize - blk_pos))
+                run = blkSize - blk_pos;
+
+            crc_value = rc_crc32(crc_value, &buf[idx], run);
+            adler_value = update_adler32(adler_value, &buf[idx], run);
+            fwrite(&buf[idx], 1, run, _file);
+
+            Xpos += run;
+            idx += run;
+            img_pos += run;
+            blk_pos += run;
+        }
 
         // check for end of's
         if (Xpos == width)
@@ -348,8 +301,7 @@ void pngPrinter::png_add_data(uint8_t *buf, uint32_t n)
             0, 0, 0, 0  // CRC32: 4 bytes
         };
         uint32_to_array(adler_value, &data[0]);
-        for (int i = 0; i < 4; i++)
-            crc_value = rc_crc32(crc_value, data[i]); // crc_value = rc_crc32(crc_value, data[0],4); ?????????
+        crc_value = rc_crc32(crc_value, &data[0], 4);
         uint32_to_array(crc_value, &data[4]);
         fwrite(data, 1, 8, _file);
         png_end();
@@ -19,6 +19,7 @@ protected:
     uint16_t Xpos = 0;                       // current position within image line
     uint16_t Ypos = 0;                       // current image line number
     uint32_t dataSize = 0;                   // size of data for IDAT chunk
+    uint16_t maxBlkSize = DEFLATE_MAX_BLOCK_SIZE; // largest zlib block written
     uint16_t blkSize = 0;                    // size of zlib block
     uint16_t blk_pos = 0;                    // serial position within zlib block
     uint32_t crc_value = 0;                  // running crc32 value
@@ -31,7 +32,7 @@ protected:
     uint8_t rep_code = 0;
 
     void uint32_to_array(uint32_t src, uint8_t dest[4]);
-    uint32_t update_adler32(uint32_t adler, uint8_t data);
+    uint32_t update_adler32(uint32_t adler, const uint8_t *buf, size_t len);
     uint32_t rc_crc32(uint32_t crc, const uint8_t *buf, size_t len);
     uint32_t rc_crc32(uint32_t crc, uint8_t c) { return rc_crc32(crc, &c, 1); }
 
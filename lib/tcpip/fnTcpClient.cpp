@@ -13,6 +13,7 @@
 #  define MSG_DONTWAIT 0
 # else
 #  include <sys/ioctl.h>
+#  include <sys/uio.h>
 #  include <netinet/tcp.h>
 # endif
 
@@ -26,6 +27,8 @@
 #   define MSG_NOSIGNAL 0
 #  endif
 # endif
+#else
+# include <sys/uio.h>
 #endif // !ESP_PLATFORM
 
 #include "fnDNS.h"
@@ -505,6 +508,66 @@ size_t fnTcpClient::write(const uint8_t *buf, size_t size)
     return totalBytesSent;
 }
 
+// Send what the socket takes now of the segments, in order
+int fnTcpClient::write_some(const fnTcpSegment *segments, int count)
+{
+    int socketFileDescriptor = fd();
+    if (!_connected || (socketFileDescriptor < 0))
+        return -1;
+
+    if (count > FNTCP_MAX_SEGMENTS)
+        count = FNTCP_MAX_SEGMENTS;
+
+    int res;
+#if defined(_WIN32)
+    // No sendmsg(), send the segments one by one until the socket is full
+    res = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int sent = send(socketFileDescriptor, (const char *)segments[i].data, segments[i].size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (res == 0)
+                res = -1;
+            break;
+        }
+        res += sent;
+        if ((size_t)sent < segments[i].size)
+            break;
+    }
+#else
+    struct iovec iov[FNTCP_MAX_SEGMENTS];
+    for (int i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (void *)segments[i].data;
+        iov[i].iov_len = segments[i].size;
+    }
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    res = sendmsg(socketFileDescriptor, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+
+    if (res < 0)
+    {
+        int err = compat_getsockerr();
+#if defined(_WIN32)
+        if (err == WSAEWOULDBLOCK)
+#else
+        if (err == EAGAIN || err == EWOULDBLOCK)
+#endif
+            return 0;
+
+        Debug_printf("fail on fd %d, errno: %d, \"%s\"\r\n", socketFileDescriptor, err, strerror(err));
+        stop();
+        return -1;
+    }
+    return res;
+}
+
 // Send std::string of data
 size_t fnTcpClient::write(const std::string str)
 {
@@ -10,6 +10,16 @@
 class fnTcpClientSocketHandle;
 class fnTcpClientRxBuffer;
 
+// One piece of a gathered write
+struct fnTcpSegment
+{
+    const uint8_t *data;
+    size_t size;
+};
+
+// Most segments write_some() sends in one call
+#define FNTCP_MAX_SEGMENTS 16
+
 class fnTcpClient
 {
 protected:
@@ -31,6 +41,12 @@ public:
     size_t write(const uint8_t *buf, size_t size);
     size_t write(const char *buff);
     size_t write(const std::string str);
+    /**
+     * @brief Send the segments, in order, as far as the socket takes them
+     * without waiting (one sendmsg() where available)
+     * @return number of bytes sent, -1 if the connection failed
+     */
+    int write_some(const fnTcpSegment *segments, int count);
 
     int read();
     int read(uint8_t *buf, size_t size);
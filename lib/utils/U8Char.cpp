@@ -1,39 +1,6 @@
 #include "U8Char.h"
 #include "punycode.h"
 
-// from https://style64.org/petscii/
-
-// PETSCII table in UTF8,  non-mappable characters mapped to Private Use Area E000-F8FF
-const char16_t U8Char::utf8map[] = {
-// we can't touch standard ASCII (<127), even for codes imssing in PETSCII, as this will cause all kinds of problems
-//  ---0,   ---1,   ---2,   ---3,   ---4,   ---5,   ---6,   ---7,   ---8,   ---9,   --10,   --11,   --12,   --13,   --14,   --15    
-    0x00,   0x01,   0x02,   0x03,   0x04,   0x05,   0x06,   0x07,   0x08,   0x09,   0x0a,   0x0b,   0x0c,   0x0d,   0x0e,   0x0f,  // ASCII control codes
-    0x10,   0x11,   0x12,   0x13,   0x14,   0x15,   0x16,   0x17,   0x18,   0x19,   0x1a,   0x1b,   0x1c,   0x1d,   0x1e,   0x1f,  // ASCII control codes
-    0x20,   0x21,   0x22,   0x23,   0x24,   0x25,   0x26,   0x27,   0x28,   0x29,   0x2a,   0x2b,   0x2c,   0x2d,   0x2e,   0x2f,  // punct
-    0x30,   0x31,   0x32,   0x33,   0x34,   0x35,   0x36,   0x37,   0x38,   0x39,   0x3a,   0x3b,   0x3c,   0x3d,   0x3e,   0x3f,  // numbers
-
-    0x40, // @
-    0x61,   0x62,   0x63,   0x64,   0x65,   0x66,   0x67,   0x68,   0x69,   0x6a,   0x6b,   0x6c,   0x6d,   0x6e,   0x6f,  // a-o
-    0x70,   0x71,   0x72,   0x73,   0x74,   0x75,   0x76,   0x77,   0x78,   0x79,   0x7a,   // p-z
-    0x5b,   0x5c,   0x5d,   0x5e,   0x5f, // [ \ ] ^ _
-
-    0x60, // `
-    0x41,   0x42,   0x43,   0x44,   0x45,   0x46,   0x47,   0x48,   0x49,   0x4a,   0x4b,   0x4c,   0x4d,   0x4e,   0x4f,  // A-O
-    0x50,   0x51,   0x52,   0x53,   0x54,   0x55,   0x56,   0x57,   0x58,   0x59,   0x5a, // P-Z
-    0x7b,   0x7c,   0x7d,   0x7e,   0x7f, // { | } ~ DEL
-
-  0xE015, 0xE016, 0xE017, 0xE018, 0xE019, 0xE01A, 0xE01B, 0xE01C, 0xE01D, 0xE01E, 0xE01F, 0xE020, 0xE021, 0x2028, 0xE022, 0xE023,  // PETSCII control codes
-  0xE024, 0xE025, 0xE026, 0xE027, 0xE028, 0xE029, 0xE02A, 0xE02B, 0xE02C, 0xE02D, 0xE02E, 0xE02F, 0xE030, 0xE031, 0xE032, 0xE033,  // PETSCII control codes
-
-    0xa0, 0x258c, 0x2584, 0x2594, 0x2581, 0x258e, 0x2592, 0xE034, 0xE035, 0xE036, 0xE037, 0x251c, 0x2597, 0x2514, 0x2510, 0x2582,  // PETSCII tables etc.
-  0x250c, 0x2534, 0x252c, 0x2524, 0x258e, 0x258d, 0xE038, 0xE039, 0xE03A, 0x2583, 0x2713, 0x2596, 0x259d, 0x2518, 0x2598, 0x259a,  // PETSCII tables etc.
-  0x2500,   0x41,   0x42,   0x43,   0x44,   0x45,   0x46,   0x47,   0x48,   0x49,   0x4a,   0x4b,   0x4c,   0x4d,   0x4e,   0x4f,  // A-Z again
-    0x50,   0x51,   0x52,   0x53,   0x54,   0x55,   0x56,   0x57,   0x58,   0x59,   0x5a, 0x253c, 0xE03B, 0x2502, 0xE03C, 0xE03D,  
-    0xa0, 0x258c, 0x2584, 0x2594, 0x2581, 0x258e, 0x2592, 0xE03F, 0xE040, 0xE041, 0xE042, 0x251c, 0x2597, 0x2514, 0x2510, 0x2582,  // PETSCII tables etc.
-  0x250c, 0x2534, 0x252c, 0x2524, 0x258e, 0x258d, 0xE043, 0xE044, 0xE045, 0x2583, 0x2713, 0x2596, 0x259d, 0x2518, 0x2598, 0xE046   // PETSCII tables etc.
-
-};
-
 // std::unordered_map<char16_t, uint8_t> U8Char::ch_to_petascii_map;
 // std::once_flag U8Char::ch_to_petascii_init_flag;
 
@@ -43,12 +10,12 @@ void U8Char::fromUtf8Stream(std::istream* reader) {
         ch = byte;
     }   
     else if((byte & 0b11100000) == 0b11000000) {
-        uint16_t hi =  ((uint16_t)(byte & 0b1111)) << 6;
+        uint16_t hi =  ((uint16_t)(byte & 0b11111)) << 6;
         uint16_t lo = (reader->get() & 0b111111);
         ch = hi | lo;
     }
     else if((byte & 0b11110000) == 0b11100000) {
-        uint16_t hi = ((uint16_t)(byte & 0b111)) << 12;
+        uint16_t hi = ((uint16_t)(byte & 0b1111)) << 12;
         uint16_t mi = ((uint16_t)(reader->get() & 0b111111)) << 6;
         uint16_t lo = reader->get() & 0b111111;
         ch = hi | mi | lo;
@@ -65,13 +32,13 @@ size_t U8Char::fromCharArray(char* reader) {
         return 1;
     }   
     else if((byte & 0b11100000) == 0b11000000) {
-        uint16_t hi =  ((uint16_t)(byte & 0b1111)) << 6;
+        uint16_t hi =  ((uint16_t)(byte & 0b11111)) << 6;
         uint16_t lo = (reader[1] & 0b111111);
         ch = hi | lo;
         return 2;
     }
     else if((byte & 0b11110000) == 0b11100000) {
-        uint16_t hi = ((uint16_t)(byte & 0b111)) << 12;
+        uint16_t hi = ((uint16_t)(byte & 0b1111)) << 12;
         uint16_t mi = ((uint16_t)(reader[1] & 0b111111)) << 6;
         uint16_t lo = reader[2] & 0b111111;
         ch = hi | mi | lo;
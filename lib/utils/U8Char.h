@@ -7,6 +7,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "charset.h"
+
 /********************************************************
  * U8Char
  * 
@@ -15,7 +17,6 @@
  ********************************************************/
 
 class U8Char {
-    static const char16_t utf8map[];
     const char missing = '?';
     void fromUtf8Stream(std::istream* reader);
     // static std::once_flag ch_to_petascii_init_flag;
@@ -28,7 +29,7 @@ public:
         // ensureReverseMapInitialized();
         fromUtf8Stream(reader);
     }
-    U8Char(const char petscii) : ch(utf8map[static_cast<uint8_t>(petscii)]) {
+    U8Char(const char petscii) : ch(charset::petscii_ucs[static_cast<uint8_t>(petscii)]) {
         // ensureReverseMapInitialized();
     }
 
@@ -50,7 +51,7 @@ public:
 
     // static void initialize_ch_to_petascii_map() {
     //     for (size_t i = 0; i < 256; ++i) {
-    //         ch_to_petascii_map.insert({utf8map[i], static_cast<uint8_t>(i)});
+    //         ch_to_petascii_map.insert({charset::petscii_ucs[i], static_cast<uint8_t>(i)});
     //     }
     // }
 };
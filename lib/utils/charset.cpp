@@ -0,0 +1,153 @@
+#include "charset.h"
+
+namespace charset
+{
+    // Decode the character at in[0], missing continuation bytes at the end read as 0
+    static inline size_t decode_utf8(const uint8_t *in, size_t len, char16_t *ch)
+    {
+        uint8_t b = in[0];
+        switch (utf8_lengths[b])
+        {
+        case 1:
+            *ch = b;
+            return 1;
+        case 2:
+        {
+            uint8_t b1 = len > 1 ? in[1] : 0;
+            *ch = ((b & 0x1f) << 6) | (b1 & 0x3f);
+            return len < 2 ? len : 2;
+        }
+        case 3:
+        {
+            uint8_t b1 = len > 1 ? in[1] : 0;
+            uint8_t b2 = len > 2 ? in[2] : 0;
+            *ch = ((b & 0x0f) << 12) | ((b1 & 0x3f) << 6) | (b2 & 0x3f);
+            return len < 3 ? len : 3;
+        }
+        default:
+            *ch = 0;
+            return 1;
+        }
+    }
+
+    size_t petscii_to_utf8(const char *in, size_t len, char *out, size_t out_size, size_t *used)
+    {
+        size_t r = 0;
+        size_t w = 0;
+        for (; r < len; r++)
+        {
+            uint8_t c = in[r];
+            if (c == 0)
+                continue;
+
+            const sequence &seq = petscii_utf8[c];
+            if (w + seq.len > out_size)
+                break;
+            out[w] = seq.bytes[0];
+            if (seq.len > 1)
+            {
+                out[w + 1] = seq.bytes[1];
+                if (seq.len > 2)
+                    out[w + 2] = seq.bytes[2];
+            }
+            w += seq.len;
+        }
+
+        if (used != nullptr)
+            *used = r;
+        return w;
+    }
+
+    size_t petscii_to_utf8_size(const char *in, size_t len)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < len; i++)
+            if (in[i] != 0)
+                size += petscii_utf8[(uint8_t)in[i]].len;
+        return size;
+    }
+
+    void petscii_to_utf8(std::string &s)
+    {
+        // Drop NULs first. Then every byte becomes one or more, so converting
+        // from the back never overwrites a byte before it has been read.
+        size_t len = 0;
+        for (size_t i = 0; i < s.size(); i++)
+            if (s[i] != 0)
+                s[len++] = s[i];
+
+        size_t size = petscii_to_utf8_size(s.data(), len);
+        s.resize(size);
+
+        char *p = s.data();
+        size_t w = size;
+        for (size_t r = len; r-- > 0;)
+        {
+            const sequence &seq = petscii_utf8[(uint8_t)p[r]];
+            w -= seq.len;
+            for (int i = seq.len - 1; i >= 0; i--)
+                p[w + i] = seq.bytes[i];
+        }
+    }
+
+    size_t utf8_to_petscii(const char *in, size_t len, char *out, size_t out_size, size_t *used)
+    {
+        const uint8_t *p = (const uint8_t *)in;
+        size_t r = 0;
+        size_t w = 0;
+        while (r < len && w < out_size)
+        {
+            uint8_t b = p[r];
+            if (b <= 0x7f)
+            {
+                // Most names are plain ASCII
+                out[w++] = ucs_petscii[b];
+                r++;
+                continue;
+            }
+
+            char16_t ch;
+            r += decode_utf8(p + r, len - r, &ch);
+            out[w++] = ch > 0xff ? missing : ucs_petscii[ch];
+        }
+
+        if (used != nullptr)
+            *used = r;
+        return w;
+    }
+
+    void utf8_to_petscii(std::string &s)
+    {
+        s.resize(utf8_to_petscii(s.data(), s.size(), s.data(), s.size()));
+    }
+
+    size_t utf8_to_atascii(char *buf, size_t len, bool international)
+    {
+        const auto &table = international ? latin1_atascii_intl : latin1_atascii;
+        size_t w = 0;
+        for (size_t r = 0; r < len;)
+        {
+            uint8_t b = buf[r];
+            // Latin-1 letters are C2 or C3 and one continuation byte
+            if ((b == 0xc2 || b == 0xc3) && r + 1 < len && ((uint8_t)buf[r + 1] & 0xc0) == 0x80)
+            {
+                const sequence &seq = table[((b & 0x1f) << 6) | ((uint8_t)buf[r + 1] & 0x3f)];
+                if (seq.len > 0)
+                {
+                    buf[w++] = seq.bytes[0];
+                    if (seq.len > 1)
+                        buf[w++] = seq.bytes[1];
+                    r += 2;
+                    continue;
+                }
+            }
+            buf[w++] = buf[r++];
+        }
+        return w;
+    }
+
+    void utf8_to_atascii(std::string &s, bool international)
+    {
+        s.resize(utf8_to_atascii(s.data(), s.size(), international));
+    }
+}
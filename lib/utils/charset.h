@@ -0,0 +1,210 @@
+#ifndef CHARSET_H
+#define CHARSET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Character set conversion between PETSCII, ATASCII and UTF-8.
+ *
+ * Every per-byte decision is a lookup in a table generated at compile time
+ * from the PETSCII map below. The conversions work on caller buffers or in
+ * place in a std::string, and don't allocate (the std::string versions only
+ * grow the string when the result is longer and it has no spare capacity).
+ */
+namespace charset
+{
+    // Returned for anything without a PETSCII equivalent
+    constexpr char missing = '?';
+
+    // PETSCII in Unicode, from https://style64.org/petscii/
+    // Non-mappable characters are mapped to the Private Use Area E000-F8FF.
+    inline constexpr char16_t petscii_ucs[256] = {
+    // we can't touch standard ASCII (<127), even for codes imssing in PETSCII, as this will cause all kinds of problems
+    //  ---0,   ---1,   ---2,   ---3,   ---4,   ---5,   ---6,   ---7,   ---8,   ---9,   --10,   --11,   --12,   --13,   --14,   --15
+        0x00,   0x01,   0x02,   0x03,   0x04,   0x05,   0x06,   0x07,   0x08,   0x09,   0x0a,   0x0b,   0x0c,   0x0d,   0x0e,   0x0f,  // ASCII control codes
+        0x10,   0x11,   0x12,   0x13,   0x14,   0x15,   0x16,   0x17,   0x18,   0x19,   0x1a,   0x1b,   0x1c,   0x1d,   0x1e,   0x1f,  // ASCII control codes
+        0x20,   0x21,   0x22,   0x23,   0x24,   0x25,   0x26,   0x27,   0x28,   0x29,   0x2a,   0x2b,   0x2c,   0x2d,   0x2e,   0x2f,  // punct
+        0x30,   0x31,   0x32,   0x33,   0x34,   0x35,   0x36,   0x37,   0x38,   0x39,   0x3a,   0x3b,   0x3c,   0x3d,   0x3e,   0x3f,  // numbers
+
+        0x40, // @
+        0x61,   0x62,   0x63,   0x64,   0x65,   0x66,   0x67,   0x68,   0x69,   0x6a,   0x6b,   0x6c,   0x6d,   0x6e,   0x6f,  // a-o
+        0x70,   0x71,   0x72,   0x73,   0x74,   0x75,   0x76,   0x77,   0x78,   0x79,   0x7a,   // p-z
+        0x5b,   0x5c,   0x5d,   0x5e,   0x5f, // [ \ ] ^ _
+
+        0x60, // `
+        0x41,   0x42,   0x43,   0x44,   0x45,   0x46,   0x47,   0x48,   0x49,   0x4a,   0x4b,   0x4c,   0x4d,   0x4e,   0x4f,  // A-O
+        0x50,   0x51,   0x52,   0x53,   0x54,   0x55,   0x56,   0x57,   0x58,   0x59,   0x5a, // P-Z
+        0x7b,   0x7c,   0x7d,   0x7e,   0x7f, // { | } ~ DEL
+
+      0xE015, 0xE016, 0xE017, 0xE018, 0xE019, 0xE01A, 0xE01B, 0xE01C, 0xE01D, 0xE01E, 0xE01F, 0xE020, 0xE021, 0x2028, 0xE022, 0xE023,  // PETSCII control codes
+      0xE024, 0xE025, 0xE026, 0xE027, 0xE028, 0xE029, 0xE02A, 0xE02B, 0xE02C, 0xE02D, 0xE02E, 0xE02F, 0xE030, 0xE031, 0xE032, 0xE033,  // PETSCII control codes
+
+        0xa0, 0x258c, 0x2584, 0x2594, 0x2581, 0x258e, 0x2592, 0xE034, 0xE035, 0xE036, 0xE037, 0x251c, 0x2597, 0x2514, 0x2510, 0x2582,  // PETSCII tables etc.
+      0x250c, 0x2534, 0x252c, 0x2524, 0x258e, 0x258d, 0xE038, 0xE039, 0xE03A, 0x2583, 0x2713, 0x2596, 0x259d, 0x2518, 0x2598, 0x259a,  // PETSCII tables etc.
+      0x2500,   0x41,   0x42,   0x43,   0x44,   0x45,   0x46,   0x47,   0x48,   0x49,   0x4a,   0x4b,   0x4c,   0x4d,   0x4e,   0x4f,  // A-Z again
+        0x50,   0x51,   0x52,   0x53,   0x54,   0x55,   0x56,   0x57,   0x58,   0x59,   0x5a, 0x253c, 0xE03B, 0x2502, 0xE03C, 0xE03D,
+        0xa0, 0x258c, 0x2584, 0x2594, 0x2581, 0x258e, 0x2592, 0xE03F, 0xE040, 0xE041, 0xE042, 0x251c, 0x2597, 0x2514, 0x2510, 0x2582,  // PETSCII tables etc.
+      0x250c, 0x2534, 0x252c, 0x2524, 0x258e, 0x258d, 0xE043, 0xE044, 0xE045, 0x2583, 0x2713, 0x2596, 0x259d, 0x2518, 0x2598, 0xE046   // PETSCII tables etc.
+    };
+
+    // Up to three bytes of UTF-8, or of replacement text
+    struct sequence
+    {
+        uint8_t len;
+        char bytes[3];
+    };
+
+    // UTF-8 for a code point, '?' for 0 as U8Char::toUtf8() does
+    constexpr sequence encode_utf8(char16_t ch)
+    {
+        if (ch == 0)
+            return {1, {missing, 0, 0}};
+        if (ch <= 0x7f)
+            return {1, {(char)ch, 0, 0}};
+        if (ch <= 0x7ff)
+            return {2, {(char)(0xc0 | ((ch >> 6) & 0x1f)), (char)(0x80 | (ch & 0x3f)), 0}};
+        return {3, {(char)(0xe0 | ((ch >> 12) & 0x0f)), (char)(0x80 | ((ch >> 6) & 0x3f)), (char)(0x80 | (ch & 0x3f))}};
+    }
+
+    // PETSCII for code points up to 0xff: the ASCII letters swap case, the rest stay
+    constexpr char ucs_to_petscii(uint8_t c)
+    {
+        if (c > 0x40 && c < 0x5b)
+            return (char)(c + 0x20);
+        if (c > 0x60 && c < 0x7b)
+            return (char)(c - 0x20);
+        return (char)c;
+    }
+
+    /*
+     * Length of the UTF-8 sequence starting with each byte: 1 for ASCII, 2 or
+     * 3 for lead bytes, 0 for anything else, which is skipped as code point 0
+     * (U8Char only reads the Basic Multilingual Plane)
+     */
+    constexpr uint8_t utf8_length(uint8_t b)
+    {
+        if (b <= 0x7f)
+            return 1;
+        if ((b & 0xe0) == 0xc0)
+            return 2;
+        if ((b & 0xf0) == 0xe0)
+            return 3;
+        return 0;
+    }
+
+    template <typename T, typename F>
+    constexpr std::array<T, 256> make_table(F f)
+    {
+        std::array<T, 256> table{};
+        for (int i = 0; i < 256; i++)
+            table[i] = f(i);
+        return table;
+    }
+
+    inline constexpr auto petscii_utf8 = make_table<sequence>([](int i) { return encode_utf8(petscii_ucs[i]); });
+    inline constexpr auto ucs_petscii = make_table<char>([](int i) { return ucs_to_petscii(i); });
+    inline constexpr auto utf8_lengths = make_table<uint8_t>([](int i) { return utf8_length(i); });
+
+    // ATASCII for Latin-1 code points, len 0 where the character is kept as it is
+    constexpr sequence latin1_to_atascii(char16_t ch, bool international)
+    {
+        if (international)
+        {
+            switch (ch)
+            {
+            case u'á': return {1, {0x00}};
+            case u'ù': return {1, {0x01}};
+            case u'Ñ': return {1, {0x02}};
+            case u'É': return {1, {0x03}};
+            case u'ç': return {1, {0x04}};
+            case u'ô': return {1, {0x05}};
+            case u'ò': return {1, {0x06}};
+            case u'ì': return {1, {0x07}};
+            case u'£': return {1, {0x08}};
+            case u'ï': return {1, {0x09}};
+            case u'ü': return {1, {0x0a}};
+            case u'ä': return {1, {0x0b}};
+            case u'Ö': return {1, {0x0c}};
+            case u'ú': return {1, {0x0d}};
+            case u'ó': return {1, {0x0e}};
+            case u'ö': return {1, {0x0f}};
+            case u'Ü': return {1, {0x10}};
+            case u'â': return {1, {0x11}};
+            case u'û': return {1, {0x12}};
+            case u'î': return {1, {0x13}};
+            case u'é': return {1, {0x14}};
+            case u'è': return {1, {0x15}};
+            case u'ñ': return {1, {0x16}};
+            case u'ê': return {1, {0x17}};
+            case u'å': return {1, {0x18}};
+            case u'à': return {1, {0x19}};
+            case u'Å': return {1, {0x1a}};
+            case u'¡': return {1, {0x60}};
+            case u'Ä': return {1, {0x7b}};
+            case u'ß': return {2, {'s', 's'}};
+            }
+        }
+        else
+        {
+            switch (ch)
+            {
+            case u'Ä': return {2, {'A', 'e'}};
+            case u'Ö': return {2, {'O', 'e'}};
+            case u'Ü': return {2, {'U', 'e'}};
+            case u'ä': return {2, {'a', 'e'}};
+            case u'ö': return {2, {'o', 'e'}};
+            case u'ü': return {2, {'u', 'e'}};
+            case u'ß': return {2, {'s', 's'}};
+            case u'é': case u'è': return {1, {'e'}};
+            case u'á': case u'à': return {1, {'a'}};
+            case u'ó': case u'ò': return {1, {'o'}};
+            case u'ú': case u'ù': return {1, {'u'}};
+            }
+        }
+        return {0, {0}};
+    }
+
+    inline constexpr auto latin1_atascii = make_table<sequence>([](int i) { return latin1_to_atascii(i, false); });
+    inline constexpr auto latin1_atascii_intl = make_table<sequence>([](int i) { return latin1_to_atascii(i, true); });
+
+    /**
+     * @brief PETSCII to UTF-8. NUL bytes are dropped.
+     * @param out output buffer; only whole characters are written
+     * @param used if not null, set to the number of input bytes converted
+     * @return bytes written to out
+     */
+    size_t petscii_to_utf8(const char *in, size_t len, char *out, size_t out_size, size_t *used = nullptr);
+
+    // Bytes petscii_to_utf8() writes for the whole input
+    size_t petscii_to_utf8_size(const char *in, size_t len);
+
+    // PETSCII to UTF-8 in place
+    void petscii_to_utf8(std::string &s);
+
+    /**
+     * @brief UTF-8 to PETSCII, one byte per character, '?' for characters
+     * above U+00FF. Never longer than the input, so out may be in.
+     * @return bytes written to out
+     */
+    size_t utf8_to_petscii(const char *in, size_t len, char *out, size_t out_size, size_t *used = nullptr);
+
+    // UTF-8 to PETSCII in place
+    void utf8_to_petscii(std::string &s);
+
+    /**
+     * @brief Latin-1 letters in UTF-8 to ATASCII. With international set,
+     * to the ATASCII international character set (switched on with
+     * POKE 756,204), otherwise to plain ASCII spellings ("ä" to "ae").
+     * Everything else is left as it is. Never longer than the input.
+     * @return new length of buf
+     */
+    size_t utf8_to_atascii(char *buf, size_t len, bool international);
+
+    // UTF-8 to ATASCII in place
+    void utf8_to_atascii(std::string &s, bool international);
+}
+
+#endif // CHARSET_H
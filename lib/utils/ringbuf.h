@@ -0,0 +1,176 @@
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Fixed size byte ring buffer, lock-free for a single producer and a single
+ * consumer thread.
+ *
+ * Head and tail are free running counters; their difference is the fill
+ * level, so the whole capacity is usable without a separate "full" flag.
+ * Only the producer stores head and only the consumer stores tail, each
+ * publishing with release and reading the other side with acquire. The two
+ * counters live on separate cache lines to avoid false sharing.
+ *
+ * push() and pop() copy in at most two memcpy calls (before and after the
+ * wrap point) instead of moving one byte at a time.
+ */
+template <size_t N>
+class RingBuffer
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+public:
+    RingBuffer() : _head(0), _tail(0) {}
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    static constexpr size_t capacity() { return N; }
+
+    // Number of bytes waiting to be read
+    size_t available() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    // Number of bytes which can be written without overrun
+    size_t room() const { return N - available(); }
+
+    bool empty() const { return available() == 0; }
+    bool full() const { return available() == N; }
+
+    /**
+     * @brief Producer: append up to len bytes
+     * @return number of bytes stored, less than len if the buffer filled up
+     */
+    size_t push(const uint8_t *src, size_t len)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+
+        size_t n = N - (head - tail);
+        if (n > len)
+            n = len;
+        if (n == 0)
+            return 0;
+
+        size_t pos = head & (N - 1);
+        size_t first = N - pos;
+        if (first > n)
+            first = n;
+        memcpy(_buf + pos, src, first);
+        memcpy(_buf, src + first, n - first);
+
+        _head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    bool push(uint8_t b) { return push(&b, 1) == 1; }
+
+    /**
+     * @brief Consumer: remove up to len bytes into dst
+     * @return number of bytes copied, 0 if the buffer is empty
+     */
+    size_t pop(uint8_t *dst, size_t len)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+
+        size_t n = head - tail;
+        if (n > len)
+            n = len;
+        if (n == 0)
+            return 0;
+
+        size_t pos = tail & (N - 1);
+        size_t first = N - pos;
+        if (first > n)
+            first = n;
+        memcpy(dst, _buf + pos, first);
+        memcpy(dst + first, _buf, n - first);
+
+        _tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: remove a single byte, -1 if empty
+    int pop()
+    {
+        uint8_t b;
+        return pop(&b, 1) == 1 ? b : -1;
+    }
+
+    // Consumer: drop up to len of the oldest bytes
+    size_t discard(size_t len)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+
+        size_t n = head - tail;
+        if (n > len)
+            n = len;
+        _tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: drop everything currently in the buffer
+    void clear() { discard(N); }
+
+    /**
+     * @brief Consumer: the waiting bytes in place, without copying, as up to
+     * two runs (before and after the wrap point). Release them with discard().
+     * @return number of bytes waiting, first_len + second_len
+     */
+    size_t read_spans(const uint8_t **first, size_t *first_len,
+                      const uint8_t **second, size_t *second_len) const
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t head = _head.load(std::memory_order_acquire);
+        return spans(tail, head - tail, (uint8_t **)first, first_len, (uint8_t **)second, second_len);
+    }
+
+    /**
+     * @brief Producer: the free space in place, as up to two runs, to be
+     * filled directly and published with commit()
+     * @return number of bytes free, first_len + second_len
+     */
+    size_t write_spans(uint8_t **first, size_t *first_len, uint8_t **second, size_t *second_len)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return spans(head, N - (head - tail), first, first_len, second, second_len);
+    }
+
+    // Producer: publish len bytes written through write_spans()
+    void commit(size_t len)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+private:
+    // Split n bytes starting at counter pos into the runs before and after the wrap point
+    size_t spans(size_t pos, size_t n, uint8_t **first, size_t *first_len,
+                 uint8_t **second, size_t *second_len) const
+    {
+        pos &= N - 1;
+        size_t len = N - pos;
+        if (len > n)
+            len = n;
+        *first = (uint8_t *)_buf + pos;
+        *first_len = len;
+        *second = (uint8_t *)_buf;
+        *second_len = n - len;
+        return n;
+    }
+
+    alignas(64) std::atomic<size_t> _head; // written by producer
+    alignas(64) std::atomic<size_t> _tail; // written by consumer
+    alignas(64) uint8_t _buf[N];
+};
+
+#endif // RINGBUF_H
@@ -29,7 +29,7 @@
 
 //#include "../../include/petscii.h"
 #include "../../include/debug.h"
-#include "U8Char.h"
+#include "charset.h"
 
 
 #if defined(_WIN32)
@@ -290,33 +290,19 @@ namespace mstr {
     //                 [](unsigned char c) { return ascii2petscii(c); });
     // }
 
-    // convert PETSCII to UTF8, using methods from U8Char
+    // convert PETSCII to UTF8, see charset::petscii_to_utf8() to convert in place
     std::string toUTF8(const std::string &petsciiInput)
     {
-        std::string utf8string;
-        for(char petscii : petsciiInput) {
-            if(petscii > 0)
-            {
-                U8Char u8char(petscii);
-                utf8string+=u8char.toUtf8();
-            }
-        }
+        std::string utf8string = petsciiInput;
+        charset::petscii_to_utf8(utf8string);
         return utf8string;
     }
 
-    // convert UTF8 to PETSCII, using methods from U8Char
+    // convert UTF8 to PETSCII, see charset::utf8_to_petscii() to convert in place
     std::string toPETSCII2(const std::string &utfInputString)
     {
-        std::string petsciiString;
-        char* utfInput = (char*)utfInputString.c_str();
-        auto end = utfInput + utfInputString.length();
-
-        while(utfInput<end) {
-            U8Char u8char(' ');
-            size_t skip = u8char.fromCharArray(utfInput);
-            petsciiString+=u8char.toPetscii();
-            utfInput+=skip;
-        }
+        std::string petsciiString = utfInputString;
+        charset::utf8_to_petscii(petsciiString);
         return petsciiString;
     }
 
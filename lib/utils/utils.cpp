@@ -651,6 +651,52 @@ vector<uint8_t> util_tokenize_uint8(string s, char c)
     return tokens;
 }
 
+// Parses an HTTP Content-Range response header value, "bytes first-last/total".
+// An unknown total (a '*' after the slash) gives total 0, an unsatisfied range
+// (a '*' instead of first-last, as sent with status 416) gives first and last 0.
+// Returns false if the value isn't a byte range.
+bool util_parse_content_range(const char *value, uint32_t *first, uint32_t *last, uint32_t *total)
+{
+    if (value == nullptr)
+        return false;
+    while (*value == ' ')
+        value++;
+    if (strncasecmp(value, "bytes", 5) != 0)
+        return false;
+    value += 5;
+    while (*value == ' ')
+        value++;
+
+    char *end;
+    unsigned long f = 0, l = 0, t = 0;
+    if (*value == '*')
+        end = (char *)value + 1;
+    else
+    {
+        f = strtoul(value, &end, 10);
+        if (end == value || *end != '-')
+            return false;
+        value = end + 1;
+        l = strtoul(value, &end, 10);
+        if (end == value || l < f)
+            return false;
+    }
+    if (*end != '/')
+        return false;
+    value = end + 1;
+    if (*value != '*')
+    {
+        t = strtoul(value, &end, 10);
+        if (end == value)
+            return false;
+    }
+
+    *first = f;
+    *last = l;
+    *total = t;
+    return true;
+}
+
 string util_remove_spaces(const string &s)
 {
     int last = s.size() - 1;
@@ -72,6 +72,8 @@ std::vector<std::string> util_tokenize(std::string s, char c = ' ');
 std::vector<uint8_t> util_tokenize_uint8(std::string s, char c = ' ');
 std::string util_remove_spaces(const std::string &s);
 
+bool util_parse_content_range(const char *value, uint32_t *first, uint32_t *last, uint32_t *total);
+
 void util_strip_nonascii(std::string &s);
 void util_devicespec_fix_9b(uint8_t* buf, unsigned short len);
 std::string util_devicespec_fix_for_parsing(std::string deviceSpec, std::string prefix, bool is_directory_read, bool process_fs_dot);
@@ -42,6 +42,7 @@ Console console;
 
 #ifndef ESP_PLATFORM
 #include "fnTaskManager.h"
+#include "fnReactor.h"
 #include "version.h"
 #include "build_version.h"
 #endif
@@ -93,6 +94,7 @@ void sighandler(int signum)
 #endif
     if (fnSystem.request_for_shutdown() >= 3)
         _exit(EXIT_FAILURE);        // emergency exit after any 3 signals
+    fnReactor.wake();               // get main loop out of its wait
 }
 
 #endif // !ESP_PLATFORM
@@ -209,6 +211,8 @@ void main_setup(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
   #endif
+
+    fnReactor.begin();
 #endif
 
     fnSystem.check_hardware_ver(); // Run early to determine correct FujiNet hardware
@@ -566,7 +570,9 @@ void fn_service_loop(void *param)
 // !ESP_PLATFORM
         fnHTTPD.service();
 
-        taskMgr.service();
+        // keep stepping running tasks
+        if (!taskMgr.service())
+            fnReactor.wake_in(0);
 
         if (fnSystem.check_deferred_reboot())
         {
@@ -577,6 +583,14 @@ void fn_service_loop(void *param)
             // indicate to the controlling script (run-fujinet) that this program (fujinet) should be started again
             fnSystem.reboot(); // calls exit(75)
         }
+
+  #ifdef BUILD_ATARI
+        // Sleep until the SIO port, the web server or a timer needs attention
+        fnReactor.wait(REACTOR_MAX_WAIT_MS);
+  #else
+        // other buses wait in their service()
+        fnReactor.wait(0);
+  #endif
 #endif
     }
 }
@@ -6,6 +6,28 @@
 #include <esp32/rom/ets_sys.h>
 #include "test_pass.h"
 #include "test_networkprotocol_translation.h"
+#include "test_iwm_spi_decoder.h"
+#include "test_iwm_sp_codec.h"
+#include "test_slip.h"
+#include "test_http_template.h"
+#include "test_dircache.h"
+#include "test_fnjson_stream.h"
+#include "test_modem_pump.h"
+#include "test_charset.h"
+#include "test_meat_broker.h"
+#include "test_media_cache.h"
+#include "test_tnfs_rto.h"
+#include "test_hash.h"
+#include "test_checksum.h"
+#include "test_atx_replay.h"
+#include "test_ringbuf.h"
+#include "test_iec_prefetch.h"
+#include "test_png_printer.h"
+#include "test_block_cache.h"
+#include "test_readv.h"
+#include "test_tnfs_dirlisting.h"
+#include "test_content_range.h"
+#include "test_fuji_copy.h"
 #include "../lib/hardware/fnSystem.h"
 
 extern "C"
@@ -24,6 +46,28 @@ void app_main()
 
     test_pass_run();
     tests_networkprotocol_translation();
+    tests_iwm_spi_decoder();
+    tests_iwm_sp_codec();
+    tests_slip();
+    tests_http_template();
+    tests_dircache();
+    tests_fnjson_stream();
+    tests_modem_pump();
+    tests_charset();
+    tests_meat_broker();
+    tests_media_cache();
+    tests_tnfs_rto();
+    tests_hash();
+    tests_checksum();
+    tests_atx_replay();
+    tests_ringbuf();
+    tests_iec_prefetch();
+    tests_png_printer();
+    tests_block_cache();
+    tests_readv();
+    tests_tnfs_dirlisting();
+    tests_content_range();
+    tests_fuji_copy();
 
     UNITY_END();
 }
\ No newline at end of file
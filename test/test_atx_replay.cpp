@@ -0,0 +1,198 @@
+/**
+ * #FujiNet Tests - ATX sector lookup
+ *
+ * Replays the sector reads of booting an ATX image, including copy
+ * protected tracks with duplicate sectors, through the sorted per track
+ * index and the original scan of every sector on the track, and times both.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <esp_timer.h>
+#include "test_atx_replay.h"
+
+#ifdef BUILD_ATARI
+
+#include "../lib/media/atari/diskTypeAtx.h"
+
+#define REPLAY_TRACKS 40
+#define REPLAY_SECTORS_PER_TRACK 18
+#define REPLAY_ANGULAR_UNITS 26042
+// Boots replayed in the timing test
+#define REPLAY_ROUNDS 50
+
+/**
+ * A disk's tracks twice: in the order the ATX file lists the sectors, and indexed for find_sector()
+ */
+struct replay_disk
+{
+    std::vector<std::vector<AtxSector>> listed;
+    std::vector<AtxTrack> tracks;
+};
+
+static void make_disk(replay_disk &disk)
+{
+    disk.listed.resize(REPLAY_TRACKS);
+    disk.tracks.resize(REPLAY_TRACKS);
+    srand(17);
+
+    for (int t = 0; t < REPLAY_TRACKS; t++)
+    {
+        std::vector<AtxSector> &listed = disk.listed[t];
+
+        // Sectors in the file's order, interleaved around the track like an 810 formats them
+        for (int i = 0; i < REPLAY_SECTORS_PER_TRACK; i++)
+        {
+            sector_header_t hdr;
+            hdr.number = (i * 2) % REPLAY_SECTORS_PER_TRACK + (i * 2 / REPLAY_SECTORS_PER_TRACK) + 1;
+            hdr.status = 0;
+            hdr.position = i * (REPLAY_ANGULAR_UNITS / REPLAY_SECTORS_PER_TRACK);
+            hdr.start_data = 0x100 + i * 128;
+            listed.push_back(AtxSector(hdr));
+        }
+
+        // Every fifth track is copy protected, with extra copies of a few sectors elsewhere on it
+        if (t % 5 == 4)
+        {
+            for (int d = 0; d < 6; d++)
+            {
+                sector_header_t hdr;
+                hdr.number = 1 + rand() % REPLAY_SECTORS_PER_TRACK;
+                hdr.status = ATX_SECTOR_STATUS_FDC_CRC_ERROR;
+                hdr.position = rand() % REPLAY_ANGULAR_UNITS;
+                hdr.start_data = 0x100 + (REPLAY_SECTORS_PER_TRACK + d) * 128;
+                listed.push_back(AtxSector(hdr));
+            }
+        }
+
+        for (const AtxSector &sector : listed)
+            disk.tracks[t].sectors.push_back(sector);
+        disk.tracks[t].sort_sectors();
+    }
+}
+
+/**
+ * The original lookup: every sector on the track, keeping the copy closest to the head
+ */
+static AtxSector *reference_find_sector(std::vector<AtxSector> &sectors, uint8_t sectornum, uint16_t current_pos)
+{
+    AtxSector *pSector = nullptr;
+    for (auto &it : sectors)
+    {
+        if (it.number == sectornum)
+        {
+            if (pSector == nullptr)
+            {
+                pSector = &it;
+            }
+            else
+            {
+                int diff_this = it.position - current_pos;
+                int diff_last = pSector->position - current_pos;
+
+                if (
+                    (diff_this == 0) ||
+                    (diff_this > 0 && diff_last < 0) ||
+                    (diff_this > 0 && diff_last > 0 && diff_this < diff_last) ||
+                    (diff_this < 0 && diff_last < 0 && diff_this < diff_last))
+                {
+                    pSector = &it;
+                }
+            }
+        }
+    }
+    return pSector;
+}
+
+/**
+ * The head position for the n-th read of a replay: the disk keeps turning between reads
+ */
+static uint16_t head_position(uint32_t n)
+{
+    return (n * 1777 + (n >> 3) * 31) % REPLAY_ANGULAR_UNITS;
+}
+
+void tests_atx_replay_lookup()
+{
+    replay_disk disk;
+    make_disk(disk);
+
+    uint32_t n = 0;
+    for (int t = 0; t < REPLAY_TRACKS; t++)
+    {
+        // Every sector, a missing one, and from several head positions
+        for (int s = 1; s <= REPLAY_SECTORS_PER_TRACK + 1; s++)
+        {
+            for (int r = 0; r < 8; r++, n++)
+            {
+                uint16_t pos = head_position(n);
+                AtxSector *expected = reference_find_sector(disk.listed[t], s, pos);
+                AtxSector *got = disk.tracks[t].find_sector(s, pos);
+
+                if (expected == nullptr)
+                {
+                    TEST_ASSERT_NULL(got);
+                    continue;
+                }
+                TEST_ASSERT_NOT_NULL(got);
+                TEST_ASSERT_EQUAL(expected->number, got->number);
+                TEST_ASSERT_EQUAL(expected->position, got->position);
+                TEST_ASSERT_EQUAL(expected->start_data, got->start_data);
+            }
+        }
+    }
+}
+
+void tests_atx_replay_timing()
+{
+    char msg[200];
+    replay_disk disk;
+    make_disk(disk);
+
+    // A boot reads the disk front to back
+    const uint32_t reads = REPLAY_ROUNDS * REPLAY_TRACKS * REPLAY_SECTORS_PER_TRACK;
+    uint32_t check = 0;
+
+    int64_t t0 = esp_timer_get_time();
+    for (uint32_t n = 0; n < reads; n++)
+    {
+        uint32_t sector = n % (REPLAY_TRACKS * REPLAY_SECTORS_PER_TRACK);
+        check += reference_find_sector(disk.listed[sector / REPLAY_SECTORS_PER_TRACK],
+                                       sector % REPLAY_SECTORS_PER_TRACK + 1, head_position(n))->start_data;
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (uint32_t n = 0; n < reads; n++)
+    {
+        uint32_t sector = n % (REPLAY_TRACKS * REPLAY_SECTORS_PER_TRACK);
+        check -= disk.tracks[sector / REPLAY_SECTORS_PER_TRACK].find_sector(
+                     sector % REPLAY_SECTORS_PER_TRACK + 1, head_position(n))->start_data;
+    }
+    int64_t t2 = esp_timer_get_time();
+
+    TEST_ASSERT_EQUAL(0, check);
+
+    snprintf(msg, sizeof(msg), "%lu ATX sector lookups: scan %lld us, index %lld us",
+             (unsigned long)reads, (long long)(t1 - t0), (long long)(t2 - t1));
+    TEST_MESSAGE(msg);
+}
+
+#else
+
+void tests_atx_replay_lookup()
+{
+    TEST_IGNORE_MESSAGE("ATX is only built for Atari");
+}
+
+void tests_atx_replay_timing()
+{
+    TEST_IGNORE_MESSAGE("ATX is only built for Atari");
+}
+
+#endif /* BUILD_ATARI */
+
+void tests_atx_replay()
+{
+    RUN_TEST(tests_atx_replay_lookup);
+    RUN_TEST(tests_atx_replay_timing);
+}
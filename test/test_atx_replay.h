@@ -0,0 +1,37 @@
+/**
+ * #FujiNet Tests - ATX sector lookup
+ *
+ * Replays the sector reads of booting an ATX image, including copy
+ * protected tracks with duplicate sectors, through the sorted per track
+ * index and the original scan of every sector on the track, and times both.
+ */
+
+#ifndef TEST_ATX_REPLAY_H
+#define TEST_ATX_REPLAY_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_atx_replay();
+
+    /**
+     * Test that the index finds the same copy of every sector as the scan
+     */
+    void tests_atx_replay_lookup();
+
+    /**
+     * Report the time a replayed boot spends finding sectors both ways
+     */
+    void tests_atx_replay_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_ATX_REPLAY_H */
@@ -0,0 +1,246 @@
+/**
+ * #FujiNet Tests - SD block cache
+ *
+ * Opens in memory "remote" files through the SD block cache and checks the
+ * data, how often the remote file is read, reopening and eviction.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/FileSystem/fnio.h"
+#include "test_block_cache.h"
+
+#ifndef FNIO_IS_STDIO
+
+#include <esp_random.h>
+#include "../lib/FileSystem/fnBlockCache.h"
+#include "../lib/FileSystem/fnFileMem.h"
+#include "../lib/FileSystem/fnFsSD.h"
+#include "../lib/config/fnConfig.h"
+
+#define CACHE_TEST_HOST "cachetest:16384/"
+// Room for four blocks
+#define CACHE_TEST_BUDGET_KB (BLOCK_CACHE_BLOCK_SIZE * 4 / 1024)
+
+// Remote reads, over all test files
+static uint32_t remote_reads;
+
+static uint8_t pattern(uint32_t pos, uint32_t seed)
+{
+    return (uint8_t)(pos * 7 + (pos >> 9) + seed);
+}
+
+/**
+ * In memory remote file that counts reads
+ */
+class RemoteFile : public FileHandlerMem
+{
+public:
+    RemoteFile(uint32_t size, uint32_t seed)
+    {
+        uint8_t buf[256];
+        for (uint32_t pos = 0; pos < size; pos += sizeof(buf))
+        {
+            uint32_t n = size - pos < sizeof(buf) ? size - pos : sizeof(buf);
+            for (uint32_t i = 0; i < n; i++)
+                buf[i] = pattern(pos + i, seed);
+            write(buf, 1, n);
+        }
+        seek(0, SEEK_SET);
+    }
+
+    size_t read(void *ptr, size_t size, size_t count) override
+    {
+        remote_reads++;
+        return FileHandlerMem::read(ptr, size, count);
+    }
+};
+
+/**
+ * A remote file, its name and modification time, new for each test run so
+ * nothing is found from a run before
+ */
+struct CacheTestFile
+{
+    char path[32];
+    uint32_t size;
+    uint32_t mtime;
+    FileHandler *remote = nullptr;
+
+    CacheTestFile(const char *name, uint32_t file_size)
+    {
+        snprintf(path, sizeof(path), "/%s.atr", name);
+        size = file_size;
+        mtime = esp_random();
+    }
+
+    FileHandler *open()
+    {
+        remote = new RemoteFile(size, mtime);
+        return BlockCache::wrap(remote, CACHE_TEST_HOST, path, size, mtime);
+    }
+};
+
+// Read the file in pieces of the given size from pos to the end
+static bool read_check(FileHandler *fh, const CacheTestFile &file, uint32_t pos, uint32_t piece)
+{
+    uint8_t buf[1000];
+    if (fh->seek(pos, SEEK_SET) != 0)
+        return false;
+    while (pos < file.size)
+    {
+        uint32_t n = file.size - pos < piece ? file.size - pos : piece;
+        if (fh->read(buf, 1, n) != n)
+            return false;
+        for (uint32_t i = 0; i < n; i++)
+            if (buf[i] != pattern(pos + i, file.mtime))
+                return false;
+        pos += n;
+    }
+    return fh->read(buf, 1, 1) == 0;
+}
+
+// Set the cache budget for a test, false if there's no SD card to cache on
+static bool start_cache(int budget_kb)
+{
+    if (!fnSDFAT.running() && !fnSDFAT.start())
+        return false;
+    Config.store_general_blockcache_size(budget_kb);
+    return BlockCache::enabled();
+}
+
+void tests_block_cache_disabled()
+{
+    int budget = Config.get_general_blockcache_size();
+    Config.store_general_blockcache_size(0);
+    TEST_ASSERT_FALSE(BlockCache::enabled());
+
+    CacheTestFile file("disabled", BLOCK_CACHE_BLOCK_SIZE);
+    FileHandler *remote = new RemoteFile(file.size, file.mtime);
+    FileHandler *fh = BlockCache::wrap(remote, CACHE_TEST_HOST, file.path, file.size, file.mtime);
+    TEST_ASSERT_EQUAL_PTR(remote, fh);
+    fh->close();
+
+    Config.store_general_blockcache_size(budget);
+}
+
+void tests_block_cache_read()
+{
+    int budget = Config.get_general_blockcache_size();
+    if (!start_cache(CACHE_TEST_BUDGET_KB))
+    {
+        Config.store_general_blockcache_size(budget);
+        TEST_IGNORE_MESSAGE("No SD card");
+        return;
+    }
+
+    // Two and a half blocks
+    CacheTestFile file("read", BLOCK_CACHE_BLOCK_SIZE * 5 / 2);
+    bc_stats before = BlockCache::stats();
+    remote_reads = 0;
+
+    FileHandler *fh = file.open();
+    TEST_ASSERT_TRUE(fh != file.remote);
+    TEST_ASSERT_TRUE(read_check(fh, file, 0, 1000));
+    TEST_ASSERT_EQUAL(3, remote_reads);
+    TEST_ASSERT_EQUAL(before.misses + 3, BlockCache::stats().misses);
+
+    // Back into the blocks already read, from the SD card
+    TEST_ASSERT_TRUE(read_check(fh, file, 100, 333));
+    TEST_ASSERT_EQUAL(3, remote_reads);
+    TEST_ASSERT_EQUAL(before.hits + 3, BlockCache::stats().hits);
+
+    // Open again does not read the remote file at all
+    TEST_ASSERT_EQUAL(0, fh->close());
+    fh = file.open();
+    TEST_ASSERT_TRUE(read_check(fh, file, 0, 1000));
+    TEST_ASSERT_EQUAL(3, remote_reads);
+    TEST_ASSERT_EQUAL(before.hits + 6, BlockCache::stats().hits);
+    TEST_ASSERT_EQUAL(before.misses + 3, BlockCache::stats().misses);
+
+    // A file that changed on the server is a new entry
+    file.mtime++;
+    FileHandler *changed = file.open();
+    TEST_ASSERT_TRUE(read_check(changed, file, 0, 1000));
+    TEST_ASSERT_EQUAL(6, remote_reads);
+
+    // The same file open twice is only cached by the first
+    file.mtime--;
+    FileHandler *other = file.open();
+    TEST_ASSERT_EQUAL_PTR(file.remote, other);
+    TEST_ASSERT_TRUE(read_check(other, file, 0, 1000));
+
+    fh->close();
+    changed->close();
+    other->close();
+    Config.store_general_blockcache_size(budget);
+}
+
+void tests_block_cache_evict()
+{
+    int budget = Config.get_general_blockcache_size();
+    if (!start_cache(CACHE_TEST_BUDGET_KB))
+    {
+        Config.store_general_blockcache_size(budget);
+        TEST_IGNORE_MESSAGE("No SD card");
+        return;
+    }
+
+    CacheTestFile first("first", BLOCK_CACHE_BLOCK_SIZE * 3);
+    CacheTestFile second("second", BLOCK_CACHE_BLOCK_SIZE * 3);
+    remote_reads = 0;
+
+    // The second file can't push out the first while it is open: it is
+    // read right but only what fits is cached
+    FileHandler *fh = first.open();
+    TEST_ASSERT_TRUE(read_check(fh, first, 0, 1000));
+    FileHandler *fh2 = second.open();
+    uint32_t evictions = BlockCache::stats().evictions;
+    TEST_ASSERT_TRUE(read_check(fh2, second, 0, 1000));
+    TEST_ASSERT_TRUE(BlockCache::stats().used <= BLOCK_CACHE_BLOCK_SIZE * 4);
+    fh2->close();
+    TEST_ASSERT_EQUAL(6, remote_reads);
+
+    // Once closed the first file can be pushed out
+    fh->close();
+    fh2 = second.open();
+    TEST_ASSERT_TRUE(read_check(fh2, second, 0, 1000));
+    TEST_ASSERT_EQUAL(8, remote_reads);
+    TEST_ASSERT_TRUE(BlockCache::stats().evictions > evictions);
+    TEST_ASSERT_TRUE(BlockCache::stats().used <= BLOCK_CACHE_BLOCK_SIZE * 4);
+    fh2->close();
+
+    remote_reads = 0;
+    fh = first.open();
+    TEST_ASSERT_TRUE(read_check(fh, first, 0, 1000));
+    TEST_ASSERT_EQUAL(3, remote_reads);
+    fh->close();
+
+    Config.store_general_blockcache_size(budget);
+}
+
+#else
+
+void tests_block_cache_disabled()
+{
+    TEST_IGNORE_MESSAGE("The block cache needs fnio");
+}
+
+void tests_block_cache_read()
+{
+    TEST_IGNORE_MESSAGE("The block cache needs fnio");
+}
+
+void tests_block_cache_evict()
+{
+    TEST_IGNORE_MESSAGE("The block cache needs fnio");
+}
+
+#endif /* FNIO_IS_STDIO */
+
+void tests_block_cache()
+{
+    RUN_TEST(tests_block_cache_disabled);
+    RUN_TEST(tests_block_cache_read);
+    RUN_TEST(tests_block_cache_evict);
+}
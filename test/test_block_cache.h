@@ -0,0 +1,41 @@
+/**
+ * #FujiNet Tests - SD block cache
+ *
+ * Opens in memory "remote" files through the SD block cache and checks the
+ * data, how often the remote file is read, reopening and eviction.
+ */
+
+#ifndef TEST_BLOCK_CACHE_H
+#define TEST_BLOCK_CACHE_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_block_cache();
+
+    /**
+     * Test that files are passed through untouched without a budget
+     */
+    void tests_block_cache_disabled();
+
+    /**
+     * Test reading a file, then reading it again from the cache
+     */
+    void tests_block_cache_read();
+
+    /**
+     * Test that a full cache evicts closed files but not open ones
+     */
+    void tests_block_cache_evict();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_BLOCK_CACHE_H */
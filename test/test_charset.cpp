@@ -0,0 +1,285 @@
+/**
+ * #FujiNet Tests - Character set conversion
+ *
+ * Compares the table driven PETSCII, UTF-8 and ATASCII conversions with the
+ * original per character versions, and times directory listing conversion
+ * both ways.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <esp_timer.h>
+#include "../lib/utils/charset.h"
+#include "../lib/utils/string_utils.h"
+#include "../lib/utils/U8Char.h"
+#include "test_charset.h"
+
+// Entries in each timed listing
+#define LISTING_ENTRIES 10000
+
+/**
+ * The original PETSCII to UTF-8, one U8Char at a time
+ */
+static std::string reference_to_utf8(const std::string &petsciiInput)
+{
+    std::string utf8string;
+    for (char petscii : petsciiInput)
+    {
+        if (petscii != 0)
+        {
+            U8Char u8char(petscii);
+            utf8string += u8char.toUtf8();
+        }
+    }
+    return utf8string;
+}
+
+/**
+ * The original UTF-8 to PETSCII, one U8Char at a time
+ */
+static std::string reference_to_petscii(const std::string &utfInputString)
+{
+    std::string petsciiString;
+    char *utfInput = (char *)utfInputString.c_str();
+    auto end = utfInput + utfInputString.length();
+
+    while (utfInput < end)
+    {
+        U8Char u8char(' ');
+        size_t skip = u8char.fromCharArray(utfInput);
+        petsciiString += u8char.toPetscii();
+        utfInput += skip;
+    }
+    return petsciiString;
+}
+
+/**
+ * The original ATASCII mapping lists, applied to every occurrence
+ */
+static std::string reference_to_atascii(std::string in, bool international)
+{
+    static const char *intl_from[] = {"á", "ù", "Ñ", "É", "ç", "ô", "ò", "ì", "£", "ï", "ü", "ä", "Ö", "ú", "ó", "ö", "Ü", "â", "û", "î", "é", "è", "ñ", "ê", "å", "à", "Å", "¡", "Ä", "ß"};
+    static const char *plain_from[] = {"Ä", "Ö", "Ü", "ä", "ö", "ü", "ß", "é", "è", "á", "à", "ó", "ò", "ú", "ù"};
+    static const char *plain_to[] = {"Ae", "Oe", "Ue", "ae", "oe", "ue", "ss", "e", "e", "a", "a", "o", "o", "u", "u"};
+
+    size_t count = international ? sizeof(intl_from) / sizeof(intl_from[0]) : sizeof(plain_from) / sizeof(plain_from[0]);
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string from = international ? intl_from[i] : plain_from[i];
+        std::string to;
+        if (!international)
+            to = plain_to[i];
+        else if (i < 27)
+            to = std::string(1, (char)i);
+        else
+            to = i == 27 ? "\x60" : i == 28 ? "\x7b" : "ss";
+
+        size_t pos = 0;
+        while ((pos = in.find(from, pos)) != std::string::npos)
+        {
+            in.replace(pos, from.size(), to);
+            pos += to.size();
+        }
+    }
+    return in;
+}
+
+static void append_utf8(std::string &s, uint16_t ch)
+{
+    U8Char u8(ch);
+    s += u8.toUtf8();
+}
+
+void tests_charset_petscii_to_utf8()
+{
+    char out[64];
+    char msg[80];
+
+    // Every byte on its own
+    for (int c = 0; c < 256; c++)
+    {
+        std::string in(1, (char)c);
+        snprintf(msg, sizeof(msg), "PETSCII %02x", c);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(reference_to_utf8(in).c_str(), mstr::toUTF8(in).c_str(), msg);
+    }
+
+    srand(11);
+    for (int round = 0; round < 500; round++)
+    {
+        std::string in;
+        size_t len = rand() % 40;
+        for (size_t i = 0; i < len; i++)
+            in += (char)(rand() % 8 ? rand() : 0);
+
+        std::string expected = reference_to_utf8(in);
+        std::string s = in;
+        charset::petscii_to_utf8(s);
+        TEST_ASSERT_EQUAL(expected.size(), s.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), s.data(), s.size());
+        TEST_ASSERT_EQUAL(expected.size(), charset::petscii_to_utf8_size(in.data(), in.size()));
+
+        // Caller buffer too small: whole characters only, continue from used
+        std::string pieces;
+        size_t pos = 0;
+        while (pos < in.size())
+        {
+            size_t used;
+            size_t n = charset::petscii_to_utf8(in.data() + pos, in.size() - pos, out, 3 + rand() % 5, &used);
+            pieces.append(out, n);
+            pos += used;
+        }
+        TEST_ASSERT_EQUAL(expected.size(), pieces.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), pieces.data(), pieces.size());
+    }
+}
+
+void tests_charset_utf8_to_petscii()
+{
+    srand(12);
+    for (int round = 0; round < 500; round++)
+    {
+        // ASCII, Latin-1, box drawing, PETSCII private use, stray bytes
+        std::string in;
+        size_t chars = rand() % 30;
+        for (size_t i = 0; i < chars; i++)
+        {
+            switch (rand() % 6)
+            {
+            case 0:
+            case 1:
+                in += (char)(0x20 + rand() % 0x5f);
+                break;
+            case 2:
+                append_utf8(in, 0x80 + rand() % 0x780);
+                break;
+            case 3:
+                append_utf8(in, charset::petscii_ucs[rand() % 256]);
+                break;
+            case 4:
+                append_utf8(in, 0x800 + rand() % 0xf000);
+                break;
+            default:
+                in += (char)(0x80 + rand() % 0x80);
+                break;
+            }
+        }
+        // No truncated sequence at the end, the original reads past it
+        if (!in.empty() && charset::utf8_lengths[(uint8_t)in.back()] > 1)
+            in.pop_back();
+
+        std::string expected = reference_to_petscii(in);
+        std::string got = mstr::toPETSCII2(in);
+        TEST_ASSERT_EQUAL(expected.size(), got.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), got.data(), got.size());
+
+        charset::utf8_to_petscii(in);
+        TEST_ASSERT_EQUAL(expected.size(), in.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), in.data(), in.size());
+    }
+
+    // A sequence cut short reads the missing bytes as 0
+    std::string cut = "AB\xc3";
+    charset::utf8_to_petscii(cut);
+    TEST_ASSERT_EQUAL_STRING("ab\xc0", cut.c_str());
+}
+
+void tests_charset_atascii()
+{
+    const char *samples[] = {
+        "", "plain ascii", "Äpfel über Öl, süß", "Große Straße", "café crème brûlée", "¡Olé! Señor Ñandú £5",
+        "ÄäÄä ÖöÖö ÜüÜü ßß", "àáâãäåæçèéêëìíîïðñòóôõö÷øùúûüýþÿ", "ÀÁÂÃÄÅÆÇÈÉÊËÌÍÎÏ", "€ 日本 \xc3", "x\xc3\xa4",
+    };
+
+    for (const char *sample : samples)
+    {
+        for (bool international : {false, true})
+        {
+            std::string expected = reference_to_atascii(sample, international);
+            std::string got = sample;
+            charset::utf8_to_atascii(got, international);
+            TEST_ASSERT_EQUAL(expected.size(), got.size());
+            TEST_ASSERT_EQUAL_MEMORY(expected.data(), got.data(), got.size());
+        }
+    }
+}
+
+void tests_charset_timing()
+{
+    char msg[200];
+
+    // D64/D81 directory: 16 PETSCII characters padded with shifted spaces
+    std::vector<std::string> disk(LISTING_ENTRIES);
+    srand(13);
+    for (auto &entry : disk)
+    {
+        char name[16];
+        size_t len = 1 + rand() % 16;
+        for (size_t i = 0; i < 16; i++)
+            name[i] = i < len ? (rand() % 4 ? 0x41 + rand() % 26 : 0x20 + rand() % 0xc0) : 0xa0;
+        entry.assign(name, 16);
+    }
+
+    // TNFS directory: UTF-8 names, mostly ASCII
+    std::vector<std::string> tnfs(LISTING_ENTRIES);
+    for (auto &entry : tnfs)
+    {
+        size_t len = 4 + rand() % 40;
+        for (size_t i = 0; i < len; i++)
+        {
+            if (rand() % 10)
+                entry += (char)(0x20 + rand() % 0x5f);
+            else
+                append_utf8(entry, 0xa0 + rand() % 0x60);
+        }
+    }
+
+    // Each entry as the directory code handles it: trim, then convert
+    size_t check = 0;
+    int64_t t0 = esp_timer_get_time();
+    for (const auto &entry : disk)
+    {
+        std::string name = entry.substr(0, entry.find_first_of('\xa0'));
+        check += reference_to_utf8(name).size();
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (const auto &entry : disk)
+    {
+        std::string name = entry.substr(0, entry.find_first_of('\xa0'));
+        charset::petscii_to_utf8(name);
+        check -= name.size();
+    }
+    int64_t t2 = esp_timer_get_time();
+    for (const auto &entry : tnfs)
+    {
+        std::string name = entry;
+        check += reference_to_petscii(name).size();
+    }
+    int64_t t3 = esp_timer_get_time();
+    for (const auto &entry : tnfs)
+    {
+        std::string name = entry;
+        charset::utf8_to_petscii(name);
+        check -= name.size();
+    }
+    int64_t t4 = esp_timer_get_time();
+
+    TEST_ASSERT_EQUAL(0, check);
+
+    snprintf(msg, sizeof(msg), "%d D64/D81 entries to UTF-8: original %lld us, tables %lld us",
+             LISTING_ENTRIES, (long long)(t1 - t0), (long long)(t2 - t1));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "%d TNFS entries to PETSCII: original %lld us, tables %lld us",
+             LISTING_ENTRIES, (long long)(t3 - t2), (long long)(t4 - t3));
+    TEST_MESSAGE(msg);
+}
+
+void tests_charset()
+{
+    RUN_TEST(tests_charset_petscii_to_utf8);
+    RUN_TEST(tests_charset_utf8_to_petscii);
+    RUN_TEST(tests_charset_atascii);
+    RUN_TEST(tests_charset_timing);
+}
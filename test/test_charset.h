@@ -0,0 +1,47 @@
+/**
+ * #FujiNet Tests - Character set conversion
+ *
+ * Compares the table driven PETSCII, UTF-8 and ATASCII conversions with the
+ * original per character versions, and times directory listing conversion
+ * both ways.
+ */
+
+#ifndef TEST_CHARSET_H
+#define TEST_CHARSET_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_charset();
+
+    /**
+     * Test PETSCII to UTF-8 against U8Char
+     */
+    void tests_charset_petscii_to_utf8();
+
+    /**
+     * Test UTF-8 to PETSCII against U8Char
+     */
+    void tests_charset_utf8_to_petscii();
+
+    /**
+     * Test the ATASCII mappings against the original replacement lists
+     */
+    void tests_charset_atascii();
+
+    /**
+     * Report directory listing conversion throughput for both versions
+     */
+    void tests_charset_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_CHARSET_H */
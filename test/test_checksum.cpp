@@ -0,0 +1,152 @@
+/**
+ * #FujiNet Tests - Checksums
+ *
+ * Checks CRC-32 and Adler-32 against known vectors and the original byte at
+ * a time versions, and times both over a printer page worth of data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <esp_timer.h>
+#include "../lib/encoding/checksum.h"
+#include "test_checksum.h"
+
+// Bytes checksummed in each timed run
+#define TIMING_SIZE (256 * 1024)
+
+/**
+ * The original PNG printer CRC-32, one table lookup per byte
+ */
+static uint32_t reference_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    static uint32_t table[256];
+    if (table[1] == 0)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t rem = i;
+            for (int j = 0; j < 8; j++)
+                rem = (rem & 1) ? (rem >> 1) ^ 0xedb88320 : rem >> 1;
+            table[i] = rem;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = (crc >> 8) ^ table[(crc & 0xff) ^ buf[i]];
+    return ~crc;
+}
+
+/**
+ * The original PNG printer Adler-32, reducing after every byte
+ */
+static uint32_t reference_adler32(uint32_t adler, const uint8_t *buf, size_t len)
+{
+    uint32_t s1 = adler & 0xffff;
+    uint32_t s2 = (adler >> 16) & 0xffff;
+    for (size_t i = 0; i < len; i++)
+    {
+        s1 = (s1 + buf[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    return (s2 << 16) | s1;
+}
+
+static uint32_t crc32_of(const char *s)
+{
+    return Checksum::crc32(0, (const uint8_t *)s, strlen(s));
+}
+
+static uint32_t adler32_of(const char *s)
+{
+    return Checksum::adler32(1, (const uint8_t *)s, strlen(s));
+}
+
+void tests_checksum_vectors()
+{
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, crc32_of(""));
+    TEST_ASSERT_EQUAL_HEX32(0xcbf43926, crc32_of("123456789"));
+    TEST_ASSERT_EQUAL_HEX32(0x414fa339, crc32_of("The quick brown fox jumps over the lazy dog"));
+
+    TEST_ASSERT_EQUAL_HEX32(0x00000001, adler32_of(""));
+    TEST_ASSERT_EQUAL_HEX32(0x091e01de, adler32_of("123456789"));
+    TEST_ASSERT_EQUAL_HEX32(0x11e60398, adler32_of("Wikipedia"));
+
+    // All 0xff is the worst case for the deferred Adler-32 modulo
+    std::vector<uint8_t> ones(20000, 0xff);
+    TEST_ASSERT_EQUAL_HEX32(reference_adler32(1, ones.data(), ones.size()),
+                            Checksum::adler32(1, ones.data(), ones.size()));
+    TEST_ASSERT_EQUAL_HEX32(reference_crc32(0, ones.data(), ones.size()),
+                            Checksum::crc32(0, ones.data(), ones.size()));
+}
+
+void tests_checksum_reference()
+{
+    std::vector<uint8_t> data(12000);
+    srand(5);
+    for (auto &b : data)
+        b = rand();
+
+    // Every start alignment, lengths around the slice and modulo boundaries
+    const size_t lengths[] = {0, 1, 7, 8, 9, 15, 16, 17, 100, 5551, 5552, 5553, 11000};
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len : lengths)
+        {
+            const uint8_t *p = data.data() + offset;
+            TEST_ASSERT_EQUAL_HEX32(reference_crc32(0, p, len), Checksum::crc32(0, p, len));
+            TEST_ASSERT_EQUAL_HEX32(reference_adler32(1, p, len), Checksum::adler32(1, p, len));
+        }
+    }
+
+    // Continuing over a split gives the same result as one call
+    for (size_t split : {1, 3, 8, 333, 5552, 7000})
+    {
+        uint32_t crc = Checksum::crc32(0, data.data(), split);
+        crc = Checksum::crc32(crc, data.data() + split, data.size() - split);
+        TEST_ASSERT_EQUAL_HEX32(Checksum::crc32(0, data.data(), data.size()), crc);
+
+        uint32_t adler = Checksum::adler32(1, data.data(), split);
+        adler = Checksum::adler32(adler, data.data() + split, data.size() - split);
+        TEST_ASSERT_EQUAL_HEX32(Checksum::adler32(1, data.data(), data.size()), adler);
+    }
+}
+
+void tests_checksum_timing()
+{
+    char msg[200];
+
+    std::vector<uint8_t> data(TIMING_SIZE);
+    srand(9);
+    for (auto &b : data)
+        b = rand();
+
+    int64_t t0 = esp_timer_get_time();
+    uint32_t crc_ref = reference_crc32(0, data.data(), data.size());
+    int64_t t1 = esp_timer_get_time();
+    uint32_t crc = Checksum::crc32(0, data.data(), data.size());
+    int64_t t2 = esp_timer_get_time();
+    uint32_t adler_ref = reference_adler32(1, data.data(), data.size());
+    int64_t t3 = esp_timer_get_time();
+    uint32_t adler = Checksum::adler32(1, data.data(), data.size());
+    int64_t t4 = esp_timer_get_time();
+
+    TEST_ASSERT_EQUAL_HEX32(crc_ref, crc);
+    TEST_ASSERT_EQUAL_HEX32(adler_ref, adler);
+
+    snprintf(msg, sizeof(msg), "CRC-32 of %d bytes: byte at a time %lld us, slice-by-8 %lld us",
+             TIMING_SIZE, (long long)(t1 - t0), (long long)(t2 - t1));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "Adler-32 of %d bytes: byte at a time %lld us, deferred modulo %lld us",
+             TIMING_SIZE, (long long)(t3 - t2), (long long)(t4 - t3));
+    TEST_MESSAGE(msg);
+}
+
+void tests_checksum()
+{
+    RUN_TEST(tests_checksum_vectors);
+    RUN_TEST(tests_checksum_reference);
+    RUN_TEST(tests_checksum_timing);
+}
@@ -0,0 +1,41 @@
+/**
+ * #FujiNet Tests - Checksums
+ *
+ * Checks CRC-32 and Adler-32 against known vectors and the original byte at
+ * a time versions, and times both over a printer page worth of data.
+ */
+
+#ifndef TEST_CHECKSUM_H
+#define TEST_CHECKSUM_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_checksum();
+
+    /**
+     * Test both checksums against published vectors
+     */
+    void tests_checksum_vectors();
+
+    /**
+     * Test buffers of every alignment and split against the byte at a time versions
+     */
+    void tests_checksum_reference();
+
+    /**
+     * Report throughput of the byte at a time and buffer versions
+     */
+    void tests_checksum_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_CHECKSUM_H */
@@ -0,0 +1,79 @@
+/**
+ * #FujiNet Tests - HTTP Content-Range parsing
+ *
+ * Parses Content-Range header values as sent with 206 and 416 responses,
+ * with and without a known total, and rejects values that aren't byte
+ * ranges.
+ */
+
+#include <stdio.h>
+#include "test_content_range.h"
+#include "../lib/utils/utils.h"
+
+// Parse value, expecting it to succeed with the given fields
+static void check_range(const char *value, uint32_t first, uint32_t last, uint32_t total)
+{
+    uint32_t f = 0xdead, l = 0xdead, t = 0xdead;
+    TEST_ASSERT_TRUE_MESSAGE(util_parse_content_range(value, &f, &l, &t), value);
+    TEST_ASSERT_EQUAL_MESSAGE(first, f, value);
+    TEST_ASSERT_EQUAL_MESSAGE(last, l, value);
+    TEST_ASSERT_EQUAL_MESSAGE(total, t, value);
+}
+
+void tests_content_range_valid()
+{
+    check_range("bytes 0-0/1", 0, 0, 1);
+    check_range("bytes 0-511/175531", 0, 511, 175531);
+    check_range("bytes 175104-175530/175531", 175104, 175530, 175531);
+    check_range("  bytes  512-1023/2048", 512, 1023, 2048);
+    check_range("Bytes 1-1/2", 1, 1, 2);
+}
+
+void tests_content_range_unknown()
+{
+    // Sent with 416 Range Not Satisfiable
+    check_range("bytes */123", 0, 0, 123);
+    check_range("bytes */0", 0, 0, 0);
+
+    // The server doesn't know the length yet
+    check_range("bytes 0-99/*", 0, 99, 0);
+    check_range("bytes */*", 0, 0, 0);
+}
+
+void tests_content_range_malformed()
+{
+    const char *values[] = {
+        "",
+        "bytes",
+        "bytes ",
+        "items 0-1/2",
+        "bytes 0-1",
+        "bytes 0-1/",
+        "bytes 0-/10",
+        "bytes -1/10",
+        "bytes 0 1/10",
+        "bytes 5-2/10",
+        "bytes a-b/c",
+        "bytes *-1/10",
+        "bytes 0-1*",
+    };
+
+    for (const char *value : values)
+    {
+        uint32_t f = 0xdead, l = 0xdead, t = 0xdead;
+        TEST_ASSERT_FALSE_MESSAGE(util_parse_content_range(value, &f, &l, &t), value);
+        TEST_ASSERT_EQUAL_MESSAGE(0xdead, f, value);
+        TEST_ASSERT_EQUAL_MESSAGE(0xdead, l, value);
+        TEST_ASSERT_EQUAL_MESSAGE(0xdead, t, value);
+    }
+
+    uint32_t f, l, t;
+    TEST_ASSERT_FALSE(util_parse_content_range(nullptr, &f, &l, &t));
+}
+
+void tests_content_range()
+{
+    RUN_TEST(tests_content_range_valid);
+    RUN_TEST(tests_content_range_unknown);
+    RUN_TEST(tests_content_range_malformed);
+}
@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - HTTP Content-Range parsing
+ *
+ * Parses Content-Range header values as sent with 206 and 416 responses,
+ * with and without a known total, and rejects values that aren't byte
+ * ranges.
+ */
+
+#ifndef TEST_CONTENT_RANGE_H
+#define TEST_CONTENT_RANGE_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_content_range();
+
+    /**
+     * Test ranges with a known total, including a single byte
+     */
+    void tests_content_range_valid();
+
+    /**
+     * Test an unsatisfied range and an unknown total
+     */
+    void tests_content_range_unknown();
+
+    /**
+     * Test that malformed values fail and leave the outputs alone
+     */
+    void tests_content_range_malformed();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_CONTENT_RANGE_H */
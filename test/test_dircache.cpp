@@ -0,0 +1,287 @@
+/**
+ * #FujiNet Tests - Directory cache
+ *
+ * Checks filtered listings read page by page, in order or after seeks,
+ * against the original filter and full sort, and times opening a large
+ * synthetic directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <esp_timer.h>
+#include "../lib/FileSystem/fnDirCache.h"
+#include "../lib/utils/utils.h"
+#include "test_dircache.h"
+
+// Entries are MAX_PATHLEN bytes each, 50000 won't fit on most boards
+#ifndef DIRCACHE_TEST_ENTRIES
+#define DIRCACHE_TEST_ENTRIES 4000
+#endif
+
+#define PAGE 20
+
+static const uint16_t all_diropts[] = {0, DIR_OPTION_DESCENDING, DIR_OPTION_FILEDATE,
+                                       DIR_OPTION_FILEDATE | DIR_OPTION_DESCENDING};
+static const char *patterns[] = {"", "*a*", "G*/", "*.ATR", "nothing matches this"};
+
+/**
+ * The original sort functions
+ */
+static bool ref_name_ascend(const fsdir_entry *left, const fsdir_entry *right)
+{
+    if (left->isDir == right->isDir)
+        return strcasecmp(left->filename, right->filename) < 0;
+    return left->isDir;
+}
+
+static bool ref_name_descend(const fsdir_entry *left, const fsdir_entry *right)
+{
+    if (left->isDir == right->isDir)
+        return strcasecmp(left->filename, right->filename) > 0;
+    return left->isDir;
+}
+
+static bool ref_time_ascend(const fsdir_entry *left, const fsdir_entry *right)
+{
+    if (left->isDir == right->isDir)
+        return left->modified_time > right->modified_time;
+    return left->isDir;
+}
+
+static bool ref_time_descend(const fsdir_entry *left, const fsdir_entry *right)
+{
+    if (left->isDir == right->isDir)
+        return left->modified_time < right->modified_time;
+    return left->isDir;
+}
+
+/**
+ * The original filter and sort
+ */
+static std::vector<const fsdir_entry *> reference_listing(const std::vector<fsdir_entry> &entries, const char *pattern, uint16_t diropts)
+{
+    std::vector<const fsdir_entry *> result;
+    bool have_pattern = pattern != nullptr && pattern[0] != '\0';
+    bool filter_dirs = have_pattern && pattern[strlen(pattern) - 1] == '/';
+
+    for (const fsdir_entry &entry : entries)
+    {
+        if (have_pattern && (!entry.isDir || filter_dirs) && !util_wildcard_match(entry.filename, pattern))
+            continue;
+        result.push_back(&entry);
+    }
+
+    bool (*sortfn)(const fsdir_entry *, const fsdir_entry *);
+    if (diropts & DIR_OPTION_FILEDATE)
+        sortfn = (diropts & DIR_OPTION_DESCENDING) ? ref_time_descend : ref_time_ascend;
+    else
+        sortfn = (diropts & DIR_OPTION_DESCENDING) ? ref_name_descend : ref_name_ascend;
+    std::sort(result.begin(), result.end(), sortfn);
+    return result;
+}
+
+/**
+ * Random entries, with long common prefixes and equal times
+ */
+static void make_entries(std::vector<fsdir_entry> &entries, size_t count)
+{
+    static const char *prefixes[] = {"", "Games", "GAMES_", "games_collection_", "Demo", "a", "zz"};
+    static const char *suffixes[] = {".ATR", ".atr", ".XEX", ".po", ""};
+
+    entries.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        fsdir_entry &e = entries[i];
+        char name[40];
+        int len = 1 + rand() % 12;
+        for (int k = 0; k < len; k++)
+        {
+            int r = rand() % 40;
+            name[k] = r < 26 ? 'a' + r : (r < 36 ? '0' + r - 26 : "AB_ "[r - 36]);
+        }
+        name[len] = '\0';
+        e.isDir = rand() % 10 == 0;
+        snprintf(e.filename, sizeof(e.filename), "%s%s%s", prefixes[rand() % 7], name, e.isDir ? "" : suffixes[rand() % 5]);
+        e.size = rand();
+        e.modified_time = 1600000000 + rand() % 5000;
+    }
+}
+
+static void fill_cache(DirCache &cache, const std::vector<fsdir_entry> &entries)
+{
+    cache.clear();
+    for (const fsdir_entry &e : entries)
+        cache.new_entry() = e;
+}
+
+/**
+ * Read entries [pos, pos + count) and compare with the reference listing.
+ * Entries that compare equal may come in either order, so the sort fields
+ * are compared.
+ */
+static void check_page(DirCache &cache, const std::vector<const fsdir_entry *> &ref, uint16_t diropts, size_t pos, size_t count)
+{
+    TEST_ASSERT_TRUE(cache.seek(pos));
+    for (size_t i = pos; i < pos + count && i < ref.size(); i++)
+    {
+        fsdir_entry *e = cache.read();
+        TEST_ASSERT_TRUE(e != nullptr);
+        TEST_ASSERT_EQUAL(ref[i]->isDir, e->isDir);
+        if (diropts & DIR_OPTION_FILEDATE)
+            TEST_ASSERT_EQUAL_UINT32(ref[i]->modified_time, e->modified_time);
+        else
+            TEST_ASSERT_EQUAL(0, strcasecmp(ref[i]->filename, e->filename));
+    }
+    if (pos + count >= ref.size())
+        TEST_ASSERT_TRUE(cache.read() == nullptr);
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_dircache()
+{
+    RUN_TEST(tests_dircache_order);
+    RUN_TEST(tests_dircache_seek);
+    RUN_TEST(tests_dircache_timing);
+}
+
+void tests_dircache_order()
+{
+    static std::vector<fsdir_entry> entries;
+    DirCache cache;
+
+    srand(1);
+    for (size_t count : {0, 1, 5, 33, 1000})
+    {
+        make_entries(entries, count);
+        fill_cache(cache, entries);
+        for (const char *pattern : patterns)
+        {
+            for (uint16_t diropts : all_diropts)
+            {
+                std::vector<const fsdir_entry *> ref = reference_listing(entries, pattern, diropts);
+                cache.apply_filter(pattern, diropts);
+                TEST_ASSERT_EQUAL(ref.empty() ? FNFS_INVALID_DIRPOS : 0, cache.tell());
+                check_page(cache, ref, diropts, 0, ref.size());
+
+                // the same entries, each once
+                std::vector<std::string> names, ref_names;
+                cache.seek(0);
+                for (fsdir_entry *e; (e = cache.read()) != nullptr;)
+                    names.push_back(e->filename);
+                for (const fsdir_entry *e : ref)
+                    ref_names.push_back(e->filename);
+                std::sort(names.begin(), names.end());
+                std::sort(ref_names.begin(), ref_names.end());
+                TEST_ASSERT_TRUE(names == ref_names);
+            }
+        }
+    }
+}
+
+void tests_dircache_seek()
+{
+    static std::vector<fsdir_entry> entries;
+    DirCache cache;
+
+    srand(2);
+    make_entries(entries, 3000);
+    fill_cache(cache, entries);
+
+    for (int round = 0; round < 200; round++)
+    {
+        const char *pattern = patterns[rand() % 3];
+        uint16_t diropts = all_diropts[rand() % 4];
+        std::vector<const fsdir_entry *> ref = reference_listing(entries, pattern, diropts);
+        cache.apply_filter(pattern, diropts);
+
+        // pages forwards, backwards and anywhere, like a user paging through
+        size_t pos = 0;
+        for (int page = 0; page < 10 && !ref.empty(); page++)
+        {
+            int r = rand() % 3;
+            if (r == 0)
+                pos = pos + PAGE < ref.size() ? pos + PAGE : pos;
+            else if (r == 1)
+                pos = pos >= PAGE ? pos - PAGE : 0;
+            else
+                pos = rand() % ref.size();
+            check_page(cache, ref, diropts, pos, PAGE);
+        }
+        TEST_ASSERT_FALSE(cache.seek(ref.size() + 1));
+    }
+
+    // a new entry drops the listings made so far
+    cache.apply_filter("", 0);
+    fsdir_entry &e = cache.new_entry();
+    strcpy(e.filename, "!first");
+    e.isDir = false;
+    e.modified_time = 0;
+    entries.push_back(e);
+    cache.apply_filter("", 0);
+    check_page(cache, reference_listing(entries, "", 0), 0, 0, PAGE);
+}
+
+void tests_dircache_timing()
+{
+    static std::vector<fsdir_entry> entries;
+    DirCache cache;
+    char msg[200];
+    const int rounds = 5;
+    int64_t t_ref = 0, t_first = 0, t_middle = 0, t_reopen = 0, t_all = 0;
+
+    srand(3);
+    make_entries(entries, DIRCACHE_TEST_ENTRIES);
+    fill_cache(cache, entries);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        const char *pattern = r & 1 ? "*a*" : "";
+        // original: filter and sort everything, then read a page
+        int64_t t0 = esp_timer_get_time();
+        std::vector<const fsdir_entry *> ref = reference_listing(entries, pattern, 0);
+        int64_t t1 = esp_timer_get_time();
+
+        // a new listing, and its first page
+        cache.clear();
+        fill_cache(cache, entries);
+        int64_t t2 = esp_timer_get_time();
+        cache.apply_filter(pattern, 0);
+        for (int i = 0; i < PAGE; i++)
+            cache.read();
+        int64_t t3 = esp_timer_get_time();
+        // a page in the middle
+        cache.seek(ref.size() / 2);
+        for (int i = 0; i < PAGE; i++)
+            cache.read();
+        int64_t t4 = esp_timer_get_time();
+        // back to the same listing
+        cache.apply_filter(pattern, 0);
+        cache.seek(PAGE);
+        for (int i = 0; i < PAGE; i++)
+            cache.read();
+        int64_t t5 = esp_timer_get_time();
+        // everything
+        cache.apply_filter(pattern, DIR_OPTION_FILEDATE);
+        while (cache.read() != nullptr)
+            ;
+        int64_t t6 = esp_timer_get_time();
+
+        t_ref += t1 - t0;
+        t_first += t3 - t2;
+        t_middle += t4 - t3;
+        t_reopen += t5 - t4;
+        t_all += t6 - t5;
+    }
+
+    snprintf(msg, sizeof(msg), "DirCache %d entries, us: first page %lld/%lld (original/new), middle page %lld, reopen %lld, whole listing %lld",
+             DIRCACHE_TEST_ENTRIES, (long long)(t_ref / rounds), (long long)(t_first / rounds),
+             (long long)(t_middle / rounds), (long long)(t_reopen / rounds), (long long)(t_all / rounds));
+    TEST_MESSAGE(msg);
+}
@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - Directory cache
+ *
+ * Checks filtered listings read page by page, in order or after seeks,
+ * against the original filter and full sort, and times opening a large
+ * synthetic directory.
+ */
+
+#ifndef TEST_DIRCACHE_H
+#define TEST_DIRCACHE_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_dircache();
+
+    /**
+     * Test whole listings for every sort order and some patterns
+     */
+    void tests_dircache_order();
+
+    /**
+     * Test pages read after random seeks, and switching between listings
+     */
+    void tests_dircache_seek();
+
+    /**
+     * Report time to the first page, a middle page and a reopen
+     */
+    void tests_dircache_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_DIRCACHE_H */
@@ -0,0 +1,224 @@
+/**
+ * #FujiNet Tests - Streaming JSON document
+ *
+ * Feeds documents in pieces of random size and compares validation and
+ * JSON pointer queries with cJSON_Parse() and cJSONUtils_GetPointer(),
+ * and compares memory used with parsing the whole document.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <cJSON.h>
+#include <cJSON_Utils.h>
+#include "../lib/fnjson/fnJsonStream.h"
+#include "test_fnjson_stream.h"
+
+// A few MB show the difference best, but won't fit on most boards
+#ifndef JSON_TEST_DOC_SIZE
+#define JSON_TEST_DOC_SIZE 200000
+#endif
+
+static const char *documents[] = {
+    "{\"a\":1,\"b\":[true,false,null],\"c\":{\"d\":\"e\"}}",
+    "  {\n  \"name\" : \"FujiNet\" ,\n  \"list\" : [ 1 , 2.5 , -3e2 , { \"x\" : [ ] } ] ,\n  \"empty\" : { }\n}\n  ",
+    "[[1,[2,[3,[4]]]],\"s\\\"q\\\\\",{\"A/B\":1,\"m~n\":2,\"\":3}]",
+    "{\"Key\":\"upper\",\"key\":\"lower\",\"esc\\u0041ped\":\"\\u00e9\\ud83d\\ude00\",\"sl\\/ash\":\"\\/\"}",
+    "\xEF\xBB\xBF{\"bom\":true}",
+    "{\"html\":\"<b>bold</b> text\",\"nested\":{\"deeper\":{\"deepest\":[{\"v\":\"found\"}]}}}",
+    "[0,10,100,1000,{\"k\":[\"a\",\"b\",\"c\",\"d\",\"e\",\"f\",\"g\",\"h\",\"i\",\"j\",\"k\",\"l\"]}]",
+    "\"just a string\"",
+    "42",
+    "{\"a\":1} trailing bytes are ignored",
+};
+
+static const char *pointers[] = {
+    "", "/", "/a", "/b", "/b/0", "/b/2", "/b/3", "/c", "/c/d", "/name", "/NAME", "/list",
+    "/list/1", "/list/3/x", "/list/4", "/empty", "/0", "/0/1/1/1", "/1", "/2/A~1B", "/2/m~0n",
+    "/2/", "/2/~2", "/key", "/escAped", "/sl~1ash", "/bom", "/nested/deeper/deepest/0/v",
+    "/4/k/11", "/4/k/12", "/01", "/-", "/a/b", "no slash", "/html",
+};
+
+static const char *invalid_documents[] = {
+    "", "   ", "{", "[1,2", "{\"a\":1,}", "[1,]", "{\"a\" 1}", "{a:1}", "[01x]", "[-]", "[1.2.3]",
+    "\"unterminated", "\"bad \\x escape\"", "\"\\ud800\"", "\"\\udc00\"", "\"\\ud800\\u0041\"",
+    "[nul]", "[truth]", "{\"a\":1]", "[1}", "\xEF\xBB", "+1", ".5", "]",
+};
+
+// Feed the document in pieces of random size
+static bool feed_random(FNJSONStream &stream, const char *doc, size_t len)
+{
+    stream.clear();
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t n = 1 + rand() % 17;
+        if (n > len - pos)
+            n = len - pos;
+        stream.feed(doc + pos, n);
+        pos += n;
+    }
+    return stream.finish();
+}
+
+static std::string print(cJSON *item)
+{
+    if (item == nullptr)
+        return "(none)";
+    char *s = cJSON_PrintUnformatted(item);
+    std::string result(s);
+    cJSON_free(s);
+    return result;
+}
+
+void tests_fnjson_stream_query()
+{
+    FNJSONStream stream;
+    char msg[200];
+
+    srand(5);
+    for (const char *doc : documents)
+    {
+        cJSON *ref = cJSON_Parse(doc);
+        TEST_ASSERT_TRUE(ref != nullptr);
+
+        for (int round = 0; round < 4; round++)
+        {
+            TEST_ASSERT_TRUE(feed_random(stream, doc, strlen(doc)));
+            for (const char *pointer : pointers)
+            {
+                cJSON *value = stream.get(pointer);
+                std::string expected = print(cJSONUtils_GetPointer(ref, pointer));
+                std::string got = print(value);
+                cJSON_Delete(value);
+                snprintf(msg, sizeof(msg), "doc %.30s pointer \"%s\"", doc, pointer);
+                TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.c_str(), got.c_str(), msg);
+            }
+        }
+        cJSON_Delete(ref);
+    }
+}
+
+void tests_fnjson_stream_valid()
+{
+    FNJSONStream stream;
+    char msg[100];
+
+    srand(6);
+    for (const char *doc : invalid_documents)
+    {
+        cJSON *ref = cJSON_Parse(doc);
+        TEST_ASSERT_TRUE(ref == nullptr);
+        snprintf(msg, sizeof(msg), "doc \"%s\"", doc);
+        TEST_ASSERT_FALSE_MESSAGE(feed_random(stream, doc, strlen(doc)), msg);
+        TEST_ASSERT_EQUAL(0, stream.size());
+        TEST_ASSERT_TRUE(stream.get("") == nullptr);
+    }
+
+    // Nesting limit
+    std::string deep(FNJSON_NESTING_LIMIT, '[');
+    deep += std::string(FNJSON_NESTING_LIMIT, ']');
+    TEST_ASSERT_TRUE(feed_random(stream, deep.data(), deep.size()));
+    deep = "[" + deep + "]";
+    TEST_ASSERT_FALSE(feed_random(stream, deep.data(), deep.size()));
+
+    // Document ends at NUL, as cJSON_Parse() sees it
+    const char with_nul[] = "{\"a\":[1,2]}\0garbage";
+    TEST_ASSERT_TRUE(feed_random(stream, with_nul, sizeof(with_nul)));
+    const char cut_by_nul[] = "{\"a\":[1,\0 2]}";
+    TEST_ASSERT_FALSE(feed_random(stream, cut_by_nul, sizeof(cut_by_nul)));
+
+    // Whitespace is dropped outside strings only
+    const char *spaced = " { \"a b\" :\t[ 1 ,\r\n 2 ] } ";
+    TEST_ASSERT_TRUE(feed_random(stream, spaced, strlen(spaced)));
+    TEST_ASSERT_EQUAL_STRING("{\"a b\":[1,2]}", std::string(stream.data(), stream.size()).c_str());
+}
+
+/**
+ * Count bytes cJSON has allocated
+ */
+static size_t heap_now = 0;
+static size_t heap_peak = 0;
+
+static void *count_malloc(size_t size)
+{
+    size_t *p = (size_t *)malloc(size + sizeof(size_t));
+    if (p == nullptr)
+        return nullptr;
+    *p = size;
+    heap_now += size;
+    if (heap_now > heap_peak)
+        heap_peak = heap_now;
+    return p + 1;
+}
+
+static void count_free(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    size_t *p = (size_t *)ptr - 1;
+    heap_now -= *p;
+    free(p);
+}
+
+void tests_fnjson_stream_memory()
+{
+    // Pretty printed array of records, like most web APIs send
+    std::string doc = "{\n  \"results\": [\n";
+    int records = 0;
+    while (doc.size() < JSON_TEST_DOC_SIZE)
+    {
+        char record[200];
+        snprintf(record, sizeof(record),
+                 "%s    {\n      \"id\": %d,\n      \"name\": \"Item %d\",\n      \"score\": %d.%d,\n"
+                 "      \"tags\": [\"a\", \"b\"],\n      \"active\": %s\n    }",
+                 records ? ",\n" : "", records, records, records % 100, records % 7, records & 1 ? "true" : "false");
+        doc += record;
+        records++;
+    }
+    doc += "\n  ]\n}\n";
+
+    char pointer[40];
+    snprintf(pointer, sizeof(pointer), "/results/%d/name", records - 1);
+
+    cJSON_Hooks hooks = {count_malloc, count_free};
+    cJSON_InitHooks(&hooks);
+
+    // Whole tree: the document, then its tree
+    heap_now = heap_peak = 0;
+    cJSON *tree = cJSON_Parse(doc.c_str());
+    TEST_ASSERT_TRUE(tree != nullptr);
+    std::string expected = print(cJSONUtils_GetPointer(tree, pointer));
+    size_t tree_peak = doc.size() + heap_peak;
+    cJSON_Delete(tree);
+
+    // Stream: compact text, then the value found
+    FNJSONStream stream;
+    const size_t chunk = 4096;
+    for (size_t pos = 0; pos < doc.size(); pos += chunk)
+        stream.feed(doc.data() + pos, doc.size() - pos < chunk ? doc.size() - pos : chunk);
+    TEST_ASSERT_TRUE(stream.finish());
+    heap_now = heap_peak = 0;
+    cJSON *value = stream.get(pointer);
+    std::string got = print(value);
+    cJSON_Delete(value);
+    size_t stream_peak = stream.size() + heap_peak;
+
+    cJSON_InitHooks(nullptr);
+
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), got.c_str());
+    TEST_ASSERT_TRUE(stream_peak < tree_peak);
+
+    char msg[200];
+    snprintf(msg, sizeof(msg), "JSON %u bytes, %d records: whole tree %u bytes, stream %u bytes",
+             (unsigned)doc.size(), records, (unsigned)tree_peak, (unsigned)stream_peak);
+    TEST_MESSAGE(msg);
+}
+
+void tests_fnjson_stream()
+{
+    RUN_TEST(tests_fnjson_stream_query);
+    RUN_TEST(tests_fnjson_stream_valid);
+    RUN_TEST(tests_fnjson_stream_memory);
+}
@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - Streaming JSON document
+ *
+ * Feeds documents in pieces of random size and compares validation and
+ * JSON pointer queries with cJSON_Parse() and cJSONUtils_GetPointer(),
+ * and compares memory used with parsing the whole document.
+ */
+
+#ifndef TEST_FNJSON_STREAM_H
+#define TEST_FNJSON_STREAM_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_fnjson_stream();
+
+    /**
+     * Test queries give the same values as cJSONUtils_GetPointer()
+     */
+    void tests_fnjson_stream_query();
+
+    /**
+     * Test documents cJSON rejects are rejected, and others accepted
+     */
+    void tests_fnjson_stream_valid();
+
+    /**
+     * Report memory for a large document, whole tree against stream
+     */
+    void tests_fnjson_stream_memory();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_FNJSON_STREAM_H */
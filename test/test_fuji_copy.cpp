@@ -0,0 +1,247 @@
+/**
+ * #FujiNet Tests - Host to host file copy
+ *
+ * Copies between in memory files through the reader and writer tasks,
+ * checking every byte, that reads run ahead of a slow writer only as far
+ * as the buffers allow, and that short reads and a failing write end the
+ * copy as failed.
+ */
+
+#include <stdio.h>
+#include "test_fuji_copy.h"
+#include "../lib/fuji/fujiCopy.h"
+#include "fnSystem.h"
+
+#ifndef FNIO_IS_STDIO
+
+#define COPY_TEST_BUFFERS 4
+#define COPY_TEST_BUFFER_SIZE 512
+
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 11 + (pos >> 8));
+}
+
+/**
+ * Source that makes up its bytes, size bytes of them
+ */
+class CopySource : public FileHandler
+{
+public:
+    uint32_t size;
+    uint32_t pos = 0;
+    bool closed = false;
+
+    CopySource(uint32_t file_size) : size(file_size) {}
+
+    int close(bool destroy) override
+    {
+        closed = true;
+        return 0;
+    }
+    int seek(long int off, int whence) override { return -1; }
+    long int tell() override { return pos; }
+    int flush() override { return 0; }
+
+    size_t read(void *ptr, size_t size_, size_t count) override
+    {
+        size_t n = size_ * count;
+        if (n > size - pos)
+            n = size - pos;
+        for (size_t i = 0; i < n; i++)
+            ((uint8_t *)ptr)[i] = pattern(pos + i);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const void *ptr, size_t size_, size_t count) override { return 0; }
+};
+
+/**
+ * Destination that checks the bytes, may write slowly and may stop taking
+ * them part way
+ */
+class CopyDest : public FileHandler
+{
+public:
+    fujiCopy *copy = nullptr;
+    uint32_t delay_ms = 0;
+    uint32_t fail_at = UINT32_MAX; // writes stop here
+    uint32_t pos = 0;
+    uint32_t max_ahead = 0; // most bytes the reader was ahead of the writer
+    bool busy = true;       // status() showed the copy running on every write
+    bool right = true;      // every byte was right
+    bool closed = false;
+
+    int close(bool destroy) override
+    {
+        closed = true;
+        return 0;
+    }
+    int seek(long int off, int whence) override { return -1; }
+    long int tell() override { return pos; }
+    int flush() override { return 0; }
+    size_t read(void *ptr, size_t size, size_t count) override { return 0; }
+
+    size_t write(const void *ptr, size_t size, size_t count) override
+    {
+        if (delay_ms)
+            fnSystem.delay(delay_ms);
+        if (copy != nullptr)
+        {
+            // This write isn't counted yet, so it's part of what the reader is ahead
+            uint32_t ahead = copy->bytes_read - copy->bytes_written;
+            if (ahead > max_ahead)
+                max_ahead = ahead;
+        }
+        busy = busy && fujiCopy::status().busy;
+
+        size_t n = size * count;
+        if (pos + n > fail_at)
+            n = fail_at > pos ? fail_at - pos : 0;
+        for (size_t i = 0; i < n; i++)
+            if (((const uint8_t *)ptr)[i] != pattern(pos + i))
+                right = false;
+        pos += n;
+        return n;
+    }
+};
+
+void tests_fuji_copy_handoff()
+{
+    const uint32_t sizes[] = {0, 1, COPY_TEST_BUFFER_SIZE - 1, COPY_TEST_BUFFER_SIZE, COPY_TEST_BUFFER_SIZE + 1, 5000};
+
+    for (uint32_t size : sizes)
+    {
+        fujiCopy copy(COPY_TEST_BUFFERS, COPY_TEST_BUFFER_SIZE);
+        CopySource src(size);
+        CopyDest dst;
+        dst.copy = &copy;
+
+        TEST_ASSERT_TRUE(copy.start(&src, &dst, size));
+        TEST_ASSERT_TRUE_MESSAGE(copy.wait(), "Copy failed");
+        TEST_ASSERT_EQUAL(size, dst.pos);
+        TEST_ASSERT_TRUE_MESSAGE(dst.right, "Bytes copied wrong");
+        TEST_ASSERT_EQUAL(size, copy.bytes_read);
+        TEST_ASSERT_EQUAL(size, copy.bytes_written);
+        TEST_ASSERT_TRUE(src.closed && dst.closed);
+        TEST_ASSERT_TRUE(dst.busy);
+
+        fujiCopyStatus status = fujiCopy::status();
+        TEST_ASSERT_FALSE(status.busy);
+        TEST_ASSERT_FALSE(status.failed);
+        TEST_ASSERT_EQUAL(size, status.bytes_written);
+        TEST_ASSERT_EQUAL(size, status.total);
+    }
+
+    // With a slow writer the reader fills every free buffer, and no more
+    for (bool one_buffer : {false, true})
+    {
+        const uint32_t size = 20 * COPY_TEST_BUFFER_SIZE;
+        fujiCopy copy(COPY_TEST_BUFFERS, COPY_TEST_BUFFER_SIZE);
+        CopySource src(size);
+        CopyDest dst;
+        dst.copy = &copy;
+        dst.delay_ms = 5;
+
+        TEST_ASSERT_TRUE(copy.start(&src, &dst, size, one_buffer));
+        TEST_ASSERT_TRUE_MESSAGE(copy.wait(), "Copy failed");
+        TEST_ASSERT_EQUAL(size, dst.pos);
+        TEST_ASSERT_TRUE_MESSAGE(dst.right, "Bytes copied wrong");
+
+        // Boards without PSRAM always copy through one buffer
+        uint32_t buffers = copy.buffers();
+        if (one_buffer)
+            TEST_ASSERT_EQUAL(1, buffers);
+        TEST_ASSERT_TRUE_MESSAGE(dst.max_ahead <= buffers * copy.buffer_size(), "Reader got ahead of the buffers");
+        if (buffers > 1)
+            TEST_ASSERT_TRUE_MESSAGE(dst.max_ahead > copy.buffer_size(), "Reads didn't overlap the writes");
+    }
+}
+
+void tests_fuji_copy_short_read()
+{
+    const uint32_t size = 10 * COPY_TEST_BUFFER_SIZE;
+    const uint32_t have = 3000;
+
+    // The source ends before its size
+    {
+        fujiCopy copy(COPY_TEST_BUFFERS, COPY_TEST_BUFFER_SIZE);
+        CopySource src(have);
+        CopyDest dst;
+
+        TEST_ASSERT_TRUE(copy.start(&src, &dst, size));
+        TEST_ASSERT_FALSE_MESSAGE(copy.wait(), "Short read not noticed");
+        TEST_ASSERT_EQUAL(have, copy.bytes_read);
+        TEST_ASSERT_TRUE(dst.pos <= have);
+        TEST_ASSERT_TRUE_MESSAGE(dst.right, "Bytes copied wrong");
+        TEST_ASSERT_TRUE(src.closed && dst.closed);
+        TEST_ASSERT_TRUE(fujiCopy::status().failed);
+    }
+
+    // Without a size, the end of the source is the end of the copy
+    {
+        fujiCopy copy(COPY_TEST_BUFFERS, COPY_TEST_BUFFER_SIZE);
+        CopySource src(have);
+        CopyDest dst;
+
+        TEST_ASSERT_TRUE(copy.start(&src, &dst, -1));
+        TEST_ASSERT_TRUE_MESSAGE(copy.wait(), "Copy of unknown size failed");
+        TEST_ASSERT_EQUAL(have, dst.pos);
+        TEST_ASSERT_TRUE_MESSAGE(dst.right, "Bytes copied wrong");
+        TEST_ASSERT_FALSE(fujiCopy::status().failed);
+    }
+}
+
+void tests_fuji_copy_write_error()
+{
+    const uint32_t size = 40 * COPY_TEST_BUFFER_SIZE;
+    const uint32_t fail_at = 3000;
+
+    fujiCopy copy(COPY_TEST_BUFFERS, COPY_TEST_BUFFER_SIZE);
+    CopySource src(size);
+    CopyDest dst;
+    dst.fail_at = fail_at;
+    dst.delay_ms = 1;
+
+    TEST_ASSERT_TRUE(copy.start(&src, &dst, size));
+    TEST_ASSERT_FALSE_MESSAGE(copy.wait(), "Write error not noticed");
+    TEST_ASSERT_EQUAL(fail_at, dst.pos);
+    TEST_ASSERT_EQUAL(fail_at, copy.bytes_written);
+    TEST_ASSERT_TRUE_MESSAGE(dst.right, "Bytes copied wrong");
+    TEST_ASSERT_TRUE(src.closed && dst.closed);
+
+    // The reader stops once the write failed, it doesn't read the rest
+    TEST_ASSERT_TRUE_MESSAGE(copy.bytes_read < size, "Reader went on after the write error");
+
+    fujiCopyStatus status = fujiCopy::status();
+    TEST_ASSERT_FALSE(status.busy);
+    TEST_ASSERT_TRUE(status.failed);
+    TEST_ASSERT_EQUAL(fail_at, status.bytes_written);
+}
+
+#else
+
+void tests_fuji_copy_handoff()
+{
+    TEST_IGNORE_MESSAGE("Copy tests need a build that uses fnio");
+}
+
+void tests_fuji_copy_short_read()
+{
+    TEST_IGNORE_MESSAGE("Copy tests need a build that uses fnio");
+}
+
+void tests_fuji_copy_write_error()
+{
+    TEST_IGNORE_MESSAGE("Copy tests need a build that uses fnio");
+}
+
+#endif /* FNIO_IS_STDIO */
+
+void tests_fuji_copy()
+{
+    RUN_TEST(tests_fuji_copy_handoff);
+    RUN_TEST(tests_fuji_copy_short_read);
+    RUN_TEST(tests_fuji_copy_write_error);
+}
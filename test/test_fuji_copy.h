@@ -0,0 +1,45 @@
+/**
+ * #FujiNet Tests - Host to host file copy
+ *
+ * Copies between in memory files through the reader and writer tasks,
+ * checking every byte, that reads run ahead of a slow writer only as far
+ * as the buffers allow, and that short reads and a failing write end the
+ * copy as failed.
+ */
+
+#ifndef TEST_FUJI_COPY_H
+#define TEST_FUJI_COPY_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_fuji_copy();
+
+    /**
+     * Test files of several sizes are copied whole, with the reader
+     * handing buffers to the writer ahead of it
+     */
+    void tests_fuji_copy_handoff();
+
+    /**
+     * Test a source shorter than its size fails the copy, and one of
+     * unknown size is copied to its end
+     */
+    void tests_fuji_copy_short_read();
+
+    /**
+     * Test a write failing part way fails the copy and stops the reader
+     */
+    void tests_fuji_copy_write_error();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_FUJI_COPY_H */
@@ -0,0 +1,213 @@
+/**
+ * #FujiNet Tests - Hash
+ *
+ * Checks that hashing data as it arrives, in chunks of any size, or from a
+ * file, gives the same digests as hashing it all at once, for every
+ * algorithm, and that a file that can't be read to the end is an error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../lib/encoding/hash.h"
+#ifndef FNIO_IS_STDIO
+#include "../lib/FileSystem/fnFileMem.h"
+#endif
+#include "test_hash.h"
+
+// Long enough to cross several SHA-512 blocks
+#define HASH_DATA_SIZE 3000
+
+static const Hash::Algorithm algorithms[] = {
+    Hash::Algorithm::MD5, Hash::Algorithm::SHA1, Hash::Algorithm::SHA256, Hash::Algorithm::SHA512};
+
+static const char *algorithm_names[] = {"MD5", "SHA1", "SHA256", "SHA512"};
+
+static std::vector<uint8_t> test_data()
+{
+    std::vector<uint8_t> data(HASH_DATA_SIZE);
+    srand(3);
+    for (auto &b : data)
+        b = rand();
+    return data;
+}
+
+static std::vector<uint8_t> one_shot(Hash::Algorithm algorithm, const std::vector<uint8_t> &data)
+{
+    Hash h;
+    h.add_data(data);
+    h.compute(algorithm, true);
+    return h.output_binary();
+}
+
+void tests_hash_vectors()
+{
+    const std::string abc = "abc";
+    const char *expected[] = {
+        "900150983cd24fb0d6963f7d28e17f72",
+        "a9993e364706816aba3e25717850c26c9cd0d89d",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+        "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"};
+
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+    {
+        Hash h;
+        h.add_data(abc);
+        h.compute(algorithms[i], true);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected[i], h.output_hex().c_str(), algorithm_names[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(h.hash_length(algorithms[i], false), h.output_binary().size(), algorithm_names[i]);
+    }
+}
+
+void tests_hash_streamed()
+{
+    std::vector<uint8_t> data = test_data();
+    const size_t chunks[] = {1, 7, 63, 64, 65, 128, 512, HASH_DATA_SIZE};
+
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+    {
+        std::vector<uint8_t> expected = one_shot(algorithms[i], data);
+        TEST_ASSERT_EQUAL_MESSAGE(Hash().hash_length(algorithms[i], false), expected.size(), algorithm_names[i]);
+
+        // One context, reused for every chunk size
+        Hash::Context ctx;
+        for (size_t chunk : chunks)
+        {
+            TEST_ASSERT_TRUE(ctx.init(algorithms[i]));
+            for (size_t pos = 0; pos < data.size(); pos += chunk)
+                TEST_ASSERT_TRUE(ctx.update(data.data() + pos, std::min(chunk, data.size() - pos)));
+
+            std::vector<uint8_t> digest;
+            TEST_ASSERT_TRUE(ctx.finish(digest));
+            TEST_ASSERT_EQUAL_MESSAGE(expected.size(), digest.size(), algorithm_names[i]);
+            TEST_ASSERT_EQUAL_MEMORY(expected.data(), digest.data(), expected.size());
+            TEST_ASSERT_TRUE(ctx.algorithm() == Hash::Algorithm::UNKNOWN);
+        }
+    }
+
+    // An empty update is allowed, but not before init()
+    Hash::Context ctx;
+    TEST_ASSERT_FALSE(ctx.update(data.data(), 0));
+    TEST_ASSERT_FALSE(ctx.init(Hash::Algorithm::UNKNOWN));
+}
+
+void tests_hash_begin_finish()
+{
+    std::vector<uint8_t> data = test_data();
+
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+    {
+        std::vector<uint8_t> expected = one_shot(algorithms[i], data);
+
+        Hash h;
+        TEST_ASSERT_TRUE(h.begin(algorithms[i]));
+        TEST_ASSERT_TRUE(h.update(data.data(), 1000));
+        TEST_ASSERT_TRUE(h.update(data.data() + 1000, data.size() - 1000));
+        TEST_ASSERT_TRUE(h.finish());
+
+        std::vector<uint8_t> digest = h.output_binary();
+        TEST_ASSERT_EQUAL_MESSAGE(expected.size(), digest.size(), algorithm_names[i]);
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), digest.data(), expected.size());
+    }
+}
+
+#ifdef FNIO_IS_STDIO
+
+static fnFile *test_file(std::vector<uint8_t> &data)
+{
+    return fmemopen(data.data(), data.size(), "r");
+}
+
+#else
+
+static fnFile *test_file(std::vector<uint8_t> &data)
+{
+    FileHandlerMem *f = new FileHandlerMem();
+    f->write(data.data(), 1, data.size());
+    f->seek(0, SEEK_SET);
+    return f;
+}
+
+/**
+ * File whose reads fail part of the way through
+ */
+class FailingFile : public FileHandlerMem
+{
+public:
+    long int fail_at = 0;
+
+    size_t read(void *ptr, size_t size, size_t count) override
+    {
+        if (tell() >= fail_at)
+            return 0;
+        return FileHandlerMem::read(ptr, size, count);
+    }
+};
+
+#endif
+
+void tests_hash_file()
+{
+    std::vector<uint8_t> data = test_data();
+
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+    {
+        std::vector<uint8_t> expected = one_shot(algorithms[i], data);
+
+        fnFile *f = test_file(data);
+        TEST_ASSERT_NOT_NULL(f);
+        Hash h;
+        TEST_ASSERT_TRUE(h.begin(algorithms[i]));
+        TEST_ASSERT_TRUE(h.update_from_file(f));
+        TEST_ASSERT_TRUE(h.finish());
+        fnio::fclose(f);
+
+        std::vector<uint8_t> digest = h.output_binary();
+        TEST_ASSERT_EQUAL_MESSAGE(expected.size(), digest.size(), algorithm_names[i]);
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), digest.data(), expected.size());
+    }
+
+    // From the middle of a file, the rest of it
+    std::vector<uint8_t> rest(data.begin() + 1000, data.end());
+    std::vector<uint8_t> expected = one_shot(Hash::Algorithm::SHA256, rest);
+    fnFile *f = test_file(data);
+    fnio::fseek(f, 1000, SEEK_SET);
+    Hash::Context ctx;
+    std::vector<uint8_t> digest;
+    TEST_ASSERT_TRUE(ctx.init(Hash::Algorithm::SHA256));
+    TEST_ASSERT_TRUE(ctx.update_from_file(f));
+    TEST_ASSERT_TRUE(ctx.finish(digest));
+    fnio::fclose(f);
+    TEST_ASSERT_EQUAL_MEMORY(expected.data(), digest.data(), expected.size());
+}
+
+void tests_hash_file_error()
+{
+#ifdef FNIO_IS_STDIO
+    TEST_IGNORE_MESSAGE("Needs FileHandler files to fail a read");
+#else
+    std::vector<uint8_t> data = test_data();
+    FailingFile *f = new FailingFile();
+    f->write(data.data(), 1, data.size());
+    f->seek(0, SEEK_SET);
+    f->fail_at = 1024;
+
+    Hash::Context ctx;
+    TEST_ASSERT_TRUE(ctx.init(Hash::Algorithm::SHA256));
+    TEST_ASSERT_FALSE(ctx.update_from_file(f));
+    fnio::fclose(f);
+#endif
+}
+
+void tests_hash()
+{
+    RUN_TEST(tests_hash_vectors);
+    RUN_TEST(tests_hash_streamed);
+    RUN_TEST(tests_hash_begin_finish);
+    RUN_TEST(tests_hash_file);
+    RUN_TEST(tests_hash_file_error);
+}
@@ -0,0 +1,52 @@
+/**
+ * #FujiNet Tests - Hash
+ *
+ * Checks that hashing data as it arrives, in chunks of any size, or from a
+ * file, gives the same digests as hashing it all at once, for every
+ * algorithm, and that a file that can't be read to the end is an error.
+ */
+
+#ifndef TEST_HASH_H
+#define TEST_HASH_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_hash();
+
+    /**
+     * Test one-shot digests against published vectors
+     */
+    void tests_hash_vectors();
+
+    /**
+     * Test Hash::Context fed in chunks against compute()
+     */
+    void tests_hash_streamed();
+
+    /**
+     * Test the streaming calls on a Hash against compute()
+     */
+    void tests_hash_begin_finish();
+
+    /**
+     * Test hashing a file against compute()
+     */
+    void tests_hash_file();
+
+    /**
+     * Test that a read error part of the way through fails the hash
+     */
+    void tests_hash_file_error();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_HASH_H */
@@ -0,0 +1,266 @@
+/**
+ * #FujiNet Tests - Web server templates
+ *
+ * Scans templates in pieces of random size and renders them through
+ * buffers of random size, compares the result with the original
+ * parse_contents() and times the first byte of a page.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+#include <esp_timer.h>
+#include "../lib/http/httpTemplate.h"
+#include "test_http_template.h"
+
+#define NUM_TAGS 6
+
+static const char *tag_names[NUM_TAGS] = {"FN_A", "FN_B", "FN_EMPTY", "FN_NUMBER", "FN_LIST", "FN_LONGER_TAG_NAME"};
+static std::string tag_values[NUM_TAGS];
+
+static int lookup(const char *name)
+{
+    for (int i = 0; i < NUM_TAGS; i++)
+    {
+        if (strcmp(name, tag_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static std::string substitute(int tagid)
+{
+    return tag_values[tagid];
+}
+
+static void make_values()
+{
+    tag_values[0] = "alpha";
+    tag_values[1] = "<%FN_A%>"; // values aren't parsed again
+    tag_values[2] = "";
+    tag_values[3] = "12345";
+    tag_values[4] = "";
+    for (int i = 0; i < 60; i++)
+        tag_values[4] += "<option value=\"model\">model</option>\n";
+    tag_values[5] = "x";
+}
+
+/**
+ * The original parser
+ */
+static std::string reference_parse(const std::string &contents)
+{
+    std::stringstream ss;
+    size_t pos = 0, x, y;
+    do
+    {
+        x = contents.find("<%", pos);
+        if (x == std::string::npos)
+        {
+            ss << contents.substr(pos);
+            break;
+        }
+        y = contents.find("%>", x + 2);
+        if (y == std::string::npos)
+        {
+            ss << contents.substr(pos);
+            break;
+        }
+        if (x > 0)
+            ss << contents.substr(pos, x - pos);
+        std::string tag = contents.substr(x + 2, y - x - 2);
+        int tagid = lookup(tag.c_str());
+        ss << (tagid < 0 ? tag : substitute(tagid));
+        pos = y + 2;
+    } while (true);
+
+    return ss.str();
+}
+
+/**
+ * Random page built from text, tags and pieces of tags
+ */
+static std::string make_page(size_t size)
+{
+    static const char *pieces[] = {
+        "<%FN_A%>", "<%FN_B%>", "<%FN_EMPTY%>", "<%FN_NUMBER%>", "<%FN_LIST%>", "<%FN_LONGER_TAG_NAME%>",
+        "<%FN_UNKNOWN%>", "<%%>", "<%>", "<<%FN_A%>", "<%FN_A%%>", "<", "%", ">", "<%", "%>",
+        "<%FN_THIS_TAG_NAME_IS_FAR_TOO_LONG_TO_BE_LOOKED_UP_AT_ALL%>"};
+    std::string page;
+
+    while (page.size() < size)
+    {
+        int r = rand() % 4;
+        if (r == 0)
+            page += pieces[rand() % (sizeof(pieces) / sizeof(pieces[0]))];
+        else
+        {
+            int n = 1 + rand() % 40;
+            for (int i = 0; i < n; i++)
+                page += (char)(' ' + rand() % 95);
+        }
+    }
+    return page;
+}
+
+static fnHttpTemplate scan_page(const std::string &page, size_t max_piece)
+{
+    fnHttpTemplate tmpl;
+    size_t pos = 0;
+    while (pos < page.size())
+    {
+        size_t n = 1 + rand() % max_piece;
+        if (n > page.size() - pos)
+            n = page.size() - pos;
+        tmpl.scan(page.data() + pos, n, lookup);
+        pos += n;
+    }
+    tmpl.scan_end();
+    return tmpl;
+}
+
+static fnHttpTemplate::read_fn page_reader(const std::string &page)
+{
+    return [&page](uint32_t offset, char *buf, size_t len) -> size_t
+    {
+        if (offset >= page.size())
+            return 0;
+        if (len > page.size() - offset)
+            len = page.size() - offset;
+        memcpy(buf, page.data() + offset, len);
+        return len;
+    };
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_http_template()
+{
+    RUN_TEST(tests_http_template_render);
+    RUN_TEST(tests_http_template_chunks);
+    RUN_TEST(tests_http_template_timing);
+}
+
+void tests_http_template_render()
+{
+    static char buf[1024];
+
+    srand(1);
+    make_values();
+
+    // unclosed and empty tags
+    for (const char *page : {"", "<%", "<%FN_A", "abc<%FN_A%>def<%FN_B", "<%%>", "%><%FN_NUMBER%><%%>>"})
+    {
+        fnHttpTemplate tmpl = scan_page(page, 3);
+        std::string out;
+        TEST_ASSERT_TRUE(tmpl.render(page_reader(page), substitute,
+                                     [&out](const char *data, size_t len) { out.append(data, len); return true; },
+                                     buf, 16));
+        TEST_ASSERT_EQUAL_STRING(reference_parse(page).c_str(), out.c_str());
+    }
+
+    for (int round = 0; round < 50; round++)
+    {
+        std::string page = make_page(1 + rand() % 8000);
+        fnHttpTemplate tmpl = scan_page(page, 1 + rand() % 600);
+        TEST_ASSERT_EQUAL_UINT32(page.size(), tmpl.size());
+
+        std::string out;
+        size_t bufsize = 1 + rand() % sizeof(buf);
+        TEST_ASSERT_TRUE(tmpl.render(page_reader(page), substitute,
+                                     [&out](const char *data, size_t len) { out.append(data, len); return true; },
+                                     buf, bufsize));
+        std::string ref = reference_parse(page);
+        TEST_ASSERT_EQUAL_UINT32(ref.size(), out.size());
+        TEST_ASSERT_EQUAL_STRING(ref.c_str(), out.c_str());
+    }
+}
+
+void tests_http_template_chunks()
+{
+    static char buf[512];
+
+    srand(2);
+    make_values();
+    std::string page = make_page(20000);
+    fnHttpTemplate tmpl = scan_page(page, 512);
+
+    for (size_t bufsize : {1, 7, 64, 512})
+    {
+        size_t total = 0, pieces = 0, short_pieces = 0, bad_pieces = 0;
+        TEST_ASSERT_TRUE(tmpl.render(page_reader(page), substitute,
+                                     [&](const char * /*unused*/, size_t len) {
+                                         bad_pieces += len == 0 || len > bufsize;
+                                         short_pieces += len < bufsize;
+                                         total += len;
+                                         pieces++;
+                                         return true;
+                                     },
+                                     buf, bufsize));
+        TEST_ASSERT_EQUAL(0, bad_pieces);
+        TEST_ASSERT_EQUAL_UINT32(reference_parse(page).size(), total);
+        // only the last piece may be short
+        TEST_ASSERT_TRUE(short_pieces <= 1);
+        TEST_ASSERT_TRUE(pieces >= total / bufsize);
+    }
+
+    // a failed send stops rendering
+    int calls = 0;
+    TEST_ASSERT_FALSE(tmpl.render(page_reader(page), substitute,
+                                  [&calls](const char * /*unused*/, size_t /*unused*/) { return ++calls < 3; },
+                                  buf, 64));
+    TEST_ASSERT_EQUAL(3, calls);
+}
+
+void tests_http_template_timing()
+{
+    static char buf[512];
+    char msg[200];
+    const int rounds = 10;
+    int64_t t_ref = 0, t_scan = 0, t_new_first = 0, t_new_all = 0;
+    size_t peak_ref = 0;
+
+    srand(3);
+    make_values();
+    // about the size of the config page
+    std::string page = make_page(40000);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        // original: the whole page is built before anything is sent
+        int64_t t0 = esp_timer_get_time();
+        std::string contents(page);
+        std::string out = reference_parse(contents);
+        int64_t t1 = esp_timer_get_time();
+        peak_ref = contents.size() + out.size();
+
+        int64_t t2 = esp_timer_get_time();
+        fnHttpTemplate tmpl = scan_page(page, sizeof(buf));
+        int64_t t3 = esp_timer_get_time();
+
+        int64_t t_first = 0;
+        TEST_ASSERT_TRUE(tmpl.render(page_reader(page), substitute,
+                                     [&t_first](const char * /*unused*/, size_t /*unused*/) {
+                                         if (t_first == 0)
+                                             t_first = esp_timer_get_time();
+                                         return true;
+                                     },
+                                     buf, sizeof(buf)));
+        int64_t t4 = esp_timer_get_time();
+
+        t_ref += t1 - t0;
+        t_scan += t3 - t2;
+        t_new_first += t_first - t3;
+        t_new_all += t4 - t3;
+    }
+
+    // the original sends its first byte only once the whole page is done
+    snprintf(msg, sizeof(msg), "Template us: first byte %lld/%lld, page %lld/%lld (original/streaming), scan once %lld; buffer %u/%u bytes",
+             (long long)(t_ref / rounds), (long long)(t_new_first / rounds),
+             (long long)(t_ref / rounds), (long long)(t_new_all / rounds),
+             (long long)(t_scan / rounds), (unsigned)peak_ref, (unsigned)sizeof(buf));
+    TEST_MESSAGE(msg);
+}
@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - Web server templates
+ *
+ * Scans templates in pieces of random size and renders them through
+ * buffers of random size, compares the result with the original
+ * parse_contents() and times the first byte of a page.
+ */
+
+#ifndef TEST_HTTP_TEMPLATE_H
+#define TEST_HTTP_TEMPLATE_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_http_template();
+
+    /**
+     * Test rendering against the original parser, including odd tags
+     */
+    void tests_http_template_render();
+
+    /**
+     * Test output is sent in pieces no larger than the buffer
+     */
+    void tests_http_template_chunks();
+
+    /**
+     * Report time to first byte and to the whole page for both versions
+     */
+    void tests_http_template_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_HTTP_TEMPLATE_H */
@@ -0,0 +1,149 @@
+/**
+ * #FujiNet Tests - IEC read prefetch
+ *
+ * Reads files through an IEC file channel while the prefetch task fills
+ * the next buffer, checking every byte, and stops the task in the middle
+ * of a fill to check that no data is lost and the stream is left where
+ * the channel is.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test_iec_prefetch.h"
+
+#ifdef BUILD_IEC
+
+#include "../lib/device/iec/drive.h"
+
+// BUFFER_SIZE in drive.cpp
+#define PREFETCH_TEST_BUFFER 512
+// Most bytes one stream read returns, so a fill takes several reads
+#define PREFETCH_TEST_CHUNK 100
+// Time each stream read takes, so a fill is still running when it's stopped
+#define PREFETCH_TEST_READ_MS 2
+
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 7 + (pos >> 8));
+}
+
+/**
+ * In memory file that reads slowly, in short pieces, and may not seek
+ */
+class SlowStream : public MStream
+{
+public:
+    SlowStream(uint32_t size, bool seekable) : _seekable(seekable)
+    {
+        _size = size;
+        mode = std::ios_base::in;
+    }
+
+    bool isOpen() override { return true; }
+    bool open(std::ios_base::openmode mode) override { return true; }
+    void close() override {}
+
+    bool seek(uint32_t pos) override
+    {
+        if (!_seekable || pos > _size)
+            return false;
+        _position = pos;
+        return true;
+    }
+
+    uint32_t read(uint8_t *buf, uint32_t size) override
+    {
+        vTaskDelay(pdMS_TO_TICKS(PREFETCH_TEST_READ_MS));
+        if (size > available())
+            size = available();
+        if (size > PREFETCH_TEST_CHUNK)
+            size = PREFETCH_TEST_CHUNK;
+        for (uint32_t i = 0; i < size; i++)
+            buf[i] = pattern(_position + i);
+        _position += size;
+        return size;
+    }
+
+    uint32_t write(const uint8_t *buf, uint32_t size) override { return 0; }
+
+private:
+    bool _seekable;
+};
+
+/**
+ * Read the channel to the end the way a LOAD does, checking the bytes from pos on
+ * @return the position after the last byte, or UINT32_MAX if a byte was wrong
+ */
+static uint32_t channel_read_all(iecChannelHandler *channel, uint32_t pos)
+{
+    uint8_t buf[254];
+    while (true)
+    {
+        // Standard IEC takes a byte at a time, fast loaders take blocks
+        uint8_t n = channel->read(buf, (pos % 3) ? 1 : sizeof(buf));
+        if (n == 0)
+            return pos;
+        for (uint8_t i = 0; i < n; i++)
+            if (buf[i] != pattern(pos + i))
+                return UINT32_MAX;
+        pos += n;
+    }
+}
+
+void tests_iec_prefetch_read()
+{
+    const uint32_t sizes[] = {1, PREFETCH_TEST_BUFFER - 1, PREFETCH_TEST_BUFFER, PREFETCH_TEST_BUFFER + 1,
+                              2 * PREFETCH_TEST_BUFFER, 5000};
+
+    for (uint32_t size : sizes)
+    {
+        iecChannelHandlerFile *channel = new iecChannelHandlerFile(nullptr, new SlowStream(size, true), -1, true);
+        TEST_ASSERT_EQUAL_MESSAGE(size, channel_read_all(channel, 0), "Channel didn't deliver the whole file");
+        delete channel;
+    }
+}
+
+void tests_iec_prefetch_stop()
+{
+    for (bool seekable : {true, false})
+    {
+        SlowStream *stream = new SlowStream(5000, seekable);
+        iecChannelHandlerFile *channel = new iecChannelHandlerFile(nullptr, stream, -1, true);
+
+        // The first buffer is read right away, then the prefetch starts on the next one
+        uint8_t buf[10];
+        TEST_ASSERT_EQUAL(sizeof(buf), channel->read(buf, sizeof(buf)));
+        for (uint32_t i = 0; i < sizeof(buf); i++)
+            TEST_ASSERT_EQUAL(pattern(i), buf[i]);
+
+        // That fill takes several reads, so this stops it part way
+        MStream *s = channel->getStream();
+        TEST_ASSERT_TRUE(s == stream);
+        if (seekable)
+            TEST_ASSERT_EQUAL_MESSAGE(PREFETCH_TEST_BUFFER, s->position(), "Stream not back where the channel is");
+
+        // Either way the channel carries on without losing a byte
+        TEST_ASSERT_EQUAL_MESSAGE(5000, channel_read_all(channel, sizeof(buf)), "Bytes lost when the prefetch stopped");
+        delete channel;
+    }
+}
+
+#else
+
+void tests_iec_prefetch_read()
+{
+    TEST_IGNORE_MESSAGE("IEC is only built for Commodore");
+}
+
+void tests_iec_prefetch_stop()
+{
+    TEST_IGNORE_MESSAGE("IEC is only built for Commodore");
+}
+
+#endif /* BUILD_IEC */
+
+void tests_iec_prefetch()
+{
+    RUN_TEST(tests_iec_prefetch_read);
+    RUN_TEST(tests_iec_prefetch_stop);
+}
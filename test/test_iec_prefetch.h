@@ -0,0 +1,38 @@
+/**
+ * #FujiNet Tests - IEC read prefetch
+ *
+ * Reads files through an IEC file channel while the prefetch task fills
+ * the next buffer, checking every byte, and stops the task in the middle
+ * of a fill to check that no data is lost and the stream is left where
+ * the channel is.
+ */
+
+#ifndef TEST_IEC_PREFETCH_H
+#define TEST_IEC_PREFETCH_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_iec_prefetch();
+
+    /**
+     * Test that files of every size around the buffer size come through whole
+     */
+    void tests_iec_prefetch_read();
+
+    /**
+     * Test stopping the prefetch mid-fill, on a stream that can seek back and one that can't
+     */
+    void tests_iec_prefetch_stop();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_IEC_PREFETCH_H */
@@ -0,0 +1,211 @@
+/**
+ * #FujiNet Tests - SmartPort 7-to-8 group codec
+ *
+ * Checks the word-at-a-time group encoder and decoder against the original
+ * per-bit loops, round trips random packets and times a 512 byte block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "../lib/bus/iwm/iwm_sp_codec.h"
+#include "test_iwm_sp_codec.h"
+
+#define MAX_DATA 1024
+#define MAX_ENCODED (MAX_DATA / 7 * 8 + 8)
+
+static uint8_t data[MAX_DATA];
+static uint8_t ref_enc[MAX_ENCODED];
+static uint8_t new_enc[MAX_ENCODED];
+static uint8_t ref_dec[MAX_DATA];
+static uint8_t new_dec[MAX_DATA];
+
+/**
+ * The original encoder: checksum pass, then groups and odd bytes bit by bit
+ */
+static uint8_t reference_encode(const uint8_t *src, size_t num, uint8_t *dst)
+{
+    uint8_t checksum = 0;
+    size_t numgrps = num / 7;
+    size_t numodds = num % 7;
+    size_t grpstart = numodds + (numodds != 0);
+
+    for (size_t count = 0; count < num; count++)
+        checksum ^= src[count];
+
+    for (size_t grpcount = 0; grpcount < numgrps; grpcount++)
+    {
+        uint8_t grpmsb = 0;
+        for (int grpbyte = 0; grpbyte < 7; grpbyte++)
+            grpmsb |= (src[numodds + grpcount * 7 + grpbyte] >> (grpbyte + 1)) & (0x80 >> (grpbyte + 1));
+        dst[grpstart + grpcount * 8] = grpmsb | 0x80;
+        for (int grpbyte = 0; grpbyte < 7; grpbyte++)
+            dst[grpstart + 1 + grpcount * 8 + grpbyte] = src[numodds + grpcount * 7 + grpbyte] | 0x80;
+    }
+
+    if (numodds)
+    {
+        dst[0] = 0x80;
+        for (size_t oddcnt = 0; oddcnt < numodds; oddcnt++)
+        {
+            dst[0] |= (src[oddcnt] & 0x80) >> (1 + oddcnt);
+            dst[1 + oddcnt] = src[oddcnt] | 0x80;
+        }
+    }
+    return checksum;
+}
+
+/**
+ * The original decoder
+ */
+static void reference_decode(const uint8_t *src, size_t numodd, size_t numgrps, uint8_t *dst)
+{
+    for (size_t i = 0; i < numodd; i++)
+        dst[i] = ((src[0] << (i + 1)) & 0x80) | (src[1 + i] & 0x7f);
+
+    size_t grpstart = numodd + (numodd != 0);
+    for (size_t grpcount = 0; grpcount < numgrps; grpcount++)
+        for (int grpbyte = 0; grpbyte < 7; grpbyte++)
+            dst[numodd + grpcount * 7 + grpbyte] = ((src[grpstart + grpcount * 8] << (grpbyte + 1)) & 0x80) |
+                                                   (src[grpstart + grpcount * 8 + grpbyte + 1] & 0x7f);
+}
+
+static void fill_random(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        buf[i] = rand();
+}
+
+/**
+ * Encode and decode num bytes of data with both versions and compare
+ */
+static void compare_codecs(size_t num)
+{
+    size_t len = sp_encoded_len(num);
+
+    memset(ref_enc, 0, sizeof(ref_enc));
+    memset(new_enc, 0, sizeof(new_enc));
+    uint8_t ref_sum = reference_encode(data, num, ref_enc);
+    uint8_t new_sum = sp_encode_data(data, num, new_enc);
+
+    TEST_ASSERT_EQUAL_HEX8(ref_sum, new_sum);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref_enc, new_enc, len + 1);
+    for (size_t i = 0; i < len; i++)
+        TEST_ASSERT_EQUAL_HEX8(0x80, new_enc[i] & 0x80);
+
+    reference_decode(ref_enc, num % 7, num / 7, ref_dec);
+    uint8_t dec_sum = sp_decode_data(new_enc, num % 7, num / 7, new_dec);
+
+    TEST_ASSERT_EQUAL_HEX8(new_sum, dec_sum);
+    if (num)
+    {
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(data, ref_dec, num);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(data, new_dec, num);
+    }
+
+    uint8_t grp_sum = 0;
+    for (size_t i = 0; i < num / 7; i++)
+        grp_sum ^= sp_group_checksum(new_enc + (num % 7) + (num % 7 != 0) + i * 8);
+    for (size_t i = 0; i < num % 7; i++)
+        grp_sum ^= data[i];
+    TEST_ASSERT_EQUAL_HEX8(new_sum, grp_sum);
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_iwm_sp_codec()
+{
+    RUN_TEST(tests_iwm_sp_codec_group);
+    RUN_TEST(tests_iwm_sp_codec_fuzz);
+    RUN_TEST(tests_iwm_sp_codec_in_place);
+    RUN_TEST(tests_iwm_sp_codec_timing);
+}
+
+void tests_iwm_sp_codec_group()
+{
+    srand(1);
+    for (int msbs = 0; msbs < 128; msbs++)
+    {
+        fill_random(data, 7);
+        for (int k = 0; k < 7; k++)
+            data[k] = (data[k] & 0x7f) | ((msbs << (k + 1)) & 0x80);
+        compare_codecs(7);
+        TEST_ASSERT_EQUAL_HEX8(msbs | 0x80, new_enc[0]);
+    }
+}
+
+void tests_iwm_sp_codec_fuzz()
+{
+    srand(2);
+    for (size_t num = 0; num <= MAX_DATA; num++)
+    {
+        fill_random(data, num);
+        compare_codecs(num);
+    }
+    for (int i = 0; i < 200; i++)
+    {
+        fill_random(data, 512);
+        compare_codecs(512);
+    }
+}
+
+void tests_iwm_sp_codec_in_place()
+{
+    static uint8_t buf[MAX_ENCODED];
+
+    srand(3);
+    for (size_t num = 1; num <= 600; num += 1 + rand() % 13)
+    {
+        fill_random(data, num);
+        reference_encode(data, num, ref_enc);
+
+        // data at the start of the buffer it is encoded into, as when
+        // encode_packet() is handed its own packet buffer
+        memcpy(buf, data, num);
+        sp_encode_data(buf, num, buf);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(ref_enc, buf, sp_encoded_len(num));
+
+        sp_decode_data(buf, num % 7, num / 7, buf);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(data, buf, num);
+    }
+}
+
+void tests_iwm_sp_codec_timing()
+{
+    char msg[160];
+    const int rounds = 200;
+    int64_t t_ref_enc = 0, t_new_enc = 0, t_ref_dec = 0, t_new_dec = 0;
+    uint8_t ref_sum = 0, new_sum = 0, dec_sum = 0;
+
+    srand(4);
+    fill_random(data, 512);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        int64_t t0 = esp_timer_get_time();
+        ref_sum = reference_encode(data, 512, ref_enc);
+        int64_t t1 = esp_timer_get_time();
+        new_sum = sp_encode_data(data, 512, new_enc);
+        int64_t t2 = esp_timer_get_time();
+        reference_decode(ref_enc, 1, 73, ref_dec);
+        int64_t t3 = esp_timer_get_time();
+        dec_sum = sp_decode_data(new_enc, 1, 73, new_dec);
+        int64_t t4 = esp_timer_get_time();
+
+        t_ref_enc += t1 - t0;
+        t_new_enc += t2 - t1;
+        t_ref_dec += t3 - t2;
+        t_new_dec += t4 - t3;
+    }
+
+    snprintf(msg, sizeof(msg), "SP 512 byte block: encode %lld/%lld ns, decode %lld/%lld ns (original/grouped)",
+             (long long)(t_ref_enc * 1000 / rounds), (long long)(t_new_enc * 1000 / rounds),
+             (long long)(t_ref_dec * 1000 / rounds), (long long)(t_new_dec * 1000 / rounds));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_HEX8(ref_sum, new_sum);
+    TEST_ASSERT_EQUAL_HEX8(ref_sum, dec_sum);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref_enc, new_enc, sp_encoded_len(512));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref_dec, new_dec, 512);
+}
@@ -0,0 +1,46 @@
+/**
+ * #FujiNet Tests - SmartPort 7-to-8 group codec
+ *
+ * Checks the word-at-a-time group encoder and decoder against the original
+ * per-bit loops, round trips random packets and times a 512 byte block.
+ */
+
+#ifndef TEST_IWM_SP_CODEC_H
+#define TEST_IWM_SP_CODEC_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_iwm_sp_codec();
+
+    /**
+     * Test every MSB pattern of a single group
+     */
+    void tests_iwm_sp_codec_group();
+
+    /**
+     * Test random data of every length up to 1024 bytes against the original encoder
+     */
+    void tests_iwm_sp_codec_fuzz();
+
+    /**
+     * Test encoding in place, with the data in the output buffer
+     */
+    void tests_iwm_sp_codec_in_place();
+
+    /**
+     * Report encode and decode time for a 512 byte block for both versions
+     */
+    void tests_iwm_sp_codec_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_IWM_SP_CODEC_H */
@@ -0,0 +1,243 @@
+/**
+ * #FujiNet Tests - IWM SPI sample decoder
+ *
+ * Feeds oversampled SmartPort bit streams through the word-at-a-time
+ * decoder and the original sample-at-a-time decoder and checks they agree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "../lib/bus/iwm/iwm_spi_decoder.h"
+#include "test_iwm_spi_decoder.h"
+
+#define SAMPLES_PER_CELL 8      // 4 us cells at 2 MHz
+#define TIMEOUT_SAMPLES 38      // 19 us at 2 MHz, as used by iwm_read_packet_spi()
+#define SAMPLE_BUF_LEN 6000     // SPI_SP_LEN
+#define MAX_BYTES 1024
+
+static uint8_t samples[SAMPLE_BUF_LEN];
+static uint8_t ref_out[MAX_BYTES];
+static uint8_t new_out[MAX_BYTES];
+static size_t ref_offsets[MAX_BYTES];
+static size_t new_offsets[MAX_BYTES];
+
+/**
+ * The original decoder, walking the samples one at a time
+ */
+#define IWM_NEXT_BIT() ({bool _v = ((src[offset / 8] << (offset % 8)) & 0x80) == 0x80; \
+      offset++; _v;})
+static uint8_t reference_decode_byte(bool &prev_level, const uint8_t *src, size_t src_size,
+                                     int spi_samples_per_cell, int timeout_ctr,
+                                     size_t *bit_offset, bool *more_avail)
+{
+    int numbits, idx;
+    uint8_t byte;
+    bool bit, current_level;
+    const int half_samples = spi_samples_per_cell / 2;
+    size_t offset = *bit_offset;
+
+    *more_avail = true;
+    for (numbits = 8, byte = 0; numbits; numbits--) {
+        for (idx = bit = 0; idx < spi_samples_per_cell; idx++) {
+            if (offset / 8 >= src_size) {
+                numbits = 1;
+                *more_avail = false;
+                break;
+            }
+            current_level = IWM_NEXT_BIT();
+            if (prev_level != current_level) {
+                bit = true;
+                idx = half_samples;
+            }
+            prev_level = current_level;
+        }
+        byte <<= 1;
+        byte |= bit;
+    }
+
+    for (; timeout_ctr; timeout_ctr--) {
+        if (offset / 8 >= src_size) {
+            *more_avail = false;
+            break;
+        }
+        current_level = IWM_NEXT_BIT();
+        if (prev_level != current_level)
+            break;
+    }
+    if (!timeout_ctr)
+        *more_avail = false;
+
+    *bit_offset = offset;
+    return byte;
+}
+
+/**
+ * Oversample bytes as the Apple II sends them: a transition for each 1 bit.
+ * jitter moves each cell by up to +/- jitter samples, glitch is the chance
+ * (in 1/1000) of flipping a single sample.
+ * @return number of samples written
+ */
+static size_t make_samples(const uint8_t *data, size_t len, int jitter, int glitch, size_t lead_in)
+{
+    size_t pos = 0;
+    bool level = true;
+
+    memset(samples, 0xff, sizeof(samples));
+    pos = lead_in;
+    for (size_t i = 0; i < len; i++)
+    {
+        for (int b = 7; b >= 0; b--)
+        {
+            int cell = SAMPLES_PER_CELL + (jitter ? (rand() % (2 * jitter + 1)) - jitter : 0);
+            if (data[i] & (1 << b))
+                level = !level;
+            for (int k = 0; k < cell && pos < sizeof(samples) * 8; k++, pos++)
+            {
+                bool v = level;
+                if (glitch && rand() % 1000 < glitch)
+                    v = !v;
+                if (v)
+                    samples[pos / 8] |= 0x80 >> (pos % 8);
+                else
+                    samples[pos / 8] &= ~(0x80 >> (pos % 8));
+            }
+        }
+    }
+    return pos;
+}
+
+/**
+ * Decode with both decoders, carrying the level across runs like
+ * iwm_read_packet_spi() does, and compare every byte and position.
+ */
+static void compare_decoders(size_t src_size, int runs_level_seed)
+{
+    bool ref_level = runs_level_seed & 1;
+    iwm_spi_decoder decoder;
+    decoder.level = ref_level;
+
+    size_t ref_off = 0, new_off = 0;
+    bool ref_more = true, new_more = true;
+    int n = 0;
+
+    while (ref_more && n < MAX_BYTES)
+    {
+        ref_out[n] = reference_decode_byte(ref_level, samples, src_size, SAMPLES_PER_CELL, TIMEOUT_SAMPLES, &ref_off, &ref_more);
+        ref_offsets[n] = ref_off;
+        new_out[n] = decoder.decode_byte(samples, src_size, SAMPLES_PER_CELL, TIMEOUT_SAMPLES, &new_off, &new_more);
+        new_offsets[n] = new_off;
+
+        TEST_ASSERT_EQUAL_HEX8(ref_out[n], new_out[n]);
+        TEST_ASSERT_EQUAL_UINT32(ref_offsets[n], new_offsets[n]);
+        TEST_ASSERT_EQUAL(ref_more, new_more);
+        TEST_ASSERT_EQUAL(ref_level, decoder.level);
+        n++;
+    }
+}
+
+static void fill_packet(uint8_t *data, size_t len)
+{
+    // sync bytes, packet begin, then random "disk nibbles" (msb set)
+    for (size_t i = 0; i < len; i++)
+        data[i] = 0x80 | (rand() & 0x7f);
+    for (size_t i = 0; i < 5 && i < len; i++)
+        data[i] = 0xff;
+    if (len > 5)
+        data[5] = 0xc3;
+    if (len > 0)
+        data[len - 1] = 0xc8;
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_iwm_spi_decoder()
+{
+    RUN_TEST(tests_iwm_spi_decoder_clean);
+    RUN_TEST(tests_iwm_spi_decoder_jitter);
+    RUN_TEST(tests_iwm_spi_decoder_truncated);
+    RUN_TEST(tests_iwm_spi_decoder_timing);
+}
+
+void tests_iwm_spi_decoder_clean()
+{
+    static uint8_t data[604];
+
+    srand(1);
+    for (int i = 0; i < 20; i++)
+    {
+        fill_packet(data, sizeof(data));
+        make_samples(data, sizeof(data), 0, 0, rand() % 64);
+        compare_decoders(sizeof(samples), i);
+    }
+}
+
+void tests_iwm_spi_decoder_jitter()
+{
+    static uint8_t data[604];
+
+    srand(2);
+    for (int i = 0; i < 40; i++)
+    {
+        fill_packet(data, sizeof(data));
+        make_samples(data, sizeof(data), i % 3, i % 4, rand() % 64);
+        compare_decoders(sizeof(samples), i);
+    }
+}
+
+void tests_iwm_spi_decoder_truncated()
+{
+    static uint8_t data[64];
+
+    srand(3);
+    for (int i = 0; i < 200; i++)
+    {
+        fill_packet(data, sizeof(data));
+        // a few zero bytes make a gap longer than the timeout
+        if (i & 1)
+            memset(data + 20, 0, 3);
+        size_t nsamples = make_samples(data, sizeof(data), i % 3, i % 5, rand() % 40);
+        compare_decoders(1 + rand() % ((nsamples + 7) / 8), i);
+    }
+}
+
+void tests_iwm_spi_decoder_timing()
+{
+    static uint8_t data[604];
+    char msg[100];
+    const int rounds = 20;
+    int64_t t_ref = 0, t_new = 0;
+    size_t bytes = 0;
+
+    srand(4);
+    fill_packet(data, sizeof(data));
+    make_samples(data, sizeof(data), 1, 0, 10);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        bool ref_level = true, more = true;
+        size_t off = 0;
+        int64_t t0 = esp_timer_get_time();
+        while (more)
+            ref_out[0] ^= reference_decode_byte(ref_level, samples, sizeof(samples), SAMPLES_PER_CELL, TIMEOUT_SAMPLES, &off, &more);
+        t_ref += esp_timer_get_time() - t0;
+
+        iwm_spi_decoder decoder;
+        more = true;
+        off = 0;
+        t0 = esp_timer_get_time();
+        while (more)
+        {
+            new_out[0] ^= decoder.decode_byte(samples, sizeof(samples), SAMPLES_PER_CELL, TIMEOUT_SAMPLES, &off, &more);
+            bytes++;
+        }
+        t_new += esp_timer_get_time() - t0;
+    }
+
+    snprintf(msg, sizeof(msg), "IWM decode: reference %lld ns/byte, word-at-a-time %lld ns/byte",
+             (long long)(t_ref * 1000 / bytes), (long long)(t_new * 1000 / bytes));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_HEX8(ref_out[0], new_out[0]);
+}
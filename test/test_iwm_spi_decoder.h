@@ -0,0 +1,46 @@
+/**
+ * #FujiNet Tests - IWM SPI sample decoder
+ *
+ * Feeds oversampled SmartPort bit streams through the word-at-a-time
+ * decoder and the original sample-at-a-time decoder and checks they agree.
+ */
+
+#ifndef TEST_IWM_SPI_DECODER_H
+#define TEST_IWM_SPI_DECODER_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_iwm_spi_decoder();
+
+    /**
+     * Test clean packets, 8 samples per cell
+     */
+    void tests_iwm_spi_decoder_clean();
+
+    /**
+     * Test packets with sample jitter and glitches
+     */
+    void tests_iwm_spi_decoder_jitter();
+
+    /**
+     * Test buffers ending mid byte and gaps longer than the timeout
+     */
+    void tests_iwm_spi_decoder_truncated();
+
+    /**
+     * Report decode time per byte for both decoders
+     */
+    void tests_iwm_spi_decoder_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_IWM_SPI_DECODER_H */
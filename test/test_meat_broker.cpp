@@ -0,0 +1,176 @@
+/**
+ * #FujiNet Tests - Meatloaf broker and object pool
+ *
+ * Checks which entries the bounded broker drops, that dropped objects live
+ * on while held, that the pool gives freed slots back out and that it
+ * stops taking slabs at its limit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include "../lib/meatloaf/meat_broker.h"
+#include "../lib/meatloaf/meat_pool.h"
+#include "fnSystem.h"
+#include "test_meat_broker.h"
+
+#define POOL_TEST_OBJECTS 40
+
+struct cached
+{
+    std::string url;
+    cached(const std::string &u) : url(u) {}
+};
+
+// Pooled the same way as MFile and MStream
+struct pooled
+{
+    uint8_t data[200];
+
+    static void *operator new(size_t size) noexcept { return MeatPool::allocate(size); }
+    static void operator delete(void *p, size_t size) { MeatPool::release(p, size); }
+};
+
+struct pooled_slab
+{
+    uint8_t data[MEATLOAF_POOL_MAX_OBJECT];
+
+    static void *operator new(size_t size) noexcept { return MeatPool::allocate(size); }
+    static void operator delete(void *p, size_t size) { MeatPool::release(p, size); }
+};
+
+struct pooled_large
+{
+    uint8_t data[MEATLOAF_POOL_MAX_OBJECT + 1];
+
+    static void *operator new(size_t size) noexcept { return MeatPool::allocate(size); }
+    static void operator delete(void *p, size_t size) { MeatPool::release(p, size); }
+};
+
+static cached *create(const std::string &url)
+{
+    return url.empty() ? nullptr : new cached(url);
+}
+
+void tests_meat_broker_lru()
+{
+    MeatBroker<cached> broker(3);
+
+    broker.obtain("a", create);
+    broker.obtain("b", create);
+    auto held = broker.obtain("c", create);
+    TEST_ASSERT_EQUAL(3, broker.stats().misses);
+
+    // a is used again, so b is the oldest
+    TEST_ASSERT_EQUAL_STRING("a", broker.obtain("a", create)->url.c_str());
+    TEST_ASSERT_EQUAL(1, broker.stats().hits);
+    broker.obtain("d", create);
+    TEST_ASSERT_EQUAL(1, broker.stats().evictions);
+    TEST_ASSERT_NULL(broker.find("b").get());
+
+    // c is now the oldest, but still held, so a goes
+    broker.obtain("d", create);
+    broker.obtain("e", create);
+    TEST_ASSERT_NULL(broker.find("a").get());
+    TEST_ASSERT_EQUAL_PTR(held.get(), broker.find("c").get());
+
+    // Held entries go once there is nothing else
+    std::weak_ptr<cached> watch = held;
+    auto held_d = broker.find("d");
+    auto held_e = broker.find("e");
+    broker.obtain("f", create);
+    TEST_ASSERT_NULL(broker.find("c").get());
+    TEST_ASSERT_FALSE(watch.expired());
+    TEST_ASSERT_EQUAL_STRING("c", held->url.c_str());
+    held.reset();
+    TEST_ASSERT_TRUE(watch.expired());
+
+    // Failures aren't cached, and never more than the capacity is
+    TEST_ASSERT_NULL(broker.obtain("", create).get());
+    TEST_ASSERT_EQUAL(3, broker.stats().entries);
+    TEST_ASSERT_EQUAL(3, broker.stats().entries_peak);
+
+    broker.dispose("e");
+    TEST_ASSERT_EQUAL(2, broker.stats().entries);
+    broker.clear();
+    TEST_ASSERT_EQUAL(0, broker.stats().entries);
+    TEST_ASSERT_EQUAL_STRING("d", held_d->url.c_str());
+}
+
+void tests_meat_broker_pool()
+{
+    MeatPoolStats before = MeatPool::stats();
+
+    pooled *objects[POOL_TEST_OBJECTS];
+    std::set<void *> slots;
+    for (int i = 0; i < POOL_TEST_OBJECTS; i++)
+    {
+        objects[i] = new pooled;
+        memset(objects[i]->data, i, sizeof(objects[i]->data));
+        slots.insert(objects[i]);
+    }
+    TEST_ASSERT_EQUAL(POOL_TEST_OBJECTS, slots.size());
+    for (int i = 0; i < POOL_TEST_OBJECTS; i++)
+        TEST_ASSERT_EQUAL(i, objects[i]->data[sizeof(objects[i]->data) - 1]);
+
+    MeatPoolStats during = MeatPool::stats();
+    TEST_ASSERT_EQUAL(before.objects + POOL_TEST_OBJECTS, during.objects);
+    TEST_ASSERT_EQUAL(before.bytes + POOL_TEST_OBJECTS * sizeof(pooled), during.bytes);
+    TEST_ASSERT_TRUE(during.bytes_peak >= during.bytes);
+
+    for (int i = 0; i < POOL_TEST_OBJECTS; i++)
+        delete objects[i];
+
+    // The same number again only takes slots that were just freed
+    for (int i = 0; i < POOL_TEST_OBJECTS; i++)
+    {
+        objects[i] = new pooled;
+        TEST_ASSERT_TRUE(slots.count(objects[i]) == 1);
+    }
+    TEST_ASSERT_EQUAL(during.slabs, MeatPool::stats().slabs);
+    for (int i = 0; i < POOL_TEST_OBJECTS; i++)
+        delete objects[i];
+
+    // Too large for a slot
+    pooled_large *large = new pooled_large;
+    TEST_ASSERT_EQUAL(during.heap_allocations + 1, MeatPool::stats().heap_allocations);
+    delete large;
+
+    MeatPoolStats after = MeatPool::stats();
+    TEST_ASSERT_EQUAL(before.objects, after.objects);
+    TEST_ASSERT_EQUAL(before.bytes, after.bytes);
+}
+
+void tests_meat_broker_pool_limit()
+{
+    MeatPoolStats before = MeatPool::stats();
+    if (fnSystem.get_psram_size() > 0)
+        TEST_ASSERT_EQUAL(MEATLOAF_POOL_SLABS, before.slabs_max);
+    else
+        TEST_ASSERT_EQUAL(MEATLOAF_POOL_SLABS_NO_PSRAM, before.slabs_max);
+    TEST_ASSERT_TRUE(before.slabs <= before.slabs_max);
+
+    // The largest pooled size, so every few take a new slab until there are no more
+    const size_t per_slab = MEATLOAF_POOL_SLAB_SIZE / MEATLOAF_POOL_MAX_OBJECT;
+    pooled_slab *objects[MEATLOAF_POOL_SLABS * per_slab + 1];
+    size_t n = 0;
+    size_t pooled = (before.slabs_max - before.slabs) * per_slab;
+    while (n < pooled + 1)
+        objects[n++] = new pooled_slab;
+
+    MeatPoolStats full = MeatPool::stats();
+    TEST_ASSERT_EQUAL(full.slabs_max, full.slabs);
+    TEST_ASSERT_EQUAL(before.heap_allocations + 1, full.heap_allocations);
+    TEST_ASSERT_EQUAL(before.objects + n, full.objects);
+
+    while (n > 0)
+        delete objects[--n];
+    TEST_ASSERT_EQUAL(before.objects, MeatPool::stats().objects);
+}
+
+void tests_meat_broker()
+{
+    RUN_TEST(tests_meat_broker_lru);
+    RUN_TEST(tests_meat_broker_pool);
+    RUN_TEST(tests_meat_broker_pool_limit);
+}
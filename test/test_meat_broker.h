@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - Meatloaf broker and object pool
+ *
+ * Checks which entries the bounded broker drops, that dropped objects live
+ * on while held, that the pool gives freed slots back out and that it
+ * stops taking slabs at its limit.
+ */
+
+#ifndef TEST_MEAT_BROKER_H
+#define TEST_MEAT_BROKER_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_meat_broker();
+
+    /**
+     * Test least recently used eviction, skipping held entries
+     */
+    void tests_meat_broker_lru();
+
+    /**
+     * Test slot reuse and the pool counters
+     */
+    void tests_meat_broker_pool();
+
+    /**
+     * Test that a full pool hands new objects to the heap
+     */
+    void tests_meat_broker_pool_limit();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_MEAT_BROKER_H */
@@ -0,0 +1,316 @@
+/**
+ * #FujiNet Tests - Meatloaf media block cache
+ *
+ * Reads a D64 through its stream from a container that, like HTTP, stops
+ * at the end of each range, and checks the bytes, the number of container
+ * requests, that the directory track stays cached, that writes drop
+ * what they touch and that a cache goes with the last stream on it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include "test_media_cache.h"
+
+#ifdef BUILD_IEC
+
+#include "../lib/meatloaf/disk/d64.h"
+
+// A 35 track D64 with errors: 683 blocks and 683 error bytes
+#define CACHE_TEST_SIZE 175531
+// Bytes a read returns before the range ends
+#define CACHE_TEST_RANGE 261
+// Track 18 is blocks 357 to 375
+#define CACHE_TEST_DIR_BLOCK 357
+#define CACHE_TEST_DIR_BLOCKS 19
+
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 13 + (pos >> 8));
+}
+
+/**
+ * In memory container that counts requests and stops at the end of each range
+ */
+class RangeStream : public MStream
+{
+public:
+    uint32_t seeks = 0;
+
+    RangeStream(const std::string &container_url)
+    {
+        url = container_url;
+        _size = CACHE_TEST_SIZE;
+    }
+
+    bool isOpen() override { return true; }
+    bool open(std::ios_base::openmode mode) override { return true; }
+    void close() override {}
+
+    bool seek(uint32_t pos) override
+    {
+        if (pos > _size)
+            return false;
+        seeks++;
+        _position = pos;
+        _range_left = CACHE_TEST_RANGE;
+        return true;
+    }
+
+    uint32_t read(uint8_t *buf, uint32_t size) override
+    {
+        if (size > available())
+            size = available();
+        if (size == 0)
+            return 0;
+        if (_range_left == 0)
+        {
+            // The next range is as long as the caller asked for
+            seeks++;
+            _range_left = size;
+        }
+        if (size > _range_left)
+            size = _range_left;
+        for (uint32_t i = 0; i < size; i++)
+            buf[i] = peek(_position + i);
+        _position += size;
+        _range_left -= size;
+        return size;
+    }
+
+    uint32_t write(const uint8_t *buf, uint32_t size) override
+    {
+        if (size > available())
+            size = available();
+        for (uint32_t i = 0; i < size; i++)
+            _written[_position + i] = buf[i];
+        _position += size;
+        return size;
+    }
+
+    uint8_t peek(uint32_t pos)
+    {
+        auto w = _written.find(pos);
+        if (w != _written.end())
+            return w->second;
+        return pattern(pos);
+    }
+
+private:
+    uint32_t _range_left = 0;
+    std::map<uint32_t, uint8_t> _written;
+};
+
+/**
+ * D64 stream with the container access the drive uses made public
+ */
+class CacheTestStream : public D64MStream
+{
+public:
+    CacheTestStream(std::shared_ptr<MStream> is) : D64MStream(is) {}
+
+    using MMediaStream::readContainer;
+    using MMediaStream::writeContainer;
+    using MMediaStream::seekContainer;
+
+    uint32_t containerPosition() { return _container_position; }
+};
+
+static uint32_t blockPos(uint32_t block, uint32_t offset = 0)
+{
+    return block * MEATLOAF_CACHE_BLOCK_SIZE + offset;
+}
+
+static bool check(RangeStream &src, const uint8_t *buf, uint32_t pos, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+        if (buf[i] != src.peek(pos + i))
+            return false;
+    return true;
+}
+
+// Read a sector the way a file chain is followed: the link, then the data
+static bool read_sector(CacheTestStream &image, RangeStream &src, uint8_t track, uint8_t sector)
+{
+    uint8_t buf[MEATLOAF_CACHE_BLOCK_SIZE];
+    if (!image.seekSector(track, sector))
+        return false;
+    uint32_t pos = image.containerPosition();
+    if (image.readContainer(buf, 2) != 2)
+        return false;
+    if (image.readContainer(buf + 2, MEATLOAF_CACHE_BLOCK_SIZE - 2) != MEATLOAF_CACHE_BLOCK_SIZE - 2)
+        return false;
+    return check(src, buf, pos, MEATLOAF_CACHE_BLOCK_SIZE);
+}
+
+void tests_media_cache_read()
+{
+    auto src = std::make_shared<RangeStream>("http://example.com/read.d64");
+    CacheTestStream image(src);
+    uint8_t buf[MEATLOAF_CACHE_BLOCK_SIZE * 3];
+    uint32_t reads = MediaBlockCache::stats().reads;
+
+    // Seeking only moves the position, nothing is asked for until a read
+    TEST_ASSERT_TRUE(image.seekSector(17, 10, 2));
+    TEST_ASSERT_EQUAL(blockPos(16 * 21 + 10, 2), image.containerPosition());
+    TEST_ASSERT_EQUAL(0, src->seeks);
+
+    // A file on tracks 17, 19 and 20 at interleave 10: one container read a
+    // track, each two requests as the first range stops short
+    uint32_t blocks = 0;
+    for (uint8_t i = 0; i < 21; i++, blocks++)
+        TEST_ASSERT_TRUE(read_sector(image, *src, 17, i * 10 % 21));
+    for (uint8_t i = 0; i < 19; i++, blocks++)
+        TEST_ASSERT_TRUE(read_sector(image, *src, 19, i * 10 % 19));
+    for (uint8_t i = 0; i < 5; i++, blocks++)
+        TEST_ASSERT_TRUE(read_sector(image, *src, 20, i * 10 % 19));
+    TEST_ASSERT_EQUAL(45, blocks);
+    TEST_ASSERT_EQUAL(reads + 3, MediaBlockCache::stats().reads);
+    TEST_ASSERT_EQUAL(6, src->seeks);
+
+    // The window is the whole track the block is on
+    uint32_t first = 0, count = 0;
+    image.cacheWindow(CACHE_TEST_DIR_BLOCK + CACHE_TEST_DIR_BLOCKS * 2 + 4, first, count);
+    TEST_ASSERT_EQUAL(CACHE_TEST_DIR_BLOCK + CACHE_TEST_DIR_BLOCKS * 2, first);
+    TEST_ASSERT_EQUAL(19, count);
+
+    // Across block boundaries, all from the cache
+    TEST_ASSERT_TRUE(image.seekContainer(blockPos(16 * 21 + 5, 100)));
+    TEST_ASSERT_EQUAL(sizeof(buf), image.readContainer(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(check(*src, buf, blockPos(16 * 21 + 5, 100), sizeof(buf)));
+    TEST_ASSERT_EQUAL(reads + 3, MediaBlockCache::stats().reads);
+
+    // The error bytes at the end are short of a block
+    TEST_ASSERT_TRUE(image.seekContainer(CACHE_TEST_SIZE - 10));
+    TEST_ASSERT_EQUAL(10, image.readContainer(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(check(*src, buf, CACHE_TEST_SIZE - 10, 10));
+    TEST_ASSERT_EQUAL(0, image.readContainer(buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(image.seekContainer(CACHE_TEST_SIZE + 1));
+
+    // Another stream on the same image finds the blocks already there
+    auto other_src = std::make_shared<RangeStream>("http://example.com/read.d64");
+    CacheTestStream other(other_src);
+    TEST_ASSERT_TRUE(read_sector(other, *other_src, 19, 4));
+    TEST_ASSERT_EQUAL(0, other_src->seeks);
+
+    MediaBlockCache::clear();
+}
+
+void tests_media_cache_pinned()
+{
+    auto src = std::make_shared<RangeStream>("http://example.com/pinned.d64");
+    CacheTestStream image(src);
+    uint8_t buf[16];
+
+    // The header, directory and BAM track stays, the next one doesn't
+    TEST_ASSERT_TRUE(image.cachePinned(CACHE_TEST_DIR_BLOCK));
+    TEST_ASSERT_TRUE(image.cachePinned(CACHE_TEST_DIR_BLOCK + CACHE_TEST_DIR_BLOCKS - 1));
+    TEST_ASSERT_FALSE(image.cachePinned(CACHE_TEST_DIR_BLOCK + CACHE_TEST_DIR_BLOCKS));
+    TEST_ASSERT_FALSE(image.cachePinned(0));
+
+    // A listing reads the BAM and the first directory sector
+    TEST_ASSERT_TRUE(read_sector(image, *src, 18, 0));
+    TEST_ASSERT_TRUE(read_sector(image, *src, 18, 1));
+
+    // Read every other track, far more than the cache holds
+    for (uint8_t track = 1; track <= 35; track++)
+        if (track != 18)
+            TEST_ASSERT_TRUE(read_sector(image, *src, track, 0));
+    uint32_t reads = MediaBlockCache::stats().reads;
+
+    for (uint8_t sector = 0; sector < CACHE_TEST_DIR_BLOCKS; sector++)
+        TEST_ASSERT_TRUE(read_sector(image, *src, 18, sector));
+    TEST_ASSERT_EQUAL(reads, MediaBlockCache::stats().reads);
+
+    TEST_ASSERT_TRUE(read_sector(image, *src, 1, 0));
+    TEST_ASSERT_EQUAL(reads + 1, MediaBlockCache::stats().reads);
+
+    // Writes drop the blocks they touch, and the next read sees the new bytes
+    uint8_t data[4] = {0xde, 0xad, 0xbe, 0xef};
+    TEST_ASSERT_TRUE(image.seekSector(1, 3, 254));
+    TEST_ASSERT_EQUAL(sizeof(data), image.writeContainer(data, sizeof(data)));
+    TEST_ASSERT_EQUAL(blockPos(4, 2), image.containerPosition());
+    reads = MediaBlockCache::stats().reads;
+
+    TEST_ASSERT_TRUE(image.seekSector(1, 2));
+    TEST_ASSERT_EQUAL(sizeof(buf), image.readContainer(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL(reads, MediaBlockCache::stats().reads);
+
+    TEST_ASSERT_TRUE(image.seekSector(1, 3, 250));
+    TEST_ASSERT_EQUAL(sizeof(buf), image.readContainer(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(check(*src, buf, blockPos(3, 250), sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8(0xde, buf[4]);
+    TEST_ASSERT_EQUAL_HEX8(0xef, buf[7]);
+    TEST_ASSERT_EQUAL(reads + 1, MediaBlockCache::stats().reads);
+
+    MediaBlockCache::clear();
+}
+
+void tests_media_cache_release()
+{
+    uint8_t data[4] = {0xde, 0xad, 0xbe, 0xef};
+    uint32_t pos = blockPos(18 * 21 + 4);
+
+    {
+        auto src = std::make_shared<RangeStream>("http://example.com/release.d64");
+        CacheTestStream image(src);
+        TEST_ASSERT_TRUE(read_sector(image, *src, 19, 4));
+    }
+    TEST_ASSERT_EQUAL(0, MediaBlockCache::brokerStats().entries);
+
+    // Rewritten to the same size while nothing had it open
+    auto src = std::make_shared<RangeStream>("http://example.com/release.d64");
+    TEST_ASSERT_TRUE(src->seek(pos));
+    TEST_ASSERT_EQUAL(sizeof(data), src->write(data, sizeof(data)));
+    src->seeks = 0;
+    auto image = std::make_shared<CacheTestStream>(src);
+    TEST_ASSERT_TRUE(read_sector(*image, *src, 19, 4));
+    TEST_ASSERT_TRUE(src->seeks > 0);
+
+    // Pushed out of the broker while held, by two other images
+    auto b_src = std::make_shared<RangeStream>("http://example.com/b.d64");
+    auto c_src = std::make_shared<RangeStream>("http://example.com/c.d64");
+    auto b = std::make_shared<CacheTestStream>(b_src);
+    auto c = std::make_shared<CacheTestStream>(c_src);
+    TEST_ASSERT_EQUAL(2, MediaBlockCache::brokerStats().entries);
+
+    // A new stream on it gets a new cache, which the old one closing leaves alone
+    auto new_src = std::make_shared<RangeStream>("http://example.com/release.d64");
+    auto newer = std::make_shared<CacheTestStream>(new_src);
+    TEST_ASSERT_TRUE(read_sector(*newer, *new_src, 19, 4));
+    b.reset();
+    c.reset();
+    image.reset();
+    auto shared_src = std::make_shared<RangeStream>("http://example.com/release.d64");
+    CacheTestStream shared(shared_src);
+    TEST_ASSERT_TRUE(read_sector(shared, *shared_src, 19, 4));
+    TEST_ASSERT_EQUAL(0, shared_src->seeks);
+
+    MediaBlockCache::clear();
+}
+
+#else
+
+void tests_media_cache_read()
+{
+    TEST_IGNORE_MESSAGE("Meatloaf is only built for Commodore");
+}
+
+void tests_media_cache_pinned()
+{
+    TEST_IGNORE_MESSAGE("Meatloaf is only built for Commodore");
+}
+
+void tests_media_cache_release()
+{
+    TEST_IGNORE_MESSAGE("Meatloaf is only built for Commodore");
+}
+
+#endif /* BUILD_IEC */
+
+void tests_media_cache()
+{
+    RUN_TEST(tests_media_cache_read);
+    RUN_TEST(tests_media_cache_pinned);
+    RUN_TEST(tests_media_cache_release);
+}
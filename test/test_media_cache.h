@@ -0,0 +1,43 @@
+/**
+ * #FujiNet Tests - Meatloaf media block cache
+ *
+ * Reads a D64 through its stream from a container that, like HTTP, stops
+ * at the end of each range, and checks the bytes, the number of container
+ * requests, that the directory track stays cached, that writes drop
+ * what they touch and that a cache goes with the last stream on it.
+ */
+
+#ifndef TEST_MEDIA_CACHE_H
+#define TEST_MEDIA_CACHE_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_media_cache();
+
+    /**
+     * Test that a file across three tracks loads in one container read a track
+     */
+    void tests_media_cache_read();
+
+    /**
+     * Test that the directory track stays, and that writes are read back
+     */
+    void tests_media_cache_pinned();
+
+    /**
+     * Test that an image changed in place is read again once its streams close
+     */
+    void tests_media_cache_release();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_MEDIA_CACHE_H */
@@ -0,0 +1,111 @@
+/**
+ * #FujiNet Tests - Modem data pump
+ *
+ * Checks the backward "+++" scan against a byte at a time count, and the
+ * in place ring buffer spans the pump reads and writes through.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/modem-pump/modem-pump.h"
+#include "test_modem_pump.h"
+
+/**
+ * The original count, one byte at a time
+ */
+static int reference_count(int count, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (buf[i] == MODEM_ESCAPE_CHAR)
+            count++;
+        else
+            count = 0;
+    }
+    return count;
+}
+
+void tests_modem_pump_escape()
+{
+    uint8_t buf[64];
+    char msg[100];
+
+    srand(7);
+    for (int round = 0; round < 2000; round++)
+    {
+        // Mostly escape characters, so runs of every length turn up
+        size_t len = rand() % sizeof(buf);
+        for (size_t i = 0; i < len; i++)
+            buf[i] = rand() % 4 ? MODEM_ESCAPE_CHAR : 'A' + rand() % 26;
+
+        int before = rand() % (MODEM_ESCAPE_COUNT + 1);
+        int expected = reference_count(before, buf, len);
+        int got = ModemPump::count_escape(before, buf, len);
+
+        // Only "fewer than" or "at least" MODEM_ESCAPE_COUNT matters
+        if (expected > MODEM_ESCAPE_COUNT)
+            expected = MODEM_ESCAPE_COUNT;
+        snprintf(msg, sizeof(msg), "round %d, %u bytes, %d before", round, (unsigned)len, before);
+        TEST_ASSERT_EQUAL_MESSAGE(expected, got, msg);
+    }
+
+    // "+++" split across reads
+    const uint8_t plus = MODEM_ESCAPE_CHAR;
+    int count = ModemPump::count_escape(0, (const uint8_t *)"AT", 2);
+    for (int i = 0; i < MODEM_ESCAPE_COUNT; i++)
+        count = ModemPump::count_escape(count, &plus, 1);
+    TEST_ASSERT_EQUAL(MODEM_ESCAPE_COUNT, count);
+    count = ModemPump::count_escape(count, (const uint8_t *)"x", 1);
+    TEST_ASSERT_EQUAL(0, count);
+}
+
+void tests_modem_pump_spans()
+{
+    RingBuffer<64> ring;
+    uint8_t out[64];
+    uint8_t next_in = 0;
+    uint8_t next_out = 0;
+
+    srand(8);
+    for (int round = 0; round < 1000; round++)
+    {
+        // Fill part of the free space in place
+        uint8_t *w[2];
+        size_t w_len[2];
+        size_t free_space = ring.write_spans(&w[0], &w_len[0], &w[1], &w_len[1]);
+        TEST_ASSERT_EQUAL(ring.room(), free_space);
+        TEST_ASSERT_EQUAL(free_space, w_len[0] + w_len[1]);
+
+        size_t n = free_space ? rand() % (free_space + 1) : 0;
+        for (size_t i = 0; i < n; i++)
+            (i < w_len[0] ? w[0][i] : w[1][i - w_len[0]]) = next_in++;
+        ring.commit(n);
+
+        // Check the waiting bytes in place, then drop some
+        const uint8_t *r[2];
+        size_t r_len[2];
+        size_t waiting = ring.read_spans(&r[0], &r_len[0], &r[1], &r_len[1]);
+        TEST_ASSERT_EQUAL(ring.available(), waiting);
+        TEST_ASSERT_EQUAL(waiting, r_len[0] + r_len[1]);
+        for (size_t i = 0; i < waiting; i++)
+            TEST_ASSERT_EQUAL((uint8_t)(next_out + i), i < r_len[0] ? r[0][i] : r[1][i - r_len[0]]);
+
+        size_t drop = waiting ? rand() % (waiting + 1) : 0;
+        if (round % 3 == 0)
+        {
+            TEST_ASSERT_EQUAL(drop, ring.pop(out, drop));
+            for (size_t i = 0; i < drop; i++)
+                TEST_ASSERT_EQUAL((uint8_t)(next_out + i), out[i]);
+        }
+        else
+            TEST_ASSERT_EQUAL(drop, ring.discard(drop));
+        next_out += drop;
+    }
+}
+
+void tests_modem_pump()
+{
+    RUN_TEST(tests_modem_pump_escape);
+    RUN_TEST(tests_modem_pump_spans);
+}
@@ -0,0 +1,36 @@
+/**
+ * #FujiNet Tests - Modem data pump
+ *
+ * Checks the backward "+++" scan against a byte at a time count, and the
+ * in place ring buffer spans the pump reads and writes through.
+ */
+
+#ifndef TEST_MODEM_PUMP_H
+#define TEST_MODEM_PUMP_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_modem_pump();
+
+    /**
+     * Test escape counting against the original per byte count
+     */
+    void tests_modem_pump_escape();
+
+    /**
+     * Test ring buffer spans across the wrap point
+     */
+    void tests_modem_pump_spans();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_MODEM_PUMP_H */
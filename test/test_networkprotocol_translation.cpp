@@ -4,9 +4,16 @@
  * This set of tests exercise the translation code that's in the NetworkProtocol base class.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <algorithm>
+#include <esp_timer.h>
 #include "../lib/network-protocol/Protocol.h"
+#include "../lib/network-protocol/Translation.h"
+#include "../lib/utils/utils.h"
+#include "../lib/utils/string_utils.h"
 #include "test_networkprotocol_translation.h"
 
 /**
@@ -15,6 +22,12 @@
 #define RX_TX_SIZE 65535
 #define SP_SIZE 256
 
+/**
+ * Bytes translated per mode in the timing test, and how often
+ */
+#define TIMING_SIZE 4096
+#define TIMING_ROUNDS 64
+
 using namespace std;
 
 /**
@@ -48,6 +61,7 @@ void tests_networkprotocol_translation()
     RUN_TEST(tests_networkprotocol_translation_tx_eol_to_cr);
     RUN_TEST(tests_networkprotocol_translation_tx_eol_to_lf);
     RUN_TEST(tests_networkprotocol_translation_tx_eol_to_crlf);
+    RUN_TEST(tests_networkprotocol_translation_timing);
 }
 
 /**
@@ -209,3 +223,141 @@ void tests_networkprotocol_translation_done()
     if (sp_buf != nullptr)
         delete sp_buf;
 }
+
+/**
+ * The receive translation as it was before the tables, one pass per rule
+ */
+static void reference_receive(unsigned char mode, string &buf)
+{
+#ifdef BUILD_ATARI
+    replace(buf.begin(), buf.end(), '\x07', '\xfd');
+    replace(buf.begin(), buf.end(), '\x08', '\x7e');
+    replace(buf.begin(), buf.end(), '\x09', '\x7f');
+#endif
+
+#ifdef BUILD_APPLE
+    const char eol = '\x0d';
+#else
+    const char eol = '\x9b';
+#endif
+
+    switch (mode)
+    {
+    case TRANSLATION_MODE_CR:
+        replace(buf.begin(), buf.end(), '\x0d', eol);
+        break;
+    case TRANSLATION_MODE_LF:
+        replace(buf.begin(), buf.end(), '\x0a', eol);
+        break;
+    case TRANSLATION_MODE_CRLF:
+#ifndef BUILD_APPLE
+        replace(buf.begin(), buf.end(), '\x0d', eol);
+#endif
+        break;
+    case TRANSLATION_MODE_PETSCII:
+        buf = mstr::toUTF8(buf);
+        break;
+    }
+
+    if (mode == TRANSLATION_MODE_CRLF)
+        buf.erase(remove(buf.begin(), buf.end(), '\n'), buf.end());
+}
+
+/**
+ * The transmit translation as it was before the tables, one pass per rule
+ */
+static void reference_transmit(unsigned char mode, string &buf)
+{
+#ifdef BUILD_ATARI
+    util_replaceAll(buf, "\xfd", "\x07");
+    util_replaceAll(buf, "\x7e", "\x08");
+    util_replaceAll(buf, "\x7f", "\x09");
+#endif
+
+#ifdef BUILD_APPLE
+    const string eol = "\x0d";
+#else
+    const string eol = "\x9b";
+#endif
+
+    switch (mode)
+    {
+    case TRANSLATION_MODE_CR:
+        util_replaceAll(buf, eol, "\x0d");
+        break;
+    case TRANSLATION_MODE_LF:
+        util_replaceAll(buf, eol, "\x0a");
+        break;
+    case TRANSLATION_MODE_CRLF:
+        util_replaceAll(buf, eol, "\x0d\x0a");
+        break;
+    case TRANSLATION_MODE_PETSCII:
+        buf = mstr::toUTF8(buf);
+        break;
+    }
+}
+
+/**
+ * Test throughput of the old passes against the tables, for every mode
+ */
+void tests_networkprotocol_translation_timing()
+{
+    char msg[200];
+    const char *names[] = {"", "CR", "LF", "CRLF", "PETSCII"};
+
+    // Lines of text with the line endings and control characters the rules touch
+    string sample;
+    const char *endings[] = {"\x0d", "\x0a", "\x0d\x0a", "\x9b"};
+    srand(11);
+    while (sample.size() < TIMING_SIZE)
+    {
+        size_t len = 10 + rand() % 60;
+        for (size_t i = 0; i < len; i++)
+        {
+            switch (rand() % 40)
+            {
+            case 0: sample += '\x07'; break;
+            case 1: sample += '\x08'; break;
+            case 2: sample += '\x09'; break;
+            case 3: sample += '\x7e'; break;
+            default: sample += (char)(0x20 + rand() % 0x5e); break;
+            }
+        }
+        sample += endings[rand() % 4];
+    }
+
+    for (unsigned char mode = TRANSLATION_MODE_CR; mode <= TRANSLATION_MODE_PETSCII; mode++)
+    {
+        for (int dir = 0; dir < NetworkTranslation::DIRECTION_COUNT; dir++)
+        {
+            const NetworkTranslation *table = NetworkTranslation::get(mode, (NetworkTranslation::direction_t)dir);
+
+            string expected = sample;
+            string got = sample;
+            int64_t t0 = esp_timer_get_time();
+            for (int round = 0; round < TIMING_ROUNDS; round++)
+            {
+                expected = sample;
+                if (dir == NetworkTranslation::DIRECTION_RECEIVE)
+                    reference_receive(mode, expected);
+                else
+                    reference_transmit(mode, expected);
+            }
+            int64_t t1 = esp_timer_get_time();
+            for (int round = 0; round < TIMING_ROUNDS; round++)
+            {
+                got = sample;
+                table->apply(got);
+            }
+            int64_t t2 = esp_timer_get_time();
+
+            TEST_ASSERT_EQUAL(expected.size(), got.size());
+            TEST_ASSERT_EQUAL_MEMORY(expected.data(), got.data(), got.size());
+
+            snprintf(msg, sizeof(msg), "%s %s, %d x %d bytes: passes %lld us, table %lld us",
+                     names[mode], dir == NetworkTranslation::DIRECTION_RECEIVE ? "receive" : "transmit",
+                     TIMING_ROUNDS, (int)sample.size(), (long long)(t1 - t0), (long long)(t2 - t1));
+            TEST_MESSAGE(msg);
+        }
+    }
+}
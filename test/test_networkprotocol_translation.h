@@ -51,6 +51,11 @@ extern "C"
      */
     void tests_networkprotocol_translation_tx_eol_to_crlf();
 
+    /**
+     * Report throughput of the old passes against the tables, for every mode
+     */
+    void tests_networkprotocol_translation_timing();
+
     /**
      * Test set-up
      * @param c The test fixture to stuff into the buffer.
@@ -0,0 +1,249 @@
+/**
+ * #FujiNet Tests - PNG printer
+ *
+ * Prints pages through the PNG printer and compares the file byte for byte
+ * with one built here, with zlib blocks small enough that lines, and the
+ * filter byte at the start of one, cross block boundaries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/printer-emulator/png_printer.h"
+#include "test_png_printer.h"
+
+#define PNG_TEST_WIDTH 320
+#define PNG_TEST_HEIGHT 192
+#define PNG_TEST_IMAGE ((PNG_TEST_WIDTH + 1) * PNG_TEST_HEIGHT)
+// Signature, IHDR and PLTE
+#define PNG_TEST_IDAT_OFFSET (8 + 25 + 12 + 768)
+
+static uint8_t pixel(uint16_t x, uint16_t line)
+{
+    return (uint8_t)(x * 7 + line * 13 + (x >> 5));
+}
+
+/**
+ * PNG printer writing to a memory file, with the zlib block size chosen by the test
+ */
+class TestPngPrinter : public pngPrinter
+{
+public:
+    uint8_t *data = nullptr;
+    size_t size = 0;
+
+    TestPngPrinter(uint16_t block_size)
+    {
+        maxBlkSize = block_size;
+        uint32_t blocks = (PNG_TEST_IMAGE + block_size - 1) / block_size;
+        size = PNG_TEST_IDAT_OFFSET + 8 + 2 + blocks * 5 + PNG_TEST_IMAGE + 4 + 4 + 12;
+        data = (uint8_t *)calloc(1, size + 1);
+        _file = fmemopen(data, size + 1, "w");
+        post_new_file();
+    }
+
+    ~TestPngPrinter()
+    {
+        free(data);
+    }
+
+    // Close the file and return how much was written
+    long finish()
+    {
+        long written = ftell(_file);
+        fclose(_file);
+        _file = nullptr;
+        return written;
+    }
+
+    void add(uint8_t *buf, uint32_t n) { png_add_data(buf, n); }
+    bool send(uint8_t *buf, uint8_t n)
+    {
+        memcpy(buffer, buf, n);
+        return process_buffer(n, 0, 0);
+    }
+};
+
+static uint32_t crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+    }
+    return ~crc;
+}
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * Walks the printer's output and counts where it differs from the file built here
+ */
+struct PngExpect
+{
+    const uint8_t *out;
+    size_t pos = 0;
+    size_t bad = 0;
+    size_t first_bad = 0;
+    uint32_t crc = 0;
+
+    PngExpect(const uint8_t *o, size_t start) : out(o), pos(start) {}
+
+    void put(uint8_t c)
+    {
+        if (out[pos] != c && bad++ == 0)
+            first_bad = pos;
+        crc = crc32(crc, &c, 1);
+        pos++;
+    }
+
+    void put32(uint32_t v)
+    {
+        put(v >> 24);
+        put(v >> 16);
+        put(v >> 8);
+        put(v);
+    }
+};
+
+/**
+ * Check a printed page against the image with rows taken from the given
+ * source lines, stored in zlib blocks of up to block_size bytes
+ */
+static void check_png(TestPngPrinter &png, const uint16_t *lines, uint16_t block_size)
+{
+    long written = png.finish();
+    TEST_ASSERT_EQUAL(png.size, written);
+
+    // Signature and header
+    static const uint8_t head[] = {
+        0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A,
+        0x00, 0x00, 0x00, 0x0D, 'I', 'H', 'D', 'R',
+        0x00, 0x00, 0x01, 0x40, 0x00, 0x00, 0x00, 0xC0,
+        0x08, 0x03, 0x00, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_MEMORY(head, png.data, sizeof(head));
+    TEST_ASSERT_EQUAL_HEX32(crc32(0, &head[12], 17), be32(&png.data[29]));
+
+    // The palette is the printer's own, only its length and CRC are known here
+    TEST_ASSERT_EQUAL(768, be32(&png.data[33]));
+    TEST_ASSERT_EQUAL_MEMORY("PLTE", &png.data[37], 4);
+    TEST_ASSERT_EQUAL_HEX32(crc32(0, &png.data[37], 4 + 768), be32(&png.data[41 + 768]));
+
+    // Image data as stored zlib blocks of filter byte 0 and the row
+    uint32_t blocks = (PNG_TEST_IMAGE + block_size - 1) / block_size;
+    PngExpect e(png.data, PNG_TEST_IDAT_OFFSET);
+    e.put32(2 + blocks * 5 + PNG_TEST_IMAGE + 4);
+    e.crc = 0;
+    e.put('I');
+    e.put('D');
+    e.put('A');
+    e.put('T');
+    e.put(0x08);
+    e.put(0x1D);
+
+    uint32_t a = 1, b = 0;
+    for (uint32_t i = 0; i < PNG_TEST_IMAGE; i++)
+    {
+        if (i % block_size == 0)
+        {
+            uint16_t len = PNG_TEST_IMAGE - i < block_size ? PNG_TEST_IMAGE - i : block_size;
+            e.put(PNG_TEST_IMAGE - i <= block_size ? 1 : 0);
+            e.put(len);
+            e.put(len >> 8);
+            e.put(~len);
+            e.put(~len >> 8);
+        }
+        uint16_t x = i % (PNG_TEST_WIDTH + 1);
+        uint8_t c = x == 0 ? 0 : pixel(x - 1, lines[i / (PNG_TEST_WIDTH + 1)]);
+        e.put(c);
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    e.put32((b << 16) | a);
+    e.put32(e.crc);
+
+    // IEND
+    e.put32(0);
+    e.crc = 0;
+    e.put('I');
+    e.put('E');
+    e.put('N');
+    e.put('D');
+    e.put32(e.crc);
+
+    TEST_ASSERT_EQUAL(png.size, e.pos);
+    if (e.bad)
+        printf("%u bytes differ, first at %u\n", (unsigned)e.bad, (unsigned)e.first_bad);
+    TEST_ASSERT_EQUAL(0, e.bad);
+}
+
+void tests_png_printer_page()
+{
+    static uint16_t lines[PNG_TEST_HEIGHT];
+    TestPngPrinter png(DEFLATE_MAX_BLOCK_SIZE);
+
+    // Each line is a repeat count and 320 pixels, sent 40 bytes at a time
+    uint8_t line[1 + PNG_TEST_WIDTH];
+    uint16_t row = 0;
+    for (uint16_t source = 0; row < PNG_TEST_HEIGHT; source++)
+    {
+        line[0] = source % 3 + 1;
+        for (uint16_t x = 0; x < PNG_TEST_WIDTH; x++)
+            line[1 + x] = pixel(x, source);
+        for (uint8_t r = 0; r < line[0] && row < PNG_TEST_HEIGHT; r++)
+            lines[row++] = source;
+        for (uint16_t i = 0; i < sizeof(line); i += 40)
+            TEST_ASSERT_TRUE(png.send(&line[i], sizeof(line) - i < 40 ? sizeof(line) - i : 40));
+    }
+
+    check_png(png, lines, DEFLATE_MAX_BLOCK_SIZE);
+}
+
+void tests_png_printer_blocks()
+{
+    static uint16_t lines[PNG_TEST_HEIGHT];
+    for (uint16_t y = 0; y < PNG_TEST_HEIGHT; y++)
+        lines[y] = y;
+
+    // 322 puts the second line's filter byte last in the first block, 321
+    // and 320 end blocks on and just before a filter byte
+    const uint16_t block_sizes[] = {322, 321, 320, 1000, 4099, DEFLATE_MAX_BLOCK_SIZE};
+    const uint32_t pieces[] = {PNG_TEST_WIDTH, 97, 1};
+
+    uint8_t image_line[PNG_TEST_WIDTH];
+    for (uint16_t block_size : block_sizes)
+    {
+        for (uint32_t piece : pieces)
+        {
+            TestPngPrinter png(block_size);
+            // Pieces run on from one line into the next
+            uint32_t pos = 0;
+            for (uint16_t y = 0; y < PNG_TEST_HEIGHT; y++)
+            {
+                for (uint16_t x = 0; x < PNG_TEST_WIDTH; x++)
+                    image_line[x] = pixel(x, y);
+                for (uint32_t offset = 0; offset < PNG_TEST_WIDTH;)
+                {
+                    uint32_t n = piece - pos % piece;
+                    if (n > PNG_TEST_WIDTH - offset)
+                        n = PNG_TEST_WIDTH - offset;
+                    png.add(&image_line[offset], n);
+                    offset += n;
+                    pos += n;
+                }
+            }
+            check_png(png, lines, block_size);
+        }
+    }
+}
+
+void tests_png_printer()
+{
+    RUN_TEST(tests_png_printer_page);
+    RUN_TEST(tests_png_printer_blocks);
+}
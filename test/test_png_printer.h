@@ -0,0 +1,37 @@
+/**
+ * #FujiNet Tests - PNG printer
+ *
+ * Prints pages through the PNG printer and compares the file byte for byte
+ * with one built here, with zlib blocks small enough that lines, and the
+ * filter byte at the start of one, cross block boundaries.
+ */
+
+#ifndef TEST_PNG_PRINTER_H
+#define TEST_PNG_PRINTER_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_png_printer();
+
+    /**
+     * Test a page of repeated lines sent the way the bus hands them over
+     */
+    void tests_png_printer_page();
+
+    /**
+     * Test image data added in odd sized pieces across small zlib blocks
+     */
+    void tests_png_printer_blocks();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_PNG_PRINTER_H */
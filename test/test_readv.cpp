@@ -0,0 +1,218 @@
+/**
+ * #FujiNet Tests - Batched file reads
+ *
+ * Checks that FileHandler::readv() merges ranges that follow each other in
+ * the file, returns the right bytes into scattered buffers and stops short
+ * at the end of the file.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/FileSystem/fnFile.h"
+#include "test_readv.h"
+
+#define READV_TEST_SIZE 50000
+// Largest run readv() reads at once
+#define READV_TEST_SPAN 16384
+
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 11 + (pos >> 8) + (pos >> 16));
+}
+
+/**
+ * Read-only in memory file that records the reads readv() makes
+ */
+class ReadvTestFile : public FileHandler
+{
+public:
+    int reads = 0;
+    void *last_ptr = nullptr;
+    size_t last_len = 0;
+
+    int close(bool destroy = true) override
+    {
+        if (destroy)
+            delete this;
+        return 0;
+    }
+
+    int seek(long int off, int whence) override
+    {
+        if (whence != SEEK_SET || off < 0)
+            return -1;
+        _pos = off;
+        return 0;
+    }
+
+    long int tell() override { return _pos; }
+
+    size_t read(void *ptr, size_t size, size_t n) override
+    {
+        size_t len = size * n;
+        if (_pos >= READV_TEST_SIZE)
+            return 0;
+        if (len > (size_t)(READV_TEST_SIZE - _pos))
+            len = READV_TEST_SIZE - _pos;
+        for (size_t i = 0; i < len; i++)
+            ((uint8_t *)ptr)[i] = pattern(_pos + i);
+        _pos += len;
+        return len / size;
+    }
+
+    size_t write(const void *ptr, size_t size, size_t n) override { return 0; }
+    int flush() override { return 0; }
+
+protected:
+    size_t read_at(void *ptr, size_t len, long int offset) override
+    {
+        reads++;
+        last_ptr = ptr;
+        last_len = len;
+        return FileHandler::read_at(ptr, len, offset);
+    }
+
+private:
+    long int _pos = 0;
+};
+
+static void set_range(fnFileRange &r, long int offset, void *buf, size_t len)
+{
+    r.offset = offset;
+    r.buf = buf;
+    r.len = len;
+    r.done = 0xdead;
+}
+
+static bool check_range(const fnFileRange &r)
+{
+    size_t expect = r.offset >= READV_TEST_SIZE ? 0 : READV_TEST_SIZE - r.offset;
+    if (expect > r.len)
+        expect = r.len;
+    if (r.done != expect)
+        return false;
+    for (size_t i = 0; i < expect; i++)
+        if (((uint8_t *)r.buf)[i] != pattern(r.offset + i))
+            return false;
+    return true;
+}
+
+void tests_readv_coalesce()
+{
+    ReadvTestFile f;
+    static uint8_t buf[READV_TEST_SPAN * 2];
+    fnFileRange r[4];
+
+    // Adjacent in the file and in memory: one read straight into the buffers
+    set_range(r[0], 1000, buf, 512);
+    set_range(r[1], 1512, buf + 512, 100);
+    set_range(r[2], 1612, buf + 612, 900);
+    TEST_ASSERT_EQUAL(1512, f.readv(r, 3));
+    TEST_ASSERT_EQUAL(1, f.reads);
+    TEST_ASSERT_EQUAL_PTR(buf, f.last_ptr);
+    TEST_ASSERT_EQUAL(1512, f.last_len);
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_TRUE(check_range(r[i]));
+
+    // Adjacent in the file only: still one read, through another buffer
+    f.reads = 0;
+    set_range(r[0], 6656, buf + 7000, 6656);
+    set_range(r[1], 13312, buf, 6656);
+    TEST_ASSERT_EQUAL(13312, f.readv(r, 2));
+    TEST_ASSERT_EQUAL(1, f.reads);
+    TEST_ASSERT_EQUAL(13312, f.last_len);
+    TEST_ASSERT_TRUE(f.last_ptr != buf && f.last_ptr != buf + 7000);
+    TEST_ASSERT_TRUE(check_range(r[0]));
+    TEST_ASSERT_TRUE(check_range(r[1]));
+
+    // A gap, going backwards or the run growing too long start a new read
+    f.reads = 0;
+    set_range(r[0], 0, buf, 100);
+    set_range(r[1], 101, buf + 100, 100);
+    set_range(r[2], 0, buf + 200, READV_TEST_SPAN - 100);
+    set_range(r[3], READV_TEST_SPAN - 100, buf + READV_TEST_SPAN + 100, 101);
+    TEST_ASSERT_EQUAL(READV_TEST_SPAN + 201, f.readv(r, 4));
+    TEST_ASSERT_EQUAL(4, f.reads);
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(check_range(r[i]));
+
+    // A run of exactly the largest span is one read
+    f.reads = 0;
+    set_range(r[0], 100, buf, READV_TEST_SPAN - 1);
+    set_range(r[1], 100 + READV_TEST_SPAN - 1, buf + READV_TEST_SPAN - 1, 1);
+    TEST_ASSERT_EQUAL(READV_TEST_SPAN, f.readv(r, 2));
+    TEST_ASSERT_EQUAL(1, f.reads);
+}
+
+void tests_readv_eof()
+{
+    ReadvTestFile f;
+    uint8_t buf[3000];
+    fnFileRange r[4];
+
+    // The run stops in its second range, the rest get nothing
+    set_range(r[0], READV_TEST_SIZE - 700, buf, 500);
+    set_range(r[1], READV_TEST_SIZE - 200, buf + 500, 500);
+    set_range(r[2], READV_TEST_SIZE + 300, buf + 1000, 500);
+    set_range(r[3], READV_TEST_SIZE + 10000, buf + 2000, 500);
+    TEST_ASSERT_EQUAL(700, f.readv(r, 4));
+    TEST_ASSERT_EQUAL(500, r[0].done);
+    TEST_ASSERT_EQUAL(200, r[1].done);
+    TEST_ASSERT_EQUAL(0, r[2].done);
+    TEST_ASSERT_EQUAL(0, r[3].done);
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(check_range(r[i]));
+
+    // Through the temporary buffer too
+    set_range(r[0], READV_TEST_SIZE - 1500, buf + 1500, 1000);
+    set_range(r[1], READV_TEST_SIZE - 500, buf, 1000);
+    TEST_ASSERT_EQUAL(1500, f.readv(r, 2));
+    TEST_ASSERT_TRUE(check_range(r[0]));
+    TEST_ASSERT_TRUE(check_range(r[1]));
+
+    TEST_ASSERT_EQUAL(0, f.readv(r, 0));
+}
+
+void tests_readv_random()
+{
+    ReadvTestFile f;
+    static uint8_t pool[40000];
+    uint32_t seed = 12345;
+    auto next = [&seed](uint32_t n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % n;
+    };
+
+    for (int run = 0; run < 2000; run++)
+    {
+        fnFileRange r[10];
+        size_t count = 1 + next(10);
+        size_t pos = 0;
+        for (size_t k = 0; k < count; k++)
+        {
+            size_t len = 1 + next(3000);
+            long int offset = (k > 0 && next(2)) ? r[k - 1].offset + r[k - 1].len : next(READV_TEST_SIZE + 2000);
+            // Buffers are sometimes apart in memory
+            if (next(2))
+                pos += next(10);
+            set_range(r[k], offset, pool + pos, len);
+            pos += len;
+        }
+
+        size_t total = f.readv(r, count);
+        size_t expect = 0;
+        for (size_t k = 0; k < count; k++)
+        {
+            TEST_ASSERT_TRUE(check_range(r[k]));
+            expect += r[k].done;
+        }
+        TEST_ASSERT_EQUAL(expect, total);
+    }
+}
+
+void tests_readv()
+{
+    RUN_TEST(tests_readv_coalesce);
+    RUN_TEST(tests_readv_eof);
+    RUN_TEST(tests_readv_random);
+}
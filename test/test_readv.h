@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - Batched file reads
+ *
+ * Checks that FileHandler::readv() merges ranges that follow each other in
+ * the file, returns the right bytes into scattered buffers and stops short
+ * at the end of the file.
+ */
+
+#ifndef TEST_READV_H
+#define TEST_READV_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_readv();
+
+    /**
+     * Test which ranges are read with one request
+     */
+    void tests_readv_coalesce();
+
+    /**
+     * Test ranges reaching and starting past the end of the file
+     */
+    void tests_readv_eof();
+
+    /**
+     * Test random batches of ranges against the file contents
+     */
+    void tests_readv_random();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_READV_H */
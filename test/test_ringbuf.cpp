@@ -0,0 +1,319 @@
+/**
+ * #FujiNet Tests - SPSC ring buffer
+ *
+ * Checks the NetSIO receive ring across its wrap point, streams data from a
+ * producer thread to a consumer thread checking every byte, and times the
+ * NetSIO receive path against the per byte buffer it replaced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <esp_timer.h>
+#include "../lib/utils/ringbuf.h"
+#include "test_ringbuf.h"
+
+// Same size as the NetSIO receive buffer
+#define RING_SIZE 1024
+// Bytes streamed through the ring per timed run
+#define SPSC_BYTES (1024 * 1024)
+// Largest NetSIO data block and the SIO frame read from it (sector and checksum)
+#define NETSIO_BLOCK 512
+#define NETSIO_FRAME 129
+
+static uint8_t pattern(uint32_t n)
+{
+    return (uint8_t)(n * 7 + (n >> 8));
+}
+
+void tests_ringbuf_wrap()
+{
+    RingBuffer<16> ring;
+    uint8_t in[32], out[32];
+    for (int i = 0; i < 32; i++)
+        in[i] = i;
+
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_EQUAL(16, ring.room());
+
+    // Move the counters up to the wrap point, then across it
+    TEST_ASSERT_EQUAL(12, ring.push(in, 12));
+    TEST_ASSERT_EQUAL(12, ring.pop(out, 12));
+    TEST_ASSERT_EQUAL_MEMORY(in, out, 12);
+
+    // Only the capacity goes in
+    TEST_ASSERT_EQUAL(16, ring.push(in, 20));
+    TEST_ASSERT_TRUE(ring.full());
+    TEST_ASSERT_FALSE(ring.push(in[0]));
+
+    const uint8_t *first, *second;
+    size_t first_len, second_len;
+    TEST_ASSERT_EQUAL(16, ring.read_spans(&first, &first_len, &second, &second_len));
+    TEST_ASSERT_EQUAL(4, first_len);
+    TEST_ASSERT_EQUAL(12, second_len);
+    TEST_ASSERT_EQUAL_MEMORY(in, first, 4);
+    TEST_ASSERT_EQUAL_MEMORY(in + 4, second, 12);
+
+    // Drop the oldest, the rest comes out in order
+    TEST_ASSERT_EQUAL(3, ring.discard(3));
+    TEST_ASSERT_EQUAL(3, ring.pop());
+    TEST_ASSERT_EQUAL(12, ring.pop(out, 32));
+    TEST_ASSERT_EQUAL_MEMORY(in + 4, out, 12);
+    TEST_ASSERT_EQUAL(-1, ring.pop());
+
+    // Filled in place, published with commit()
+    uint8_t *wfirst, *wsecond;
+    size_t wfirst_len, wsecond_len;
+    TEST_ASSERT_EQUAL(16, ring.write_spans(&wfirst, &wfirst_len, &wsecond, &wsecond_len));
+    TEST_ASSERT_EQUAL(4, wfirst_len);
+    TEST_ASSERT_EQUAL(12, wsecond_len);
+    memcpy(wfirst, in + 16, wfirst_len);
+    memcpy(wsecond, in + 16 + wfirst_len, wsecond_len);
+    ring.commit(16);
+    TEST_ASSERT_EQUAL(16, ring.available());
+    TEST_ASSERT_EQUAL(16, ring.pop(out, 32));
+    TEST_ASSERT_EQUAL_MEMORY(in + 16, out, 16);
+}
+
+/**
+ * Stream SPSC_BYTES through the ring, chunk bytes per call (0 = random chunks up to 300)
+ * @return transfer time in microseconds, or -1 if a byte came out wrong
+ */
+static int64_t spsc_run(RingBuffer<RING_SIZE> &ring, size_t chunk)
+{
+    std::atomic<bool> bad(false);
+
+    int64_t t0 = esp_timer_get_time();
+
+    std::thread producer([&ring, chunk]() {
+        uint8_t buf[300];
+        uint32_t n = 0;
+        uint32_t seed = 1;
+        while (n < SPSC_BYTES)
+        {
+            seed = seed * 1103515245 + 12345;
+            size_t len = chunk != 0 ? chunk : 1 + (seed >> 16) % sizeof(buf);
+            if (len > SPSC_BYTES - n)
+                len = SPSC_BYTES - n;
+            for (size_t i = 0; i < len; i++)
+                buf[i] = pattern(n + i);
+
+            size_t done = 0;
+            while (done < len)
+            {
+                size_t pushed = ring.push(buf + done, len - done);
+                if (pushed == 0)
+                    std::this_thread::yield();
+                done += pushed;
+            }
+            n += len;
+        }
+    });
+
+    uint8_t buf[300];
+    uint32_t n = 0;
+    while (n < SPSC_BYTES)
+    {
+        size_t got = ring.pop(buf, chunk != 0 ? chunk : sizeof(buf));
+        if (got == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < got; i++)
+            if (buf[i] != pattern(n + i))
+                bad = true;
+        n += got;
+    }
+
+    producer.join();
+    int64_t t1 = esp_timer_get_time();
+
+    return bad ? -1 : t1 - t0;
+}
+
+void tests_ringbuf_spsc()
+{
+    char msg[200];
+    static RingBuffer<RING_SIZE> ring;
+
+    int64_t bulk = spsc_run(ring, 0);
+    TEST_ASSERT_TRUE(bulk >= 0);
+    TEST_ASSERT_TRUE(ring.empty());
+
+    int64_t single = spsc_run(ring, 1);
+    TEST_ASSERT_TRUE(single >= 0);
+    TEST_ASSERT_TRUE(ring.empty());
+
+    snprintf(msg, sizeof(msg), "%d bytes through a %d byte ring between two threads: random chunks %lld us, single bytes %lld us",
+             SPSC_BYTES, RING_SIZE, (long long)bulk, (long long)single);
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * The NetSIO receive buffer before the ring, as it was
+ */
+struct OldRxBuffer
+{
+    uint8_t _rxbuf[RING_SIZE];
+    int _rxhead = 0;
+    int _rxtail = 0;
+    bool _rxfull = false;
+
+    bool rxbuffer_empty()
+    {
+        return (_rxhead == _rxtail && !_rxfull);
+    }
+
+    bool rxbuffer_put(uint8_t b)
+    {
+        _rxbuf[_rxhead++] = b;
+        _rxhead %= sizeof(_rxbuf);
+        if (_rxfull) {
+            // tail byte was overwritten / lost
+            _rxtail = _rxhead;
+            return true;
+        }
+        _rxfull = (_rxhead == _rxtail);
+        return false;
+    }
+
+    int rxbuffer_get()
+    {
+        int b;
+        if (rxbuffer_empty())
+            return -1;
+        b = _rxbuf[_rxtail++];
+        _rxtail %= sizeof(_rxbuf);
+        _rxfull = false;
+        return b;
+    }
+
+    int rxbuffer_available()
+    {
+        int avail = _rxhead - _rxtail;
+        if ((avail < 0) || (avail == 0 && _rxfull))
+            avail += sizeof(_rxbuf);
+        return avail;
+    }
+};
+
+// Baud rates of a matching peer, nothing is corrupted
+static int _baud = 19200;
+static int _baud_peer = 19200;
+
+// Old handle_netsio() storing a data block, one byte at a time
+static void old_put(OldRxBuffer &rx, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t b = data[i];
+        if (_baud_peer < _baud * 90 / 100 || _baud_peer > _baud * 110 / 100)
+            b ^= (uint8_t)_baud_peer ^ (uint8_t)_baud; // corrupt byte
+        rx.rxbuffer_put(b);
+    }
+}
+
+// Old read(buffer, length): wait_for_data() and read() for every byte
+static size_t old_read(OldRxBuffer &rx, uint8_t *buffer, size_t length)
+{
+    size_t rxbytes = 0;
+    while (rxbytes < length && rx.rxbuffer_available() > 0)
+        buffer[rxbytes++] = (uint8_t)rx.rxbuffer_get();
+    return rxbytes;
+}
+
+// NetSioPort::rxbuffer_put() with the ring
+static void new_put(RingBuffer<RING_SIZE> &rx, uint8_t *data, size_t size)
+{
+    if (_baud_peer < _baud * 90 / 100 || _baud_peer > _baud * 110 / 100)
+    {
+        uint8_t x = (uint8_t)_baud_peer ^ (uint8_t)_baud;
+        for (size_t i = 0; i < size; i++)
+            data[i] ^= x; // corrupt byte
+    }
+    size_t room = rx.room();
+    if (size > room)
+        rx.discard(size - room);
+    rx.push(data, size);
+}
+
+// NetSioPort::read(buffer, length) with the ring
+static size_t new_read(RingBuffer<RING_SIZE> &rx, uint8_t *buffer, size_t length)
+{
+    size_t rxbytes = 0;
+    while (rxbytes < length && !rx.empty())
+        rxbytes += rx.pop(&buffer[rxbytes], length - rxbytes);
+    return rxbytes;
+}
+
+/**
+ * Receive SPSC_BYTES in data blocks of random size and read them as SIO
+ * frames on one thread, the way NetSIO does, with the old buffer or the ring
+ * @return time in microseconds, or -1 if a byte came out wrong
+ */
+static int64_t netsio_run(bool old)
+{
+    static OldRxBuffer old_rx;
+    static RingBuffer<RING_SIZE> new_rx;
+    uint8_t block[NETSIO_BLOCK], frame[NETSIO_FRAME];
+    uint32_t in = 0, out = 0, seed = 1;
+    bool bad = false;
+
+    int64_t t0 = esp_timer_get_time();
+    while (out < SPSC_BYTES)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t len = 1 + (seed >> 16) % NETSIO_BLOCK;
+        if (len > SPSC_BYTES - in)
+            len = SPSC_BYTES - in;
+        for (size_t i = 0; i < len; i++)
+            block[i] = pattern(in + i);
+        in += len;
+        if (old)
+            old_put(old_rx, block, len);
+        else
+            new_put(new_rx, block, len);
+
+        // Read whole frames while there are any, the rest at the end
+        for (;;)
+        {
+            size_t avail = old ? old_rx.rxbuffer_available() : new_rx.available();
+            if (avail == 0 || (avail < NETSIO_FRAME && in < SPSC_BYTES))
+                break;
+            size_t got = old ? old_read(old_rx, frame, NETSIO_FRAME) : new_read(new_rx, frame, NETSIO_FRAME);
+            for (size_t i = 0; i < got; i++)
+                if (frame[i] != pattern(out + i))
+                    bad = true;
+            out += got;
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+
+    return bad ? -1 : t1 - t0;
+}
+
+void tests_ringbuf_netsio()
+{
+    char msg[200];
+
+    int64_t old_us = netsio_run(true);
+    TEST_ASSERT_TRUE(old_us >= 0);
+    int64_t new_us = netsio_run(false);
+    TEST_ASSERT_TRUE(new_us >= 0);
+
+    snprintf(msg, sizeof(msg), "%d bytes in NetSIO blocks read as %d byte frames: per byte buffer %lld us (%lld KiB/s), ring %lld us (%lld KiB/s)",
+             SPSC_BYTES, NETSIO_FRAME,
+             (long long)old_us, old_us > 0 ? (long long)SPSC_BYTES * 1000000 / 1024 / old_us : 0LL,
+             (long long)new_us, new_us > 0 ? (long long)SPSC_BYTES * 1000000 / 1024 / new_us : 0LL);
+    TEST_MESSAGE(msg);
+}
+
+void tests_ringbuf()
+{
+    RUN_TEST(tests_ringbuf_wrap);
+    RUN_TEST(tests_ringbuf_spsc);
+    RUN_TEST(tests_ringbuf_netsio);
+}
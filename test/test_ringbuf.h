@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - SPSC ring buffer
+ *
+ * Checks the NetSIO receive ring across its wrap point, streams data from a
+ * producer thread to a consumer thread checking every byte, and times the
+ * NetSIO receive path against the per byte buffer it replaced.
+ */
+
+#ifndef TEST_RINGBUF_H
+#define TEST_RINGBUF_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_ringbuf();
+
+    /**
+     * Test push, pop, discard and the spans across the wrap point
+     */
+    void tests_ringbuf_wrap();
+
+    /**
+     * Test a producer and a consumer thread
+     */
+    void tests_ringbuf_spsc();
+
+    /**
+     * Report the NetSIO receive path with the old per byte buffer and the ring
+     */
+    void tests_ringbuf_netsio();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_RINGBUF_H */
@@ -0,0 +1,289 @@
+/**
+ * #FujiNet Tests - SLIP codec
+ *
+ * Round trips frames through the buffer encoder and the incremental
+ * decoder, fed in chunks of random size, and compares throughput with the
+ * original vector based encoder and decoder.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <esp_timer.h>
+#include "../lib/devrelay/slip/SLIP.h"
+#include "test_slip.h"
+
+#define MAX_FRAME 1100
+#define NUM_FRAMES 40
+
+static uint8_t frames[NUM_FRAMES][MAX_FRAME];
+static size_t frame_len[NUM_FRAMES];
+static uint8_t stream[NUM_FRAMES * (2 * MAX_FRAME + 2)];
+
+/**
+ * The original encoder
+ */
+static std::vector<uint8_t> reference_encode(const uint8_t *data, size_t len)
+{
+    std::vector<uint8_t> encoded_data;
+
+    encoded_data.push_back(SLIP_END);
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+        if (byte == SLIP_END || byte == SLIP_ESC)
+        {
+            encoded_data.push_back(SLIP_ESC);
+            encoded_data.push_back(byte == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC);
+        }
+        else
+            encoded_data.push_back(byte);
+    }
+    encoded_data.push_back(SLIP_END);
+
+    return encoded_data;
+}
+
+/**
+ * The original decoder (split_into_packets() and decode()) for a buffer of whole frames
+ */
+static std::vector<std::vector<uint8_t>> reference_split(const uint8_t *data, size_t bytes_read)
+{
+    std::vector<std::vector<uint8_t>> decoded_packets;
+    const uint8_t *packet_start = nullptr;
+
+    for (size_t i = 0; i < bytes_read; i++)
+    {
+        if (data[i] != SLIP_END)
+            continue;
+        if (packet_start == nullptr)
+        {
+            packet_start = data + i;
+            continue;
+        }
+        std::vector<uint8_t> packet(packet_start, data + i + 1);
+        std::vector<uint8_t> decoded;
+        for (size_t k = 1; k + 1 < packet.size(); k++)
+        {
+            if (packet[k] == SLIP_ESC)
+                decoded.push_back(packet[++k] == SLIP_ESC_END ? SLIP_END : SLIP_ESC);
+            else
+                decoded.push_back(packet[k]);
+        }
+        decoded_packets.push_back(decoded);
+        packet_start = nullptr;
+    }
+    return decoded_packets;
+}
+
+/**
+ * Random frames, special bytes with the given chance in 1/256
+ */
+static void make_frames(int special)
+{
+    for (int f = 0; f < NUM_FRAMES; f++)
+    {
+        frame_len[f] = 1 + rand() % MAX_FRAME;
+        for (size_t i = 0; i < frame_len[f]; i++)
+        {
+            int r = rand();
+            if ((r & 0xff) < special)
+                frames[f][i] = (r & 0x100) ? SLIP_END : SLIP_ESC;
+            else
+                frames[f][i] = r >> 9;
+        }
+    }
+}
+
+static size_t encode_frames()
+{
+    size_t len = 0;
+    for (int f = 0; f < NUM_FRAMES; f++)
+        len += SLIP::encode(frames[f], frame_len[f], stream + len);
+    return len;
+}
+
+/**
+ * Feed the stream to the decoder in chunks of at most max_chunk bytes,
+ * check the frames come out in order
+ */
+static void decode_in_chunks(SLIPDecoder &decoder, const uint8_t *data, size_t len, size_t max_chunk, int first_frame, int num_frames)
+{
+    int f = first_frame;
+
+    while (len > 0)
+    {
+        size_t chunk = 1 + rand() % max_chunk;
+        if (chunk > len)
+            chunk = len;
+        const uint8_t *p = data;
+        size_t n = chunk;
+        while (n > 0)
+        {
+            size_t used = decoder.feed(p, n);
+            TEST_ASSERT_TRUE(used > 0 && used <= n);
+            p += used;
+            n -= used;
+            if (decoder.has_frame())
+            {
+                TEST_ASSERT_TRUE(f < first_frame + num_frames);
+                TEST_ASSERT_EQUAL_UINT32(frame_len[f], decoder.frame_size());
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(frames[f], decoder.frame(), frame_len[f]);
+                f++;
+            }
+        }
+        data += chunk;
+        len -= chunk;
+    }
+    TEST_ASSERT_EQUAL(first_frame + num_frames, f);
+}
+
+/**
+ * Tests entrypoint
+ */
+void tests_slip()
+{
+    RUN_TEST(tests_slip_encode);
+    RUN_TEST(tests_slip_decode_chunks);
+    RUN_TEST(tests_slip_decode_errors);
+    RUN_TEST(tests_slip_timing);
+}
+
+void tests_slip_encode()
+{
+    static uint8_t out[2 * MAX_FRAME + 2];
+
+    srand(1);
+    for (int special : {0, 1, 16, 128, 256})
+    {
+        make_frames(special);
+        for (int f = 0; f < NUM_FRAMES; f++)
+        {
+            std::vector<uint8_t> ref = reference_encode(frames[f], frame_len[f]);
+            size_t len = SLIP::encode(frames[f], frame_len[f], out);
+            TEST_ASSERT_EQUAL_UINT32(ref.size(), len);
+            TEST_ASSERT_TRUE(len <= SLIP::max_encoded_size(frame_len[f]));
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(ref.data(), out, len);
+        }
+    }
+}
+
+void tests_slip_decode_chunks()
+{
+    srand(2);
+    for (size_t max_chunk : {1, 2, 7, 64, 1024, 100000})
+    {
+        for (int special : {0, 8, 128})
+        {
+            make_frames(special);
+            size_t len = encode_frames();
+            SLIPDecoder decoder;
+            decode_in_chunks(decoder, stream, len, max_chunk, 0, NUM_FRAMES);
+
+            std::vector<std::vector<uint8_t>> ref = reference_split(stream, len);
+            TEST_ASSERT_EQUAL(NUM_FRAMES, ref.size());
+        }
+    }
+
+    // frames sharing the END between them
+    make_frames(8);
+    size_t len = 0;
+    for (int f = 0; f < NUM_FRAMES; f++)
+        len += SLIP::encode(frames[f], frame_len[f], stream + len) - 1;
+    stream[len++] = SLIP_END;
+    SLIPDecoder decoder;
+    decode_in_chunks(decoder, stream, len, 300, 0, NUM_FRAMES);
+}
+
+void tests_slip_decode_errors()
+{
+    srand(3);
+    make_frames(8);
+    size_t len = encode_frames();
+
+    // garbage before the first END is skipped
+    {
+        static uint8_t buf[sizeof(stream) + 100];
+        memset(buf, 0x41, 100);
+        memcpy(buf + 100, stream, len);
+        SLIPDecoder decoder;
+        decode_in_chunks(decoder, buf, len + 100, 50, 0, NUM_FRAMES);
+    }
+
+    // an invalid escape drops that frame only
+    {
+        size_t first_len = SLIP::encode(frames[0], frame_len[0], stream);
+        stream[first_len / 2] = SLIP_ESC;
+        stream[first_len / 2 + 1] = 0x42;
+        SLIPDecoder decoder;
+        decode_in_chunks(decoder, stream, len, 50, 1, NUM_FRAMES - 1);
+    }
+
+    // too long frames are dropped
+    {
+        len = encode_frames();
+        size_t max_frame = 0;
+        for (int f = 1; f < NUM_FRAMES; f++)
+            max_frame = frame_len[f] > max_frame ? frame_len[f] : max_frame;
+        frame_len[0] = max_frame + 1;
+        memset(frames[0], 0x55, frame_len[0]);
+        len = encode_frames();
+        SLIPDecoder decoder(max_frame);
+        decode_in_chunks(decoder, stream, len, 500, 1, NUM_FRAMES - 1);
+    }
+}
+
+void tests_slip_timing()
+{
+    static uint8_t out[2 * MAX_FRAME + 2];
+    char msg[160];
+    const int rounds = 10;
+    int64_t t_ref_enc = 0, t_new_enc = 0, t_ref_dec = 0, t_new_dec = 0;
+    size_t bytes = 0, frames_out = 0;
+
+    srand(4);
+    make_frames(2);
+    size_t len = encode_frames();
+
+    for (int r = 0; r < rounds; r++)
+    {
+        int64_t t0 = esp_timer_get_time();
+        for (int f = 0; f < NUM_FRAMES; f++)
+            out[0] ^= reference_encode(frames[f], frame_len[f]).size();
+        int64_t t1 = esp_timer_get_time();
+        for (int f = 0; f < NUM_FRAMES; f++)
+            out[0] ^= SLIP::encode(frames[f], frame_len[f], out);
+        int64_t t2 = esp_timer_get_time();
+        // like the old TCP reader, one 1024 byte read at a time
+        for (size_t pos = 0; pos < len; pos += 1024)
+            frames_out += reference_split(stream + pos, len - pos < 1024 ? len - pos : 1024).size();
+        int64_t t3 = esp_timer_get_time();
+        SLIPDecoder decoder;
+        for (size_t pos = 0; pos < len; pos += 1024)
+        {
+            const uint8_t *p = stream + pos;
+            size_t n = len - pos < 1024 ? len - pos : 1024;
+            while (n > 0)
+            {
+                size_t used = decoder.feed(p, n);
+                p += used;
+                n -= used;
+                frames_out += decoder.has_frame();
+            }
+        }
+        int64_t t4 = esp_timer_get_time();
+
+        t_ref_enc += t1 - t0;
+        t_new_enc += t2 - t1;
+        t_ref_dec += t3 - t2;
+        t_new_dec += t4 - t3;
+        bytes += len;
+    }
+
+    // bytes per microsecond is MB/s
+    snprintf(msg, sizeof(msg), "SLIP MB/s: encode %.1f/%.1f, decode %.1f/%.1f (original/streaming)",
+             (double)bytes / t_ref_enc, (double)bytes / t_new_enc, (double)bytes / t_ref_dec, (double)bytes / t_new_dec);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(frames_out > 0);
+}
@@ -0,0 +1,47 @@
+/**
+ * #FujiNet Tests - SLIP codec
+ *
+ * Round trips frames through the buffer encoder and the incremental
+ * decoder, fed in chunks of random size, and compares throughput with the
+ * original vector based encoder and decoder.
+ */
+
+#ifndef TEST_SLIP_H
+#define TEST_SLIP_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_slip();
+
+    /**
+     * Test encoding against the original encoder
+     */
+    void tests_slip_encode();
+
+    /**
+     * Test decoding frames split across chunks of every size
+     */
+    void tests_slip_decode_chunks();
+
+    /**
+     * Test resync after garbage, invalid escapes and oversized frames
+     */
+    void tests_slip_decode_errors();
+
+    /**
+     * Report encode and decode throughput for both versions
+     */
+    void tests_slip_timing();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_SLIP_H */
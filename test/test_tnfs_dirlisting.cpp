@@ -0,0 +1,396 @@
+/**
+ * #FujiNet Tests - TNFS directory listings
+ *
+ * Reads directories from a simulated server and counts the requests:
+ * entries are fetched as they are read, positions are kept locally, and
+ * changes made through the mount throw cached listings away.
+ * Needs a build with TNFS_UDP_SIMULATE_POOR_CONNECTION.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../lib/TNFSlib/tnfslib_udp.h"
+#include "test_tnfs_dirlisting.h"
+
+#ifdef TNFS_UDP_SIMULATE_POOR_CONNECTION
+
+// Entries in every directory the simulated server lists
+#define DIRLISTING_TEST_ENTRIES 200
+
+/**
+ * Answers straight away, with the same DIRLISTING_TEST_ENTRIES entries for
+ * any directory, and counts the requests it gets by command
+ */
+struct dirlisting_server
+{
+    uint32_t requests[256];
+    uint8_t last_sequence;
+    bool answered;
+    tnfsPacket response;
+    int response_len;
+    bool pending;
+
+    int16_t dir_handle; // open directory, or -1
+    uint16_t dir_pos;
+    uint8_t last_batch; // entries in the last READDIRX response
+};
+
+static dirlisting_server server;
+
+static void dir_entry_name(uint16_t pos, char *name, size_t len)
+{
+    snprintf(name, len, "FILE%03u.ATR", pos);
+}
+
+static int dirlisting_answer(const tnfsPacket &req, tnfsPacket &res)
+{
+    res = req;
+    uint8_t *p = res.payload;
+    p[0] = TNFS_RESULT_SUCCESS;
+
+    switch (req.command)
+    {
+    case TNFS_CMD_OPENDIRX:
+        server.dir_handle = 3;
+        server.dir_pos = 0;
+        p[1] = server.dir_handle;
+        p[2] = TNFS_LOBYTE_FROM_UINT16(DIRLISTING_TEST_ENTRIES);
+        p[3] = TNFS_HIBYTE_FROM_UINT16(DIRLISTING_TEST_ENTRIES);
+        return 4;
+
+    case TNFS_CMD_SEEKDIR:
+        if (req.payload[0] != server.dir_handle)
+            break;
+        server.dir_pos = TNFS_UINT32_FROM_LOHI_BYTEPTR(req.payload + 1);
+        return 1;
+
+    case TNFS_CMD_CLOSEDIR:
+        if (req.payload[0] != server.dir_handle)
+            break;
+        server.dir_handle = -1;
+        return 1;
+
+    case TNFS_CMD_READDIRX:
+    {
+        if (req.payload[0] != server.dir_handle)
+            break;
+        if (server.dir_pos >= DIRLISTING_TEST_ENTRIES)
+        {
+            p[0] = TNFS_RESULT_END_OF_FILE;
+            return 1;
+        }
+        uint16_t start = server.dir_pos;
+        int len = 5;
+        uint8_t count = 0;
+        while (count < req.payload[1] && server.dir_pos < DIRLISTING_TEST_ENTRIES)
+        {
+            char name[16];
+            dir_entry_name(server.dir_pos, name, sizeof(name));
+            int record_len = TNFS_DIRLISTING_RECORD_HEADER + strlen(name) + 1;
+            if (len + record_len > TNFS_PAYLOAD_SIZE)
+                break;
+            uint8_t *r = p + len;
+            uint32_t v = server.dir_pos * 10;
+            r[0] = 0;
+            TNFS_UINT32_TO_LOHI_BYTEPTR(v, r + 1);
+            v = server.dir_pos;
+            TNFS_UINT32_TO_LOHI_BYTEPTR(v, r + 5);
+            TNFS_UINT32_TO_LOHI_BYTEPTR(v, r + 9);
+            strcpy((char *)r + TNFS_DIRLISTING_RECORD_HEADER, name);
+            len += record_len;
+            count++;
+            server.dir_pos++;
+        }
+        server.last_batch = count;
+        p[1] = count;
+        p[2] = server.dir_pos >= DIRLISTING_TEST_ENTRIES ? TNFS_READDIRX_STATUS_EOF : 0;
+        p[3] = TNFS_LOBYTE_FROM_UINT16(start);
+        p[4] = TNFS_HIBYTE_FROM_UINT16(start);
+        return len;
+    }
+
+    case TNFS_CMD_STAT:
+    {
+        // Everything is a directory that last changed at 1000
+        uint16_t mode = S_IFDIR | 0755;
+        uint32_t mtime = 1000;
+        memset(p + 1, 0, 22);
+        p[1] = TNFS_LOBYTE_FROM_UINT16(mode);
+        p[2] = TNFS_HIBYTE_FROM_UINT16(mode);
+        TNFS_UINT32_TO_LOHI_BYTEPTR(mtime, p + 15);
+        return 23;
+    }
+
+    case TNFS_CMD_OPEN:
+        p[1] = 5;
+        return 2;
+
+    case TNFS_CMD_CLOSE:
+    case TNFS_CMD_MKDIR:
+    case TNFS_CMD_RMDIR:
+    case TNFS_CMD_UNLINK:
+    case TNFS_CMD_RENAME:
+    case TNFS_CMD_CHMOD:
+        return 1;
+    }
+
+    p[0] = TNFS_RESULT_BAD_FILE_DESCRIPTOR;
+    return 1;
+}
+
+static bool dirlisting_send(tnfsMountInfo *m_info, const tnfsPacket &pkt, uint16_t payload_size)
+{
+    // A request sent again gets the answer it already had, like tnfsd
+    if (!server.answered || pkt.sequence_num != server.last_sequence)
+    {
+        server.requests[pkt.command]++;
+        server.response_len = TNFS_HEADER_SIZE + dirlisting_answer(pkt, server.response);
+        server.last_sequence = pkt.sequence_num;
+        server.answered = true;
+    }
+    server.pending = true;
+    return true;
+}
+
+static int dirlisting_recv(tnfsMountInfo *m_info, tnfsPacket &pkt)
+{
+    if (!server.pending)
+        return -1;
+    server.pending = false;
+    pkt = server.response;
+    return server.response_len;
+}
+
+static tnfsSimulatedServer dirlisting_simulated_server = {dirlisting_send, dirlisting_recv};
+
+static void dirlisting_mount(tnfsMountInfo &m_info)
+{
+    server = dirlisting_server();
+    server.dir_handle = -1;
+    tnfs_udp_simulated_server = &dirlisting_simulated_server;
+
+    m_info.protocol = TNFS_PROTOCOL_UDP;
+    m_info.session = 1;
+    m_info.max_retries = 10;
+    strcpy(m_info.current_working_directory, "/");
+}
+
+static uint32_t requests(uint8_t command)
+{
+    return server.requests[command];
+}
+
+static uint32_t all_requests()
+{
+    uint32_t total = 0;
+    for (int i = 0; i < 256; i++)
+        total += server.requests[i];
+    return total;
+}
+
+// Read the entry at the current position and check it's the one at pos
+static bool read_entry(tnfsMountInfo &m_info, uint16_t pos)
+{
+    tnfsStat st;
+    char name[64], expect[16];
+    uint16_t at;
+    if (tnfs_telldir(&m_info, &at) != 0 || at != pos)
+        return false;
+    if (tnfs_readdirx(&m_info, &st, name, sizeof(name)) != TNFS_RESULT_SUCCESS)
+        return false;
+    dir_entry_name(pos, expect, sizeof(expect));
+    return strcmp(name, expect) == 0 && st.filesize == pos * 10u && st.m_time == pos;
+}
+
+static bool read_entries(tnfsMountInfo &m_info, uint16_t pos, uint16_t count)
+{
+    if (tnfs_seekdir(&m_info, pos) != 0)
+        return false;
+    for (uint16_t i = 0; i < count; i++)
+        if (!read_entry(m_info, pos + i))
+            return false;
+    return true;
+}
+
+static bool at_end(tnfsMountInfo &m_info)
+{
+    tnfsStat st;
+    char name[64];
+    return tnfs_readdirx(&m_info, &st, name, sizeof(name)) == TNFS_RESULT_END_OF_FILE;
+}
+
+void tests_tnfs_dirlisting_paging()
+{
+    tnfsMountInfo m_info("localhost");
+    dirlisting_mount(m_info);
+
+    // Opening stats the directory and opens it, nothing is read yet
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, "*.ATR", 0));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_STAT));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_OPENDIRX));
+    TEST_ASSERT_EQUAL(0, requests(TNFS_CMD_READDIRX));
+
+    // The first entry brings a batch, the rest of the batch needs nothing more
+    TEST_ASSERT_TRUE(read_entry(m_info, 0));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_READDIRX));
+    uint8_t batch = server.last_batch;
+    TEST_ASSERT_TRUE(batch > 1);
+    for (uint16_t i = 1; i < batch; i++)
+        TEST_ASSERT_TRUE(read_entry(m_info, i));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_READDIRX));
+
+    // One more batch for every batch read on
+    for (uint16_t i = batch; i < DIRLISTING_TEST_ENTRIES; i++)
+        TEST_ASSERT_TRUE(read_entry(m_info, i));
+    TEST_ASSERT_EQUAL((DIRLISTING_TEST_ENTRIES + batch - 1) / batch, requests(TNFS_CMD_READDIRX));
+    TEST_ASSERT_TRUE(at_end(m_info));
+    TEST_ASSERT_TRUE(at_end(m_info));
+
+    // Moving around the listing is local, and so is reading it again
+    uint32_t before = all_requests();
+    TEST_ASSERT_TRUE(read_entries(m_info, 5, 10));
+    TEST_ASSERT_TRUE(read_entries(m_info, DIRLISTING_TEST_ENTRIES - 3, 3));
+    TEST_ASSERT_TRUE(at_end(m_info));
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, 1));
+    TEST_ASSERT_EQUAL(before, all_requests());
+
+    // Closing lets the server go of its handle, reopening costs nothing
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_CLOSEDIR));
+    TEST_ASSERT_EQUAL(-1, server.dir_handle);
+    before = all_requests();
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, "*.ATR", 0));
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, DIRLISTING_TEST_ENTRIES));
+    TEST_ASSERT_TRUE(at_end(m_info));
+    TEST_ASSERT_TRUE(read_entries(m_info, 100, 20));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+    TEST_ASSERT_EQUAL(before, all_requests());
+
+    // Another pattern is another listing
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, "*.XEX", 0));
+    TEST_ASSERT_EQUAL(2, requests(TNFS_CMD_OPENDIRX));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+
+    tnfs_udp_simulated_server = nullptr;
+}
+
+void tests_tnfs_dirlisting_seek()
+{
+    tnfsMountInfo m_info("localhost");
+    dirlisting_mount(m_info);
+
+    // Straight to the middle: the server is moved there once
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, nullptr, 0));
+    TEST_ASSERT_TRUE(read_entries(m_info, 150, 5));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_SEEKDIR));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_READDIRX));
+    uint8_t batch = server.last_batch;
+
+    // Reading on from there needs no seek
+    TEST_ASSERT_TRUE(read_entries(m_info, 155, DIRLISTING_TEST_ENTRIES - 155));
+    TEST_ASSERT_TRUE(at_end(m_info));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_SEEKDIR));
+
+    // Back to the start: the window starts over there
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, batch));
+    TEST_ASSERT_EQUAL(2, requests(TNFS_CMD_SEEKDIR));
+    uint32_t readdirx = requests(TNFS_CMD_READDIRX);
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, batch));
+    TEST_ASSERT_EQUAL(readdirx, requests(TNFS_CMD_READDIRX));
+
+    // After closing, the cached window is read without the server's handle,
+    // which is only opened again to fetch what isn't there
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, nullptr, 0));
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, batch));
+    TEST_ASSERT_EQUAL(1, requests(TNFS_CMD_OPENDIRX));
+    TEST_ASSERT_TRUE(read_entry(m_info, batch));
+    TEST_ASSERT_EQUAL(2, requests(TNFS_CMD_OPENDIRX));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+    TEST_ASSERT_EQUAL(-1, server.dir_handle);
+
+    tnfs_udp_simulated_server = nullptr;
+}
+
+// List /games and close it, return whether the server was asked to open it
+static bool lists_from_server(tnfsMountInfo &m_info)
+{
+    uint32_t opens = requests(TNFS_CMD_OPENDIRX);
+    if (tnfs_opendirx(&m_info, "/games", 0, 0, nullptr, 0) != TNFS_RESULT_SUCCESS)
+        return false;
+    bool read = read_entries(m_info, 0, 3);
+    tnfs_closedir(&m_info);
+    return read && requests(TNFS_CMD_OPENDIRX) != opens;
+}
+
+void tests_tnfs_dirlisting_invalidate()
+{
+    tnfsMountInfo m_info("localhost");
+    dirlisting_mount(m_info);
+    int16_t handle;
+
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+    TEST_ASSERT_FALSE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_mkdir(&m_info, "/games/new"));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+    TEST_ASSERT_FALSE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_rmdir(&m_info, "/games/new"));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_unlink(&m_info, "/games/FILE001.ATR"));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_rename(&m_info, "/games/FILE002.ATR", "/games/OTHER.ATR"));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_chmod(&m_info, "/games/FILE003.ATR", 0644));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    // Reading a file changes nothing, writing one does
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_open(&m_info, "/games/FILE004.ATR", TNFS_OPENMODE_READ, 0, &handle));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_close(&m_info, handle));
+    TEST_ASSERT_FALSE(lists_from_server(m_info));
+
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_open(&m_info, "/games/FILE004.ATR", TNFS_OPENMODE_WRITE, 0, &handle));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_close(&m_info, handle));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    // A change while a listing is open lets it be read to the end, but not reused
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_opendirx(&m_info, "/games", 0, 0, nullptr, 0));
+    TEST_ASSERT_TRUE(read_entries(m_info, 0, 3));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_unlink(&m_info, "/games/FILE005.ATR"));
+    TEST_ASSERT_TRUE(read_entries(m_info, 3, 3));
+    TEST_ASSERT_EQUAL(TNFS_RESULT_SUCCESS, tnfs_closedir(&m_info));
+    TEST_ASSERT_TRUE(lists_from_server(m_info));
+
+    tnfs_udp_simulated_server = nullptr;
+}
+
+#else
+
+void tests_tnfs_dirlisting_paging()
+{
+    TEST_IGNORE_MESSAGE("Needs TNFS_UDP_SIMULATE_POOR_CONNECTION");
+}
+
+void tests_tnfs_dirlisting_seek()
+{
+    TEST_IGNORE_MESSAGE("Needs TNFS_UDP_SIMULATE_POOR_CONNECTION");
+}
+
+void tests_tnfs_dirlisting_invalidate()
+{
+    TEST_IGNORE_MESSAGE("Needs TNFS_UDP_SIMULATE_POOR_CONNECTION");
+}
+
+#endif /* TNFS_UDP_SIMULATE_POOR_CONNECTION */
+
+void tests_tnfs_dirlisting()
+{
+    RUN_TEST(tests_tnfs_dirlisting_paging);
+    RUN_TEST(tests_tnfs_dirlisting_seek);
+    RUN_TEST(tests_tnfs_dirlisting_invalidate);
+}
@@ -0,0 +1,44 @@
+/**
+ * #FujiNet Tests - TNFS directory listings
+ *
+ * Reads directories from a simulated server and counts the requests:
+ * entries are fetched as they are read, positions are kept locally, and
+ * changes made through the mount throw cached listings away.
+ * Needs a build with TNFS_UDP_SIMULATE_POOR_CONNECTION.
+ */
+
+#ifndef TEST_TNFS_DIRLISTING_H
+#define TEST_TNFS_DIRLISTING_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_tnfs_dirlisting();
+
+    /**
+     * Test that entries are fetched in batches as they are read, and that
+     * telldir, seekdir and reopening use the cached listing
+     */
+    void tests_tnfs_dirlisting_paging();
+
+    /**
+     * Test reading from the middle of a listing that isn't cached yet
+     */
+    void tests_tnfs_dirlisting_seek();
+
+    /**
+     * Test that changes through the mount make the next open ask the server
+     */
+    void tests_tnfs_dirlisting_invalidate();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_TNFS_DIRLISTING_H */
@@ -0,0 +1,211 @@
+/**
+ * #FujiNet Tests - TNFS retransmit timeout
+ *
+ * Checks the RTT estimator, then runs real transactions against a simulated
+ * server over a link that loses datagrams, and measures how long they stall.
+ * The transaction tests need a build with TNFS_UDP_SIMULATE_POOR_CONNECTION.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../lib/TNFSlib/tnfslib_udp.h"
+#include "../lib/hardware/fnSystem.h"
+#include "test_tnfs_rto.h"
+
+// Responses the simulated server may have on the way at once
+#define RTO_SERVER_QUEUE 8
+// What the simulated server asks for between retries, in ms
+#define RTO_SERVER_MIN_RETRY 50
+// How long the simulated server takes over a slow command, in ms
+#define RTO_SERVER_SLOW_MS 600
+
+void tests_tnfs_rto_estimate()
+{
+    tnfsMountInfo m_info("localhost");
+    m_info.protocol = TNFS_PROTOCOL_UDP;
+
+    TEST_ASSERT_EQUAL(TNFS_TIMEOUT, m_info.current_timeout_ms());
+
+    // A steady 30 ms link brings the timeout down to the floor
+    for (int i = 0; i < 50; i++)
+        m_info.rtt_sample(30000);
+    TEST_ASSERT_EQUAL(30000, m_info.srtt_us);
+    TEST_ASSERT_EQUAL(TNFS_MIN_TIMEOUT, m_info.current_timeout_ms());
+
+    // A slow one sets it from the round trip, and it doubles on each timeout
+    for (int i = 0; i < 50; i++)
+        m_info.rtt_sample(400000);
+    TEST_ASSERT_INT_WITHIN(10, 400, m_info.current_timeout_ms());
+    m_info.rto_backoff();
+    TEST_ASSERT_INT_WITHIN(20, 800, m_info.current_timeout_ms());
+    for (int i = 0; i < 4; i++)
+        m_info.rto_backoff();
+    TEST_ASSERT_EQUAL(m_info.timeout_ms, m_info.current_timeout_ms());
+
+    // TCP always uses the fixed timeout
+    m_info.protocol = TNFS_PROTOCOL_TCP;
+    TEST_ASSERT_EQUAL(m_info.timeout_ms, m_info.current_timeout_ms());
+}
+
+#ifdef TNFS_UDP_SIMULATE_POOR_CONNECTION
+
+/**
+ * Answers every request it gets after about rtt_ms, the way tnfsd would.
+ * Requests and responses lost on the link never reach it or the client.
+ */
+struct rto_server
+{
+    struct response {
+        tnfsPacket pkt;
+        uint32_t sent_us;
+        uint32_t due_us;
+    };
+
+    uint32_t rtt_ms = 0;
+    uint32_t slow_ms = 0; // extra time OPENDIRX takes
+    response queue[RTO_SERVER_QUEUE];
+    int queued = 0;
+    uint32_t requests = 0;
+    uint32_t early_resends = 0; // requests sent again while their answer was still being worked on
+};
+
+static rto_server server;
+
+static bool rto_server_send(tnfsMountInfo *m_info, const tnfsPacket &pkt, uint16_t payload_size)
+{
+    uint32_t now = (uint32_t)fnSystem.micros();
+    server.requests++;
+    // The link sending a datagram twice isn't the client's doing
+    for (int i = 0; i < server.queued; i++)
+        if (server.queue[i].pkt.sequence_num == pkt.sequence_num && now - server.queue[i].sent_us > 1000)
+            server.early_resends++;
+    if (server.queued == RTO_SERVER_QUEUE)
+        return true;
+
+    // The round trip varies by a quarter either way
+    uint32_t rtt_us = server.rtt_ms * 750 + rand() % (server.rtt_ms * 500 + 1);
+    if (pkt.command == TNFS_CMD_OPENDIRX)
+        rtt_us += server.slow_ms * 1000;
+
+    rto_server::response &r = server.queue[server.queued++];
+    r.pkt = pkt;
+    r.pkt.payload[0] = TNFS_RESULT_SUCCESS;
+    r.sent_us = now;
+    r.due_us = now + rtt_us;
+    return true;
+}
+
+static int rto_server_recv(tnfsMountInfo *m_info, tnfsPacket &pkt)
+{
+    uint32_t now = (uint32_t)fnSystem.micros();
+    for (int i = 0; i < server.queued; i++)
+    {
+        if ((int32_t)(now - server.queue[i].due_us) >= 0)
+        {
+            pkt = server.queue[i].pkt;
+            server.queue[i] = server.queue[--server.queued];
+            return TNFS_HEADER_SIZE + 1;
+        }
+    }
+    return -1;
+}
+
+static tnfsSimulatedServer rto_simulated_server = {rto_server_send, rto_server_recv};
+
+static void rto_mount(tnfsMountInfo &m_info, uint32_t rtt_ms)
+{
+    server = rto_server();
+    server.rtt_ms = rtt_ms;
+    server.slow_ms = RTO_SERVER_SLOW_MS;
+    tnfs_udp_simulated_server = &rto_simulated_server;
+
+    m_info.protocol = TNFS_PROTOCOL_UDP;
+    m_info.session = 1;
+    m_info.min_retry_ms = RTO_SERVER_MIN_RETRY;
+    // Enough that no transaction runs out of retries on this link
+    m_info.max_retries = 10;
+}
+
+static bool rto_transaction(tnfsMountInfo &m_info, uint8_t command)
+{
+    tnfsPacket pkt;
+    pkt.command = command;
+    return _tnfs_transaction(&m_info, pkt, 0) && pkt.payload[0] == TNFS_RESULT_SUCCESS;
+}
+
+void tests_tnfs_rto_stall()
+{
+    char msg[200];
+    const uint32_t rtts[] = {5, 50, 200};
+    const int transactions[] = {200, 100, 30};
+
+    for (int i = 0; i < 3; i++)
+    {
+        tnfsMountInfo m_info("localhost");
+        rto_mount(m_info, rtts[i]);
+        srand(7);
+
+        uint64_t start_ms = fnSystem.millis();
+        for (int t = 0; t < transactions[i]; t++)
+            TEST_ASSERT_TRUE(rto_transaction(m_info, TNFS_CMD_READ));
+        uint32_t elapsed_ms = fnSystem.millis() - start_ms;
+        tnfs_udp_simulated_server = nullptr;
+
+        // Time not spent on the round trips themselves went on timeouts and retry delays
+        uint32_t trips_ms = transactions[i] * rtts[i];
+        uint32_t stall_ms = elapsed_ms > trips_ms ? elapsed_ms - trips_ms : 0;
+        snprintf(msg, sizeof(msg), "%d transactions, %lu ms round trip: %lu ms in all, %lu ms stalled over %lu retransmits, rto %d ms",
+                 transactions[i], (unsigned long)rtts[i], (unsigned long)elapsed_ms, (unsigned long)stall_ms,
+                 (unsigned long)m_info.retransmits, m_info.rto_ms);
+        TEST_MESSAGE(msg);
+
+        // The link lost some, and each cost far less than the fixed timeout
+        TEST_ASSERT_TRUE(m_info.retransmits > 0);
+        TEST_ASSERT_TRUE(stall_ms < m_info.retransmits * (uint32_t)m_info.timeout_ms / 2);
+        // Give or take the time spent polling and logging
+        TEST_ASSERT_UINT32_WITHIN(rtts[i] * 500 + 5000, rtts[i] * 1000, m_info.srtt_us);
+    }
+}
+
+void tests_tnfs_rto_slow_command()
+{
+    tnfsMountInfo m_info("localhost");
+    rto_mount(m_info, 20);
+    srand(11);
+
+    for (int t = 0; t < 20; t++)
+        TEST_ASSERT_TRUE(rto_transaction(m_info, TNFS_CMD_READ));
+    TEST_ASSERT_TRUE(m_info.rto_ms < RTO_SERVER_SLOW_MS);
+    uint32_t srtt_us = m_info.srtt_us;
+    uint32_t early = server.early_resends;
+
+    // Sorting a big directory takes longer than the estimate, but it isn't sent
+    // again while the server works on it, nor does it skew the estimate
+    for (int t = 0; t < 5; t++)
+        TEST_ASSERT_TRUE(rto_transaction(m_info, TNFS_CMD_OPENDIRX));
+    tnfs_udp_simulated_server = nullptr;
+
+    TEST_ASSERT_EQUAL(early, server.early_resends);
+    TEST_ASSERT_EQUAL(srtt_us, m_info.srtt_us);
+}
+
+#else
+
+void tests_tnfs_rto_stall()
+{
+    TEST_IGNORE_MESSAGE("Needs TNFS_UDP_SIMULATE_POOR_CONNECTION");
+}
+
+void tests_tnfs_rto_slow_command()
+{
+    TEST_IGNORE_MESSAGE("Needs TNFS_UDP_SIMULATE_POOR_CONNECTION");
+}
+
+#endif /* TNFS_UDP_SIMULATE_POOR_CONNECTION */
+
+void tests_tnfs_rto()
+{
+    RUN_TEST(tests_tnfs_rto_estimate);
+    RUN_TEST(tests_tnfs_rto_stall);
+    RUN_TEST(tests_tnfs_rto_slow_command);
+}
@@ -0,0 +1,42 @@
+/**
+ * #FujiNet Tests - TNFS retransmit timeout
+ *
+ * Checks the RTT estimator, then runs real transactions against a simulated
+ * server over a link that loses datagrams, and measures how long they stall.
+ * The transaction tests need a build with TNFS_UDP_SIMULATE_POOR_CONNECTION.
+ */
+
+#ifndef TEST_TNFS_RTO_H
+#define TEST_TNFS_RTO_H
+
+#include <unity.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+
+extern "C"
+{
+    /**
+     * Tests entrypoint
+     */
+    void tests_tnfs_rto();
+
+    /**
+     * Test that the estimate settles near the round trip time
+     */
+    void tests_tnfs_rto_estimate();
+
+    /**
+     * Test that lost datagrams cost far less than the fixed timeout
+     */
+    void tests_tnfs_rto_stall();
+
+    /**
+     * Test that slow commands aren't sent again while the server works on them
+     */
+    void tests_tnfs_rto_slow_command();
+}
+
+#endif /* __cplusplus */
+
+#endif /* TEST_TNFS_RTO_H */